@@ -177,6 +177,11 @@ if(WIN32)
   list(APPEND oneflow_third_party_libs "Ws2_32.lib")
 endif()
 
+if(UNIX AND NOT APPLE)
+  # shm_open and shm_unlink of ccl live in librt before glibc 2.34
+  list(APPEND oneflow_third_party_libs rt)
+endif()
+
 set(oneflow_third_party_dependencies
   protobuf
   gflags
@@ -51,7 +51,9 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
       "DispatchOfrecordReader",
       [](const std::shared_ptr<OpExpr>& op, const std::string& data_dir, int32_t data_part_num,
          const std::string& part_name_prefix, int32_t part_name_suffix_length, int32_t batch_size,
-         int32_t shuffle_buffer_size, bool random_shuffle, bool shuffle_after_epoch, int64_t seed,
+         int32_t shuffle_buffer_size, bool random_shuffle, const std::string& shuffle_mode,
+         bool shuffle_after_epoch, int64_t seed, int32_t num_load_workers,
+         int32_t prefetch_buffer_size,
          const Optional<Symbol<Device>>& device) -> Maybe<Tensor> {
         MutableAttrMap attrs;
         JUST(attrs.SetAttr("data_dir", data_dir));
@@ -61,15 +63,20 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         JUST(attrs.SetAttr("batch_size", batch_size));
         JUST(attrs.SetAttr("shuffle_buffer_size", shuffle_buffer_size));
         JUST(attrs.SetAttr("random_shuffle", random_shuffle));
+        JUST(attrs.SetAttr("shuffle_mode", shuffle_mode));
         JUST(attrs.SetAttr("shuffle_after_epoch", shuffle_after_epoch));
         JUST(attrs.SetAttr("seed", seed));
+        JUST(attrs.SetAttr("num_load_workers", num_load_workers));
+        JUST(attrs.SetAttr("prefetch_buffer_size", prefetch_buffer_size));
         return OpInterpUtil::Dispatch<Tensor>(*op, {}, OpExprInterpContext(attrs, JUST(device)));
       });
   m.add_functor(
       "DispatchOfrecordReader",
       [](const std::shared_ptr<OpExpr>& op, const std::string& data_dir, int32_t data_part_num,
          const std::string& part_name_prefix, int32_t part_name_suffix_length, int32_t batch_size,
-         int32_t shuffle_buffer_size, bool random_shuffle, bool shuffle_after_epoch, int64_t seed,
+         int32_t shuffle_buffer_size, bool random_shuffle, const std::string& shuffle_mode,
+         bool shuffle_after_epoch, int64_t seed, int32_t num_load_workers,
+         int32_t prefetch_buffer_size,
          const Symbol<ParallelDesc>& placement,
          const std::vector<Symbol<cfg::SbpParallel>>& sbp_tuple) -> Maybe<Tensor> {
         MutableAttrMap attrs;
@@ -80,8 +87,11 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         JUST(attrs.SetAttr("batch_size", batch_size));
         JUST(attrs.SetAttr("shuffle_buffer_size", shuffle_buffer_size));
         JUST(attrs.SetAttr("random_shuffle", random_shuffle));
+        JUST(attrs.SetAttr("shuffle_mode", shuffle_mode));
         JUST(attrs.SetAttr("shuffle_after_epoch", shuffle_after_epoch));
         JUST(attrs.SetAttr("seed", seed));
+        JUST(attrs.SetAttr("num_load_workers", num_load_workers));
+        JUST(attrs.SetAttr("prefetch_buffer_size", prefetch_buffer_size));
         JUST(attrs.SetAttr("nd_sbp", *JUST(GetNdSbpStrList(sbp_tuple))));
         auto nd_sbp = JUST(GetNdSbp(sbp_tuple));
         return OpInterpUtil::Dispatch<Tensor>(*op, {},
@@ -266,7 +276,8 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
       [](const std::shared_ptr<OpExpr>& op, const std::string& image_dir,
          const std::string& annotation_file, int64_t batch_size, bool shuffle_after_epoch,
          int64_t random_seed, bool group_by_ratio, bool remove_images_without_annotations,
-         bool stride_partition, int64_t session_id,
+         bool stride_partition, int64_t session_id, int32_t num_load_workers,
+         int32_t prefetch_buffer_size,
          const Optional<Symbol<Device>>& device) -> Maybe<TensorTuple> {
         MutableAttrMap attrs;
         JUST(attrs.SetAttr("session_id", session_id));
@@ -278,6 +289,8 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         JUST(attrs.SetAttr("group_by_ratio", group_by_ratio));
         JUST(attrs.SetAttr("remove_images_without_annotations", remove_images_without_annotations));
         JUST(attrs.SetAttr("stride_partition", stride_partition));
+        JUST(attrs.SetAttr("num_load_workers", num_load_workers));
+        JUST(attrs.SetAttr("prefetch_buffer_size", prefetch_buffer_size));
         return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
                                                    OpExprInterpContext(attrs, JUST(device)));
       });
@@ -286,7 +299,8 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
       [](const std::shared_ptr<OpExpr>& op, const std::string& image_dir,
          const std::string& annotation_file, int64_t batch_size, bool shuffle_after_epoch,
          int64_t random_seed, bool group_by_ratio, bool remove_images_without_annotations,
-         bool stride_partition, int64_t session_id, const Symbol<ParallelDesc>& placement,
+         bool stride_partition, int64_t session_id, int32_t num_load_workers,
+         int32_t prefetch_buffer_size, const Symbol<ParallelDesc>& placement,
          const std::vector<Symbol<cfg::SbpParallel>>& sbp_tuple) -> Maybe<TensorTuple> {
         MutableAttrMap attrs;
         JUST(attrs.SetAttr("session_id", session_id));
@@ -298,6 +312,8 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         JUST(attrs.SetAttr("group_by_ratio", group_by_ratio));
         JUST(attrs.SetAttr("remove_images_without_annotations", remove_images_without_annotations));
         JUST(attrs.SetAttr("stride_partition", stride_partition));
+        JUST(attrs.SetAttr("num_load_workers", num_load_workers));
+        JUST(attrs.SetAttr("prefetch_buffer_size", prefetch_buffer_size));
         JUST(attrs.SetAttr("nd_sbp", *JUST(GetNdSbpStrList(sbp_tuple))));
         auto nd_sbp = JUST(GetNdSbp(sbp_tuple));
         return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
@@ -25,13 +25,21 @@ limitations under the License.
 #include "oneflow/core/autograd/autograd_mode.h"
 #include "oneflow/core/eager/dev_vm_dep_object_consume_mode.h"
 #include "oneflow/core/functional/functional.h"
+#include "oneflow/core/framework/eager_trace.h"
+#include "oneflow/core/framework/instruction_replay.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/recycling_allocator.h"
+#include "oneflow/core/framework/op_expr_grad_function.h"
+#include "oneflow/core/job/lazy_mode.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 namespace one {
 
 namespace {
 
-bool IsReadyToRun(const std::vector<std::shared_ptr<AutogradMeta>>& out_meta_datas) {
+template<typename MetaList>
+bool IsReadyToRun(const MetaList& out_meta_datas) {
   return std::any_of(out_meta_datas.begin(), out_meta_datas.end(),
                      [](const std::shared_ptr<AutogradMeta>& meta_data) {
                        return !meta_data->current_grad()->Empty();
@@ -64,6 +72,23 @@ Maybe<void> CopyOrAccGrad(AutogradMeta* autograd_meta, bool autograd_mode) {
   return Maybe<void>::Ok();
 }
 
+// Returns nullptr if the backward nodes are applied by the calling thread only.
+ThreadPool* BackwardThreadPool() {
+  static const int64_t thread_num = ParseIntegerFromEnv("ONEFLOW_AUTOGRAD_BACKWARD_THREAD_NUM", 1);
+  if (thread_num <= 1) { return nullptr; }
+  static ThreadPool thread_pool(thread_num);
+  return &thread_pool;
+}
+
+// A node whose input grads are computed by a work of the backward thread pool.
+struct ComputingNode {
+  ComputingNode(FunctionNode* node, int64_t cnt) : node(node), counter(cnt) {}
+  FunctionNode* node;
+  TensorTuple input_grads;
+  std::shared_ptr<cfg::ErrorProto> error;
+  BlockingCounter counter;
+};
+
 Maybe<void> RawTorchConsistentTensor(const std::shared_ptr<one::Tensor>& tensor) {
   // Do nothing.
   return Maybe<void>::Ok();
@@ -102,12 +127,20 @@ Maybe<TensorTuple> AutogradEngine::RunBackwardAndReturnInputsTensorGradIf(
                                               create_graph);
 }
 
-StackFunctionNode::StackFunctionNode(
-    const std::string& op_type_name,
-    const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
-        backward_fn,
-    const TensorTuple& inputs, const TensorTuple& outputs)
-    : FunctionNode(op_type_name) {
+Maybe<void> BackwardFunction::operator()(const TensorTuple& out_grads, TensorTuple* in_grads,
+                                         bool create_graph) const {
+  if (grad_closure_) {
+    autograd::AutoGradMode mode(create_graph);
+    return grad_closure_->Apply(out_grads, in_grads);
+  }
+  return (*function_)(out_grads, in_grads, create_graph);
+}
+
+FunctionNode::FunctionNode(const std::string& op_type_name, const BackwardFunction& backward_fn,
+                           const TensorTuple& inputs, const TensorTuple& outputs)
+    : op_type_name_(op_type_name),
+      next_functions_(std::allocate_shared<std::vector<std::shared_ptr<FunctionNode>>>(
+          RecyclingAllocator<std::vector<std::shared_ptr<FunctionNode>>>())) {
   input_meta_data_.resize(inputs.size());
   next_functions_->reserve(inputs.size());
   for (int i = 0; i < inputs.size(); ++i) {
@@ -128,6 +161,12 @@ StackFunctionNode::StackFunctionNode(
   }
 
   backward_fn_ = backward_fn;
+}
+
+StackFunctionNode::StackFunctionNode(const std::string& op_type_name,
+                                     const BackwardFunction& backward_fn,
+                                     const TensorTuple& inputs, const TensorTuple& outputs)
+    : FunctionNode(op_type_name, backward_fn, inputs, outputs) {
   is_in_stack_ = false;
 }
 
@@ -158,13 +197,21 @@ void StackFunctionNode::ReleaseData() {
   is_in_stack_ = false;
 }
 
-Maybe<bool> FunctionNode::Apply(bool create_graph) {
-  CHECK_NOTNULL_OR_RETURN(backward_fn_.get())
+bool FunctionNode::has_consistent_output() const {
+  return std::any_of(output_tensor_infos_.begin(), output_tensor_infos_.end(),
+                     [](const TensorInfo& info) { return info.is_consistent(); });
+}
+
+Maybe<bool> FunctionNode::IsReadyToApply() const {
+  CHECK_OR_RETURN(static_cast<bool>(backward_fn_))
       << "This FunctionNode with name `" << GetOpTypeName() << "` has been released.\n"
       << "Maybe you try to backward through the node a second time. Specify retain_graph=True when "
          "calling .backward() or autograd.grad() the first time.";
-  if (!IsReadyToRun(output_meta_data_)) { return false; }
-  TensorTuple input_grads(input_meta_data_.size());
+  return IsReadyToRun(output_meta_data_);
+}
+
+Maybe<void> FunctionNode::ComputeInputGrads(bool create_graph, TensorTuple* input_grads) {
+  input_grads->resize(input_meta_data_.size());
   TensorTuple output_grads(output_meta_data_.size());
   for (int i = 0; i < output_meta_data_.size(); ++i) {
     if (output_meta_data_.at(i)->current_grad()->Empty()) {
@@ -173,7 +220,11 @@ Maybe<bool> FunctionNode::Apply(bool create_graph) {
       output_grads.at(i) = JUST(output_meta_data_.at(i)->current_grad()->GetAccTensor());
     }
   }
-  JUST((*backward_fn_)(output_grads, &input_grads, create_graph));
+  JUST((*backward_fn_)(output_grads, input_grads, create_graph));
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> FunctionNode::PushInputGrads(const TensorTuple& input_grads) {
   for (int i = 0; i < input_meta_data_.size(); ++i) {
     if (input_grads.at(i)) {
       CHECK_NOTNULL_OR_RETURN(input_meta_data_.at(i))
@@ -184,6 +235,14 @@ Maybe<bool> FunctionNode::Apply(bool create_graph) {
       JUST(input_meta_data_.at(i)->current_grad()->PushPartialTensor(input_grads.at(i)));
     }
   }
+  return Maybe<void>::Ok();
+}
+
+Maybe<bool> FunctionNode::Apply(bool create_graph) {
+  if (!JUST(IsReadyToApply())) { return false; }
+  TensorTuple input_grads(input_meta_data_.size());
+  JUST(ComputeInputGrads(create_graph, &input_grads));
+  JUST(PushInputGrads(input_grads));
   return true;
 }
 
@@ -255,11 +314,10 @@ Maybe<TensorTuple> StackAutogradEngine::RunBackwardAndReturnInputsTensorGrad(
   return input_current_grad;
 }
 
-Maybe<FunctionNode> StackAutogradEngine::AddBackwardFuncPtr(
-    const std::string& op_type_name,
-    const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
-        backward_fn,
-    const TensorTuple& inputs, TensorTuple* outputs) {
+Maybe<FunctionNode> StackAutogradEngine::AddBackwardFuncPtr(const std::string& op_type_name,
+                                                    const BackwardFunction& backward_fn,
+                                                    const TensorTuple& inputs,
+                                                    TensorTuple* outputs) {
   // Firstly push function_node of tensor in stack which is leaf and requires_grad
   for (const std::shared_ptr<Tensor>& in_tensor : inputs) {
     if (in_tensor->is_leaf() && in_tensor->requires_grad()) {
@@ -273,8 +331,8 @@ Maybe<FunctionNode> StackAutogradEngine::AddBackwardFuncPtr(
     }
   }
 
-  std::shared_ptr<StackFunctionNode> func_node =
-      std::make_shared<StackFunctionNode>(op_type_name, backward_fn, inputs, *outputs);
+  std::shared_ptr<StackFunctionNode> func_node = std::allocate_shared<StackFunctionNode>(
+      RecyclingAllocator<StackFunctionNode>(), op_type_name, backward_fn, inputs, *outputs);
   for (const std::shared_ptr<Tensor>& out_tensor : *outputs) {
     out_tensor->set_grad_fn_node(func_node);
   }
@@ -287,33 +345,10 @@ void GraphFunctionNode::ReleaseData() {
   if (!input_meta_data_.empty()) { backward_fn_.reset(); }
 }
 
-GraphFunctionNode::GraphFunctionNode(
-    const std::string& op_type_name,
-    const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
-        backward_fn,
-    const TensorTuple& inputs, const TensorTuple& outputs)
-    : FunctionNode(op_type_name) {
-  input_meta_data_.resize(inputs.size());
-  next_functions_->reserve(inputs.size());
-  for (int i = 0; i < inputs.size(); ++i) {
-    if (inputs.at(i)->requires_grad()) {
-      input_meta_data_.at(i) = inputs.at(i)->mut_autograd_meta();
-      next_functions_->emplace_back(inputs.at(i)->mut_grad_fn_node());
-    }
-  }
-
-  output_meta_data_.resize(outputs.size());
-  output_tensor_infos_.reserve(outputs.size());
-  for (int i = 0; i < outputs.size(); ++i) {
-    const auto& autograd_meta =
-        NewAutogradMeta(outputs.at(i)->requires_grad(), outputs.at(i)->is_leaf());
-    outputs.at(i)->set_autograd_meta(autograd_meta);
-    output_meta_data_.at(i) = outputs.at(i)->mut_autograd_meta();
-    output_tensor_infos_.emplace_back(TensorInfo(*outputs.at(i)));
-  }
-
-  backward_fn_ = backward_fn;
-}
+GraphFunctionNode::GraphFunctionNode(const std::string& op_type_name,
+                                     const BackwardFunction& backward_fn,
+                                     const TensorTuple& inputs, const TensorTuple& outputs)
+    : FunctionNode(op_type_name, backward_fn, inputs, outputs) {}
 
 GraphTask::GraphTask(const TensorTuple& outputs, bool retain_graph, bool create_graph)
     : retain_graph_(retain_graph), create_graph_(create_graph) {
@@ -398,32 +433,129 @@ Maybe<void> GraphTask::ComputeDependenciesAndPruneNode(const TensorTuple& inputs
   return Maybe<void>::Ok();
 }
 
+bool GraphTask::IsPruned(FunctionNode* node) const {
+  return !need_execute_.empty() && need_execute_.find(node) == need_execute_.end();
+}
+
+Maybe<void> GraphTask::FinishNode(FunctionNode* node, bool save_grad_for_leaf,
+                                  const std::function<void(FunctionNode*)>& Ready) {
+  if (save_grad_for_leaf) { JUST(node->AccGrad4LeafTensor(create_graph_)); }
+  JUST(node->AccGrad4RetainGradTensor());
+  node->ReleaseOutTensorArgs();
+  if (!retain_graph_) { node->ReleaseData(); }
+
+  for (const auto& next_grad_fn : *(node->GetNextFunctions())) {
+    FunctionNode* next_node = next_grad_fn.get();
+    dependencies_[next_node] -= 1;
+    if (dependencies_[next_node] == 0) { Ready(next_node); }
+  }
+  return Maybe<void>::Ok();
+}
+
 Maybe<void> GraphTask::Apply(bool save_grad_for_leaf) {
+  ThreadPool* thread_pool = BackwardThreadPool();
+  if (thread_pool != nullptr && CanApplyInParallel()) {
+    return ParallelApply(save_grad_for_leaf, thread_pool);
+  }
   std::queue<FunctionNode*> queue;
   for (FunctionNode* node : roots_) {
     if (dependencies_[node] == 0) { queue.push(node); }
   }
+  const auto& Ready = [&](FunctionNode* node) { queue.push(node); };
 
   while (!queue.empty()) {
     FunctionNode* node = queue.front();
     queue.pop();
-    if (!need_execute_.empty() && need_execute_.find(node) == need_execute_.end()) {
+    if (IsPruned(node)) {
       node->ReleaseOutTensorArgs();
       continue;
     }
     if (/*bool not_ready_to_apply=*/!(JUST(node->Apply(create_graph_)))) { continue; }
-    if (save_grad_for_leaf) { JUST(node->AccGrad4LeafTensor(create_graph_)); }
-    JUST(node->AccGrad4RetainGradTensor());
-    node->ReleaseOutTensorArgs();
-    if (!retain_graph_) { node->ReleaseData(); }
+    JUST(FinishNode(node, save_grad_for_leaf, Ready));
+  }
+  return Maybe<void>::Ok();
+}
 
-    for (const auto& next_grad_fn : *(node->GetNextFunctions())) {
-      FunctionNode* next_node = next_grad_fn.get();
-      dependencies_[next_node] -= 1;
-      if (dependencies_[next_node] == 0) { queue.push(next_node); }
+// Backward ops of consistent tensors communicate with other ranks, so they are interpreted by
+// the calling thread in the same order on all ranks. So are the ops building a graph for higher
+// order derivatives, and the ops traced or recorded by the calling thread. Custom functions may
+// run Python code, which needs the GIL held by the calling thread. In lazy mode the backward ops
+// are added to the job being built, which needs the lazy mode and the scope of the calling thread.
+bool GraphTask::CanApplyInParallel() const {
+  if (create_graph_ || LazyMode::is_enabled() || CurrentEagerTrace() != nullptr
+      || debug::RecordingInstructions()) {
+    return false;
+  }
+  return std::none_of(dependencies_.begin(), dependencies_.end(),
+                      [](const std::pair<FunctionNode* const, int>& pair) {
+                        return pair.first->has_consistent_output()
+                               || pair.first->is_custom_function();
+                      });
+}
+
+// Nodes are taken from the ready queue in the same order as the sequential loop in `Apply`, and
+// their input grads are computed by the thread pool. The calling thread pushes the input grads,
+// accumulates the grads of leaf tensors and runs the hooks in that order, so the results do not
+// depend on how the computations are scheduled.
+Maybe<void> GraphTask::ParallelApply(bool save_grad_for_leaf, ThreadPool* thread_pool) {
+  std::queue<FunctionNode*> ready_queue;
+  for (FunctionNode* node : roots_) {
+    if (dependencies_[node] == 0) { ready_queue.push(node); }
+  }
+  const auto& Ready = [&](FunctionNode* node) { ready_queue.push(node); };
+  std::queue<std::unique_ptr<ComputingNode>> computing_queue;
+  const bool grad_mode = autograd::GradMode::is_enabled();
+  const bool create_graph = create_graph_;
+
+  const auto& Dispatch = [&](FunctionNode* node) -> Maybe<void> {
+    if (node->GetNextFunctions()->empty()) {
+      // No input grads to propagate, e.g. the AccumulateGrad node of a leaf tensor.
+      auto computing_node = std::make_unique<ComputingNode>(node, /*cnt=*/0);
+      JUST(node->ComputeInputGrads(create_graph, &computing_node->input_grads));
+      computing_queue.push(std::move(computing_node));
+      return Maybe<void>::Ok();
+    }
+    auto computing_node = std::make_unique<ComputingNode>(node, /*cnt=*/1);
+    ComputingNode* raw_computing_node = computing_node.get();
+    computing_queue.push(std::move(computing_node));
+    thread_pool->AddWork([raw_computing_node, grad_mode, create_graph]() {
+      autograd::AutoGradMode mode(grad_mode);
+      const auto& maybe = raw_computing_node->node->ComputeInputGrads(
+          create_graph, &raw_computing_node->input_grads);
+      if (!maybe.IsOk()) { raw_computing_node->error = maybe.error(); }
+      raw_computing_node->counter.Decrease();
+    });
+    return Maybe<void>::Ok();
+  };
+  const auto& Run = [&]() -> Maybe<void> {
+    while (!ready_queue.empty() || !computing_queue.empty()) {
+      while (!ready_queue.empty()) {
+        FunctionNode* node = ready_queue.front();
+        ready_queue.pop();
+        if (IsPruned(node)) {
+          node->ReleaseOutTensorArgs();
+          continue;
+        }
+        if (/*bool not_ready_to_apply=*/!JUST(node->IsReadyToApply())) { continue; }
+        JUST(Dispatch(node));
+      }
+      if (computing_queue.empty()) { break; }
+      std::unique_ptr<ComputingNode> computing_node = std::move(computing_queue.front());
+      computing_queue.pop();
+      computing_node->counter.WaitUntilCntEqualZero();
+      if (computing_node->error) { return computing_node->error; }
+      JUST(computing_node->node->PushInputGrads(computing_node->input_grads));
+      JUST(FinishNode(computing_node->node, save_grad_for_leaf, Ready));
     }
+    return Maybe<void>::Ok();
+  };
+  const auto& maybe = Run();
+  // The works write to the computing nodes, so wait for them even if something went wrong.
+  while (!computing_queue.empty()) {
+    computing_queue.front()->counter.WaitUntilCntEqualZero();
+    computing_queue.pop();
   }
-  return Maybe<void>::Ok();
+  return maybe;
 }
 
 Maybe<void> GraphAutogradEngine::RunBackwardAndSaveGrads4LeafTensor(const TensorTuple& outputs,
@@ -467,11 +599,10 @@ Maybe<TensorTuple> GraphAutogradEngine::RunBackwardAndReturnInputsTensorGrad(
   return input_current_grad;
 }
 
-Maybe<FunctionNode> GraphAutogradEngine::AddBackwardFuncPtr(
-    const std::string& op_type_name,
-    const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
-        backward_fn,
-    const TensorTuple& inputs, TensorTuple* outputs) {
+Maybe<FunctionNode> GraphAutogradEngine::AddBackwardFuncPtr(const std::string& op_type_name,
+                                                    const BackwardFunction& backward_fn,
+                                                    const TensorTuple& inputs,
+                                                    TensorTuple* outputs) {
   // Firstly push function_node of tensor in stack which is leaf and requires_grad
   for (const std::shared_ptr<Tensor>& in_tensor : inputs) {
     if (in_tensor->is_leaf() && in_tensor->requires_grad()) {
@@ -479,8 +610,8 @@ Maybe<FunctionNode> GraphAutogradEngine::AddBackwardFuncPtr(
     }
   }
 
-  std::shared_ptr<FunctionNode> func_node =
-      std::make_shared<GraphFunctionNode>(op_type_name, backward_fn, inputs, *outputs);
+  std::shared_ptr<FunctionNode> func_node = std::allocate_shared<GraphFunctionNode>(
+      RecyclingAllocator<GraphFunctionNode>(), op_type_name, backward_fn, inputs, *outputs);
   for (const std::shared_ptr<Tensor>& out_tensor : *outputs) {
     out_tensor->set_grad_fn_node(func_node);
   }
@@ -494,12 +625,13 @@ AutogradEngine* GetThreadLocalAutogradEngine() {
 }
 
 Maybe<void> AddAccumulateFunctionNode(const std::shared_ptr<Tensor>& tensor) {
-  auto backward_fn =
-      std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
-          [=](const TensorTuple& out_grads, TensorTuple* in_grads,
-              bool create_graph) -> Maybe<void> { return Maybe<void>::Ok(); });
-  tensor->set_grad_fn_node(std::make_shared<StackFunctionNode>(
-      "accumulate_grad", backward_fn, TensorTuple(), TensorTuple({tensor})));
+  static const auto backward_fn = std::make_shared<const BackwardFunction::Function>(
+      [](const TensorTuple& out_grads, TensorTuple* in_grads, bool create_graph) -> Maybe<void> {
+        return Maybe<void>::Ok();
+      });
+  tensor->set_grad_fn_node(std::allocate_shared<StackFunctionNode>(
+      RecyclingAllocator<StackFunctionNode>(), "accumulate_grad", backward_fn, TensorTuple(),
+      TensorTuple({tensor})));
   return Maybe<void>::Ok();
 }
 
@@ -22,14 +22,42 @@ limitations under the License.
 #include <memory>
 #include <functional>
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/small_vector.h"
 #include "oneflow/core/autograd/autograd_meta.h"
 
 namespace oneflow {
 
+class ThreadPool;
+
 namespace one {
 
 class Tensor;
 class TensorTuple;
+class OpExprGradClosure;
+
+// The backward function of a FunctionNode. An OpExprGradClosure captured by an op call is called
+// directly, so recording the op call does not allocate a std::function for it.
+class BackwardFunction final {
+ public:
+  using Function = std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>;
+
+  BackwardFunction() = default;
+  BackwardFunction(const std::shared_ptr<const Function>& function) : function_(function) {}
+  BackwardFunction(const std::shared_ptr<OpExprGradClosure>& grad_closure)
+      : grad_closure_(grad_closure) {}
+
+  explicit operator bool() const { return function_ || grad_closure_; }
+  Maybe<void> operator()(const TensorTuple& out_grads, TensorTuple* in_grads,
+                         bool create_graph) const;
+  void reset() {
+    function_.reset();
+    grad_closure_.reset();
+  }
+
+ private:
+  std::shared_ptr<const Function> function_;
+  std::shared_ptr<OpExprGradClosure> grad_closure_;
+};
 
 // Calculates one backward op
 class FunctionNode {
@@ -37,6 +65,12 @@ class FunctionNode {
   virtual ~FunctionNode() = default;
 
   Maybe<bool> Apply(bool create_graph);
+  // The steps of `Apply`. GraphTask may call ComputeInputGrads on a worker thread, but pushes the
+  // input grads on its own thread in a fixed order so that they are accumulated
+  // deterministically.
+  Maybe<bool> IsReadyToApply() const;
+  Maybe<void> ComputeInputGrads(bool create_graph, TensorTuple* input_grads);
+  Maybe<void> PushInputGrads(const TensorTuple& input_grads);
   Maybe<void> AccGrad4LeafTensor(bool create_graph);
   Maybe<void> AccGrad4RetainGradTensor();
   void ReleaseOutTensorArgs();
@@ -49,21 +83,26 @@ class FunctionNode {
     return next_functions_;
   }
   const std::string& GetOpTypeName() const { return op_type_name_; }
+  bool has_consistent_output() const;
+  // The backward of a user defined autograd.Function may call back into Python, so it has to run
+  // on the thread calling backward, which holds the GIL.
+  bool is_custom_function() const { return is_custom_function_; }
+  void set_is_custom_function(bool is_custom_function) { is_custom_function_ = is_custom_function; }
 
  protected:
-  explicit FunctionNode(const std::string& op_type_name)
-      : op_type_name_(op_type_name),
-        next_functions_(new std::vector<std::shared_ptr<FunctionNode>>{}) {}
+  FunctionNode(const std::string& op_type_name, const BackwardFunction& backward_fn,
+               const TensorTuple& inputs, const TensorTuple& outputs);
 
   const std::string op_type_name_;
   std::shared_ptr<std::vector<std::shared_ptr<FunctionNode>>> next_functions_;
 
-  std::vector<std::shared_ptr<AutogradMeta>> input_meta_data_;
-  std::vector<std::shared_ptr<AutogradMeta>> output_meta_data_;
-  std::vector<TensorInfo> output_tensor_infos_;
+  // Most ops have a few inputs and outputs, whose metas are kept inline.
+  small_vector<std::shared_ptr<AutogradMeta>, 4> input_meta_data_;
+  small_vector<std::shared_ptr<AutogradMeta>, 2> output_meta_data_;
+  small_vector<TensorInfo, 2> output_tensor_infos_;
   // Actual backward function builds in `AutogradInterpreter` to calculate one backward op
-  std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>
-      backward_fn_;
+  BackwardFunction backward_fn_;
+  bool is_custom_function_ = false;
 };
 
 class AutogradEngine {
@@ -79,11 +118,10 @@ class AutogradEngine {
                                                             bool retain_graph, bool create_graph);
   virtual void ClearEngine() = 0;
   // Builds FunctionNode, binding to all `outputs_` tensors and saving in AutogradEngine
-  virtual Maybe<FunctionNode> AddBackwardFuncPtr(
-      const std::string& op_type_name,
-      const std::shared_ptr<
-          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, TensorTuple* outputs) = 0;
+  virtual Maybe<FunctionNode> AddBackwardFuncPtr(const std::string& op_type_name,
+                                                 const BackwardFunction& backward_fn,
+                                                 const TensorTuple& inputs,
+                                                 TensorTuple* outputs) = 0;
 
  protected:
   AutogradEngine() = default;
@@ -103,11 +141,8 @@ class AutogradEngine {
 class StackFunctionNode final : public FunctionNode {
  public:
   OF_DISALLOW_COPY_AND_MOVE(StackFunctionNode);
-  StackFunctionNode(
-      const std::string& op_type_name,
-      const std::shared_ptr<
-          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, const TensorTuple& outputs);
+  StackFunctionNode(const std::string& op_type_name, const BackwardFunction& backward_fn,
+                    const TensorTuple& inputs, const TensorTuple& outputs);
   StackFunctionNode() = delete;
   ~StackFunctionNode() override = default;
 
@@ -126,11 +161,9 @@ class StackAutogradEngine final : public AutogradEngine {
   ~StackAutogradEngine() override = default;
 
   void ClearEngine() override;
-  Maybe<FunctionNode> AddBackwardFuncPtr(
-      const std::string& op_type_name,
-      const std::shared_ptr<
-          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, TensorTuple* outputs) override;
+  Maybe<FunctionNode> AddBackwardFuncPtr(const std::string& op_type_name,
+                                         const BackwardFunction& backward_fn,
+                                         const TensorTuple& inputs, TensorTuple* outputs) override;
 
  private:
   // StackFunctionNode must be saved in engine, because any node in list may be released at any
@@ -151,11 +184,8 @@ class StackAutogradEngine final : public AutogradEngine {
 class GraphFunctionNode final : public FunctionNode {
  public:
   OF_DISALLOW_COPY_AND_MOVE(GraphFunctionNode);
-  GraphFunctionNode(
-      const std::string& op_type_name,
-      const std::shared_ptr<
-          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, const TensorTuple& outputs);
+  GraphFunctionNode(const std::string& op_type_name, const BackwardFunction& backward_fn,
+                    const TensorTuple& inputs, const TensorTuple& outputs);
   GraphFunctionNode() = delete;
   ~GraphFunctionNode() override = default;
 
@@ -173,6 +203,14 @@ class GraphTask final {
   Maybe<void> Apply(bool save_grad_for_leaf);
 
  private:
+  bool CanApplyInParallel() const;
+  Maybe<void> ParallelApply(bool save_grad_for_leaf, ThreadPool* thread_pool);
+  bool IsPruned(FunctionNode* node) const;
+  // Accumulates the grads of an applied node, releases it and calls `Ready` with each next node
+  // whose dependencies are all done.
+  Maybe<void> FinishNode(FunctionNode* node, bool save_grad_for_leaf,
+                         const std::function<void(FunctionNode*)>& Ready);
+
   bool retain_graph_;
   bool create_graph_;
   std::vector<FunctionNode*> roots_;
@@ -187,11 +225,9 @@ class GraphAutogradEngine final : public AutogradEngine {
   ~GraphAutogradEngine() override = default;
 
   void ClearEngine() override{};
-  Maybe<FunctionNode> AddBackwardFuncPtr(
-      const std::string& op_type_name,
-      const std::shared_ptr<
-          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, TensorTuple* outputs) override;
+  Maybe<FunctionNode> AddBackwardFuncPtr(const std::string& op_type_name,
+                                         const BackwardFunction& backward_fn,
+                                         const TensorTuple& inputs, TensorTuple* outputs) override;
 
  private:
   Maybe<void> RunBackwardAndSaveGrads4LeafTensor(const TensorTuple& outputs,
@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/symbol.h"
 #include "oneflow/core/common/optional.h"
+#include "oneflow/core/common/recycling_allocator.h"
 
 namespace oneflow {
 
@@ -48,7 +49,7 @@ class AutogradMeta final {
       : is_leaf_(is_leaf),
         requires_grad_(requires_grad),
         retain_grad_(false),
-        current_grad_(new TensorArg) {}
+        current_grad_(std::allocate_shared<TensorArg>(RecyclingAllocator<TensorArg>())) {}
 
   // Getters
   const std::shared_ptr<Tensor>& acc_grad() const { return acc_grad_; }
@@ -82,7 +83,8 @@ class AutogradMeta final {
 };
 
 inline std::shared_ptr<AutogradMeta> NewAutogradMeta(bool requires_grad, bool is_leaf) {
-  return std::shared_ptr<AutogradMeta>(new AutogradMeta(requires_grad, is_leaf));
+  return std::allocate_shared<AutogradMeta>(RecyclingAllocator<AutogradMeta>(), requires_grad,
+                                            is_leaf);
 }
 
 class TensorInfo final {
@@ -91,6 +93,7 @@ class TensorInfo final {
   explicit TensorInfo(const Tensor& tensor);
 
   Maybe<Tensor> zeros() const;
+  bool is_consistent() const { return parallel_desc_.has_value(); }
 
  private:
   std::shared_ptr<const Shape> shape_;
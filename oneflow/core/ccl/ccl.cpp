@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/ccl/ccl.h"
+#include "oneflow/core/ccl/shm_comm.h"
 #include "oneflow/core/device/nccl_util.h"
 #include "oneflow/core/framework/transport_util.h"
 #include "oneflow/core/job/parallel_desc.h"
@@ -60,6 +61,201 @@ void VecAdd(size_t size, T* out, const T* in0, const T* in1) {
   });
 }
 
+constexpr int64_t kDefaultRecursiveDoublingMaxBytes = 64 * 1024;  // 64KB
+constexpr int64_t kDefaultBinomialTreeMaxBytes = 64 * 1024;       // 64KB
+
+// Ring collectives take 2(N-1) (all reduce) or N-1 (reduce) steps that each move 1/N of the
+// buffer, which is the least traffic but a lot of round trips. Below these sizes the latency
+// dominates, so the algorithms taking log2(N) steps of the whole buffer win.
+bool UseRecursiveDoublingAllReduce(size_t bytes, int64_t parallel_num) {
+  static const int64_t max_bytes = ParseIntegerFromEnv(
+      "ONEFLOW_CCL_CPU_RECURSIVE_DOUBLING_MAX_BYTES", kDefaultRecursiveDoublingMaxBytes);
+  return parallel_num > 1 && static_cast<int64_t>(bytes) <= max_bytes;
+}
+
+bool UseBinomialTree(size_t bytes, int64_t parallel_num) {
+  static const int64_t max_bytes = ParseIntegerFromEnv("ONEFLOW_CCL_CPU_BINOMIAL_TREE_MAX_BYTES",
+                                                       kDefaultBinomialTreeMaxBytes);
+  return parallel_num > 1 && static_cast<int64_t>(bytes) <= max_bytes;
+}
+
+void LogAlgorithm(const std::string& collective, const std::string& algorithm, size_t bytes,
+                  int64_t parallel_num) {
+  VLOG(2) << "ccl " << collective << " of " << bytes << " bytes on " << parallel_num
+          << " ranks uses " << algorithm;
+}
+
+Maybe<int64_t> ParallelId4Rank(const ParallelDesc& parallel_desc, int64_t rank) {
+  for (int64_t parallel_id = 0; parallel_id < parallel_desc.parallel_num(); ++parallel_id) {
+    if (JUST(parallel_desc.MachineId4ParallelId(parallel_id)) == rank) { return parallel_id; }
+  }
+  UNIMPLEMENTED_THEN_RETURN() << "rank " << rank << " not found in parallel desc";
+}
+
+// Sends `send_size` bytes to send_rank and receives `recv_size` bytes from recv_rank at the same
+// time, a rank of -1 skips that side.
+Maybe<void> SendRecv(const TransportToken& transport_token, int64_t send_rank,
+                     const void* send_ptr, size_t send_size, int64_t recv_rank, void* recv_ptr,
+                     size_t recv_size) {
+  NaiveAsyncTransportCtx ctx(
+      transport_token,
+      [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
+        *buffer = const_cast<void*>(send_ptr);
+        *size = send_size;
+        *Cb = [] {};
+        return Maybe<void>::Ok();
+      },
+      [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
+        *buffer = recv_ptr;
+        *size = recv_size;
+        *Cb = [] {};
+        return Maybe<void>::Ok();
+      });
+  if (send_rank != -1) { JUST(TransportUtil::SendDataToRank(send_rank, transport_token, &ctx)); }
+  if (recv_rank != -1) {
+    JUST(TransportUtil::ReceiveDataFromRank(recv_rank, transport_token, &ctx));
+  }
+  JUST(TransportUtil::WaitUntilDoneOrTimeout(ctx, TransportUtil::TimeoutSeconds()));
+  return Maybe<void>::Ok();
+}
+
+// Recursive doubling: in step k every rank exchanges its partial sum with the rank 2^k away and
+// both sides add the same pair, so all ranks end up with identical results. With N not a power
+// of 2, the ranks beyond the largest power of 2 P first hand their buffers to the ranks N-P below
+// them and get the result back at the end.
+template<typename T>
+Maybe<void> RecursiveDoublingAllReduceSum(const T* in, T* out, size_t elem_cnt,
+                                          Symbol<ParallelDesc> parallel_desc) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
+  CHECK_OR_RETURN(opt_parallel_id->has_value());
+  const int64_t parallel_id = JUST(*opt_parallel_id);
+  const auto Rank4ParallelId = [&](int64_t id) { return parallel_desc->MachineId4ParallelId(id); };
+  const size_t size = elem_cnt * sizeof(T);
+  if (out != in) { std::memcpy(out, in, size); }
+  std::vector<T> recv_buffer(elem_cnt);
+  TransportToken transport_token =
+      JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  int64_t pow2_num = 1;
+  while (pow2_num * 2 <= parallel_num) { pow2_num *= 2; }
+  const int64_t rest_num = parallel_num - pow2_num;
+  if (parallel_id >= pow2_num) {
+    const int64_t partner = JUST(Rank4ParallelId(parallel_id - pow2_num));
+    JUST(SendRecv(transport_token, partner, out, size, -1, nullptr, 0));
+    JUST(SendRecv(transport_token, -1, nullptr, 0, partner, out, size));
+    return Maybe<void>::Ok();
+  }
+  if (parallel_id < rest_num) {
+    const int64_t partner = JUST(Rank4ParallelId(parallel_id + pow2_num));
+    JUST(SendRecv(transport_token, -1, nullptr, 0, partner, recv_buffer.data(), size));
+    VecAdd(elem_cnt, out, out, recv_buffer.data());
+  }
+  for (int64_t mask = 1; mask < pow2_num; mask <<= 1) {
+    const int64_t peer = JUST(Rank4ParallelId(parallel_id ^ mask));
+    JUST(SendRecv(transport_token, peer, out, size, peer, recv_buffer.data(), size));
+    VecAdd(elem_cnt, out, out, recv_buffer.data());
+  }
+  if (parallel_id < rest_num) {
+    const int64_t partner = JUST(Rank4ParallelId(parallel_id + pow2_num));
+    JUST(SendRecv(transport_token, partner, out, size, -1, nullptr, 0));
+  }
+  return Maybe<void>::Ok();
+}
+
+// Binomial tree rooted at root_parallel_id: in the virtual ids relative to the root, the parent
+// of v is v with its lowest set bit cleared, so every step doubles the ranks that are done.
+int64_t BinomialTreeVirtualId(int64_t parallel_id, int64_t root_parallel_id,
+                              int64_t parallel_num) {
+  return (parallel_id - root_parallel_id + parallel_num) % parallel_num;
+}
+
+int64_t BinomialTreeParallelId(int64_t virtual_id, int64_t root_parallel_id,
+                               int64_t parallel_num) {
+  return (virtual_id + root_parallel_id) % parallel_num;
+}
+
+template<typename T>
+Maybe<void> BinomialTreeReduceSum(const T* in, T* out, size_t elem_cnt, int64_t root,
+                                  Symbol<ParallelDesc> parallel_desc) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
+  CHECK_OR_RETURN(opt_parallel_id->has_value());
+  const int64_t parallel_id = JUST(*opt_parallel_id);
+  const int64_t root_parallel_id = JUST(ParallelId4Rank(*parallel_desc, root));
+  const int64_t virtual_id = BinomialTreeVirtualId(parallel_id, root_parallel_id, parallel_num);
+  const size_t size = elem_cnt * sizeof(T);
+  // out is only used on rank root
+  std::vector<T> acc_buffer;
+  T* acc = nullptr;
+  if (parallel_id == root_parallel_id) {
+    acc = out;
+  } else {
+    acc_buffer.resize(elem_cnt);
+    acc = acc_buffer.data();
+  }
+  if (acc != in) { std::memcpy(acc, in, size); }
+  std::vector<T> recv_buffer(elem_cnt);
+  TransportToken transport_token =
+      JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  for (int64_t mask = 1; mask < parallel_num; mask <<= 1) {
+    if (virtual_id & mask) {
+      const int64_t parent = JUST(parallel_desc->MachineId4ParallelId(
+          BinomialTreeParallelId(virtual_id - mask, root_parallel_id, parallel_num)));
+      JUST(SendRecv(transport_token, parent, acc, size, -1, nullptr, 0));
+      break;
+    }
+    if (virtual_id + mask < parallel_num) {
+      const int64_t child = JUST(parallel_desc->MachineId4ParallelId(
+          BinomialTreeParallelId(virtual_id + mask, root_parallel_id, parallel_num)));
+      JUST(SendRecv(transport_token, -1, nullptr, 0, child, recv_buffer.data(), size));
+      VecAdd(elem_cnt, acc, acc, recv_buffer.data());
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> BinomialTreeBroadcast(const void* in, void* out, size_t size, int64_t root,
+                                  Symbol<ParallelDesc> parallel_desc) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
+  CHECK_OR_RETURN(opt_parallel_id->has_value());
+  const int64_t parallel_id = JUST(*opt_parallel_id);
+  const int64_t root_parallel_id = JUST(ParallelId4Rank(*parallel_desc, root));
+  const int64_t virtual_id = BinomialTreeVirtualId(parallel_id, root_parallel_id, parallel_num);
+  TransportToken transport_token =
+      JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  int64_t mask = 1;
+  if (virtual_id == 0) {
+    if (out != in) { std::memcpy(out, in, size); }
+    while (mask < parallel_num) { mask <<= 1; }
+  } else {
+    while ((virtual_id & mask) == 0) { mask <<= 1; }
+    const int64_t parent = JUST(parallel_desc->MachineId4ParallelId(
+        BinomialTreeParallelId(virtual_id - mask, root_parallel_id, parallel_num)));
+    JUST(SendRecv(transport_token, -1, nullptr, 0, parent, out, size));
+  }
+  NaiveAsyncTransportCtx ctx(
+      transport_token,
+      [&](void** buffer, std::size_t* buffer_size, std::function<void()>* Cb) -> Maybe<void> {
+        *buffer = out;
+        *buffer_size = size;
+        *Cb = [] {};
+        return Maybe<void>::Ok();
+      },
+      [&](void** buffer, std::size_t* buffer_size, std::function<void()>* Cb) -> Maybe<void> {
+        UNIMPLEMENTED_THEN_RETURN();
+      });
+  for (mask >>= 1; mask > 0; mask >>= 1) {
+    if (virtual_id + mask < parallel_num) {
+      const int64_t child = JUST(parallel_desc->MachineId4ParallelId(
+          BinomialTreeParallelId(virtual_id + mask, root_parallel_id, parallel_num)));
+      JUST(TransportUtil::SendDataToRank(child, transport_token, &ctx));
+    }
+  }
+  JUST(TransportUtil::WaitUntilDoneOrTimeout(ctx, TransportUtil::TimeoutSeconds()));
+  return Maybe<void>::Ok();
+}
+
 }  // namespace
 
 template<typename T, ReduceType reduce_type>
@@ -71,7 +267,18 @@ struct DtypeAllReduce<T, kSum> {
                           Symbol<ParallelDesc> parallel_desc) {
     const T* in = reinterpret_cast<const T*>(void_in);
     T* out = reinterpret_cast<T*>(void_out);
+    ShmComm* shm_comm = JUST(GetShmComm(parallel_desc));
+    if (shm_comm != nullptr) {
+      LogAlgorithm("AllReduce", "shared memory", elem_cnt * sizeof(T),
+                   parallel_desc->parallel_num());
+      return shm_comm->AllReduceSum(in, out, elem_cnt);
+    }
     int64_t parallel_num = parallel_desc->parallel_num();
+    if (UseRecursiveDoublingAllReduce(elem_cnt * sizeof(T), parallel_num)) {
+      LogAlgorithm("AllReduce", "recursive doubling", elem_cnt * sizeof(T), parallel_num);
+      return RecursiveDoublingAllReduceSum(in, out, elem_cnt, parallel_desc);
+    }
+    LogAlgorithm("AllReduce", "ring", elem_cnt * sizeof(T), parallel_num);
     BalancedSplitter bs(elem_cnt, parallel_num);
     std::vector<T> recv_buffer(bs.At(0).size());
     Optional<int64_t> parallel_id;
@@ -174,6 +381,8 @@ struct DtypeReduceScatter<T, kSum> {
                           Symbol<ParallelDesc> parallel_desc) {
     const T* in = reinterpret_cast<const T*>(void_in);
     T* out = reinterpret_cast<T*>(void_out);
+    ShmComm* shm_comm = JUST(GetShmComm(parallel_desc));
+    if (shm_comm != nullptr) { return shm_comm->ReduceScatterSum(in, out, elem_cnt); }
 
     int64_t parallel_num = parallel_desc->parallel_num();
     BalancedSplitter bs(elem_cnt * parallel_num, parallel_num);
@@ -248,6 +457,8 @@ Maybe<void> AllGather<DeviceType::kCPU>(const void* in, void* out, size_t elem_c
   char* char_out = reinterpret_cast<char*>(out);
   int64_t parallel_num = parallel_desc->parallel_num();
   size_t chunk_size = elem_cnt * GetSizeOfDataType(dtype);
+  ShmComm* shm_comm = JUST(GetShmComm(parallel_desc));
+  if (shm_comm != nullptr) { return shm_comm->AllGather(in, out, chunk_size); }
   BalancedSplitter bs(chunk_size * parallel_num, parallel_num);
   const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
   CHECK_OR_RETURN(opt_parallel_id->has_value());
@@ -298,6 +509,17 @@ Maybe<void> Broadcast<DeviceType::kCPU>(const void* in, void* out, size_t elem_c
   CHECK_EQ_OR_RETURN(parallel_desc->device_type(), DeviceType::kCPU);
   CHECK_OR_RETURN(IsPODDataType(dtype));
   size_t buffer_size = elem_cnt * GetSizeOfDataType(dtype);
+  ShmComm* shm_comm = JUST(GetShmComm(parallel_desc));
+  if (shm_comm != nullptr) {
+    LogAlgorithm("Broadcast", "shared memory", buffer_size, parallel_desc->parallel_num());
+    const int64_t root_parallel_id = JUST(ParallelId4Rank(*parallel_desc, root));
+    return shm_comm->Broadcast(in, out, buffer_size, root_parallel_id);
+  }
+  if (UseBinomialTree(buffer_size, parallel_desc->parallel_num())) {
+    LogAlgorithm("Broadcast", "binomial tree", buffer_size, parallel_desc->parallel_num());
+    return BinomialTreeBroadcast(in, out, buffer_size, root, parallel_desc);
+  }
+  LogAlgorithm("Broadcast", "heap", buffer_size, parallel_desc->parallel_num());
   const auto& transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
   return CpuBroadcast(in, out, buffer_size, root, parallel_desc, transport_token);
 }
@@ -340,6 +562,11 @@ struct DtypeReduce<T, kSum> {
     T* out = reinterpret_cast<T*>(void_out);
 
     int64_t parallel_num = parallel_desc->parallel_num();
+    if (UseBinomialTree(elem_cnt * sizeof(T), parallel_num)) {
+      LogAlgorithm("Reduce", "binomial tree", elem_cnt * sizeof(T), parallel_num);
+      return BinomialTreeReduceSum(in, out, elem_cnt, root, parallel_desc);
+    }
+    LogAlgorithm("Reduce", "ring", elem_cnt * sizeof(T), parallel_num);
     BalancedSplitter bs(elem_cnt, parallel_num);
 
     size_t size = root == GlobalProcessCtx::Rank() && void_in != void_out ? 0 : bs.At(0).size();
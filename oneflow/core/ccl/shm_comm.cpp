@@ -0,0 +1,299 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cerrno>
+#include <cstring>
+#include "oneflow/core/ccl/shm_comm.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/rpc/include/global_process_ctx.h"
+#include "oneflow/core/thread/thread_consistent_id.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace oneflow {
+
+namespace ccl {
+
+namespace {
+
+constexpr size_t kShmPageSize = 4096;
+constexpr int64_t kDefaultShmBufferSize = 4 * 1024 * 1024;  // 4MB
+// the same as TransportUtil::TimeoutSeconds()
+constexpr int64_t kShmTimeoutSeconds = 5 * 60;
+constexpr int64_t kShmSpinCntBetweenTimeoutChecks = 1024;
+
+Maybe<void> SpinUntil(const std::function<bool()>& Done, const std::string& what) {
+  if (Done()) { return Maybe<void>::Ok(); }
+  const auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 1; !Done(); ++i) {
+    std::this_thread::yield();
+    if (i % kShmSpinCntBetweenTimeoutChecks == 0) {
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      CHECK_LT_OR_RETURN(elapsed.count(), kShmTimeoutSeconds)
+          << Error::TimeoutError() << "Timeout error at " << kShmTimeoutSeconds
+          << " seconds waiting for " << what;
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+ShmComm::ShmComm(const std::string& name, int64_t slot, int64_t slot_num, size_t buffer_size,
+                 char* ptr, size_t segment_size)
+    : name_(name),
+      slot_(slot),
+      slot_num_(slot_num),
+      buffer_size_(buffer_size),
+      ptr_(ptr),
+      buffers_(ptr + RoundUp(sizeof(Header) + slot_num * sizeof(SlotCtrl), kShmPageSize)),
+      segment_size_(segment_size),
+      step_(0),
+      calling_thread_id_(std::thread::id()) {}
+
+ShmComm::~ShmComm() {
+#ifdef __linux__
+  munmap(ptr_, segment_size_);
+  if (slot_ == 0) { shm_unlink(name_.c_str()); }
+#endif  // __linux__
+}
+
+size_t ShmComm::SegmentSize(int64_t slot_num, size_t buffer_size) {
+  return RoundUp(sizeof(Header) + slot_num * sizeof(SlotCtrl), kShmPageSize)
+         + slot_num * buffer_size;
+}
+
+std::unique_ptr<ShmComm> ShmComm::Create(const std::string& name, int64_t slot_num,
+                                         size_t buffer_size) {
+#ifdef __linux__
+  buffer_size = RoundUp(buffer_size, kShmPageSize);
+  const size_t segment_size = SegmentSize(slot_num, buffer_size);
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    PLOG(WARNING) << "Fail to create shared memory " << name;
+    return nullptr;
+  }
+  // allocate the pages now, a full /dev/shm would raise SIGBUS on first touch otherwise
+  if (ftruncate(fd, segment_size) != 0 || posix_fallocate(fd, 0, segment_size) != 0) {
+    LOG(WARNING) << "Fail to allocate " << segment_size << " bytes of shared memory " << name;
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  void* ptr = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED) {
+    PLOG(WARNING) << "Fail to map shared memory " << name;
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  std::unique_ptr<ShmComm> comm(
+      new ShmComm(name, 0, slot_num, buffer_size, static_cast<char*>(ptr), segment_size));
+  new (comm->header()) Header();
+  comm->header()->opened_cnt.store(0);
+  FOR_RANGE(int64_t, i, 0, slot_num) {
+    new (comm->slot_ctrl(i)) SlotCtrl();
+    comm->slot_ctrl(i)->step.store(0);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  return comm;
+#else
+  return nullptr;
+#endif  // __linux__
+}
+
+Maybe<void> ShmComm::Open(const std::string& name, int64_t slot, int64_t slot_num,
+                          size_t buffer_size, std::unique_ptr<ShmComm>* comm) {
+#ifdef __linux__
+  CHECK_GT_OR_RETURN(slot, 0);
+  CHECK_LT_OR_RETURN(slot, slot_num);
+  buffer_size = RoundUp(buffer_size, kShmPageSize);
+  const size_t segment_size = SegmentSize(slot_num, buffer_size);
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  CHECK_GE_OR_RETURN(fd, 0) << "Fail to open shared memory " << name << ": "
+                            << std::strerror(errno);
+  struct stat st {};
+  const bool stat_ok = fstat(fd, &st) == 0;
+  const int stat_errno = errno;
+  void* ptr = MAP_FAILED;
+  if (stat_ok && static_cast<size_t>(st.st_size) == segment_size) {
+    ptr = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const int mmap_errno = errno;
+  close(fd);
+  CHECK_OR_RETURN(stat_ok) << "Fail to stat shared memory " << name << ": "
+                           << std::strerror(stat_errno);
+  CHECK_EQ_OR_RETURN(static_cast<size_t>(st.st_size), segment_size)
+      << "unexpected size of shared memory " << name;
+  CHECK_OR_RETURN(ptr != MAP_FAILED)
+      << "Fail to map shared memory " << name << ": " << std::strerror(mmap_errno);
+  comm->reset(
+      new ShmComm(name, slot, slot_num, buffer_size, static_cast<char*>(ptr), segment_size));
+  (*comm)->header()->opened_cnt.fetch_add(1);
+  return Maybe<void>::Ok();
+#else
+  UNIMPLEMENTED_THEN_RETURN();
+#endif  // __linux__
+}
+
+Maybe<void> ShmComm::UnlinkWhenAllOpened() {
+  CHECK_EQ_OR_RETURN(slot_, 0);
+  JUST(SpinUntil([&]() { return header()->opened_cnt.load() == slot_num_ - 1; },
+                 "peers opening shared memory " + name_));
+#ifdef __linux__
+  shm_unlink(name_.c_str());
+#endif  // __linux__
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> ShmComm::Barrier() {
+  std::thread::id calling_thread_id;
+  if (!calling_thread_id_.compare_exchange_strong(calling_thread_id,
+                                                  std::this_thread::get_id())) {
+    CHECK_EQ_OR_RETURN(calling_thread_id, std::this_thread::get_id())
+        << "shared memory " << name_ << " is used by more than one thread";
+  }
+  step_ += 1;
+  slot_ctrl(slot_)->step.store(step_, std::memory_order_release);
+  FOR_RANGE(int64_t, i, 0, slot_num_) {
+    if (i == slot_) { continue; }
+    const std::atomic<int64_t>& step = slot_ctrl(i)->step;
+    JUST(SpinUntil([&]() { return step.load(std::memory_order_acquire) >= step_; },
+                   "slot " + std::to_string(i) + " of shared memory " + name_));
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> ShmComm::AllGather(const void* in, void* out, size_t size) {
+  const char* char_in = static_cast<const char*>(in);
+  char* char_out = static_cast<char*>(out);
+  for (size_t offset = 0; offset < size; offset += buffer_size_) {
+    const size_t n = std::min(buffer_size_, size - offset);
+    std::memcpy(buffer(slot_), char_in + offset, n);
+    JUST(Barrier());
+    FOR_RANGE(int64_t, i, 0, slot_num_) {
+      std::memcpy(char_out + i * size + offset, buffer(i), n);
+    }
+    JUST(Barrier());
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> ShmComm::Broadcast(const void* in, void* out, size_t size, int64_t root_slot) {
+  const char* char_in = static_cast<const char*>(in);
+  char* char_out = static_cast<char*>(out);
+  if (slot_ == root_slot && out != in) { std::memcpy(out, in, size); }
+  for (size_t offset = 0; offset < size; offset += buffer_size_) {
+    const size_t n = std::min(buffer_size_, size - offset);
+    if (slot_ == root_slot) { std::memcpy(buffer(slot_), char_in + offset, n); }
+    JUST(Barrier());
+    if (slot_ != root_slot) { std::memcpy(char_out + offset, buffer(root_slot), n); }
+    JUST(Barrier());
+  }
+  return Maybe<void>::Ok();
+}
+
+namespace {
+
+// Guarded by its own mutex, so that the rendezvous of a communicator does not block the lookup
+// of the others.
+struct ShmCommEntry {
+  std::mutex mutex;
+  bool initialized = false;
+  std::unique_ptr<ShmComm> comm;
+};
+
+// Runs the rendezvous of the processes of parallel_desc. Leaves comm empty if they can not share
+// memory.
+Maybe<void> InitShmComm(Symbol<ParallelDesc> parallel_desc, int64_t thread_consistent_id,
+                        std::unique_ptr<ShmComm>* comm) {
+  static std::mutex mutex;
+  static HashMap<std::string, int64_t> ranks2comm_cnt;
+  static std::atomic<int64_t> segment_cnt(0);
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  if (parallel_desc->sorted_machine_ids().size() != parallel_num) { return Maybe<void>::Ok(); }
+  std::string ranks;
+  FOR_RANGE(int64_t, parallel_id, 0, parallel_num) {
+    const int64_t rank = JUST(parallel_desc->MachineId4ParallelId(parallel_id));
+    if (GlobalProcessCtx::NodeId(rank) != GlobalProcessCtx::ThisNodeId()) {
+      return Maybe<void>::Ok();
+    }
+    ranks += std::to_string(rank) + ",";
+  }
+  const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
+  if (!opt_parallel_id->has_value()) { return Maybe<void>::Ok(); }
+  const int64_t slot = JUST(*opt_parallel_id);
+  // the threads of a thread_consistent_id create their communicators of the same ranks in the
+  // same order in all the processes
+  ranks += "-" + std::to_string(thread_consistent_id);
+  int64_t comm_cnt = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    comm_cnt = ranks2comm_cnt[ranks]++;
+  }
+  const std::string key = "CclShmComm-" + ranks + "-" + std::to_string(comm_cnt);
+  const size_t buffer_size =
+      ParseIntegerFromEnv("ONEFLOW_CCL_SHM_BUFFER_SIZE_BYTES", kDefaultShmBufferSize);
+  if (slot == 0) {
+    const std::string name = "/oneflow-ccl-" + std::to_string(getpid()) + "-"
+                             + std::to_string(segment_cnt++);
+    *comm = ShmComm::Create(name, parallel_num, buffer_size);
+    // an empty name makes the peers fall back to the transport too
+    Global<CtrlClient>::Get()->PushKV(key, *comm ? name : "");
+    if (*comm) { JUST((*comm)->UnlinkWhenAllOpened()); }
+  } else {
+    std::string name;
+    Global<CtrlClient>::Get()->PullKV(key, &name);
+    if (!name.empty()) { JUST(ShmComm::Open(name, slot, parallel_num, buffer_size, comm)); }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+Maybe<ShmComm*> GetShmComm(Symbol<ParallelDesc> parallel_desc) {
+  static const bool use_shm = ParseBooleanFromEnv("ONEFLOW_CCL_CPU_USE_SHM", true);
+  if (!use_shm || parallel_desc->parallel_num() <= 1) { return nullptr; }
+  // the collective boxing worker and the eager transport streams run collectives of the same
+  // ranks concurrently, so each of them gets its own communicator
+  const int64_t thread_consistent_id = JUST(GetThisThreadConsistentId());
+  static std::mutex mutex;
+  static HashMap<std::pair<Symbol<ParallelDesc>, int64_t>, std::unique_ptr<ShmCommEntry>>
+      key2entry;
+  ShmCommEntry* entry = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<ShmCommEntry>& entry_ptr =
+        key2entry[std::make_pair(parallel_desc, thread_consistent_id)];
+    if (!entry_ptr) { entry_ptr.reset(new ShmCommEntry()); }
+    entry = entry_ptr.get();
+  }
+  std::lock_guard<std::mutex> entry_lock(entry->mutex);
+  if (!entry->initialized) {
+    JUST(InitShmComm(parallel_desc, thread_consistent_id, &entry->comm));
+    entry->initialized = true;
+  }
+  return entry->comm.get();
+}
+
+}  // namespace ccl
+
+}  // namespace oneflow
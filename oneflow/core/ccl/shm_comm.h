@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_CCL_SHM_COMM_H_
+#define ONEFLOW_CORE_CCL_SHM_COMM_H_
+
+#include <atomic>
+#include <thread>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+class ParallelDesc;
+
+namespace ccl {
+
+// Collectives among the processes of one host through a POSIX shared memory segment.
+//
+// Every process owns a slot of the segment, made of a step counter and a staging buffer.
+// A collective runs in rounds of at most one buffer: each process copies its part of the input
+// to its own buffer, then reads the buffers of its peers in place, reducing straight out of
+// them. The steps of a round are separated by barriers on the step counters.
+//
+// All the processes have to call the same collectives in the same order, from one thread each.
+// A communicator binds to the first thread calling a collective on it and fails on any other.
+class ShmComm final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmComm);
+  ~ShmComm();
+
+  // Creates the segment as slot 0. Returns nullptr when it can not be allocated.
+  static std::unique_ptr<ShmComm> Create(const std::string& name, int64_t slot_num,
+                                         size_t buffer_size);
+  // Opens the segment created by slot 0.
+  static Maybe<void> Open(const std::string& name, int64_t slot, int64_t slot_num,
+                          size_t buffer_size, std::unique_ptr<ShmComm>* comm);
+
+  // Called by slot 0 after Create, removes the name of the segment once all the slots opened it,
+  // so that the segment goes away with the processes.
+  Maybe<void> UnlinkWhenAllOpened();
+
+  int64_t slot() const { return slot_; }
+  int64_t slot_num() const { return slot_num_; }
+  size_t buffer_size() const { return buffer_size_; }
+
+  template<typename T>
+  Maybe<void> AllReduceSum(const T* in, T* out, size_t elem_cnt);
+  // `in` holds slot_num blocks of elem_cnt elements, `out` gets the sum of the blocks of slot().
+  template<typename T>
+  Maybe<void> ReduceScatterSum(const T* in, T* out, size_t elem_cnt);
+  // `out` gets the `size` bytes of `in` of every slot, in slot order.
+  Maybe<void> AllGather(const void* in, void* out, size_t size);
+  Maybe<void> Broadcast(const void* in, void* out, size_t size, int64_t root_slot);
+
+ private:
+  struct alignas(64) SlotCtrl {
+    std::atomic<int64_t> step;
+  };
+  struct alignas(64) Header {
+    std::atomic<int64_t> opened_cnt;
+  };
+
+  ShmComm(const std::string& name, int64_t slot, int64_t slot_num, size_t buffer_size, char* ptr,
+          size_t segment_size);
+  static size_t SegmentSize(int64_t slot_num, size_t buffer_size);
+
+  Header* header() const { return reinterpret_cast<Header*>(ptr_); }
+  SlotCtrl* slot_ctrl(int64_t slot) const {
+    return reinterpret_cast<SlotCtrl*>(ptr_ + sizeof(Header)) + slot;
+  }
+  char* buffer(int64_t slot) const { return buffers_ + slot * buffer_size_; }
+
+  // Waits until every slot reaches the next step.
+  Maybe<void> Barrier();
+
+  const std::string name_;
+  const int64_t slot_;
+  const int64_t slot_num_;
+  const size_t buffer_size_;
+  char* ptr_;
+  char* buffers_;
+  const size_t segment_size_;
+  int64_t step_;
+  std::atomic<std::thread::id> calling_thread_id_;
+};
+
+// Returns the communicator of the processes of parallel_desc for the thread_consistent_id of the
+// calling thread, which every one of them creates on its first call. Returns nullptr if they are
+// not all on this host, some process has more than one device of parallel_desc, or
+// ONEFLOW_CCL_CPU_USE_SHM=0.
+Maybe<ShmComm*> GetShmComm(Symbol<ParallelDesc> parallel_desc);
+
+namespace detail {
+
+constexpr size_t kShmReduceBlockSize = 256;
+
+// dst may be one of srcs, so every block is summed up on the stack first
+template<typename T>
+void SumOfSlots(const std::vector<const T*>& srcs, size_t offset, size_t elem_cnt, T* dst) {
+  T block[kShmReduceBlockSize];
+  for (size_t begin = 0; begin < elem_cnt; begin += kShmReduceBlockSize) {
+    const size_t n = std::min(kShmReduceBlockSize, elem_cnt - begin);
+    const T* src0 = srcs.at(0) + offset + begin;
+    for (size_t i = 0; i < n; ++i) { block[i] = src0[i]; }
+    for (size_t k = 1; k < srcs.size(); ++k) {
+      const T* src = srcs.at(k) + offset + begin;
+      for (size_t i = 0; i < n; ++i) { block[i] += src[i]; }
+    }
+    std::memcpy(dst + begin, block, n * sizeof(T));
+  }
+}
+
+}  // namespace detail
+
+template<typename T>
+Maybe<void> ShmComm::AllReduceSum(const T* in, T* out, size_t elem_cnt) {
+  const size_t round_elem_cnt = buffer_size_ / sizeof(T);
+  CHECK_GT_OR_RETURN(round_elem_cnt, 0);
+  std::vector<const T*> srcs(slot_num_);
+  FOR_RANGE(int64_t, i, 0, slot_num_) { srcs.at(i) = reinterpret_cast<const T*>(buffer(i)); }
+  T* own_buffer = reinterpret_cast<T*>(buffer(slot_));
+  for (size_t offset = 0; offset < elem_cnt; offset += round_elem_cnt) {
+    const size_t n = std::min(round_elem_cnt, elem_cnt - offset);
+    std::memcpy(own_buffer, in + offset, n * sizeof(T));
+    JUST(Barrier());
+    // every slot reduces its share of the round and leaves the sum in its own buffer
+    BalancedSplitter bs(n, slot_num_);
+    const Range share = bs.At(slot_);
+    detail::SumOfSlots(srcs, share.begin(), share.size(), own_buffer + share.begin());
+    JUST(Barrier());
+    FOR_RANGE(int64_t, i, 0, slot_num_) {
+      std::memcpy(out + offset + bs.At(i).begin(), srcs.at(i) + bs.At(i).begin(),
+                  bs.At(i).size() * sizeof(T));
+    }
+    JUST(Barrier());
+  }
+  return Maybe<void>::Ok();
+}
+
+template<typename T>
+Maybe<void> ShmComm::ReduceScatterSum(const T* in, T* out, size_t elem_cnt) {
+  const size_t round_elem_cnt = buffer_size_ / sizeof(T) / slot_num_;
+  CHECK_GT_OR_RETURN(round_elem_cnt, 0);
+  std::vector<const T*> srcs(slot_num_);
+  FOR_RANGE(int64_t, i, 0, slot_num_) { srcs.at(i) = reinterpret_cast<const T*>(buffer(i)); }
+  T* own_buffer = reinterpret_cast<T*>(buffer(slot_));
+  for (size_t offset = 0; offset < elem_cnt; offset += round_elem_cnt) {
+    const size_t n = std::min(round_elem_cnt, elem_cnt - offset);
+    FOR_RANGE(int64_t, i, 0, slot_num_) {
+      std::memcpy(own_buffer + i * n, in + i * elem_cnt + offset, n * sizeof(T));
+    }
+    JUST(Barrier());
+    detail::SumOfSlots(srcs, slot_ * n, n, out + offset);
+    JUST(Barrier());
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace ccl
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_CCL_SHM_COMM_H_
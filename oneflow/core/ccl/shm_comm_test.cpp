@@ -0,0 +1,225 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "oneflow/core/ccl/shm_comm.h"
+
+namespace oneflow {
+namespace ccl {
+namespace test {
+
+namespace {
+
+// Runs Fn on slot_num processes with comm_num communicators among them, slot 0 on the calling
+// one.
+void RunOnProcesses(int64_t slot_num, size_t buffer_size, int64_t comm_num,
+                    const std::function<void(const std::vector<ShmComm*>&)>& Fn) {
+  static int64_t comm_cnt = 0;
+  std::vector<std::string> names;
+  std::vector<std::unique_ptr<ShmComm>> comms;
+  FOR_RANGE(int64_t, i, 0, comm_num) {
+    names.emplace_back("/oneflow-ccl-test-" + std::to_string(getpid()) + "-"
+                       + std::to_string(comm_cnt++));
+    comms.emplace_back(ShmComm::Create(names.back(), slot_num, buffer_size));
+    ASSERT_TRUE(comms.back());
+  }
+  std::vector<pid_t> children;
+  FOR_RANGE(int64_t, slot, 1, slot_num) {
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      std::vector<std::unique_ptr<ShmComm>> child_comms;
+      std::vector<ShmComm*> child_comm_ptrs;
+      FOR_RANGE(int64_t, i, 0, comm_num) {
+        // the copy of slot 0 must not remove the name of the segment
+        comms.at(i).release();
+        child_comms.emplace_back();
+        CHECK_JUST(ShmComm::Open(names.at(i), slot, slot_num, buffer_size, &child_comms.back()));
+        child_comm_ptrs.emplace_back(child_comms.back().get());
+      }
+      Fn(child_comm_ptrs);
+      child_comms.clear();
+      _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+    children.emplace_back(pid);
+  }
+  std::vector<ShmComm*> comm_ptrs;
+  for (const auto& comm : comms) {
+    CHECK_JUST(comm->UnlinkWhenAllOpened());
+    comm_ptrs.emplace_back(comm.get());
+  }
+  Fn(comm_ptrs);
+  for (pid_t pid : children) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+  }
+}
+
+void RunOnProcesses(int64_t slot_num, size_t buffer_size,
+                    const std::function<void(ShmComm*)>& Fn) {
+  RunOnProcesses(slot_num, buffer_size, 1,
+                 [&](const std::vector<ShmComm*>& comms) { Fn(comms.at(0)); });
+}
+
+int64_t Value(int64_t slot, size_t i) { return slot * 1000003 + i * 7 + 1; }
+
+}  // namespace
+
+TEST(ShmComm, collectives) {
+  constexpr int64_t kSlotNum = 3;
+  // one page of buffer, so that the larger sizes take several rounds
+  RunOnProcesses(kSlotNum, 4096, [&](ShmComm* comm) {
+    const int64_t slot = comm->slot();
+    for (size_t elem_cnt : {1, 7, 512, 513, 5000}) {
+      std::vector<int64_t> in(elem_cnt);
+      FOR_RANGE(size_t, i, 0, elem_cnt) { in.at(i) = Value(slot, i); }
+      std::vector<int64_t> out(elem_cnt);
+      CHECK_JUST(comm->AllReduceSum(in.data(), out.data(), elem_cnt));
+      FOR_RANGE(size_t, i, 0, elem_cnt) {
+        int64_t sum = 0;
+        FOR_RANGE(int64_t, s, 0, kSlotNum) { sum += Value(s, i); }
+        ASSERT_EQ(out.at(i), sum);
+      }
+      // in place
+      CHECK_JUST(comm->AllReduceSum(in.data(), in.data(), elem_cnt));
+      ASSERT_EQ(in, out);
+
+      std::vector<float> scatter_in(elem_cnt * kSlotNum);
+      FOR_RANGE(size_t, i, 0, scatter_in.size()) { scatter_in.at(i) = Value(slot, i) % 1024; }
+      std::vector<float> scatter_out(elem_cnt);
+      CHECK_JUST(comm->ReduceScatterSum(scatter_in.data(), scatter_out.data(), elem_cnt));
+      FOR_RANGE(size_t, i, 0, elem_cnt) {
+        float sum = 0;
+        FOR_RANGE(int64_t, s, 0, kSlotNum) { sum += Value(s, slot * elem_cnt + i) % 1024; }
+        ASSERT_EQ(scatter_out.at(i), sum);
+      }
+
+      std::vector<int64_t> gather_out(elem_cnt * kSlotNum);
+      std::vector<int64_t> gather_in(elem_cnt);
+      FOR_RANGE(size_t, i, 0, elem_cnt) { gather_in.at(i) = Value(slot, i); }
+      CHECK_JUST(comm->AllGather(gather_in.data(), gather_out.data(),
+                                 elem_cnt * sizeof(int64_t)));
+      FOR_RANGE(int64_t, s, 0, kSlotNum) {
+        FOR_RANGE(size_t, i, 0, elem_cnt) {
+          ASSERT_EQ(gather_out.at(s * elem_cnt + i), Value(s, i));
+        }
+      }
+
+      FOR_RANGE(int64_t, root, 0, kSlotNum) {
+        std::vector<int64_t> broadcast_out(elem_cnt);
+        CHECK_JUST(comm->Broadcast(gather_in.data(), broadcast_out.data(),
+                                   elem_cnt * sizeof(int64_t), root));
+        FOR_RANGE(size_t, i, 0, elem_cnt) { ASSERT_EQ(broadcast_out.at(i), Value(root, i)); }
+      }
+    }
+  });
+}
+
+TEST(ShmComm, one_comm_per_calling_thread) {
+  constexpr int64_t kSlotNum = 3;
+  constexpr int64_t kThreadNum = 2;
+  // like the collective boxing worker and an eager transport stream, every process runs the
+  // collectives of two threads at the same time, each thread on its own communicator
+  RunOnProcesses(kSlotNum, 4096, kThreadNum, [&](const std::vector<ShmComm*>& comms) {
+    std::vector<std::thread> threads;
+    std::atomic<int64_t> failed_cnt(0);
+    FOR_RANGE(int64_t, t, 0, kThreadNum) {
+      threads.emplace_back([&, t]() {
+        ShmComm* comm = comms.at(t);
+        FOR_RANGE(int64_t, iter, 0, 200) {
+          const size_t elem_cnt = 1 + (iter * 131 + t * 977) % 2000;
+          std::vector<int64_t> in(elem_cnt);
+          FOR_RANGE(size_t, i, 0, elem_cnt) { in.at(i) = Value(comm->slot(), i + t); }
+          std::vector<int64_t> out(elem_cnt);
+          CHECK_JUST(comm->AllReduceSum(in.data(), out.data(), elem_cnt));
+          FOR_RANGE(size_t, i, 0, elem_cnt) {
+            int64_t sum = 0;
+            FOR_RANGE(int64_t, s, 0, kSlotNum) { sum += Value(s, i + t); }
+            if (out.at(i) != sum) { ++failed_cnt; }
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    ASSERT_EQ(failed_cnt, 0);
+  });
+}
+
+TEST(ShmComm, fail_on_second_calling_thread) {
+  const std::string name = "/oneflow-ccl-test-" + std::to_string(getpid()) + "-shared";
+  std::unique_ptr<ShmComm> comm = ShmComm::Create(name, 1, 4096);
+  ASSERT_TRUE(comm);
+  int64_t in = 1;
+  int64_t out = 0;
+  ASSERT_TRUE(TRY(comm->AllGather(&in, &out, sizeof(in))).IsOk());
+  ASSERT_EQ(out, 1);
+  std::thread([&]() {
+    ASSERT_FALSE(TRY(comm->AllGather(&in, &out, sizeof(in))).IsOk());
+  }).join();
+  ASSERT_TRUE(TRY(comm->AllGather(&in, &out, sizeof(in))).IsOk());
+}
+
+TEST(ShmComm, open_fails_without_abort) {
+  const std::string name = "/oneflow-ccl-test-" + std::to_string(getpid()) + "-open";
+  std::unique_ptr<ShmComm> opened;
+  ASSERT_FALSE(TRY(ShmComm::Open(name, 1, 2, 4096, &opened)).IsOk());
+  ASSERT_FALSE(opened);
+  std::unique_ptr<ShmComm> comm = ShmComm::Create(name, 2, 4096);
+  ASSERT_TRUE(comm);
+  // the size of the segment follows from slot_num and buffer_size, a mismatch is an error
+  ASSERT_FALSE(TRY(ShmComm::Open(name, 1, 3, 4096, &opened)).IsOk());
+  ASSERT_FALSE(TRY(ShmComm::Open(name, 2, 2, 4096, &opened)).IsOk());
+  ASSERT_FALSE(opened);
+  ASSERT_TRUE(TRY(ShmComm::Open(name, 1, 2, 4096, &opened)).IsOk());
+  ASSERT_TRUE(opened);
+  ASSERT_TRUE(TRY(comm->UnlinkWhenAllOpened()).IsOk());
+}
+
+TEST(ShmComm, benchmark) {
+  constexpr int64_t kSlotNum = 4;
+  RunOnProcesses(kSlotNum, 4 * 1024 * 1024, [&](ShmComm* comm) {
+    for (size_t size = 4096; size <= 64 * 1024 * 1024; size *= 4) {
+      const size_t elem_cnt = size / sizeof(float);
+      std::vector<float> in(elem_cnt, 1);
+      std::vector<float> out(elem_cnt);
+      const int64_t iter_num = std::max<int64_t>(256 * 1024 * 1024 / size, 4);
+      CHECK_JUST(comm->AllReduceSum(in.data(), out.data(), elem_cnt));
+      const auto start = std::chrono::steady_clock::now();
+      FOR_RANGE(int64_t, i, 0, iter_num) {
+        CHECK_JUST(comm->AllReduceSum(in.data(), out.data(), elem_cnt));
+      }
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      ASSERT_EQ(out.at(elem_cnt - 1), kSlotNum);
+      if (comm->slot() == 0) {
+        const double seconds = elapsed.count() / iter_num;
+        // bus bandwidth as nccl-tests reports it
+        const double bus_bytes = 2.0 * (kSlotNum - 1) / kSlotNum * size;
+        LOG(INFO) << "all reduce of " << size << " bytes on " << kSlotNum << " processes: "
+                  << seconds * 1e6 << " us, bus bandwidth " << bus_bytes / seconds / 1e9
+                  << " GB/s";
+      }
+    }
+  });
+}
+
+}  // namespace test
+}  // namespace ccl
+}  // namespace oneflow
@@ -0,0 +1,219 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+#define ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+// Multi-producer single-consumer channel with the same interface as Channel.
+//
+// Send goes to a bounded lock-free ring (Vyukov's sequence-numbered slots), so producers never
+// take a lock on the fast path. When the ring is full, items go to a mutex-protected overflow
+// queue; once the overflow is in use all producers keep using it until the consumer has drained
+// it, so that items from one producer are always received in the order they were sent.
+//
+// The consumer spins for a while before sleeping on a condition variable. The spin budget adapts:
+// it grows when spinning found items and shrinks when the consumer had to sleep anyway.
+template<typename T>
+class MpscChannel final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpscChannel);
+  explicit MpscChannel(size_t capacity);
+  MpscChannel()
+      : MpscChannel(ParseIntegerFromEnv("ONEFLOW_MPSC_CHANNEL_CAPACITY", kDefaultCapacity)) {}
+  ~MpscChannel() = default;
+
+  template<typename U>
+  ChannelStatus Send(U&& item);
+  ChannelStatus ReceiveMany(std::queue<T>* items);
+  void Close();
+
+ private:
+  static constexpr size_t kDefaultCapacity = 4096;
+  static constexpr int64_t kMinSpinCnt = 16;
+  static constexpr int64_t kMaxSpinCnt = 4096;
+
+  struct Slot {
+    std::atomic<size_t> seq;
+    T item;
+  };
+
+  template<typename U>
+  bool TryPushToRing(U&& item);
+  size_t DrainRing(std::queue<T>* items);
+  size_t TryReceiveMany(std::queue<T>* items);
+  bool RingNotEmpty() const {
+    return slots_[head_ & mask_].seq.load(std::memory_order_acquire) == head_ + 1;
+  }
+  void NotifyConsumerIfSleeping();
+
+  std::vector<Slot> slots_;
+  const size_t mask_;
+  std::atomic<size_t> tail_;
+  // keeps the producers' CAS on tail_ away from the consumer's cache line
+  char padding_[64];
+  // only accessed by the consumer
+  size_t head_;
+  int64_t spin_cnt_;
+
+  std::atomic<bool> overflowed_;
+  std::atomic<bool> consumer_sleeping_;
+  std::atomic<bool> is_closed_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::queue<T> overflow_queue_;
+};
+
+template<typename T>
+constexpr size_t MpscChannel<T>::kDefaultCapacity;
+template<typename T>
+constexpr int64_t MpscChannel<T>::kMinSpinCnt;
+template<typename T>
+constexpr int64_t MpscChannel<T>::kMaxSpinCnt;
+
+template<typename T>
+MpscChannel<T>::MpscChannel(size_t capacity)
+    : slots_(capacity),
+      mask_(capacity - 1),
+      tail_(0),
+      head_(0),
+      spin_cnt_(kMaxSpinCnt),
+      overflowed_(false),
+      consumer_sleeping_(false),
+      is_closed_(false) {
+  CHECK_GT(capacity, 0);
+  CHECK_EQ(capacity & (capacity - 1), 0) << "capacity must be a power of 2";
+  FOR_RANGE(size_t, i, 0, capacity) { slots_[i].seq.store(i, std::memory_order_relaxed); }
+}
+
+template<typename T>
+template<typename U>
+bool MpscChannel<T>::TryPushToRing(U&& item) {
+  size_t pos = tail_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const size_t seq = slot->seq.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->item = std::forward<U>(item);
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+template<typename U>
+ChannelStatus MpscChannel<T>::Send(U&& item) {
+  if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+  if (overflowed_.load(std::memory_order_acquire) || !TryPushToRing(std::forward<U>(item))) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_closed_.load(std::memory_order_relaxed)) { return kChannelStatusErrorClosed; }
+    overflow_queue_.push(std::forward<U>(item));
+    overflowed_.store(true, std::memory_order_release);
+  }
+  NotifyConsumerIfSleeping();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+void MpscChannel<T>::NotifyConsumerIfSleeping() {
+  // pairs with the fence in ReceiveMany, either the consumer sees the new item or we see it
+  // sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!consumer_sleeping_.load(std::memory_order_relaxed)) { return; }
+  { std::unique_lock<std::mutex> lock(mutex_); }
+  cond_.notify_one();
+}
+
+template<typename T>
+size_t MpscChannel<T>::DrainRing(std::queue<T>* items) {
+  size_t cnt = 0;
+  while (RingNotEmpty()) {
+    Slot* slot = &slots_[head_ & mask_];
+    items->push(std::move(slot->item));
+    slot->seq.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    ++cnt;
+  }
+  return cnt;
+}
+
+template<typename T>
+size_t MpscChannel<T>::TryReceiveMany(std::queue<T>* items) {
+  size_t cnt = DrainRing(items);
+  // Overflowed items are newer than everything a producer put into the ring before, so they are
+  // only taken when every claimed slot has been received. An empty ring is not enough: a slot
+  // claimed but not yet published would hide the published ones behind it. A producer claims its
+  // slot before it pushes to the overflow queue under mutex_, so reading tail_ under mutex_ sees
+  // the claims of all the overflowed items' producers.
+  if (cnt == 0 && overflowed_.load(std::memory_order_acquire)) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (tail_.load(std::memory_order_relaxed) != head_) { return 0; }
+    while (!overflow_queue_.empty()) {
+      items->push(std::move(overflow_queue_.front()));
+      overflow_queue_.pop();
+      ++cnt;
+    }
+    overflowed_.store(false, std::memory_order_release);
+  }
+  return cnt;
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::ReceiveMany(std::queue<T>* items) {
+  while (true) {
+    for (int64_t i = 0; i < spin_cnt_; ++i) {
+      if (TryReceiveMany(items) > 0) {
+        spin_cnt_ = std::min(spin_cnt_ * 2, kMaxSpinCnt);
+        return kChannelStatusSuccess;
+      }
+      std::this_thread::yield();
+    }
+    spin_cnt_ = std::max(spin_cnt_ / 2, kMinSpinCnt);
+    std::unique_lock<std::mutex> lock(mutex_);
+    consumer_sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cond_.wait(lock, [this]() {
+      return RingNotEmpty() || !overflow_queue_.empty()
+             || is_closed_.load(std::memory_order_relaxed);
+    });
+    consumer_sleeping_.store(false, std::memory_order_relaxed);
+    lock.unlock();
+    if (TryReceiveMany(items) > 0) { return kChannelStatusSuccess; }
+    if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+  }
+}
+
+template<typename T>
+void MpscChannel<T>::Close() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  is_closed_.store(true, std::memory_order_release);
+  cond_.notify_all();
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_RECYCLING_ALLOCATOR_H_
+#define ONEFLOW_CORE_COMMON_RECYCLING_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <glog/logging.h>
+#include "oneflow/core/common/cpp_attribute.h"
+
+namespace oneflow {
+
+// An allocator for std::allocate_shared, which keeps the memory of deallocated objects in a
+// thread local free list and hands it out again to the next allocations of the same type on that
+// thread. Objects freed by another thread go to the free list of that thread. Suits short-lived
+// objects created at a high rate, e.g. the autograd graph rebuilt by every iteration.
+template<typename T>
+class RecyclingAllocator final {
+ public:
+  using value_type = T;
+
+  RecyclingAllocator() = default;
+  template<typename U>
+  RecyclingAllocator(const RecyclingAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (likely(n == 1)) {
+      auto* free_list = ThreadLocalFreeList();
+      if (likely(free_list != nullptr && !free_list->empty())) {
+        void* ptr = free_list->back();
+        free_list->pop_back();
+        return static_cast<T*>(ptr);
+      }
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (likely(n == 1)) {
+      auto* free_list = ThreadLocalFreeList();
+      if (likely(free_list != nullptr && free_list->size() < kMaxFreeNum)) {
+        free_list->push_back(ptr);
+        return;
+      }
+    }
+    ::operator delete(ptr);
+  }
+
+  template<typename U>
+  bool operator==(const RecyclingAllocator<U>&) const {
+    return true;
+  }
+  template<typename U>
+  bool operator!=(const RecyclingAllocator<U>&) const {
+    return false;
+  }
+
+ private:
+  static constexpr size_t kMaxFreeNum = 4096;
+
+  struct FreeList final {
+    ~FreeList() {
+      for (void* ptr : blocks) { ::operator delete(ptr); }
+      *IsDestroyed() = true;
+    }
+    std::vector<void*> blocks;
+  };
+
+  static bool* IsDestroyed() {
+    static thread_local bool is_destroyed = false;
+    return &is_destroyed;
+  }
+
+  // Returns nullptr once the free list has been destroyed at thread exit.
+  static std::vector<void*>* ThreadLocalFreeList() {
+    if (unlikely(*IsDestroyed())) { return nullptr; }
+    static thread_local FreeList free_list;
+    return &free_list.blocks;
+  }
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_RECYCLING_ALLOCATOR_H_
@@ -0,0 +1,54 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/recycling_allocator.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <thread>
+
+namespace oneflow {
+
+namespace test {
+
+struct Foo {
+  explicit Foo(int v) : value(v) {}
+  int value;
+};
+
+TEST(RecyclingAllocator, reuse_memory) {
+  const void* ptr = nullptr;
+  {
+    auto foo = std::allocate_shared<Foo>(RecyclingAllocator<Foo>(), 1);
+    ptr = foo.get();
+  }
+  auto foo = std::allocate_shared<Foo>(RecyclingAllocator<Foo>(), 2);
+  ASSERT_EQ(foo.get(), ptr);
+  ASSERT_EQ(foo->value, 2);
+}
+
+TEST(RecyclingAllocator, free_by_other_thread) {
+  auto foo = std::allocate_shared<Foo>(RecyclingAllocator<Foo>(), 3);
+  const void* ptr = foo.get();
+  std::thread thread([&]() {
+    foo.reset();
+    auto bar = std::allocate_shared<Foo>(RecyclingAllocator<Foo>(), 4);
+    ASSERT_EQ(bar.get(), ptr);
+  });
+  thread.join();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,275 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_SMALL_VECTOR_H_
+#define ONEFLOW_CORE_COMMON_SMALL_VECTOR_H_
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <glog/logging.h>
+#include "oneflow/core/common/cpp_attribute.h"
+
+namespace oneflow {
+
+// A vector keeping up to kInlineSize elements in itself, and moving them to the heap only when it
+// grows beyond that. Unlike fixed_vector, it holds any number of elements and constructs only the
+// elements in use, so it also suits element types like std::shared_ptr.
+template<typename T, size_t kInlineSize>
+class small_vector {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  small_vector() : data_(inline_data()), size_(0), capacity_(kInlineSize) {}
+  explicit small_vector(size_type size) : small_vector() { resize(size); }
+  small_vector(size_type size, const T& value) : small_vector() { resize(size, value); }
+  template<class InputIt, typename = typename std::enable_if<std::is_convertible<
+                              typename std::iterator_traits<InputIt>::iterator_category,
+                              std::input_iterator_tag>::value>::type>
+  small_vector(InputIt first, InputIt last) : small_vector() {
+    for (; first != last; ++first) { emplace_back(*first); }
+  }
+  small_vector(std::initializer_list<T> ilist) : small_vector(ilist.begin(), ilist.end()) {}
+  small_vector(const small_vector& rhs) : small_vector(rhs.begin(), rhs.end()) {}
+  small_vector(small_vector&& rhs) noexcept : small_vector() { MoveFrom(&rhs); }
+  ~small_vector() {
+    clear();
+    if (!is_inline()) { FreeData(data_); }
+  }
+
+  small_vector& operator=(const small_vector& rhs) {
+    if (this != &rhs) { assign(rhs.begin(), rhs.end()); }
+    return *this;
+  }
+  small_vector& operator=(small_vector&& rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      MoveFrom(&rhs);
+    }
+    return *this;
+  }
+  small_vector& operator=(std::initializer_list<T> ilist) {
+    assign(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  template<class InputIt>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) { emplace_back(*first); }
+  }
+  void assign(size_type count, const T& value) {
+    clear();
+    resize(count, value);
+  }
+
+  // Throws std::out_of_range like std::vector, so python bindings can map it to IndexError.
+  reference at(size_type pos) {
+    if (pos >= size_) { ThrowOutOfRange(pos); }
+    return data_[pos];
+  }
+  const_reference at(size_type pos) const {
+    if (pos >= size_) { ThrowOutOfRange(pos); }
+    return data_[pos];
+  }
+  reference operator[](size_type pos) { return data_[pos]; }
+  const_reference operator[](size_type pos) const { return data_[pos]; }
+  reference front() { return data_[0]; }
+  const_reference front() const { return data_[0]; }
+  reference back() { return data_[size_ - 1]; }
+  const_reference back() const { return data_[size_ - 1]; }
+
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type capacity() const noexcept { return capacity_; }
+  bool is_inline() const noexcept { return data_ == inline_data(); }
+
+  void reserve(size_type capacity) {
+    if (capacity <= capacity_) { return; }
+    T* new_data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+    std::uninitialized_copy(std::make_move_iterator(begin()), std::make_move_iterator(end()),
+                            new_data);
+    DestroyRange(begin(), end());
+    if (!is_inline()) { FreeData(data_); }
+    data_ = new_data;
+    capacity_ = capacity;
+  }
+
+  void clear() noexcept {
+    DestroyRange(begin(), end());
+    size_ = 0;
+  }
+
+  template<class... Args>
+  reference emplace_back(Args&&... args) {
+    if (unlikely(size_ == capacity_)) { return GrowAndEmplaceBack(std::forward<Args>(args)...); }
+    new (data_ + size_) T(std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void pop_back() {
+    --size_;
+    data_[size_].~T();
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  template<class InputIt, typename = typename std::enable_if<std::is_convertible<
+                              typename std::iterator_traits<InputIt>::iterator_category,
+                              std::input_iterator_tag>::value>::type>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    const size_type index = pos - begin();
+    const size_type old_size = size_;
+    for (; first != last; ++first) { emplace_back(*first); }
+    std::rotate(begin() + index, begin() + old_size, end());
+    return begin() + index;
+  }
+  template<class... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    const size_type index = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + index, end() - 1, end());
+    return begin() + index;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator mut_first = begin() + (first - begin());
+    iterator mut_last = begin() + (last - begin());
+    iterator new_end = std::move(mut_last, end(), mut_first);
+    DestroyRange(new_end, end());
+    size_ = new_end - begin();
+    return mut_first;
+  }
+
+  void resize(size_type count) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      reserve(count);
+      while (size_ < count) { emplace_back(); }
+    }
+  }
+  void resize(size_type count, const T& value) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      reserve(count);
+      while (size_ < count) { emplace_back(value); }
+    }
+  }
+
+  void swap(small_vector& rhs) {
+    small_vector tmp(std::move(rhs));
+    rhs = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  bool operator==(const small_vector& rhs) const {
+    return size() == rhs.size() && std::equal(begin(), end(), rhs.begin());
+  }
+  bool operator!=(const small_vector& rhs) const { return !(*this == rhs); }
+  bool operator<(const small_vector& rhs) const {
+    return std::lexicographical_compare(begin(), end(), rhs.begin(), rhs.end());
+  }
+
+ private:
+  T* inline_data() noexcept { return reinterpret_cast<T*>(&inline_storage_); }
+  const T* inline_data() const noexcept { return reinterpret_cast<const T*>(&inline_storage_); }
+
+  static void DestroyRange(T* first, T* last) {
+    for (; first != last; ++first) { first->~T(); }
+  }
+  static void FreeData(T* data) { ::operator delete(data); }
+  [[noreturn]] void ThrowOutOfRange(size_type pos) const {
+    throw std::out_of_range("small_vector::at: pos (which is " + std::to_string(pos)
+                            + ") >= size (which is " + std::to_string(size_) + ")");
+  }
+
+  // The new element is constructed before the old ones are moved, because args may refer to them.
+  template<class... Args>
+  reference GrowAndEmplaceBack(Args&&... args) {
+    const size_type new_capacity = std::max<size_type>(capacity_ * 2, 1);
+    T* new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+    new (new_data + size_) T(std::forward<Args>(args)...);
+    std::uninitialized_copy(std::make_move_iterator(begin()), std::make_move_iterator(end()),
+                            new_data);
+    DestroyRange(begin(), end());
+    if (!is_inline()) { FreeData(data_); }
+    data_ = new_data;
+    capacity_ = new_capacity;
+    return data_[size_++];
+  }
+
+  // Takes the heap data of rhs if any, otherwise moves its elements one by one.
+  void MoveFrom(small_vector* rhs) {
+    if (rhs->is_inline()) {
+      for (T& value : *rhs) { emplace_back(std::move(value)); }
+      rhs->clear();
+      return;
+    }
+    if (!is_inline()) { FreeData(data_); }
+    data_ = rhs->data_;
+    size_ = rhs->size_;
+    capacity_ = rhs->capacity_;
+    rhs->data_ = rhs->inline_data();
+    rhs->size_ = 0;
+    rhs->capacity_ = kInlineSize;
+  }
+
+  typename std::aligned_storage<sizeof(T) * kInlineSize, alignof(T)>::type inline_storage_;
+  T* data_;
+  size_type size_;
+  size_type capacity_;
+};
+
+template<typename T, size_t kInlineSize>
+void swap(small_vector<T, kInlineSize>& lhs, small_vector<T, kInlineSize>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_SMALL_VECTOR_H_
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/small_vector.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <vector>
+
+namespace oneflow {
+
+namespace test {
+
+using SmallVec = small_vector<int, 4>;
+
+TEST(small_vector, constructor) {
+  SmallVec a(3, 7);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_TRUE(a.is_inline());
+  ASSERT_TRUE(std::all_of(a.begin(), a.end(), [](int x) { return x == 7; }));
+  SmallVec b{1, 2, 3, 4, 5, 6};
+  ASSERT_EQ(b.size(), 6);
+  ASSERT_FALSE(b.is_inline());
+  std::vector<int> vec{1, 2, 3, 4, 5, 6};
+  ASSERT_TRUE(std::equal(b.begin(), b.end(), vec.begin()));
+}
+
+TEST(small_vector, copy_and_move) {
+  for (int size : {2, 9}) {
+    SmallVec a;
+    for (int i = 0; i < size; ++i) { a.push_back(i); }
+    SmallVec b(a);
+    ASSERT_EQ(a, b);
+    SmallVec c(std::move(b));
+    ASSERT_EQ(a, c);
+    ASSERT_TRUE(b.empty());
+    SmallVec d{42};
+    d = c;
+    ASSERT_EQ(a, d);
+    SmallVec e{1, 2, 3, 4, 5, 6, 7, 8};
+    e = std::move(d);
+    ASSERT_EQ(a, e);
+  }
+}
+
+TEST(small_vector, grow_beyond_inline_size) {
+  SmallVec a;
+  for (int i = 0; i < 100; ++i) {
+    a.push_back(i);
+    ASSERT_EQ(a.is_inline(), a.size() <= 4);
+  }
+  for (int i = 0; i < 100; ++i) { ASSERT_EQ(a.at(i), i); }
+  ASSERT_THROW(a.at(100), std::out_of_range);
+  // Pushes an element of the vector itself while it reallocates.
+  SmallVec b{1, 2, 3, 4};
+  b.push_back(b.back());
+  ASSERT_EQ(b.back(), 4);
+}
+
+TEST(small_vector, insert_and_erase) {
+  SmallVec a{1, 2, 5};
+  a.insert(a.begin() + 2, 4);
+  a.insert(a.begin() + 2, 3);
+  ASSERT_EQ(a, SmallVec({1, 2, 3, 4, 5}));
+  std::vector<int> vec{6, 7};
+  a.insert(a.end(), vec.begin(), vec.end());
+  ASSERT_EQ(a, SmallVec({1, 2, 3, 4, 5, 6, 7}));
+  a.erase(a.begin() + 1, a.begin() + 3);
+  ASSERT_EQ(a, SmallVec({1, 4, 5, 6, 7}));
+  a.erase(a.begin());
+  ASSERT_EQ(a, SmallVec({4, 5, 6, 7}));
+  a.resize(2);
+  ASSERT_EQ(a, SmallVec({4, 5}));
+  a.resize(6, 1);
+  ASSERT_EQ(a, SmallVec({4, 5, 1, 1, 1, 1}));
+}
+
+TEST(small_vector, destroy_elements) {
+  auto ptr = std::make_shared<int>(0);
+  {
+    small_vector<std::shared_ptr<int>, 2> a;
+    for (int i = 0; i < 5; ++i) { a.push_back(ptr); }
+    ASSERT_EQ(ptr.use_count(), 6);
+    a.pop_back();
+    a.erase(a.begin());
+    ASSERT_EQ(ptr.use_count(), 4);
+    small_vector<std::shared_ptr<int>, 2> b(std::move(a));
+    ASSERT_EQ(ptr.use_count(), 4);
+    b.resize(1);
+    ASSERT_EQ(ptr.use_count(), 2);
+  }
+  ASSERT_EQ(ptr.use_count(), 1);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -31,7 +31,15 @@ inline void CheckTensorBufferDataType(DataType val) {
 class TensorBuffer {
  public:
   struct Deleter {
-    void operator()(void* ptr) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    void operator()(void* ptr) {
+      if (holder) {
+        holder.reset();
+      } else {
+        MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr);
+      }
+    }
+    // set when data_ is a view of memory owned by holder, see ResetView
+    std::shared_ptr<const void> holder;
   };
   typedef std::unique_ptr<void, Deleter> BufferType;
 
@@ -58,6 +66,7 @@ class TensorBuffer {
   template<typename T = void>
   inline T* mut_data() {
     if (data_ == nullptr) { return nullptr; }
+    CHECK(!is_view()) << "TensorBuffer view is read only.";
     CheckDataType<T>(data_type_);
     return static_cast<T*>(data_.get());
   }
@@ -76,6 +85,21 @@ class TensorBuffer {
     num_bytes_ = 0;
   }
 
+  // Makes this buffer a read only view of size bytes at ptr, which stays valid while holder is
+  // alive. A view has zero capacity, so any later Resize allocates a buffer of its own.
+  void ResetView(const void* ptr, const Shape& shape, DataType data_type,
+                 std::shared_ptr<const void> holder) {
+    CheckTensorBufferDataType(data_type);
+    CHECK(holder);
+    data_.reset();
+    data_ = BufferType(const_cast<void*>(ptr), Deleter{std::move(holder)});
+    num_bytes_ = 0;
+    shape_ = shape;
+    data_type_ = data_type;
+  }
+
+  bool is_view() const { return static_cast<bool>(data_.get_deleter().holder); }
+
   void reserve(size_t new_num_bytes) {
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
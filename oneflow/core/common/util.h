@@ -136,9 +136,13 @@ void SortAndRemoveDuplication(std::vector<T>* vec) {
   vec->erase(unique_it, vec->end());
 }
 
-inline std::string NewUniqueId() {
+inline std::atomic<int64_t>* MutUniqueIdCounter() {
   static std::atomic<int64_t> counter(0);
-  return std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+  return &counter;
+}
+
+inline std::string NewUniqueId() {
+  return std::to_string(MutUniqueIdCounter()->fetch_add(1, std::memory_order_relaxed));
 }
 
 template<typename K, typename V>
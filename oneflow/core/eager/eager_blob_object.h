@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/common/maybe.h"
 #include "oneflow/core/common/optional.h"
+#include "oneflow/core/common/small_vector.h"
 #include "oneflow/core/eager/blob_object.h"
 #include "oneflow/core/eager/local_dep_object.h"
 #include "oneflow/core/memory/memory_allocator.h"
@@ -141,6 +142,15 @@ class EagerBlobObject final : public BlobObject {
 };
 
 }  // namespace vm
+
+namespace one {
+
+// Most ops have at most 4 inputs or outputs, whose blob objects are then kept inline.
+using EagerBlobObjectList = small_vector<std::shared_ptr<vm::EagerBlobObject>, 4>;
+using EagerBlobObjectListPtr = std::shared_ptr<const EagerBlobObjectList>;
+
+}  // namespace one
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_EAGER_EAGER_BLOB_OBJECT_H_
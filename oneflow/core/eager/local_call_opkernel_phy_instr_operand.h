@@ -28,10 +28,6 @@ namespace one {
 class StatefulLocalOpKernel;
 class ConsistentTensorInferResult;
 
-using EagerBlobObjectList = std::vector<std::shared_ptr<vm::EagerBlobObject>>;
-using EagerBlobObjectListPtr =
-    std::shared_ptr<const std::vector<std::shared_ptr<vm::EagerBlobObject>>>;
-
 }  // namespace one
 
 namespace user_op {
@@ -15,6 +15,15 @@ limitations under the License.
 */
 #include "oneflow/core/ep/common/primitive/permute.h"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/primitive/batch_transpose.h"
+#include "oneflow/core/ep/include/primitive/permute.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
@@ -75,6 +84,136 @@ TEST(Permute, SimplifyPermutation) {
                                         simplified_permutation_3);
 }
 
+template<size_t elem_size>
+void NaiveBatchTranspose(int64_t num_batches, int64_t rows, int64_t cols, const void* src,
+                         void* dst) {
+  using T = typename std::aligned_storage<elem_size, elem_size>::type;
+  const T* src_ptr = reinterpret_cast<const T*>(src);
+  T* dst_ptr = reinterpret_cast<T*>(dst);
+  NdIndexOffsetHelper<int64_t, 3> src_index_helper(num_batches, rows, cols);
+  NdIndexOffsetHelper<int64_t, 3> dst_index_helper(num_batches, cols, rows);
+  for (int64_t i = 0; i < num_batches * rows * cols; ++i) {
+    int64_t batch = 0;
+    int64_t col = 0;
+    int64_t row = 0;
+    dst_index_helper.OffsetToNdIndex(i, batch, col, row);
+    dst_ptr[i] = src_ptr[src_index_helper.NdIndexToOffset(batch, row, col)];
+  }
+}
+
+template<typename F>
+double GigabytesPerSecond(int64_t bytes, const F& Run) {
+  Run();
+  constexpr int kRepeat = 5;
+  double best_seconds = 0;
+  for (int i = 0; i < kRepeat; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    Run();
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    if (i == 0 || seconds.count() < best_seconds) { best_seconds = seconds.count(); }
+  }
+  // Every byte is read once and written once.
+  return 2.0 * bytes / best_seconds / 1e9;
+}
+
+template<size_t elem_size>
+void TestBatchTranspose(int64_t num_batches, int64_t rows, int64_t cols) {
+  const int64_t bytes = num_batches * rows * cols * elem_size;
+  std::vector<unsigned char> src(bytes);
+  for (int64_t i = 0; i < bytes; ++i) { src[i] = static_cast<unsigned char>(i * 7 + i / 13); }
+  std::vector<unsigned char> expected(bytes);
+  const double naive_throughput = GigabytesPerSecond(bytes, [&]() {
+    NaiveBatchTranspose<elem_size>(num_batches, rows, cols, src.data(), expected.data());
+  });
+  std::ostringstream report;
+  report << "batch transpose " << elem_size << "-byte [" << num_batches << ", " << rows << ", "
+         << cols << "]: naive " << naive_throughput << " GB/s";
+  for (CpuIsa isa : {CpuIsa::kScalar, CpuIsa::kSse41, CpuIsa::kAvx2}) {
+    if (!IsCpuIsaSupported(isa)) { continue; }
+    const BatchTransposeFunc batch_transpose = GetBatchTransposeFunc(elem_size, isa);
+    const int64_t num_tiles = GetBatchTransposeNumTiles(elem_size, num_batches, rows, cols);
+    std::vector<unsigned char> dst(bytes);
+    const double throughput = GigabytesPerSecond(bytes, [&]() {
+      batch_transpose(num_batches, rows, cols, src.data(), dst.data(), 0, num_tiles);
+    });
+    ASSERT_EQ(std::memcmp(dst.data(), expected.data(), bytes), 0) << CpuIsaToString(isa);
+    report << ", tiled " << CpuIsaToString(isa) << " " << throughput << " GB/s";
+  }
+  LOG(INFO) << report.str();
+}
+
+TEST(Permute, BatchTransposeThroughput) {
+  // 2-D transpose, NCHW -> NHWC and [batch, seq, heads * head_size] -> attention heads shapes,
+  // single threaded.
+  TestBatchTranspose<4>(1, 2048, 2048);
+  TestBatchTranspose<4>(8, 64, 56 * 56);
+  TestBatchTranspose<8>(8, 56 * 56, 64);
+  TestBatchTranspose<2>(16, 512, 64);
+  TestBatchTranspose<1>(4, 1000, 999);
+  TestBatchTranspose<16>(8, 128, 129);
+}
+
+// Moves one element at a time, dst offsets are walked in order and mapped back to src.
+void NaivePermute(size_t elem_size, const std::vector<int64_t>& src_dims,
+                  const std::vector<int>& permutation, const unsigned char* src,
+                  unsigned char* dst) {
+  const int64_t num_dims = src_dims.size();
+  std::vector<int64_t> src_strides(num_dims, 1);
+  for (int64_t dim = num_dims - 2; dim >= 0; --dim) {
+    src_strides.at(dim) = src_strides.at(dim + 1) * src_dims.at(dim + 1);
+  }
+  const int64_t count = src_strides.front() * src_dims.front();
+  for (int64_t offset = 0; offset < count; ++offset) {
+    int64_t remaining = offset;
+    int64_t src_offset = 0;
+    for (int64_t dim = num_dims - 1; dim >= 0; --dim) {
+      const int64_t dst_dim_size = src_dims.at(permutation.at(dim));
+      src_offset += (remaining % dst_dim_size) * src_strides.at(permutation.at(dim));
+      remaining /= dst_dim_size;
+    }
+    std::memcpy(dst + offset * elem_size, src + src_offset * elem_size, elem_size);
+  }
+}
+
+void TestCpuPermute(DataType data_type, const std::vector<int64_t>& src_dims,
+                    const std::vector<int>& permutation) {
+  const size_t elem_size = GetSizeOfDataType(data_type);
+  int64_t bytes = elem_size;
+  for (int64_t dim_size : src_dims) { bytes *= dim_size; }
+  std::vector<unsigned char> src(bytes);
+  for (int64_t i = 0; i < bytes; ++i) { src[i] = static_cast<unsigned char>(i * 7 + i / 13); }
+  std::vector<unsigned char> expected(bytes);
+  NaivePermute(elem_size, src_dims, permutation, src.data(), expected.data());
+  std::unique_ptr<Permute> permute =
+      NewPrimitive<PermuteFactory>(DeviceType::kCPU, src_dims.size());
+  ASSERT_TRUE(permute);
+  CpuStream stream(nullptr);
+  std::vector<unsigned char> dst(bytes);
+  permute->Launch(&stream, data_type, src_dims.size(), src_dims.data(), src.data(),
+                  permutation.data(), dst.data());
+  ASSERT_EQ(std::memcmp(dst.data(), expected.data(), bytes), 0)
+      << DataType_Name(data_type) << " " << src_dims.at(0) << "x" << src_dims.at(1) << "x"
+      << src_dims.at(2) << "x" << src_dims.at(3);
+}
+
+TEST(Permute, CpuPermuteKeepingLastDim) {
+  // The last dim stays in place and its bytes do not fit one movement, so the rows are copied by
+  // PermuteRowKernel instead of being folded into a batch transpose.
+  const bool owns_thread_pool = Global<ThreadPool>::Get() == nullptr;
+  if (owns_thread_pool) { Global<ThreadPool>::New(4); }
+  for (DataType data_type :
+       {DataType::kInt8, DataType::kFloat16, DataType::kFloat, DataType::kDouble}) {
+    TestCpuPermute(data_type, {2, 3, 4, 5}, {0, 2, 1, 3});
+    TestCpuPermute(data_type, {4, 8, 16, 12}, {0, 2, 1, 3});
+    TestCpuPermute(data_type, {3, 5, 7, 9}, {2, 0, 1, 3});
+    // enough rows to be split across the thread pool
+    TestCpuPermute(data_type, {8, 64, 128, 5}, {0, 2, 1, 3});
+    // a last dim that fits one movement, which turns this into a batch transpose
+    TestCpuPermute(data_type, {2, 3, 4, 2}, {0, 2, 1, 3});
+  }
+  if (owns_thread_pool) { Global<ThreadPool>::Delete(); }
+}
+
 }  // namespace
 
 }  // namespace permute
@@ -0,0 +1,101 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/common/util.h"
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif  // __x86_64__
+
+namespace oneflow {
+
+namespace ep {
+
+namespace {
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// F16C has no __builtin_cpu_supports name, so read CPUID.1:ECX bit 29 directly
+bool IsF16cSupported() {
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) { return false; }
+  return (ecx & bit_F16C) != 0;
+}
+#endif  // __x86_64__
+
+CpuIsa DetectCpuIsa() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  // the avx2 and avx512 kernels convert half with F16C
+  const bool f16c = IsF16cSupported();
+  if (f16c && __builtin_cpu_supports("avx512f")) { return CpuIsa::kAvx512; }
+  if (f16c && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return CpuIsa::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) { return CpuIsa::kSse41; }
+#endif  // __x86_64__
+  return CpuIsa::kScalar;
+}
+
+CpuIsa CpuIsaFromString(const std::string& isa) {
+  if (isa == "scalar") {
+    return CpuIsa::kScalar;
+  } else if (isa == "sse41") {
+    return CpuIsa::kSse41;
+  } else if (isa == "avx2") {
+    return CpuIsa::kAvx2;
+  } else if (isa == "avx512") {
+    return CpuIsa::kAvx512;
+  } else {
+    LOG(FATAL) << "unknown cpu isa " << isa;
+    return CpuIsa::kScalar;
+  }
+}
+
+}  // namespace
+
+bool IsCpuIsaSupported(CpuIsa isa) {
+  static const CpuIsa detected_isa = DetectCpuIsa();
+  return static_cast<int>(isa) <= static_cast<int>(detected_isa);
+}
+
+CpuIsa GetCpuIsa() {
+  static const CpuIsa isa = []() {
+    CpuIsa detected_isa = DetectCpuIsa();
+    const std::string max_isa = GetStringFromEnv("ONEFLOW_EP_CPU_MAX_ISA", "");
+    if (!max_isa.empty()) {
+      const CpuIsa cap = CpuIsaFromString(max_isa);
+      if (static_cast<int>(cap) < static_cast<int>(detected_isa)) { detected_isa = cap; }
+    }
+    return detected_isa;
+  }();
+  return isa;
+}
+
+std::string CpuIsaToString(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::kScalar: return "scalar";
+    case CpuIsa::kSse41: return "sse41";
+    case CpuIsa::kAvx2: return "avx2";
+    case CpuIsa::kAvx512: return "avx512";
+    default: UNIMPLEMENTED(); return "";
+  }
+}
+
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,46 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+#define ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+
+#include <string>
+
+namespace oneflow {
+
+namespace ep {
+
+// Instruction set levels CPU kernels can be specialized for, ordered by capability.
+enum class CpuIsa {
+  kScalar = 0,
+  kSse41,
+  kAvx2,  // AVX2 + FMA + F16C
+  kAvx512,
+};
+
+// The best level supported by the running CPU, capped by ONEFLOW_EP_CPU_MAX_ISA
+// (one of "scalar", "sse41", "avx2", "avx512").
+CpuIsa GetCpuIsa();
+
+// Whether the running CPU supports `isa`, regardless of ONEFLOW_EP_CPU_MAX_ISA.
+bool IsCpuIsaSupported(CpuIsa isa);
+
+std::string CpuIsaToString(CpuIsa isa);
+
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
@@ -17,6 +17,8 @@ limitations under the License.
 #define ONEFLOW_CORE_EP_CPU_CPU_STREAM_H_
 
 #include "oneflow/core/ep/include/stream.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/platform/include/pthread_fork.h"
 #ifdef WITH_ONEDNN
 #include <oneapi/dnnl/dnnl.hpp>
 #endif
@@ -28,7 +30,11 @@ namespace ep {
 class CpuStream : public Stream {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CpuStream);
-  explicit CpuStream(Device* device) : device_(device) {
+  explicit CpuStream(Device* device)
+      : device_(device),
+        num_threads_(ParseIntegerFromEnv("ONEFLOW_EP_CPU_NUM_THREADS", 0)),
+        parallel_grain_size_(
+            ParseIntegerFromEnv("ONEFLOW_EP_CPU_PARALLEL_GRAIN_SIZE", kDefaultParallelGrainSize)) {
 #ifdef WITH_ONEDNN
     onednn_engine_.reset(new dnnl::engine(dnnl::engine::kind::cpu, 0));
     onednn_stream_.reset(new dnnl::stream(*onednn_engine_));
@@ -42,15 +48,53 @@ class CpuStream : public Stream {
   Maybe<void> Sync() override;
   void RecordEvent(Event* event) override;
 
+  // Number of threads an intra-op parallel loop may use, 0 means as many as the global
+  // ThreadPool has.
+  size_t num_threads() const { return num_threads_; }
+  // Loops of at most this many units stay on the calling thread.
+  size_t parallel_grain_size() const { return parallel_grain_size_; }
+
+  // Calls DoRange on disjoint sub-ranges covering [begin, end), in parallel when the range is
+  // larger than grain_size. DoRange must not depend on how the range is split.
+  template<typename F>
+  void ParallelFor(int64_t begin, int64_t end, const F& DoRange) {
+    ParallelFor(begin, end, DoRange, parallel_grain_size_);
+  }
+  template<typename F>
+  void ParallelFor(int64_t begin, int64_t end, const F& DoRange, size_t grain_size) {
+    if (end <= begin) { return; }
+    const size_t num = end - begin;
+    ThreadPool* thread_pool = Global<ThreadPool>::Get();
+    if (num <= grain_size || thread_pool == nullptr || pthread_fork::IsForkedSubProcess()) {
+      DoRange(begin, end);
+      return;
+    }
+    const size_t num_threads = num_threads_ == 0 ? thread_pool->thread_num() + 1 : num_threads_;
+    if (num_threads <= 1) {
+      DoRange(begin, end);
+      return;
+    }
+    const size_t chunk_size = std::max(grain_size, (num + num_threads - 1) / num_threads);
+    thread_pool->ParallelFor(num, chunk_size, [&](size_t chunk_begin, size_t chunk_end) {
+      DoRange(begin + static_cast<int64_t>(chunk_begin), begin + static_cast<int64_t>(chunk_end));
+    });
+  }
+
 #ifdef WITH_ONEDNN
   dnnl::engine* onednn_engine() const { return onednn_engine_.get(); }
   dnnl::stream* onednn_stream() const { return onednn_stream_.get(); }
+#endif
 
  private:
+  static constexpr size_t kDefaultParallelGrainSize = 32768;
+
+#ifdef WITH_ONEDNN
   std::unique_ptr<dnnl::engine> onednn_engine_;
   std::unique_ptr<dnnl::stream> onednn_stream_;
 #endif
   Device* device_;
+  size_t num_threads_;
+  size_t parallel_grain_size_;
 };
 
 }  // namespace ep
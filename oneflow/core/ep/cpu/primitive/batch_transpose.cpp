@@ -0,0 +1,223 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/batch_transpose.h"
+#include <algorithm>
+#include <type_traits>
+#include "oneflow/core/common/util.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OF_EP_CPU_WITH_X86_SIMD
+#include <immintrin.h>
+#endif  // __x86_64__
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+template<size_t elem_size>
+using Elem = typename std::aligned_storage<elem_size, elem_size>::type;
+
+template<size_t elem_size>
+constexpr int64_t TileSize() {
+  // 32x32 tiles of 4 bytes and 16x16 tiles of 8 bytes are 4KB and 2KB, src and dst tiles together
+  // take a fraction of L1.
+  return elem_size <= 4 ? 32 : 16;
+}
+
+template<typename T>
+void TransposeBlock1x1(const T* src, int64_t src_stride, T* dst, int64_t dst_stride) {
+  *dst = *src;
+}
+
+// Transposes a tile_rows x tile_cols tile with block_size x block_size blocks, the edges that do
+// not fill a block are copied element by element.
+template<typename T, int64_t block_size, void (*TransposeBlock)(const T*, int64_t, T*, int64_t)>
+void TransposeTile(const T* src, int64_t src_stride, T* dst, int64_t dst_stride, int64_t tile_rows,
+                   int64_t tile_cols) {
+  const int64_t block_rows = tile_rows / block_size * block_size;
+  const int64_t block_cols = tile_cols / block_size * block_size;
+  for (int64_t i = 0; i < block_rows; i += block_size) {
+    for (int64_t j = 0; j < block_cols; j += block_size) {
+      TransposeBlock(src + i * src_stride + j, src_stride, dst + j * dst_stride + i, dst_stride);
+    }
+    for (int64_t ii = i; ii < i + block_size; ++ii) {
+      for (int64_t j = block_cols; j < tile_cols; ++j) {
+        dst[j * dst_stride + ii] = src[ii * src_stride + j];
+      }
+    }
+  }
+  for (int64_t i = block_rows; i < tile_rows; ++i) {
+    for (int64_t j = 0; j < tile_cols; ++j) { dst[j * dst_stride + i] = src[i * src_stride + j]; }
+  }
+}
+
+template<size_t elem_size, int64_t block_size,
+         void (*TransposeBlock)(const Elem<elem_size>*, int64_t, Elem<elem_size>*, int64_t)>
+void BatchTransposeTiles(int64_t num_batches, int64_t rows, int64_t cols, const void* src,
+                         void* dst, int64_t tile_begin, int64_t tile_end) {
+  using T = Elem<elem_size>;
+  constexpr int64_t tile_size = TileSize<elem_size>();
+  static_assert(tile_size % block_size == 0, "");
+  const int64_t num_row_tiles = (rows + tile_size - 1) / tile_size;
+  const int64_t num_col_tiles = (cols + tile_size - 1) / tile_size;
+  const T* src_ptr = reinterpret_cast<const T*>(src);
+  T* dst_ptr = reinterpret_cast<T*>(dst);
+  for (int64_t tile = tile_begin; tile < tile_end; ++tile) {
+    const int64_t batch = tile / (num_row_tiles * num_col_tiles);
+    const int64_t row_begin = tile / num_col_tiles % num_row_tiles * tile_size;
+    const int64_t col_begin = tile % num_col_tiles * tile_size;
+    const int64_t batch_offset = batch * rows * cols;
+    TransposeTile<T, block_size, TransposeBlock>(
+        src_ptr + batch_offset + row_begin * cols + col_begin, cols,
+        dst_ptr + batch_offset + col_begin * rows + row_begin, rows,
+        std::min(tile_size, rows - row_begin), std::min(tile_size, cols - col_begin));
+  }
+}
+
+template<size_t elem_size>
+BatchTransposeFunc ScalarBatchTransposeFunc() {
+  return BatchTransposeTiles<elem_size, 1, TransposeBlock1x1<Elem<elem_size>>>;
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+#define OF_EP_CPU_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+
+// Shuffles only move bits, so the transposes below are exact for any 4 or 8-byte type, NaN
+// payloads included. SSE2 is part of x86-64, only the AVX blocks need a target attribute.
+
+namespace sse41 {
+
+void TransposeBlock4x4(const Elem<4>* src, int64_t src_stride, Elem<4>* dst, int64_t dst_stride) {
+  const float* s = reinterpret_cast<const float*>(src);
+  float* d = reinterpret_cast<float*>(dst);
+  __m128 r0 = _mm_loadu_ps(s);
+  __m128 r1 = _mm_loadu_ps(s + src_stride);
+  __m128 r2 = _mm_loadu_ps(s + 2 * src_stride);
+  __m128 r3 = _mm_loadu_ps(s + 3 * src_stride);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(d, r0);
+  _mm_storeu_ps(d + dst_stride, r1);
+  _mm_storeu_ps(d + 2 * dst_stride, r2);
+  _mm_storeu_ps(d + 3 * dst_stride, r3);
+}
+
+void TransposeBlock2x2(const Elem<8>* src, int64_t src_stride, Elem<8>* dst, int64_t dst_stride) {
+  const double* s = reinterpret_cast<const double*>(src);
+  double* d = reinterpret_cast<double*>(dst);
+  const __m128d r0 = _mm_loadu_pd(s);
+  const __m128d r1 = _mm_loadu_pd(s + src_stride);
+  _mm_storeu_pd(d, _mm_unpacklo_pd(r0, r1));
+  _mm_storeu_pd(d + dst_stride, _mm_unpackhi_pd(r0, r1));
+}
+
+}  // namespace sse41
+
+namespace avx2 {
+
+OF_EP_CPU_TARGET_AVX2 void TransposeBlock8x8(const Elem<4>* src, int64_t src_stride, Elem<4>* dst,
+                                             int64_t dst_stride) {
+  const float* s = reinterpret_cast<const float*>(src);
+  float* d = reinterpret_cast<float*>(dst);
+  __m256 r[8];
+  for (int i = 0; i < 8; ++i) { r[i] = _mm256_loadu_ps(s + i * src_stride); }
+  __m256 t[8];
+  for (int i = 0; i < 4; ++i) {
+    t[2 * i] = _mm256_unpacklo_ps(r[2 * i], r[2 * i + 1]);
+    t[2 * i + 1] = _mm256_unpackhi_ps(r[2 * i], r[2 * i + 1]);
+  }
+  for (int i = 0; i < 2; ++i) {
+    r[4 * i] = _mm256_shuffle_ps(t[4 * i], t[4 * i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+    r[4 * i + 1] = _mm256_shuffle_ps(t[4 * i], t[4 * i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+    r[4 * i + 2] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+    r[4 * i + 3] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  for (int i = 0; i < 4; ++i) {
+    _mm256_storeu_ps(d + i * dst_stride, _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+    _mm256_storeu_ps(d + (i + 4) * dst_stride, _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+  }
+}
+
+OF_EP_CPU_TARGET_AVX2 void TransposeBlock4x4(const Elem<8>* src, int64_t src_stride, Elem<8>* dst,
+                                             int64_t dst_stride) {
+  const double* s = reinterpret_cast<const double*>(src);
+  double* d = reinterpret_cast<double*>(dst);
+  const __m256d r0 = _mm256_loadu_pd(s);
+  const __m256d r1 = _mm256_loadu_pd(s + src_stride);
+  const __m256d r2 = _mm256_loadu_pd(s + 2 * src_stride);
+  const __m256d r3 = _mm256_loadu_pd(s + 3 * src_stride);
+  const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+  _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(d + dst_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(d + 2 * dst_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(d + 3 * dst_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+}  // namespace avx2
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+}  // namespace
+
+BatchTransposeFunc GetBatchTransposeFunc(size_t elem_size, CpuIsa isa) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  const bool with_avx2 = isa >= CpuIsa::kAvx2 && IsCpuIsaSupported(CpuIsa::kAvx2);
+  const bool with_sse41 = isa >= CpuIsa::kSse41 && IsCpuIsaSupported(CpuIsa::kSse41);
+  if (elem_size == 4) {
+    if (with_avx2) { return BatchTransposeTiles<4, 8, avx2::TransposeBlock8x8>; }
+    if (with_sse41) { return BatchTransposeTiles<4, 4, sse41::TransposeBlock4x4>; }
+  } else if (elem_size == 8) {
+    if (with_avx2) { return BatchTransposeTiles<8, 4, avx2::TransposeBlock4x4>; }
+    if (with_sse41) { return BatchTransposeTiles<8, 2, sse41::TransposeBlock2x2>; }
+  }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  switch (elem_size) {
+    case 1: return ScalarBatchTransposeFunc<1>();
+    case 2: return ScalarBatchTransposeFunc<2>();
+    case 4: return ScalarBatchTransposeFunc<4>();
+    case 8: return ScalarBatchTransposeFunc<8>();
+    case 16: return ScalarBatchTransposeFunc<16>();
+    default: UNIMPLEMENTED(); return nullptr;
+  }
+}
+
+int64_t GetBatchTransposeTileSize(size_t elem_size) {
+  switch (elem_size) {
+    case 1: return TileSize<1>();
+    case 2: return TileSize<2>();
+    case 4: return TileSize<4>();
+    case 8: return TileSize<8>();
+    case 16: return TileSize<16>();
+    default: UNIMPLEMENTED(); return 0;
+  }
+}
+
+int64_t GetBatchTransposeNumTiles(size_t elem_size, int64_t num_batches, int64_t rows,
+                                  int64_t cols) {
+  const int64_t tile_size = GetBatchTransposeTileSize(elem_size);
+  return num_batches * ((rows + tile_size - 1) / tile_size) * ((cols + tile_size - 1) / tile_size);
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
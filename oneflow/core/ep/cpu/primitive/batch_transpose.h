@@ -0,0 +1,52 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_BATCH_TRANSPOSE_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_BATCH_TRANSPOSE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// dst[b][j][i] = src[b][i][j] for a contiguous [num_batches, rows, cols] src of elem_size-byte
+// elements. The work is split into square tiles small enough that the src rows read and the dst
+// rows written by a tile stay in L1. Within a tile, 4 and 8-byte elements are transposed in SIMD
+// registers when `isa` allows it.
+//
+// A BatchTransposeFunc processes the tiles [tile_begin, tile_end), distinct tiles write disjoint
+// parts of dst and may run in parallel.
+using BatchTransposeFunc = void (*)(int64_t num_batches, int64_t rows, int64_t cols,
+                                    const void* src, void* dst, int64_t tile_begin,
+                                    int64_t tile_end);
+
+// elem_size must be 1, 2, 4, 8 or 16, never returns nullptr.
+BatchTransposeFunc GetBatchTransposeFunc(size_t elem_size, CpuIsa isa);
+
+int64_t GetBatchTransposeTileSize(size_t elem_size);
+
+int64_t GetBatchTransposeNumTiles(size_t elem_size, int64_t num_batches, int64_t rows,
+                                  int64_t cols);
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_BATCH_TRANSPOSE_H_
@@ -18,8 +18,11 @@ limitations under the License.
 #include "oneflow/core/ep/common/primitive/broadcast_elementwise_binary.h"
 #include "oneflow/core/ep/cpu/primitive/binary_functor.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_functor.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
 #include "oneflow/core/ndarray/ndarray_util.h"
 #include "oneflow/core/ndarray/xpu_var_ndarray.h"
+#include "oneflow/core/common/nd_index_offset_helper.h"
 
 namespace oneflow {
 
@@ -29,6 +32,9 @@ namespace broadcast_elementwise_binary {
 
 namespace {
 
+// rows shorter than this go through the ndarray path, where the per-row setup is amortized better
+constexpr int64_t kMinVectorizedRowSize = 16;
+
 template<typename T>
 T GetValue(Scalar value) {
   return value.Value<T>();
@@ -45,31 +51,30 @@ template<BinaryOp binary_op, typename Src, typename Dst,
 class BroadcastElementwiseBinaryImpl : public BroadcastElementwiseBinary {
  public:
   OF_DISALLOW_COPY_AND_MOVE(BroadcastElementwiseBinaryImpl);
-  BroadcastElementwiseBinaryImpl() = default;
+  BroadcastElementwiseBinaryImpl()
+      : vectorized_func_(GetVectorizedBinaryFunc<Src, Dst>(binary_op, GetCpuIsa())) {}
   ~BroadcastElementwiseBinaryImpl() override = default;
 
   void Launch(Stream* stream, Scalar src0, size_t num_src1_dims, const int64_t* src1_dims,
               const void* src1, void* dst) override {
-    int64_t elem_cnt = GetElementCount(num_src1_dims, src1_dims);
-    Src src0_val = GetValue<Src>(src0);
-    binary_func(stream, XpuVarNdarray<Dst>(Shape({elem_cnt}), reinterpret_cast<Dst*>(dst), 1),
-                XpuVarNdarray<const Src>(Shape({1}), &src0_val, 1),
-                XpuVarNdarray<const Src>(Shape({elem_cnt}), reinterpret_cast<const Src*>(src1), 1));
+    const int64_t elem_cnt = GetElementCount(num_src1_dims, src1_dims);
+    const Src src0_val = GetValue<Src>(src0);
+    const int64_t src0_dim = 1;
+    LaunchWithSimplified(stream, 1, &src0_dim, &src0_val, &elem_cnt,
+                         reinterpret_cast<const Src*>(src1), &elem_cnt,
+                         reinterpret_cast<Dst*>(dst));
   }
   void Launch(Stream* stream, size_t num_src0_dims, const int64_t* src0_dims, const void* src0,
               Scalar src1, void* dst) override {
-    int64_t elem_cnt = GetElementCount(num_src0_dims, src0_dims);
-    Src src1_val = GetValue<Src>(src1);
-    binary_func(stream, XpuVarNdarray<Dst>(Shape({elem_cnt}), reinterpret_cast<Dst*>(dst), 1),
-                XpuVarNdarray<const Src>(Shape({elem_cnt}), reinterpret_cast<const Src*>(src0), 1),
-                XpuVarNdarray<const Src>(Shape({1}), &src1_val, 1));
+    const int64_t elem_cnt = GetElementCount(num_src0_dims, src0_dims);
+    const Src src1_val = GetValue<Src>(src1);
+    const int64_t src1_dim = 1;
+    LaunchWithSimplified(stream, 1, &elem_cnt, reinterpret_cast<const Src*>(src0), &src1_dim,
+                         &src1_val, &elem_cnt, reinterpret_cast<Dst*>(dst));
   }
   void Launch(Stream* stream, size_t num_src0_dims, const int64_t* src0_dims, const void* src0,
               size_t num_src1_dims, const int64_t* src1_dims, const void* src1,
               void* dst) override {
-    DimVector src0_dim_vec;
-    DimVector src1_dim_vec;
-    DimVector dst_dim_vec;
     size_t num_dims = 0;
     int64_t simplified_src0_dims[kMaxNumDims];
     int64_t simplified_src1_dims[kMaxNumDims];
@@ -79,17 +84,108 @@ class BroadcastElementwiseBinaryImpl : public BroadcastElementwiseBinary {
                                        simplified_dst_dims);
     CheckInplace(num_dims, simplified_src0_dims, src0, simplified_src1_dims, src1,
                  simplified_dst_dims, dst);
-    for (int64_t i = 0; i < num_dims; ++i) {
-      src0_dim_vec.push_back(simplified_src0_dims[i]);
-      src1_dim_vec.push_back(simplified_src1_dims[i]);
-      dst_dim_vec.push_back(simplified_dst_dims[i]);
+    LaunchWithSimplified(stream, num_dims, simplified_src0_dims,
+                         reinterpret_cast<const Src*>(src0), simplified_src1_dims,
+                         reinterpret_cast<const Src*>(src1), simplified_dst_dims,
+                         reinterpret_cast<Dst*>(dst));
+  }
+
+ private:
+  // Splits the outermost simplified dim across threads. A src broadcast along that dim keeps its
+  // single slice, so every part is itself a valid broadcast and the result does not depend on the
+  // split.
+  void LaunchWithSimplified(Stream* stream, size_t num_dims, const int64_t* src0_dims,
+                            const Src* src0, const int64_t* src1_dims, const Src* src1,
+                            const int64_t* dst_dims, Dst* dst) {
+    int64_t src0_inner_size = 1;
+    int64_t src1_inner_size = 1;
+    int64_t dst_inner_size = 1;
+    for (size_t i = 1; i < num_dims; ++i) {
+      src0_inner_size *= src0_dims[i];
+      src1_inner_size *= src1_dims[i];
+      dst_inner_size *= dst_dims[i];
     }
-    binary_func(
-        stream, XpuVarNdarray<Dst>(Shape(dst_dim_vec), reinterpret_cast<Dst*>(dst), num_dims),
-        XpuVarNdarray<const Src>(Shape(src0_dim_vec), reinterpret_cast<const Src*>(src0), num_dims),
-        XpuVarNdarray<const Src>(Shape(src1_dim_vec), reinterpret_cast<const Src*>(src1),
-                                 num_dims));
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    const size_t grain_size = std::max<size_t>(
+        cpu_stream->parallel_grain_size() / std::max<int64_t>(dst_inner_size, 1), 1);
+    cpu_stream->ParallelFor(
+        0, dst_dims[0],
+        [&](int64_t begin, int64_t end) {
+          if (vectorized_func_ != nullptr && dst_dims[num_dims - 1] >= kMinVectorizedRowSize) {
+            LaunchVectorized(num_dims, src0_dims, src0, src1_dims, src1, dst_dims, dst, begin,
+                             end);
+            return;
+          }
+          DimVector src0_dim_vec;
+          DimVector src1_dim_vec;
+          DimVector dst_dim_vec;
+          for (size_t i = 0; i < num_dims; ++i) {
+            src0_dim_vec.push_back(src0_dims[i]);
+            src1_dim_vec.push_back(src1_dims[i]);
+            dst_dim_vec.push_back(dst_dims[i]);
+          }
+          const Src* src0_begin = src0;
+          const Src* src1_begin = src1;
+          if (src0_dims[0] == dst_dims[0]) {
+            src0_dim_vec[0] = end - begin;
+            src0_begin += begin * src0_inner_size;
+          }
+          if (src1_dims[0] == dst_dims[0]) {
+            src1_dim_vec[0] = end - begin;
+            src1_begin += begin * src1_inner_size;
+          }
+          dst_dim_vec[0] = end - begin;
+          binary_func(
+              stream,
+              XpuVarNdarray<Dst>(Shape(dst_dim_vec), dst + begin * dst_inner_size, num_dims),
+              XpuVarNdarray<const Src>(Shape(src0_dim_vec), src0_begin, num_dims),
+              XpuVarNdarray<const Src>(Shape(src1_dim_vec), src1_begin, num_dims));
+        },
+        grain_size);
   }
+
+  // Computes dst[begin:end] along dim 0 one innermost row at a time. After simplification the
+  // innermost dim of each src is either full (step 1) or broadcast (step 0).
+  void LaunchVectorized(size_t num_dims, const int64_t* src0_dims, const Src* src0,
+                        const int64_t* src1_dims, const Src* src1, const int64_t* dst_dims,
+                        Dst* dst, int64_t begin, int64_t end) {
+    const size_t last = num_dims - 1;
+    const size_t src0_step = src0_dims[last] == 1 ? 0 : 1;
+    const size_t src1_step = src1_dims[last] == 1 ? 0 : 1;
+    if (num_dims == 1) {
+      vectorized_func_(end - begin, src0 + begin * src0_step, src0_step, src1 + begin * src1_step,
+                       src1_step, dst + begin);
+      return;
+    }
+    int64_t src0_strides[kMaxNumDims];
+    int64_t src1_strides[kMaxNumDims];
+    int64_t src0_stride = 1;
+    int64_t src1_stride = 1;
+    for (int64_t i = last; i >= 0; --i) {
+      src0_strides[i] = src0_dims[i] == 1 ? 0 : src0_stride;
+      src1_strides[i] = src1_dims[i] == 1 ? 0 : src1_stride;
+      src0_stride *= src0_dims[i];
+      src1_stride *= src1_dims[i];
+    }
+    const int64_t cols = dst_dims[last];
+    int64_t rows_per_outer = 1;
+    for (size_t i = 1; i < last; ++i) { rows_per_outer *= dst_dims[i]; }
+    NdIndexOffsetHelper<int64_t, kMaxNumDims> row_index_helper(dst_dims, last);
+    int64_t index[kMaxNumDims];
+    for (int64_t row = begin * rows_per_outer; row < end * rows_per_outer; ++row) {
+      row_index_helper.OffsetToNdIndex(row, index, last);
+      int64_t src0_offset = 0;
+      int64_t src1_offset = 0;
+      for (size_t i = 0; i < last; ++i) {
+        src0_offset += index[i] * src0_strides[i];
+        src1_offset += index[i] * src1_strides[i];
+      }
+      vectorized_func_(cols, src0 + src0_offset, src0_step, src1 + src1_offset, src1_step,
+                       dst + row * cols);
+    }
+  }
+
+  VectorizedBinaryFunc<Src, Dst> vectorized_func_;
 };
 
 template<BinaryOp binary_op, typename Src, typename Dst,
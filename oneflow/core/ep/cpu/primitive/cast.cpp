@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/ep/include/primitive/cast.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_functor.h"
 
 namespace oneflow {
 
@@ -32,12 +33,19 @@ template<typename From, typename To>
 class CastImpl : public Cast {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CastImpl);
-  CastImpl() = default;
+  CastImpl() : vectorized_func_(GetVectorizedCastFunc<From, To>(GetCpuIsa())) {}
   ~CastImpl() override = default;
 
   void Launch(Stream* stream, const void* from, void* to, size_t count) override {
-    CastCpu(reinterpret_cast<const From*>(from), reinterpret_cast<To*>(to), count);
+    if (vectorized_func_ != nullptr) {
+      vectorized_func_(count, reinterpret_cast<const From*>(from), reinterpret_cast<To*>(to));
+    } else {
+      CastCpu(reinterpret_cast<const From*>(from), reinterpret_cast<To*>(to), count);
+    }
   }
+
+ private:
+  VectorizedCastFunc<From, To> vectorized_func_;
 };
 
 template<typename From, typename To>
@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/ep/common/primitive/elementwise_unary.h"
 #include "oneflow/core/ep/cpu/primitive/unary_functor.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_functor.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
 
 namespace oneflow {
 
@@ -28,16 +30,28 @@ template<UnaryOp unary_op, typename Src, typename Dst>
 class ElementwiseUnaryImpl : public ElementwiseUnary {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ElementwiseUnaryImpl);
-  ElementwiseUnaryImpl() = default;
+  ElementwiseUnaryImpl()
+      : vectorized_func_(GetVectorizedUnaryFunc<Src, Dst>(unary_op, GetCpuIsa())) {}
   ~ElementwiseUnaryImpl() override = default;
 
   void Launch(Stream* stream, const void* src_ptr, void* dst_ptr, size_t count) override {
     Dst* dst = reinterpret_cast<Dst*>(dst_ptr);
     const Src* src = reinterpret_cast<const Src*>(src_ptr);
-    for (size_t i = 0; i < count; ++i) {
-      dst[i] = UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src>()(src[i]);
-    }
+    const VectorizedUnaryFunc<Src, Dst> vectorized_func = vectorized_func_;
+    stream->As<CpuStream>()->ParallelFor(
+        0, count, [dst, src, vectorized_func](int64_t begin, int64_t end) {
+          if (vectorized_func != nullptr) {
+            vectorized_func(end - begin, src + begin, dst + begin);
+            return;
+          }
+          for (int64_t i = begin; i < end; ++i) {
+            dst[i] = UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src>()(src[i]);
+          }
+        });
   }
+
+ private:
+  VectorizedUnaryFunc<Src, Dst> vectorized_func_;
 };
 
 template<UnaryOp unary_op, typename Src, typename Dst>
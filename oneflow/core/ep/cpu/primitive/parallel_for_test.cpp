@@ -0,0 +1,208 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/broadcast_elementwise_binary.h"
+#include "oneflow/core/ep/include/primitive/elementwise_unary.h"
+#include "oneflow/core/ep/include/primitive/log_softmax.h"
+#include "oneflow/core/ep/include/primitive/permute.h"
+#include "oneflow/core/ep/include/primitive/softmax.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+// An odd pool size, so that the chunks of a loop do not split it evenly.
+constexpr int32_t kThreadPoolSize = 7;
+const size_t kParallelNumThreads[] = {2, 3, 8};
+
+std::unique_ptr<CpuStream> NewCpuStream(size_t num_threads, size_t grain_size) {
+  setenv("ONEFLOW_EP_CPU_NUM_THREADS", std::to_string(num_threads).c_str(), 1);
+  setenv("ONEFLOW_EP_CPU_PARALLEL_GRAIN_SIZE", std::to_string(grain_size).c_str(), 1);
+  std::unique_ptr<CpuStream> stream(new CpuStream(nullptr));
+  unsetenv("ONEFLOW_EP_CPU_NUM_THREADS");
+  unsetenv("ONEFLOW_EP_CPU_PARALLEL_GRAIN_SIZE");
+  return stream;
+}
+
+std::vector<float> RandomFloats(int64_t count, int64_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(-4, 4);
+  std::vector<float> values(count);
+  for (float& value : values) { value = dist(gen); }
+  return values;
+}
+
+// Runs Launch on a single thread, then with grain size 1 on several threads, and expects the
+// same bytes every time.
+void ExpectSameOnThreads(size_t dst_count, const std::string& what,
+                         const std::function<void(Stream*, float*)>& Launch) {
+  std::vector<float> expected(dst_count);
+  Launch(NewCpuStream(1, 1).get(), expected.data());
+  for (size_t num_threads : kParallelNumThreads) {
+    std::vector<float> dst(dst_count);
+    Launch(NewCpuStream(num_threads, 1).get(), dst.data());
+    ASSERT_EQ(std::memcmp(dst.data(), expected.data(), dst_count * sizeof(float)), 0)
+        << what << " on " << num_threads << " threads";
+  }
+}
+
+int64_t ElementCount(const std::vector<int64_t>& dims) {
+  int64_t count = 1;
+  for (int64_t dim : dims) { count *= dim; }
+  return count;
+}
+
+class CpuPrimitiveParallelFor : public testing::Test {
+ protected:
+  void SetUp() override {
+    owns_thread_pool_ = Global<ThreadPool>::Get() == nullptr;
+    if (owns_thread_pool_) { Global<ThreadPool>::New(kThreadPoolSize); }
+  }
+  void TearDown() override {
+    if (owns_thread_pool_) { Global<ThreadPool>::Delete(); }
+  }
+
+ private:
+  bool owns_thread_pool_ = false;
+};
+
+}  // namespace
+
+TEST_F(CpuPrimitiveParallelFor, broadcast_elementwise_binary) {
+  // the src dims broadcast along the split outermost dim, the inner dims, or both
+  const std::vector<std::pair<std::vector<int64_t>, std::vector<int64_t>>> cases = {
+      {{1}, {1}},
+      {{5}, {5}},
+      {{1}, {1001}},
+      {{1001}, {1}},
+      {{3, 17}, {3, 17}},
+      {{2, 3}, {3}},
+      {{5, 1, 7}, {1, 3, 7}},
+      {{7, 33, 1}, {7, 1, 19}},
+      {{11, 1}, {1, 16}},
+      {{13, 9, 5}, {13, 9, 5}},
+  };
+  for (BinaryOp op : {BinaryOp::kAdd, BinaryOp::kMul, BinaryOp::kDiv, BinaryOp::kMax}) {
+    std::unique_ptr<BroadcastElementwiseBinary> binary =
+        NewPrimitive<BroadcastElementwiseBinaryFactory>(DeviceType::kCPU, op, DataType::kFloat,
+                                                        DataType::kFloat, 3);
+    ASSERT_TRUE(binary);
+    for (size_t i = 0; i < cases.size(); ++i) {
+      const std::vector<int64_t>& src0_dims = cases.at(i).first;
+      const std::vector<int64_t>& src1_dims = cases.at(i).second;
+      const std::vector<float> src0 = RandomFloats(ElementCount(src0_dims), 2 * i);
+      const std::vector<float> src1 = RandomFloats(ElementCount(src1_dims), 2 * i + 1);
+      // the dst dims are the larger of the src dims, aligned to the right
+      const size_t num_dims = std::max(src0_dims.size(), src1_dims.size());
+      int64_t dst_count = 1;
+      for (size_t d = 0; d < num_dims; ++d) {
+        const int64_t dim0 = d < src0_dims.size() ? src0_dims.at(src0_dims.size() - 1 - d) : 1;
+        const int64_t dim1 = d < src1_dims.size() ? src1_dims.at(src1_dims.size() - 1 - d) : 1;
+        dst_count *= std::max(dim0, dim1);
+      }
+      ASSERT_NO_FATAL_FAILURE(ExpectSameOnThreads(
+          dst_count, "binary op " + std::to_string(static_cast<int>(op)) + ", case "
+                         + std::to_string(i),
+          [&](Stream* stream, float* dst) {
+            binary->Launch(stream, src0_dims.size(), src0_dims.data(), src0.data(),
+                           src1_dims.size(), src1_dims.data(), src1.data(), dst);
+          }));
+    }
+  }
+}
+
+TEST_F(CpuPrimitiveParallelFor, elementwise_unary) {
+  for (UnaryOp op : {UnaryOp::kRelu, UnaryOp::kGelu, UnaryOp::kTanh}) {
+    std::unique_ptr<ElementwiseUnary> unary =
+        NewPrimitive<ElementwiseUnaryFactory>(DeviceType::kCPU, op, DataType::kFloat,
+                                              DataType::kFloat);
+    ASSERT_TRUE(unary);
+    for (int64_t count : {1, 3, 7, 8, 9, 1001, 65537}) {
+      const std::vector<float> src = RandomFloats(count, count);
+      ASSERT_NO_FATAL_FAILURE(ExpectSameOnThreads(
+          count, "unary op " + std::to_string(static_cast<int>(op)) + ", count "
+                     + std::to_string(count),
+          [&](Stream* stream, float* dst) { unary->Launch(stream, src.data(), dst, count); }));
+    }
+  }
+}
+
+TEST_F(CpuPrimitiveParallelFor, softmax) {
+  std::unique_ptr<Softmax> softmax =
+      NewPrimitive<SoftmaxFactory>(DeviceType::kCPU, DataType::kFloat);
+  std::unique_ptr<LogSoftmax> log_softmax =
+      NewPrimitive<LogSoftmaxFactory>(DeviceType::kCPU, DataType::kFloat);
+  ASSERT_TRUE(softmax);
+  ASSERT_TRUE(log_softmax);
+  const std::vector<std::pair<size_t, size_t>> cases = {
+      {1, 5}, {3, 1000}, {7, 3}, {9, 1}, {1001, 17}};
+  for (const auto& rows_and_cols : cases) {
+    const size_t rows = rows_and_cols.first;
+    const size_t cols = rows_and_cols.second;
+    const std::vector<float> x = RandomFloats(rows * cols, rows);
+    const std::string shape = std::to_string(rows) + "x" + std::to_string(cols);
+    ASSERT_NO_FATAL_FAILURE(
+        ExpectSameOnThreads(rows * cols, "softmax " + shape, [&](Stream* stream, float* y) {
+          softmax->Launch(stream, rows, cols, x.data(), y);
+        }));
+    ASSERT_NO_FATAL_FAILURE(
+        ExpectSameOnThreads(rows * cols, "log softmax " + shape, [&](Stream* stream, float* y) {
+          log_softmax->Launch(stream, rows, cols, x.data(), y);
+        }));
+  }
+}
+
+TEST_F(CpuPrimitiveParallelFor, permute) {
+  const std::vector<std::pair<std::vector<int64_t>, std::vector<int>>> cases = {
+      {{1, 1, 13}, {2, 1, 0}},
+      {{7, 3, 5}, {2, 0, 1}},
+      {{9, 17, 33}, {1, 0, 2}},
+      {{3, 5, 7, 9}, {0, 2, 1, 3}},
+      {{3, 5, 7, 9}, {3, 1, 2, 0}},
+      {{5, 3, 129, 65}, {0, 1, 3, 2}},
+      {{2, 37, 3, 11}, {2, 0, 3, 1}},
+  };
+  for (size_t i = 0; i < cases.size(); ++i) {
+    const std::vector<int64_t>& src_dims = cases.at(i).first;
+    const std::vector<int>& permutation = cases.at(i).second;
+    std::unique_ptr<Permute> permute =
+        NewPrimitive<PermuteFactory>(DeviceType::kCPU, src_dims.size());
+    ASSERT_TRUE(permute);
+    const int64_t count = ElementCount(src_dims);
+    const std::vector<float> src = RandomFloats(count, i);
+    ASSERT_NO_FATAL_FAILURE(ExpectSameOnThreads(
+        count, "permute case " + std::to_string(i), [&](Stream* stream, float* dst) {
+          permute->Launch(stream, DataType::kFloat, src_dims.size(), src_dims.data(),
+                          src.data(), permutation.data(), dst);
+        }));
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
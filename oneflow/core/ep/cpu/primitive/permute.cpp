@@ -14,7 +14,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/ep/include/primitive/permute.h"
+#include <algorithm>
+#include <cstring>
 #include "oneflow/core/ep/common/primitive/permute_impl.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/primitive/batch_transpose.h"
 
 namespace oneflow {
 
@@ -27,12 +31,16 @@ namespace internal {
 
 namespace {
 
+// Roughly the elements a parallel task should move, as CpuStream's default grain size.
+constexpr int64_t kParallelGrainElemCnt = 32768;
+
 template<size_t num_dims, size_t movement_size, typename IndexType>
-void PermuteKernel(PermuteKernelParams<num_dims, IndexType> params) {
+void PermuteKernel(const PermuteKernelParams<num_dims, IndexType>& params, IndexType begin,
+                   IndexType end) {
   using T = typename std::aligned_storage<movement_size, movement_size>::type;
   const T* src = reinterpret_cast<const T*>(params.src);
   T* dst = reinterpret_cast<T*>(params.dst);
-  for (IndexType i = 0; i < params.count; ++i) {
+  for (IndexType i = begin; i < end; ++i) {
     IndexType src_index[num_dims];
     IndexType dst_index[num_dims];
     params.dst_index_helper.OffsetToNdIndex(i, dst_index);
@@ -44,12 +52,68 @@ void PermuteKernel(PermuteKernelParams<num_dims, IndexType> params) {
   }
 }
 
+// Used when the last dim stays in place: every dst row is a contiguous row of src, so the index
+// arithmetic is done once per row instead of once per element.
+template<size_t num_dims, size_t movement_size, typename IndexType>
+void PermuteRowKernel(const PermuteKernelParams<num_dims, IndexType>& params, IndexType row_size,
+                      IndexType begin_row, IndexType end_row) {
+  const char* src = reinterpret_cast<const char*>(params.src);
+  char* dst = reinterpret_cast<char*>(params.dst);
+  for (IndexType row = begin_row; row < end_row; ++row) {
+    IndexType src_index[num_dims];
+    IndexType dst_index[num_dims];
+    params.dst_index_helper.OffsetToNdIndex(row * row_size, dst_index);
+    for (size_t dim = 0; dim < num_dims; ++dim) {
+      src_index[params.permutation[dim]] = dst_index[dim];
+    }
+    IndexType src_offset = params.src_index_helper.NdIndexToOffset(src_index);
+    std::memcpy(dst + row * row_size * movement_size, src + src_offset * movement_size,
+                row_size * movement_size);
+  }
+}
+
+bool IsBatchTranspose(size_t num_dims, const int* permutation) {
+  return (num_dims == 2 && permutation[0] == 1 && permutation[1] == 0)
+         || (num_dims == 3 && permutation[0] == 0 && permutation[1] == 2 && permutation[2] == 1);
+}
+
 template<size_t num_dims, size_t movement_size, typename IndexType>
 void LaunchKernel(Stream* stream, const int64_t* src_dims, const void* src, const int* permutation,
                   void* dst, size_t count) {
+  CpuStream* cpu_stream = stream->As<CpuStream>();
+  if (IsBatchTranspose(num_dims, permutation)) {
+    const int64_t num_batches = num_dims == 2 ? 1 : src_dims[0];
+    const int64_t rows = src_dims[num_dims - 2];
+    const int64_t cols = src_dims[num_dims - 1];
+    static const BatchTransposeFunc batch_transpose =
+        GetBatchTransposeFunc(movement_size, GetCpuIsa());
+    const int64_t tile_size = GetBatchTransposeTileSize(movement_size);
+    const int64_t num_tiles = GetBatchTransposeNumTiles(movement_size, num_batches, rows, cols);
+    const size_t grain_size = std::max<int64_t>(kParallelGrainElemCnt / (tile_size * tile_size), 1);
+    cpu_stream->ParallelFor(
+        0, num_tiles,
+        [&](int64_t begin, int64_t end) {
+          batch_transpose(num_batches, rows, cols, src, dst, begin, end);
+        },
+        grain_size);
+    return;
+  }
   PermuteKernelParams<num_dims, IndexType> params =
       MakePermuteParams<num_dims, IndexType>(src_dims, src, permutation, dst, count);
-  PermuteKernel<num_dims, movement_size, IndexType>(params);
+  if (num_dims > 1 && permutation[num_dims - 1] == static_cast<int>(num_dims - 1)) {
+    const IndexType row_size = src_dims[num_dims - 1];
+    const size_t grain_size = std::max<int64_t>(kParallelGrainElemCnt / row_size, 1);
+    cpu_stream->ParallelFor(
+        0, params.count / row_size,
+        [&params, row_size](int64_t begin, int64_t end) {
+          PermuteRowKernel<num_dims, movement_size, IndexType>(params, row_size, begin, end);
+        },
+        grain_size);
+    return;
+  }
+  cpu_stream->ParallelFor(0, params.count, [&params](int64_t begin, int64_t end) {
+    PermuteKernel<num_dims, movement_size, IndexType>(params, begin, end);
+  });
 }
 class PermuteImpl : public Permute {
  public:
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/ep/include/primitive/softmax.h"
 #include "oneflow/core/ep/include/primitive/log_softmax.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
 
 namespace oneflow {
 
@@ -69,7 +70,17 @@ class SoftmaxImpl : public SoftmaxBase {
   ~SoftmaxImpl() override = default;
 
   void Launch(Stream* stream, size_t rows, size_t cols, const void* x, void* y) override {
-    SoftmaxCpu<algorithm, T>(rows, cols, reinterpret_cast<const T*>(x), reinterpret_cast<T*>(y));
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    const T* x_ptr = reinterpret_cast<const T*>(x);
+    T* y_ptr = reinterpret_cast<T*>(y);
+    const size_t grain_size =
+        std::max<size_t>(cpu_stream->parallel_grain_size() / std::max<size_t>(cols, 1), 1);
+    cpu_stream->ParallelFor(
+        0, rows,
+        [=](int64_t begin, int64_t end) {
+          SoftmaxCpu<algorithm, T>(end - begin, cols, x_ptr + begin * cols, y_ptr + begin * cols);
+        },
+        grain_size);
   }
 };
 
@@ -0,0 +1,364 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/vectorized_functor.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OF_EP_CPU_WITH_X86_SIMD
+#include <immintrin.h>
+#endif  // __x86_64__
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+namespace {
+
+#define OF_EP_CPU_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define OF_EP_CPU_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define OF_EP_CPU_TARGET_AVX512 __attribute__((target("avx512f")))
+
+template<BinaryOp op>
+struct BinaryTag {};
+
+template<UnaryOp op>
+struct UnaryTag {};
+
+// Scalar tails, must match the semantics of the ndarray binary funcs and the unary functors.
+template<BinaryOp op, typename T>
+struct ScalarBinary;
+
+template<typename T>
+struct ScalarBinary<BinaryOp::kAdd, T> {
+  static T Apply(T a, T b) { return a + b; }
+};
+template<typename T>
+struct ScalarBinary<BinaryOp::kSub, T> {
+  static T Apply(T a, T b) { return a - b; }
+};
+template<typename T>
+struct ScalarBinary<BinaryOp::kMul, T> {
+  static T Apply(T a, T b) { return a * b; }
+};
+template<typename T>
+struct ScalarBinary<BinaryOp::kDiv, T> {
+  static T Apply(T a, T b) { return a / b; }
+};
+template<typename T>
+struct ScalarBinary<BinaryOp::kMax, T> {
+  static T Apply(T a, T b) { return a > b ? a : b; }
+};
+template<typename T>
+struct ScalarBinary<BinaryOp::kMin, T> {
+  static T Apply(T a, T b) { return a < b ? a : b; }
+};
+
+template<UnaryOp op, typename T>
+struct ScalarUnary;
+
+template<typename T>
+struct ScalarUnary<UnaryOp::kRelu, T> {
+  static T Apply(T a) { return a > static_cast<T>(0) ? a : static_cast<T>(0); }
+};
+
+// max/min instructions return the second operand when the comparison is false (including NaN),
+// which is exactly `a > b ? a : b` and `a < b ? a : b`.
+#define OF_EP_CPU_DEFINE_FLOATING_VEC(target, T, RegT, size, prefix, suffix)                   \
+  template<>                                                                                 \
+  struct Vec<T> {                                                                            \
+    using Reg = RegT;                                                                        \
+    static constexpr size_t kSize = size;                                                    \
+    target static Reg Load(const T* p) { return prefix##_loadu_##suffix(p); }                \
+    target static void Store(T* p, Reg v) { prefix##_storeu_##suffix(p, v); }                \
+    target static Reg Set1(T v) { return prefix##_set1_##suffix(v); }                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kAdd>, Reg a, Reg b) {                      \
+      return prefix##_add_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kSub>, Reg a, Reg b) {                      \
+      return prefix##_sub_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kMul>, Reg a, Reg b) {                      \
+      return prefix##_mul_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kDiv>, Reg a, Reg b) {                      \
+      return prefix##_div_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kMax>, Reg a, Reg b) {                      \
+      return prefix##_max_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(BinaryTag<BinaryOp::kMin>, Reg a, Reg b) {                      \
+      return prefix##_min_##suffix(a, b);                                                    \
+    }                                                                                        \
+    target static Reg Apply(UnaryTag<UnaryOp::kRelu>, Reg a) {                               \
+      return prefix##_max_##suffix(a, prefix##_setzero_##suffix());                          \
+    }                                                                                        \
+  };
+
+#define OF_EP_CPU_DEFINE_INT32_VEC(target, RegT, size, prefix, int_suffix)                      \
+  template<>                                                                                   \
+  struct Vec<int32_t> {                                                                        \
+    using Reg = RegT;                                                                          \
+    static constexpr size_t kSize = size;                                                      \
+    target static Reg Load(const int32_t* p) {                                                 \
+      return prefix##_loadu_##int_suffix(reinterpret_cast<const Reg*>(p));                     \
+    }                                                                                          \
+    target static void Store(int32_t* p, Reg v) {                                              \
+      prefix##_storeu_##int_suffix(reinterpret_cast<Reg*>(p), v);                              \
+    }                                                                                          \
+    target static Reg Set1(int32_t v) { return prefix##_set1_epi32(v); }                       \
+    target static Reg Apply(BinaryTag<BinaryOp::kAdd>, Reg a, Reg b) {                        \
+      return prefix##_add_epi32(a, b);                                                         \
+    }                                                                                          \
+    target static Reg Apply(BinaryTag<BinaryOp::kSub>, Reg a, Reg b) {                        \
+      return prefix##_sub_epi32(a, b);                                                         \
+    }                                                                                          \
+    target static Reg Apply(BinaryTag<BinaryOp::kMul>, Reg a, Reg b) {                        \
+      return prefix##_mullo_epi32(a, b);                                                       \
+    }                                                                                          \
+    target static Reg Apply(BinaryTag<BinaryOp::kMax>, Reg a, Reg b) {                        \
+      return prefix##_max_epi32(a, b);                                                         \
+    }                                                                                          \
+    target static Reg Apply(BinaryTag<BinaryOp::kMin>, Reg a, Reg b) {                        \
+      return prefix##_min_epi32(a, b);                                                         \
+    }                                                                                          \
+    target static Reg Apply(UnaryTag<UnaryOp::kRelu>, Reg a) {                                 \
+      return prefix##_max_epi32(a, prefix##_setzero_##int_suffix());                           \
+    }                                                                                          \
+  };
+
+#define OF_EP_CPU_DEFINE_VECTORIZED_LOOPS(target)                                              \
+  template<BinaryOp op, typename T>                                                           \
+  target void BinaryLoop(size_t n, const T* src0, size_t src0_step, const T* src1,            \
+                         size_t src1_step, T* dst) {                                          \
+    using V = Vec<T>;                                                                         \
+    size_t i = 0;                                                                             \
+    if (src0_step == 1 && src1_step == 1) {                                                   \
+      for (; i + V::kSize <= n; i += V::kSize) {                                              \
+        V::Store(dst + i, V::Apply(BinaryTag<op>(), V::Load(src0 + i), V::Load(src1 + i)));   \
+      }                                                                                       \
+    } else if (src0_step == 0 && src1_step == 1) {                                            \
+      const typename V::Reg a = V::Set1(*src0);                                               \
+      for (; i + V::kSize <= n; i += V::kSize) {                                              \
+        V::Store(dst + i, V::Apply(BinaryTag<op>(), a, V::Load(src1 + i)));                   \
+      }                                                                                       \
+    } else if (src0_step == 1 && src1_step == 0) {                                            \
+      const typename V::Reg b = V::Set1(*src1);                                               \
+      for (; i + V::kSize <= n; i += V::kSize) {                                              \
+        V::Store(dst + i, V::Apply(BinaryTag<op>(), V::Load(src0 + i), b));                   \
+      }                                                                                       \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      dst[i] = ScalarBinary<op, T>::Apply(src0[i * src0_step], src1[i * src1_step]);          \
+    }                                                                                         \
+  }                                                                                           \
+  template<UnaryOp op, typename T>                                                            \
+  target void UnaryLoop(size_t n, const T* src, T* dst) {                                     \
+    using V = Vec<T>;                                                                         \
+    size_t i = 0;                                                                             \
+    for (; i + V::kSize <= n; i += V::kSize) {                                                \
+      V::Store(dst + i, V::Apply(UnaryTag<op>(), V::Load(src + i)));                          \
+    }                                                                                         \
+    for (; i < n; ++i) { dst[i] = ScalarUnary<op, T>::Apply(src[i]); }                        \
+  }
+
+namespace sse41 {
+
+template<typename T>
+struct Vec;
+
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_SSE41, float, __m128, 4, _mm, ps)
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_SSE41, double, __m128d, 2, _mm, pd)
+OF_EP_CPU_DEFINE_INT32_VEC(OF_EP_CPU_TARGET_SSE41, __m128i, 4, _mm, si128)
+OF_EP_CPU_DEFINE_VECTORIZED_LOOPS(OF_EP_CPU_TARGET_SSE41)
+
+}  // namespace sse41
+
+namespace avx2 {
+
+template<typename T>
+struct Vec;
+
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_AVX2, float, __m256, 8, _mm256, ps)
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_AVX2, double, __m256d, 4, _mm256, pd)
+OF_EP_CPU_DEFINE_INT32_VEC(OF_EP_CPU_TARGET_AVX2, __m256i, 8, _mm256, si256)
+OF_EP_CPU_DEFINE_VECTORIZED_LOOPS(OF_EP_CPU_TARGET_AVX2)
+
+OF_EP_CPU_TARGET_AVX2 void HalfToFloatLoop(size_t n, const float16* from, float* to) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+    _mm256_storeu_ps(to + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < n; ++i) { to[i] = static_cast<float>(from[i]); }
+}
+
+}  // namespace avx2
+
+namespace avx512 {
+
+template<typename T>
+struct Vec;
+
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_AVX512, float, __m512, 16, _mm512, ps)
+OF_EP_CPU_DEFINE_FLOATING_VEC(OF_EP_CPU_TARGET_AVX512, double, __m512d, 8, _mm512, pd)
+OF_EP_CPU_DEFINE_INT32_VEC(OF_EP_CPU_TARGET_AVX512, __m512i, 16, _mm512, si512)
+OF_EP_CPU_DEFINE_VECTORIZED_LOOPS(OF_EP_CPU_TARGET_AVX512)
+
+OF_EP_CPU_TARGET_AVX512 void HalfToFloatLoop(size_t n, const float16* from, float* to) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+    _mm512_storeu_ps(to + i, _mm512_cvtph_ps(h));
+  }
+  for (; i < n; ++i) { to[i] = static_cast<float>(from[i]); }
+}
+
+}  // namespace avx512
+
+#undef OF_EP_CPU_DEFINE_VECTORIZED_LOOPS
+#undef OF_EP_CPU_DEFINE_INT32_VEC
+#undef OF_EP_CPU_DEFINE_FLOATING_VEC
+
+template<BinaryOp op, typename T>
+VectorizedBinaryFunc<T, T> SelectBinaryLoop(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::kAvx512: return avx512::BinaryLoop<op, T>;
+    case CpuIsa::kAvx2: return avx2::BinaryLoop<op, T>;
+    case CpuIsa::kSse41: return sse41::BinaryLoop<op, T>;
+    default: return nullptr;
+  }
+}
+
+template<UnaryOp op, typename T>
+VectorizedUnaryFunc<T, T> SelectUnaryLoop(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::kAvx512: return avx512::UnaryLoop<op, T>;
+    case CpuIsa::kAvx2: return avx2::UnaryLoop<op, T>;
+    case CpuIsa::kSse41: return sse41::UnaryLoop<op, T>;
+    default: return nullptr;
+  }
+}
+
+template<typename T>
+VectorizedBinaryFunc<T, T> GetFloatingBinaryFunc(BinaryOp op, CpuIsa isa) {
+  if (!IsCpuIsaSupported(isa)) { return nullptr; }
+  switch (op) {
+    case BinaryOp::kAdd: return SelectBinaryLoop<BinaryOp::kAdd, T>(isa);
+    case BinaryOp::kSub: return SelectBinaryLoop<BinaryOp::kSub, T>(isa);
+    case BinaryOp::kMul: return SelectBinaryLoop<BinaryOp::kMul, T>(isa);
+    case BinaryOp::kDiv: return SelectBinaryLoop<BinaryOp::kDiv, T>(isa);
+    case BinaryOp::kMax: return SelectBinaryLoop<BinaryOp::kMax, T>(isa);
+    case BinaryOp::kMin: return SelectBinaryLoop<BinaryOp::kMin, T>(isa);
+    default: return nullptr;
+  }
+}
+
+template<typename T>
+VectorizedUnaryFunc<T, T> GetUnaryFunc(UnaryOp op, CpuIsa isa) {
+  if (!IsCpuIsaSupported(isa)) { return nullptr; }
+  switch (op) {
+    case UnaryOp::kRelu: return SelectUnaryLoop<UnaryOp::kRelu, T>(isa);
+    default: return nullptr;
+  }
+}
+
+}  // namespace
+
+template<>
+VectorizedBinaryFunc<float, float> GetVectorizedBinaryFunc<float, float>(BinaryOp op,
+                                                                         CpuIsa isa) {
+  return GetFloatingBinaryFunc<float>(op, isa);
+}
+
+template<>
+VectorizedBinaryFunc<double, double> GetVectorizedBinaryFunc<double, double>(BinaryOp op,
+                                                                             CpuIsa isa) {
+  return GetFloatingBinaryFunc<double>(op, isa);
+}
+
+template<>
+VectorizedBinaryFunc<int32_t, int32_t> GetVectorizedBinaryFunc<int32_t, int32_t>(BinaryOp op,
+                                                                                 CpuIsa isa) {
+  if (!IsCpuIsaSupported(isa)) { return nullptr; }
+  // integer division has no SIMD instruction
+  switch (op) {
+    case BinaryOp::kAdd: return SelectBinaryLoop<BinaryOp::kAdd, int32_t>(isa);
+    case BinaryOp::kSub: return SelectBinaryLoop<BinaryOp::kSub, int32_t>(isa);
+    case BinaryOp::kMul: return SelectBinaryLoop<BinaryOp::kMul, int32_t>(isa);
+    case BinaryOp::kMax: return SelectBinaryLoop<BinaryOp::kMax, int32_t>(isa);
+    case BinaryOp::kMin: return SelectBinaryLoop<BinaryOp::kMin, int32_t>(isa);
+    default: return nullptr;
+  }
+}
+
+template<>
+VectorizedUnaryFunc<float, float> GetVectorizedUnaryFunc<float, float>(UnaryOp op, CpuIsa isa) {
+  return GetUnaryFunc<float>(op, isa);
+}
+
+template<>
+VectorizedUnaryFunc<double, double> GetVectorizedUnaryFunc<double, double>(UnaryOp op,
+                                                                           CpuIsa isa) {
+  return GetUnaryFunc<double>(op, isa);
+}
+
+template<>
+VectorizedUnaryFunc<int32_t, int32_t> GetVectorizedUnaryFunc<int32_t, int32_t>(UnaryOp op,
+                                                                               CpuIsa isa) {
+  return GetUnaryFunc<int32_t>(op, isa);
+}
+
+template<>
+VectorizedCastFunc<float16, float> GetVectorizedCastFunc<float16, float>(CpuIsa isa) {
+  if (!IsCpuIsaSupported(isa)) { return nullptr; }
+  switch (isa) {
+    case CpuIsa::kAvx512: return avx512::HalfToFloatLoop;
+    case CpuIsa::kAvx2: return avx2::HalfToFloatLoop;
+    default: return nullptr;
+  }
+}
+
+#else
+
+#define SPECIALIZE_GET_VECTORIZED_FUNC(T)                                                     \
+  template<>                                                                                 \
+  VectorizedBinaryFunc<T, T> GetVectorizedBinaryFunc<T, T>(BinaryOp op, CpuIsa isa) {         \
+    return nullptr;                                                                          \
+  }                                                                                          \
+  template<>                                                                                 \
+  VectorizedUnaryFunc<T, T> GetVectorizedUnaryFunc<T, T>(UnaryOp op, CpuIsa isa) {            \
+    return nullptr;                                                                          \
+  }
+
+SPECIALIZE_GET_VECTORIZED_FUNC(float)
+SPECIALIZE_GET_VECTORIZED_FUNC(double)
+SPECIALIZE_GET_VECTORIZED_FUNC(int32_t)
+
+#undef SPECIALIZE_GET_VECTORIZED_FUNC
+
+template<>
+VectorizedCastFunc<float16, float> GetVectorizedCastFunc<float16, float>(CpuIsa isa) {
+  return nullptr;
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_FUNCTOR_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_FUNCTOR_H_
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/ep/include/primitive/binary_op.h"
+#include "oneflow/core/ep/include/primitive/unary_op.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// Explicitly vectorized loops over contiguous memory, specialized per CpuIsa. Results are bitwise
+// identical to the scalar functors: only ops that map to exact IEEE instructions are covered,
+// transcendental ops (pow, gelu, tanh) keep the scalar libm path.
+//
+// The Get* functions return nullptr when (op, types, isa) has no vectorized loop.
+
+// dst[i] = op(src0[i * src0_step], src1[i * src1_step]), steps are 0 (broadcast scalar) or 1
+template<typename Src, typename Dst>
+using VectorizedBinaryFunc = void (*)(size_t n, const Src* src0, size_t src0_step,
+                                      const Src* src1, size_t src1_step, Dst* dst);
+
+template<typename Src, typename Dst>
+using VectorizedUnaryFunc = void (*)(size_t n, const Src* src, Dst* dst);
+
+template<typename From, typename To>
+using VectorizedCastFunc = void (*)(size_t n, const From* from, To* to);
+
+template<typename Src, typename Dst>
+VectorizedBinaryFunc<Src, Dst> GetVectorizedBinaryFunc(BinaryOp op, CpuIsa isa) {
+  return nullptr;
+}
+
+template<typename Src, typename Dst>
+VectorizedUnaryFunc<Src, Dst> GetVectorizedUnaryFunc(UnaryOp op, CpuIsa isa) {
+  return nullptr;
+}
+
+template<typename From, typename To>
+VectorizedCastFunc<From, To> GetVectorizedCastFunc(CpuIsa isa) {
+  return nullptr;
+}
+
+#define SPECIALIZE_GET_VECTORIZED_FUNC(T)                                                     \
+  template<>                                                                                 \
+  VectorizedBinaryFunc<T, T> GetVectorizedBinaryFunc<T, T>(BinaryOp op, CpuIsa isa);          \
+  template<>                                                                                 \
+  VectorizedUnaryFunc<T, T> GetVectorizedUnaryFunc<T, T>(UnaryOp op, CpuIsa isa);
+
+SPECIALIZE_GET_VECTORIZED_FUNC(float)
+SPECIALIZE_GET_VECTORIZED_FUNC(double)
+SPECIALIZE_GET_VECTORIZED_FUNC(int32_t)
+
+#undef SPECIALIZE_GET_VECTORIZED_FUNC
+
+template<>
+VectorizedCastFunc<float16, float> GetVectorizedCastFunc<float16, float>(CpuIsa isa);
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_FUNCTOR_H_
@@ -0,0 +1,286 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/vectorized_functor.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+const CpuIsa kVectorizedIsas[] = {CpuIsa::kSse41, CpuIsa::kAvx2, CpuIsa::kAvx512};
+
+template<typename T>
+T ScalarBinaryRef(BinaryOp op, T a, T b) {
+  switch (op) {
+    case BinaryOp::kAdd: return a + b;
+    case BinaryOp::kSub: return a - b;
+    case BinaryOp::kMul: return a * b;
+    case BinaryOp::kDiv: return a / b;
+    case BinaryOp::kMax: return a > b ? a : b;
+    case BinaryOp::kMin: return a < b ? a : b;
+    default: return T();
+  }
+}
+
+std::string BinaryOpName(BinaryOp op) {
+  switch (op) {
+    case BinaryOp::kAdd: return "add";
+    case BinaryOp::kSub: return "sub";
+    case BinaryOp::kMul: return "mul";
+    case BinaryOp::kDiv: return "div";
+    case BinaryOp::kMax: return "max";
+    case BinaryOp::kMin: return "min";
+    default: return "unknown";
+  }
+}
+
+template<typename T>
+std::vector<T> RandomData(size_t n, std::mt19937* rng) {
+  std::vector<T> data(n);
+  std::uniform_int_distribution<int32_t> dist(-1000, 1000);
+  for (size_t i = 0; i < n; ++i) { data[i] = static_cast<T>(dist(*rng)) / static_cast<T>(7); }
+  return data;
+}
+
+template<>
+std::vector<int32_t> RandomData<int32_t>(size_t n, std::mt19937* rng) {
+  std::vector<int32_t> data(n);
+  std::uniform_int_distribution<int32_t> dist(-100000, 100000);
+  for (size_t i = 0; i < n; ++i) { data[i] = dist(*rng); }
+  return data;
+}
+
+template<typename T>
+void AddSpecialValues(std::vector<T>* data) {
+  if (!std::is_floating_point<T>::value || data->size() < 4) { return; }
+  (*data)[0] = std::numeric_limits<T>::quiet_NaN();
+  (*data)[1] = -static_cast<T>(0);
+  (*data)[2] = std::numeric_limits<T>::infinity();
+  (*data)[3] = -std::numeric_limits<T>::infinity();
+}
+
+template<typename T>
+void TestBinary(BinaryOp op) {
+  std::mt19937 rng(0);
+  for (size_t n : {0, 1, 7, 16, 33, 1000}) {
+    std::vector<T> src0 = RandomData<T>(n, &rng);
+    std::vector<T> src1 = RandomData<T>(n, &rng);
+    AddSpecialValues(&src0);
+    for (size_t i = 0; i < n; ++i) {
+      if (src1[i] == static_cast<T>(0)) { src1[i] = static_cast<T>(1); }
+    }
+    for (CpuIsa isa : kVectorizedIsas) {
+      if (!IsCpuIsaSupported(isa)) { continue; }
+      VectorizedBinaryFunc<T, T> func = GetVectorizedBinaryFunc<T, T>(op, isa);
+      ASSERT_NE(func, nullptr);
+      for (size_t src0_step : {0, 1}) {
+        for (size_t src1_step : {0, 1}) {
+          if (n == 0 && (src0_step == 0 || src1_step == 0)) { continue; }
+          std::vector<T> expected(n);
+          std::vector<T> actual(n);
+          for (size_t i = 0; i < n; ++i) {
+            expected[i] = ScalarBinaryRef(op, src0[i * src0_step], src1[i * src1_step]);
+          }
+          func(n, src0.data(), src0_step, src1.data(), src1_step, actual.data());
+          ASSERT_EQ(std::memcmp(expected.data(), actual.data(), n * sizeof(T)), 0)
+              << "isa " << CpuIsaToString(isa) << " n " << n;
+        }
+      }
+    }
+  }
+}
+
+template<typename T>
+void TestRelu() {
+  std::mt19937 rng(0);
+  for (size_t n : {0, 1, 7, 16, 33, 1000}) {
+    std::vector<T> src = RandomData<T>(n, &rng);
+    AddSpecialValues(&src);
+    std::vector<T> expected(n);
+    for (size_t i = 0; i < n; ++i) {
+      expected[i] = src[i] > static_cast<T>(0) ? src[i] : static_cast<T>(0);
+    }
+    for (CpuIsa isa : kVectorizedIsas) {
+      if (!IsCpuIsaSupported(isa)) { continue; }
+      VectorizedUnaryFunc<T, T> func = GetVectorizedUnaryFunc<T, T>(UnaryOp::kRelu, isa);
+      ASSERT_NE(func, nullptr);
+      std::vector<T> actual(n);
+      func(n, src.data(), actual.data());
+      ASSERT_EQ(std::memcmp(expected.data(), actual.data(), n * sizeof(T)), 0)
+          << "isa " << CpuIsaToString(isa) << " n " << n;
+    }
+  }
+}
+
+constexpr size_t kThroughputElemCnt = 1 << 20;
+constexpr int kThroughputIters = 10;
+
+// Returns GB/s of Run, moving bytes_per_run each time.
+double MeasureThroughput(size_t bytes_per_run, const std::function<void()>& Run) {
+  Run();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kThroughputIters; ++i) { Run(); }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(bytes_per_run) * kThroughputIters / seconds / 1e9;
+}
+
+void LogThroughput(const std::string& name, const std::string& isa, double gbps,
+                   double scalar_gbps) {
+  LOG(INFO) << name << " " << isa << ": " << gbps << " GB/s, " << gbps / scalar_gbps
+            << "x scalar";
+}
+
+template<typename T>
+void ReportBinaryThroughput(BinaryOp op, const std::string& dtype) {
+  std::mt19937 rng(0);
+  const std::vector<T> src0 = RandomData<T>(kThroughputElemCnt, &rng);
+  std::vector<T> src1 = RandomData<T>(kThroughputElemCnt, &rng);
+  for (T& x : src1) {
+    if (x == static_cast<T>(0)) { x = static_cast<T>(1); }
+  }
+  std::vector<T> dst(kThroughputElemCnt);
+  const size_t bytes = 3 * kThroughputElemCnt * sizeof(T);
+  const std::string name = BinaryOpName(op) + " " + dtype;
+  const double scalar_gbps = MeasureThroughput(bytes, [&]() {
+    for (size_t i = 0; i < kThroughputElemCnt; ++i) {
+      dst[i] = ScalarBinaryRef(op, src0[i], src1[i]);
+    }
+  });
+  LogThroughput(name, "scalar", scalar_gbps, scalar_gbps);
+  for (CpuIsa isa : kVectorizedIsas) {
+    if (!IsCpuIsaSupported(isa)) { continue; }
+    VectorizedBinaryFunc<T, T> func = GetVectorizedBinaryFunc<T, T>(op, isa);
+    ASSERT_NE(func, nullptr);
+    const double gbps = MeasureThroughput(bytes, [&]() {
+      func(kThroughputElemCnt, src0.data(), 1, src1.data(), 1, dst.data());
+    });
+    LogThroughput(name, CpuIsaToString(isa), gbps, scalar_gbps);
+  }
+}
+
+template<typename T>
+void ReportReluThroughput(const std::string& dtype) {
+  std::mt19937 rng(0);
+  const std::vector<T> src = RandomData<T>(kThroughputElemCnt, &rng);
+  std::vector<T> dst(kThroughputElemCnt);
+  const size_t bytes = 2 * kThroughputElemCnt * sizeof(T);
+  const std::string name = "relu " + dtype;
+  const double scalar_gbps = MeasureThroughput(bytes, [&]() {
+    for (size_t i = 0; i < kThroughputElemCnt; ++i) {
+      dst[i] = src[i] > static_cast<T>(0) ? src[i] : static_cast<T>(0);
+    }
+  });
+  LogThroughput(name, "scalar", scalar_gbps, scalar_gbps);
+  for (CpuIsa isa : kVectorizedIsas) {
+    if (!IsCpuIsaSupported(isa)) { continue; }
+    VectorizedUnaryFunc<T, T> func = GetVectorizedUnaryFunc<T, T>(UnaryOp::kRelu, isa);
+    ASSERT_NE(func, nullptr);
+    const double gbps =
+        MeasureThroughput(bytes, [&]() { func(kThroughputElemCnt, src.data(), dst.data()); });
+    LogThroughput(name, CpuIsaToString(isa), gbps, scalar_gbps);
+  }
+}
+
+void ReportHalfToFloatThroughput() {
+  const std::vector<float16> src(kThroughputElemCnt, static_cast<float16>(1.5F));
+  std::vector<float> dst(kThroughputElemCnt);
+  const size_t bytes = kThroughputElemCnt * (sizeof(float16) + sizeof(float));
+  const double scalar_gbps = MeasureThroughput(bytes, [&]() {
+    for (size_t i = 0; i < kThroughputElemCnt; ++i) { dst[i] = static_cast<float>(src[i]); }
+  });
+  LogThroughput("cast half to float", "scalar", scalar_gbps, scalar_gbps);
+  for (CpuIsa isa : {CpuIsa::kAvx2, CpuIsa::kAvx512}) {
+    if (!IsCpuIsaSupported(isa)) { continue; }
+    VectorizedCastFunc<float16, float> func = GetVectorizedCastFunc<float16, float>(isa);
+    ASSERT_NE(func, nullptr);
+    const double gbps =
+        MeasureThroughput(bytes, [&]() { func(kThroughputElemCnt, src.data(), dst.data()); });
+    LogThroughput("cast half to float", CpuIsaToString(isa), gbps, scalar_gbps);
+  }
+}
+
+}  // namespace
+
+TEST(VectorizedFunctor, binary) {
+  if (!IsCpuIsaSupported(CpuIsa::kSse41)) { return; }
+  for (BinaryOp op : {BinaryOp::kAdd, BinaryOp::kSub, BinaryOp::kMul, BinaryOp::kDiv,
+                      BinaryOp::kMax, BinaryOp::kMin}) {
+    TestBinary<float>(op);
+    TestBinary<double>(op);
+    if (op != BinaryOp::kDiv) { TestBinary<int32_t>(op); }
+  }
+  ASSERT_EQ((GetVectorizedBinaryFunc<int32_t, int32_t>(BinaryOp::kDiv, CpuIsa::kSse41)), nullptr);
+  ASSERT_EQ((GetVectorizedBinaryFunc<float, float>(BinaryOp::kPow, CpuIsa::kSse41)), nullptr);
+  ASSERT_EQ((GetVectorizedBinaryFunc<float, float>(BinaryOp::kAdd, CpuIsa::kScalar)), nullptr);
+}
+
+TEST(VectorizedFunctor, relu) {
+  if (!IsCpuIsaSupported(CpuIsa::kSse41)) { return; }
+  TestRelu<float>();
+  TestRelu<double>();
+  TestRelu<int32_t>();
+  ASSERT_EQ((GetVectorizedUnaryFunc<float, float>(UnaryOp::kGelu, CpuIsa::kSse41)), nullptr);
+}
+
+TEST(VectorizedFunctor, half_to_float) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1000, 1000);
+  for (size_t n : {0, 1, 7, 16, 33, 1000}) {
+    std::vector<float16> src(n);
+    for (size_t i = 0; i < n; ++i) { src[i] = static_cast<float16>(dist(rng)); }
+    std::vector<float> expected(n);
+    for (size_t i = 0; i < n; ++i) { expected[i] = static_cast<float>(src[i]); }
+    for (CpuIsa isa : {CpuIsa::kAvx2, CpuIsa::kAvx512}) {
+      if (!IsCpuIsaSupported(isa)) { continue; }
+      VectorizedCastFunc<float16, float> func = GetVectorizedCastFunc<float16, float>(isa);
+      ASSERT_NE(func, nullptr);
+      std::vector<float> actual(n);
+      func(n, src.data(), actual.data());
+      ASSERT_EQ(std::memcmp(expected.data(), actual.data(), n * sizeof(float)), 0)
+          << "isa " << CpuIsaToString(isa) << " n " << n;
+    }
+  }
+}
+
+TEST(VectorizedFunctor, throughput) {
+  for (BinaryOp op : {BinaryOp::kAdd, BinaryOp::kSub, BinaryOp::kMul, BinaryOp::kDiv,
+                      BinaryOp::kMax, BinaryOp::kMin}) {
+    ReportBinaryThroughput<float>(op, "float");
+    ReportBinaryThroughput<double>(op, "double");
+    if (op != BinaryOp::kDiv) { ReportBinaryThroughput<int32_t>(op, "int32"); }
+  }
+  ReportReluThroughput<float>("float");
+  ReportReluThroughput<double>("double");
+  ReportReluThroughput<int32_t>("int32");
+  ReportHalfToFloatThroughput();
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -15,6 +15,8 @@ limitations under the License.
 */
 
 #include "oneflow/core/framework/attr_map.h"
+#include <mutex>
+#include "oneflow/core/common/hash_container.h"
 #include "oneflow/core/framework/attr_value.h"
 #include "oneflow/core/framework/attr_value_accessor.h"
 #include "oneflow/core/framework/user_op_attr.cfg.h"
@@ -42,12 +44,44 @@ const AttrName2AttrValWrapper& EmptyAttrName2AttrVal() {
 
 }  // namespace
 
+int32_t AttrNameId4Name(const std::string& attr_name) {
+  // Every thread caches the ids it has seen, so only the first lookup of a name takes the lock.
+  thread_local HashMap<std::string, int32_t> name2id_cache;
+  const auto& cache_iter = name2id_cache.find(attr_name);
+  if (cache_iter != name2id_cache.end()) { return cache_iter->second; }
+  static std::mutex mutex;
+  static HashMap<std::string, int32_t> name2id;
+  int32_t attr_name_id = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    attr_name_id = name2id.emplace(attr_name, name2id.size()).first->second;
+  }
+  name2id_cache.emplace(attr_name, attr_name_id);
+  return attr_name_id;
+}
+
 AttrName2AttrValWrapper::AttrName2AttrValWrapper(
     const std::shared_ptr<const AttrName2AttrVal>& attrs)
     : attrs_(attrs) {
+  attr_name_id2attr_val_.reserve(attrs_->size());
+  for (const auto& pair : *attrs_) {
+    attr_name_id2attr_val_.emplace_back(AttrNameId4Name(pair.first), &pair.second);
+  }
+  std::sort(attr_name_id2attr_val_.begin(), attr_name_id2attr_val_.end(),
+            [](const AttrNameId2AttrVal::value_type& lhs,
+               const AttrNameId2AttrVal::value_type& rhs) { return lhs.first < rhs.first; });
   hash_value_ = HashAttrName2AttrValWrapper(*this);
 }
 
+const std::shared_ptr<const user_op::AttrVal>* AttrName2AttrValWrapper::Attr4NameId(
+    int32_t attr_name_id) const {
+  const auto& iter = std::lower_bound(
+      attr_name_id2attr_val_.begin(), attr_name_id2attr_val_.end(), attr_name_id,
+      [](const AttrNameId2AttrVal::value_type& pair, int32_t id) { return pair.first < id; });
+  if (iter == attr_name_id2attr_val_.end() || iter->first != attr_name_id) { return nullptr; }
+  return iter->second;
+}
+
 bool AttrName2AttrValWrapper::operator==(const AttrName2AttrValWrapper& other) const {
   if (this->size() != other.size()) { return false; }
   for (const_iterator this_iter = this->begin(), that_iter = other.begin();
@@ -143,10 +177,15 @@ Maybe<const T&> ComposedAttrMap::GetAttr(const std::string& attr_name) const {
 
 const std::shared_ptr<const user_op::AttrVal>& ComposedAttrMap::Attr4Name(
     const std::string& attr_name) const {
-  const auto& prior_iter = prior_.find(attr_name);
-  if (prior_iter != prior_.end()) { return prior_iter->second; }
-  const auto& base_iter = base_.find(attr_name);
-  if (base_iter != base_.end()) { return base_iter->second; }
+  return Attr4NameId(AttrNameId4Name(attr_name));
+}
+
+const std::shared_ptr<const user_op::AttrVal>& ComposedAttrMap::Attr4NameId(
+    int32_t attr_name_id) const {
+  const auto* prior_attr = prior_.Attr4NameId(attr_name_id);
+  if (prior_attr != nullptr) { return *prior_attr; }
+  const auto* base_attr = base_.Attr4NameId(attr_name_id);
+  if (base_attr != nullptr) { return *base_attr; }
   static const std::shared_ptr<const user_op::AttrVal> none;
   return none;
 }
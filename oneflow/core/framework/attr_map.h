@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/symbol.h"
+#include "oneflow/core/common/small_vector.h"
 
 namespace oneflow {
 
@@ -34,6 +35,10 @@ class MutableCfgAttrMap;
 // Make sure AttrName2AttrVal is a ordered map.
 using AttrName2AttrVal = std::map<std::string, std::shared_ptr<const user_op::AttrVal>>;
 
+// Interns attr names into process-wide dense ids. Ids are never reused, so a caller may compute
+// the id of a hot attr once and look it up by id afterwards.
+int32_t AttrNameId4Name(const std::string& attr_name);
+
 class AttrName2AttrValWrapper {
  public:
   AttrName2AttrValWrapper(const std::shared_ptr<const AttrName2AttrVal>& attrs);
@@ -46,6 +51,7 @@ class AttrName2AttrValWrapper {
 
   AttrName2AttrValWrapper& operator=(const AttrName2AttrValWrapper& other) {
     attrs_ = other.attrs_;
+    attr_name_id2attr_val_ = other.attr_name_id2attr_val_;
     hash_value_ = other.hash_value_;
     return *this;
   }
@@ -58,10 +64,18 @@ class AttrName2AttrValWrapper {
 
   const_iterator find(const std::string& attr_name) const { return attrs_->find(attr_name); }
 
+  // Returns nullptr if there is no attr named by attr_name_id.
+  const std::shared_ptr<const user_op::AttrVal>* Attr4NameId(int32_t attr_name_id) const;
+
   size_t hash_value() const { return hash_value_; }
 
  private:
+  using AttrNameId2AttrVal =
+      small_vector<std::pair<int32_t, const std::shared_ptr<const user_op::AttrVal>*>, 8>;
+
   std::shared_ptr<const AttrName2AttrVal> attrs_;
+  // Points into *attrs_, sorted by attr name id.
+  AttrNameId2AttrVal attr_name_id2attr_val_;
   size_t hash_value_;
 };
 
@@ -98,6 +112,10 @@ class AttrMap final {
 
   const_iterator find(const std::string& attr_name) const { return attrs_.find(attr_name); }
 
+  const std::shared_ptr<const user_op::AttrVal>* Attr4NameId(int32_t attr_name_id) const {
+    return attrs_.Attr4NameId(attr_name_id);
+  }
+
   size_t hash_value() const { return attrs_.hash_value(); }
 
  private:
@@ -116,6 +134,7 @@ class ComposedAttrMap final {
   Maybe<const T&> GetAttr(const std::string& attr_name) const;
 
   const std::shared_ptr<const user_op::AttrVal>& Attr4Name(const std::string& attr_name) const;
+  const std::shared_ptr<const user_op::AttrVal>& Attr4NameId(int32_t attr_name_id) const;
 
   void ResetPrior(const AttrMap& prior) { prior_ = prior; }
   void ResetBase(const AttrMap& base) { base_ = base; }
@@ -82,5 +82,23 @@ TEST(AttrMap, hash_map) {
   ASSERT_EQ(attr_map2int_value.at(AttrMap(mut_attr_map)), 4);
 }
 
+TEST(ComposedAttrMap, prior_over_base) {
+  MutableCfgAttrMap base_attr_map{};
+  CHECK_JUST(base_attr_map.SetAttr<int32_t>("axis", 0));
+  CHECK_JUST(base_attr_map.SetAttr<int64_t>("dim", 1));
+  MutableCfgAttrMap prior_attr_map{};
+  CHECK_JUST(prior_attr_map.SetAttr<int32_t>("axis", 2));
+  ComposedAttrMap composed_attr_map(AttrMap(prior_attr_map), AttrMap(base_attr_map));
+  ASSERT_EQ(CHECK_JUST(composed_attr_map.GetAttr<int32_t>("axis")), 2);
+  ASSERT_EQ(CHECK_JUST(composed_attr_map.GetAttr<int64_t>("dim")), 1);
+  const int32_t dim_id = AttrNameId4Name("dim");
+  ASSERT_EQ(dim_id, AttrNameId4Name("dim"));
+  ASSERT_NE(dim_id, AttrNameId4Name("axis"));
+  ASSERT_TRUE(composed_attr_map.Attr4NameId(dim_id) == composed_attr_map.Attr4Name("dim"));
+  ASSERT_TRUE(composed_attr_map.Attr4Name("undefined") == nullptr);
+  composed_attr_map.ResetPrior(AttrMap());
+  ASSERT_EQ(CHECK_JUST(composed_attr_map.GetAttr<int32_t>("axis")), 0);
+}
+
 }  // namespace test
 }  // namespace oneflow
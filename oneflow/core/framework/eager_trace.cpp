@@ -0,0 +1,165 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <unordered_map>
+#include "oneflow/core/framework/eager_trace.h"
+#include "oneflow/core/framework/instruction_replay.h"
+#include "oneflow/core/framework/op_expr.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/eager/eager_oneflow.h"
+#include "oneflow/core/vm/id_generator.h"
+
+namespace oneflow {
+namespace one {
+
+namespace {
+
+std::unordered_map<std::string, std::unique_ptr<EagerTrace>>* ThreadLocalName2EagerTrace() {
+  static thread_local std::unordered_map<std::string, std::unique_ptr<EagerTrace>> name2trace;
+  return &name2trace;
+}
+
+EagerTrace** ThreadLocalCurrentEagerTrace() {
+  static thread_local EagerTrace* trace = nullptr;
+  return &trace;
+}
+
+Maybe<bool> IsTensorMetaMatched(const EagerTraceTensorMeta& meta, const Tensor& tensor) {
+  return meta.device == JUST(tensor.device()) && meta.dtype == tensor.dtype()->data_type()
+         && *meta.shape == *tensor.shape() && *meta.stride == *JUST(tensor.stride());
+}
+
+}  // namespace
+
+EagerTrace::EagerTrace()
+    : cursor_(0),
+      builder_(std::make_shared<vm::PhysicalIdGenerator>(), &instruction_list_,
+               &eager_symbol_list_),
+      max_pending_instructions_(
+          ParseIntegerFromEnv("ONEFLOW_EAGER_TRACE_MAX_PENDING_INSTRUCTIONS", 32)) {}
+
+Maybe<const EagerTraceOpCall*> EagerTrace::Match(const UserOpExpr& op_expr,
+                                                 const TensorTuple& inputs,
+                                                 const TensorTuple& outputs,
+                                                 Symbol<Device> default_device,
+                                                 const AttrMap& attrs) {
+  if (cursor_ >= calls_.size()) { return nullptr; }
+  const EagerTraceOpCall& call = calls_.at(cursor_);
+  if (call.op_expr != &op_expr || call.default_device != default_device) { return nullptr; }
+  if (call.input_metas.size() != inputs.size() || call.is_output_inplace.size() != outputs.size()) {
+    return nullptr;
+  }
+  for (int i = 0; i < inputs.size(); ++i) {
+    if (!JUST(IsTensorMetaMatched(call.input_metas.at(i), *inputs.at(i)))) { return nullptr; }
+  }
+  size_t inplace_output_idx = 0;
+  for (int i = 0; i < outputs.size(); ++i) {
+    if (call.is_output_inplace.at(i) != static_cast<bool>(outputs.at(i))) { return nullptr; }
+    if (!outputs.at(i)) { continue; }
+    const auto& meta = call.inplace_output_metas.at(inplace_output_idx++);
+    if (!JUST(IsTensorMetaMatched(meta, *outputs.at(i)))) { return nullptr; }
+  }
+  if (!(call.attrs == attrs)) { return nullptr; }
+  // A different op expr may have been allocated at the address of a released one. The recorded
+  // kernel is held by the trace, so it can only be returned by the recorded op expr.
+  if (JUST(op_expr.MutKernel4Device(call.op_device)) != call.kernel) { return nullptr; }
+  ++cursor_;
+  return &call;
+}
+
+void EagerTrace::Record(EagerTraceOpCall&& call) {
+  calls_.resize(cursor_);
+  calls_.emplace_back(std::move(call));
+  ++cursor_;
+}
+
+Maybe<void> EagerTrace::TryFlush() {
+  if (instruction_list_.size() >= max_pending_instructions_) { JUST(Flush()); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EagerTrace::Flush() {
+  if (instruction_list_.empty()) { return Maybe<void>::Ok(); }
+  vm::InstructionMsgList instruction_list;
+  instruction_list_.MoveTo(&instruction_list);
+  if (debug::RecordingInstructions()) {
+    INTRUSIVE_FOR_EACH(instruction_msg, &instruction_list) {
+      debug::RecordInstruction(instruction_msg);
+    }
+  }
+  JUST(Global<vm::EagerOneflow>::Get()->RunPhysicalInstruction(&instruction_list,
+                                                              eager_symbol_list_));
+  eager_symbol_list_.clear_eager_symbol();
+  return Maybe<void>::Ok();
+}
+
+EagerTrace* CurrentEagerTrace() { return *ThreadLocalCurrentEagerTrace(); }
+
+Maybe<void> BeginEagerTrace(const std::string& name) {
+  CHECK_OR_RETURN(CurrentEagerTrace() == nullptr) << "eager traces can not be nested";
+  auto* name2trace = ThreadLocalName2EagerTrace();
+  auto iter = name2trace->find(name);
+  if (iter == name2trace->end()) {
+    iter = name2trace->emplace(name, std::make_unique<EagerTrace>()).first;
+  }
+  iter->second->Rewind();
+  *ThreadLocalCurrentEagerTrace() = iter->second.get();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EndEagerTrace() {
+  auto* trace = CurrentEagerTrace();
+  CHECK_NOTNULL_OR_RETURN(trace) << "no eager trace to end";
+  *ThreadLocalCurrentEagerTrace() = nullptr;
+  return trace->Flush();
+}
+
+Maybe<void> AbortEagerTrace() {
+  auto* trace = CurrentEagerTrace();
+  CHECK_NOTNULL_OR_RETURN(trace) << "no eager trace to abort";
+  *ThreadLocalCurrentEagerTrace() = nullptr;
+  trace->Truncate();
+  return trace->Flush();
+}
+
+void ClearEagerTraces() {
+  CHECK(CurrentEagerTrace() == nullptr) << "can not clear eager traces while tracing";
+  ThreadLocalName2EagerTrace()->clear();
+}
+
+Maybe<void> FlushCurrentEagerTrace() {
+  auto* trace = CurrentEagerTrace();
+  if (trace == nullptr) { return Maybe<void>::Ok(); }
+  return trace->Flush();
+}
+
+Maybe<void> MakeEagerTraceTensorMetas(const TensorTuple& tensors,
+                                      std::vector<EagerTraceTensorMeta>* metas) {
+  metas->clear();
+  metas->reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    // Skips the outputs not given by the caller.
+    if (!tensor) { continue; }
+    // Copies the shape and the stride, which may be modified in place after the call.
+    metas->push_back(EagerTraceTensorMeta{std::make_shared<const Shape>(*tensor->shape()),
+                                          std::make_shared<const Stride>(*JUST(tensor->stride())),
+                                          tensor->dtype()->data_type(), JUST(tensor->device())});
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace one
+}  // namespace oneflow
@@ -0,0 +1,118 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_FRAMEWORK_EAGER_TRACE_H_
+#define ONEFLOW_CORE_FRAMEWORK_EAGER_TRACE_H_
+
+#include <string>
+#include <vector>
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/framework/attr_map.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/instructions_builder.h"
+#include "oneflow/core/framework/stride.h"
+
+namespace oneflow {
+namespace one {
+
+class UserOpExpr;
+class TensorTuple;
+class StatefulLocalOpKernel;
+
+struct EagerTraceTensorMeta final {
+  std::shared_ptr<const Shape> shape;
+  std::shared_ptr<const Stride> stride;
+  DataType dtype;
+  Symbol<Device> device;
+};
+
+// One interpreted eager local op call. The first fields identify the call, the others are what
+// NaiveInterpret inferred for it.
+struct EagerTraceOpCall final {
+  const UserOpExpr* op_expr;
+  Symbol<Device> default_device;
+  std::vector<EagerTraceTensorMeta> input_metas;
+  AttrMap attrs;
+  std::vector<bool> is_output_inplace;
+  // metas of the outputs given by the caller, in the order of the outputs
+  std::vector<EagerTraceTensorMeta> inplace_output_metas;
+
+  std::shared_ptr<StatefulLocalOpKernel> kernel;
+  Symbol<Device> op_device;
+  bool need_check_mem_case;
+  std::vector<EagerTraceTensorMeta> output_metas;
+};
+
+// Records the sequence of eager local op calls made between BeginEagerTrace and EndEagerTrace.
+// When the same trace is entered again, a call identical to the recorded one at the same position
+// skips device and shape inference, and its instructions are batched with the following calls
+// instead of being sent to the virtual machine one by one.
+class EagerTrace final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EagerTrace);
+  EagerTrace();
+  ~EagerTrace() = default;
+
+  // Returns the recorded call at the cursor and moves the cursor on if it matches the call,
+  // otherwise returns nullptr.
+  Maybe<const EagerTraceOpCall*> Match(const UserOpExpr& op_expr, const TensorTuple& inputs,
+                                       const TensorTuple& outputs, Symbol<Device> default_device,
+                                       const AttrMap& attrs);
+  // Replaces the recorded calls from the cursor on with `call` and moves the cursor on.
+  void Record(EagerTraceOpCall&& call);
+
+  // Instructions built here are sent to the virtual machine by Flush.
+  InstructionsBuilder* mut_builder() { return &builder_; }
+  Maybe<void> TryFlush();
+  Maybe<void> Flush();
+
+  void Rewind() { cursor_ = 0; }
+  // Drops the recorded calls from the cursor on, which the aborted pass did not reach.
+  void Truncate() { calls_.resize(cursor_); }
+
+ private:
+  std::vector<EagerTraceOpCall> calls_;
+  size_t cursor_;
+  vm::InstructionMsgList instruction_list_;
+  vm::cfg::EagerSymbolList eager_symbol_list_;
+  InstructionsBuilder builder_;
+  size_t max_pending_instructions_;
+};
+
+// Returns the trace of this thread being recorded or replayed, or nullptr.
+EagerTrace* CurrentEagerTrace();
+
+Maybe<void> BeginEagerTrace(const std::string& name);
+Maybe<void> EndEagerTrace();
+// Ends the current trace after an error in the traced code. The instructions of the calls made so
+// far are still sent to the virtual machine.
+Maybe<void> AbortEagerTrace();
+void ClearEagerTraces();
+
+// Sends the pending instructions of the current trace to the virtual machine. PhysicalRun calls it
+// first so that instructions stay in program order.
+Maybe<void> FlushCurrentEagerTrace();
+
+// Skips the null tensors, i.e. the outputs the caller leaves to the op.
+Maybe<void> MakeEagerTraceTensorMetas(const TensorTuple& tensors,
+                                      std::vector<EagerTraceTensorMeta>* metas);
+
+}  // namespace one
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_FRAMEWORK_EAGER_TRACE_H_
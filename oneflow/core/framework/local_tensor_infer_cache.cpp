@@ -0,0 +1,164 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <atomic>
+#include "oneflow/core/framework/local_tensor_infer_cache.h"
+#include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_impl.h"
+#include "oneflow/core/framework/op_expr.h"
+#include "oneflow/core/framework/stride.h"
+
+namespace oneflow {
+namespace one {
+
+namespace {
+
+std::atomic<int64_t>* MutHitCount() {
+  static std::atomic<int64_t> hit_count(0);
+  return &hit_count;
+}
+
+std::atomic<int64_t>* MutMissCount() {
+  static std::atomic<int64_t> miss_count(0);
+  return &miss_count;
+}
+
+class MutMirroredTensorMeta : public TensorMeta {
+ public:
+  MutMirroredTensorMeta() : TensorMeta(std::make_shared<const Shape>(), kInvalidDataType) {}
+  MutMirroredTensorMeta(const MutMirroredTensorMeta&) = default;
+  MutMirroredTensorMeta(MutMirroredTensorMeta&&) = default;
+  ~MutMirroredTensorMeta() override = default;
+};
+
+}  // namespace
+
+size_t LocalTensorMetaInferArgs::hash_value() const {
+  size_t hash_value = std::hash<AttrMap>()(attrs_);
+  HashCombine(&hash_value, std::hash<Symbol<Device>>()(default_device_));
+  for (const auto& tensor_meta : input_tensor_metas_) {
+    HashCombine(&hash_value, tensor_meta.CalcHashValue());
+  }
+  return hash_value;
+}
+
+bool LocalTensorMetaInferArgs::operator==(const LocalTensorMetaInferArgs& other) const {
+  return this->attrs_ == other.attrs_ && this->default_device_ == other.default_device_
+         && this->input_tensor_metas_ == other.input_tensor_metas_;
+}
+
+Maybe<void> LocalTensorMetaInferArgs::Init(const AttrMap& attrs, Symbol<Device> default_device,
+                                           const TensorTuple& input_tensors) {
+  attrs_ = attrs;
+  default_device_ = default_device;
+  input_tensor_metas_.clear();
+  input_tensor_metas_.reserve(input_tensors.size());
+  for (const auto& tensor : input_tensors) {
+    const auto* tensor_impl = JUST(tensor->mut_eager_mirrored_tensor_impl());
+    input_tensor_metas_.push_back(*tensor_impl->tensor_meta());
+  }
+  return Maybe<void>::Ok();
+}
+
+LocalTensorMetaInferArgs LocalTensorMetaInferArgs::DeepCopy() const {
+  LocalTensorMetaInferArgs infer_args;
+  infer_args.attrs_ = attrs_;
+  infer_args.default_device_ = default_device_;
+  infer_args.input_tensor_metas_.reserve(input_tensor_metas_.size());
+  for (const auto& tensor_meta : input_tensor_metas_) {
+    infer_args.input_tensor_metas_.emplace_back(
+        std::make_shared<const Shape>(tensor_meta.shape()), tensor_meta.dtype(),
+        tensor_meta.device(), tensor_meta.stride_ptr(), tensor_meta.storage_offset());
+  }
+  return infer_args;
+}
+
+LocalTensorInferCache::LocalTensorInferCache(const std::shared_ptr<const UserOpExpr>& user_op_expr)
+    : user_op_expr_(user_op_expr),
+      max_size_(ParseIntegerFromEnv("ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_SIZE", 256)) {}
+
+/* static */ Maybe<const LocalTensorInferResult> LocalTensorInferCache::Infer(
+    const UserOpExpr& user_op_expr, const LocalTensorMetaInferArgs& infer_args,
+    const TensorTuple& input_tensors) {
+  const auto& input_tensor_metas = infer_args.input_tensor_metas();
+  auto result = std::make_unique<LocalTensorInferResult>(user_op_expr.output_size());
+  std::vector<Symbol<Device>> output_devices(user_op_expr.output_size());
+  // Infer devices
+  if (!user_op_expr.has_device_infer_fn()) {
+    result->set_op_device(infer_args.default_device());
+    for (auto& device : output_devices) { device = infer_args.default_device(); }
+  } else {
+    // The device infer functions set the devices of output tensors.
+    TensorTuple output_tensors(user_op_expr.output_size());
+    for (auto& tensor : output_tensors) {
+      tensor = std::make_shared<MirroredTensor>(std::make_shared<EagerMirroredTensorImpl>());
+    }
+    result->set_op_device(
+        JUST(user_op_expr.InferDevices(infer_args.attrs(), input_tensors, &output_tensors)));
+    for (int32_t i = 0; i < user_op_expr.output_size(); ++i) {
+      output_devices.at(i) = JUST(output_tensors.at(i)->device());
+    }
+  }
+  // Infer shapes and dtypes
+  std::vector<MutMirroredTensorMeta> output_mut_metas(user_op_expr.output_size());
+  const auto& device_tag = JUST(result->op_device()->of_type());
+  JUST(user_op_expr.InferPhysicalShapeAndDType(
+      infer_args.attrs(), device_tag,
+      [&](int32_t i) -> const TensorMeta* { return &input_tensor_metas.at(i); },
+      [&](int32_t i) -> TensorMeta* { return &output_mut_metas.at(i); }));
+  auto* output_metas = result->mut_output_tensor_metas();
+  for (int32_t i = 0; i < user_op_expr.output_size(); ++i) {
+    const auto& output_mut_meta = output_mut_metas.at(i);
+    const auto& shape = output_mut_meta.shape_ptr();
+    output_metas->emplace_back(shape, output_mut_meta.dtype(), output_devices.at(i),
+                               std::make_shared<const Stride>(*shape), 0);
+    output_metas->back().set_is_dynamic(output_mut_meta.is_dynamic());
+  }
+  return std::shared_ptr<const LocalTensorInferResult>(std::move(result));
+}
+
+Maybe<const LocalTensorInferResult> LocalTensorInferCache::GetOrInfer(
+    const LocalTensorMetaInferArgs& infer_args, const TensorTuple& input_tensors) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto iter = cache_.find(infer_args);
+    if (likely(iter != cache_.end())) {
+      MutHitCount()->fetch_add(1, std::memory_order_relaxed);
+      return iter->second;
+    }
+  }
+  MutMissCount()->fetch_add(1, std::memory_order_relaxed);
+  const auto& user_op_expr = user_op_expr_.lock();
+  CHECK_OR_RETURN(static_cast<bool>(user_op_expr));
+  const auto& result = JUST(Infer(*user_op_expr, infer_args, input_tensors));
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Ops called with ever-changing shapes should not grow the cache without bound.
+  if (cache_.size() >= max_size_) { cache_.clear(); }
+  cache_.emplace(infer_args.DeepCopy(), result);
+  return result;
+}
+
+/* static */ int64_t LocalTensorInferCache::hit_count() { return *MutHitCount(); }
+
+/* static */ int64_t LocalTensorInferCache::miss_count() { return *MutMissCount(); }
+
+/* static */ void LocalTensorInferCache::ResetCounters() {
+  *MutHitCount() = 0;
+  *MutMissCount() = 0;
+}
+
+}  // namespace one
+}  // namespace oneflow
@@ -0,0 +1,127 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
+#define ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
+
+#include <mutex>
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/framework/attr_map.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/tensor_meta.h"
+
+namespace oneflow {
+namespace one {
+
+class TensorTuple;
+class UserOpExpr;
+
+class LocalTensorMetaInferArgs final {
+ public:
+  LocalTensorMetaInferArgs() = default;
+  LocalTensorMetaInferArgs(const LocalTensorMetaInferArgs&) = default;
+  LocalTensorMetaInferArgs(LocalTensorMetaInferArgs&&) = default;
+  ~LocalTensorMetaInferArgs() = default;
+
+  const AttrMap& attrs() const { return attrs_; }
+  Symbol<Device> default_device() const { return default_device_; }
+  const std::vector<MirroredTensorMeta>& input_tensor_metas() const {
+    return input_tensor_metas_;
+  }
+
+  size_t hash_value() const;
+
+  bool operator==(const LocalTensorMetaInferArgs& other) const;
+
+  Maybe<void> Init(const AttrMap& attrs, Symbol<Device> default_device,
+                   const TensorTuple& input_tensors);
+
+  // Input shapes are shared with the input tensors, which may modify them in place. Cache keys
+  // own copies of them instead.
+  LocalTensorMetaInferArgs DeepCopy() const;
+
+ private:
+  AttrMap attrs_;
+  Symbol<Device> default_device_;
+  std::vector<MirroredTensorMeta> input_tensor_metas_;
+};
+
+}  // namespace one
+}  // namespace oneflow
+
+namespace std {
+
+template<>
+struct hash<oneflow::one::LocalTensorMetaInferArgs> final {
+  size_t operator()(const oneflow::one::LocalTensorMetaInferArgs& val) const {
+    return val.hash_value();
+  }
+};
+
+}  // namespace std
+
+namespace oneflow {
+namespace one {
+
+class LocalTensorInferResult final {
+ public:
+  LocalTensorInferResult(size_t output_size) { output_tensor_metas_.reserve(output_size); }
+  LocalTensorInferResult(const LocalTensorInferResult&) = delete;
+  LocalTensorInferResult(LocalTensorInferResult&&) = delete;
+  ~LocalTensorInferResult() = default;
+
+  const std::vector<MirroredTensorMeta>& output_tensor_metas() const {
+    return output_tensor_metas_;
+  }
+  std::vector<MirroredTensorMeta>* mut_output_tensor_metas() { return &output_tensor_metas_; }
+
+  const Symbol<Device>& op_device() const { return op_device_; }
+  void set_op_device(const Symbol<Device>& op_device) { op_device_ = op_device; }
+
+ private:
+  std::vector<MirroredTensorMeta> output_tensor_metas_;
+  Symbol<Device> op_device_;
+};
+
+// Caches the devices, shapes and dtypes inferred for the eager local calls of a UserOpExpr.
+class LocalTensorInferCache final {
+ public:
+  LocalTensorInferCache(const std::shared_ptr<const UserOpExpr>& user_op_expr);
+
+  Maybe<const LocalTensorInferResult> GetOrInfer(const LocalTensorMetaInferArgs& infer_args,
+                                                 const TensorTuple& input_tensors);
+
+  static Maybe<const LocalTensorInferResult> Infer(const UserOpExpr& user_op_expr,
+                                                   const LocalTensorMetaInferArgs& infer_args,
+                                                   const TensorTuple& input_tensors);
+
+  // Counted over all op exprs.
+  static int64_t hit_count();
+  static int64_t miss_count();
+  static void ResetCounters();
+
+ private:
+  std::weak_ptr<const UserOpExpr> user_op_expr_;
+  size_t max_size_;
+  // Backward nodes may be applied by several threads, see GraphTask::Apply.
+  std::mutex mutex_;
+  HashMap<LocalTensorMetaInferArgs, std::shared_ptr<const LocalTensorInferResult>> cache_;
+};
+
+}  // namespace one
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
@@ -120,6 +120,7 @@ class BuiltinOpExprImpl : public BuiltinOpExpr {
 
 class StatefulLocalOpKernel;
 class ConsistentTensorInferCache;
+class LocalTensorInferCache;
 
 class UserOpExpr final : public BuiltinOpExprImpl<UserOpConf> {
  public:
@@ -151,6 +152,9 @@ class UserOpExpr final : public BuiltinOpExprImpl<UserOpConf> {
   ConsistentTensorInferCache* mut_consistent_tensor_infer_cache() const {
     return consistent_tensor_infer_cache_.get();
   }
+  LocalTensorInferCache* mut_local_tensor_infer_cache() const {
+    return local_tensor_infer_cache_.get();
+  }
 
  private:
   UserOpExpr(const std::string& op_name, UserOpConf&& proto, const AttrMap& base_attrs,
@@ -161,8 +165,10 @@ class UserOpExpr final : public BuiltinOpExprImpl<UserOpConf> {
   user_op::TensorDescInferFn shape_infer_fn_;
   user_op::DataTypeInferFn dtype_infer_fn_;
   user_op::DeviceInferFn device_infer_fn_;
+  mutable std::mutex device2kernel_mutex_;
   mutable HashMap<Symbol<Device>, std::shared_ptr<StatefulLocalOpKernel>> device2kernel_;
   std::shared_ptr<ConsistentTensorInferCache> consistent_tensor_infer_cache_;
+  std::shared_ptr<LocalTensorInferCache> local_tensor_infer_cache_;
 };
 
 class ConsistentToConsistentOpExpr : public OpExpr {
@@ -16,9 +16,11 @@ limitations under the License.
 #include "oneflow/core/common/symbol.h"
 #include "oneflow/core/common/decorator.h"
 #include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/eager_trace.h"
 #include "oneflow/core/framework/op_interpreter.h"
 #include "oneflow/core/framework/op_interpreter/op_interpreter_util.h"
 #include "oneflow/core/framework/instructions_builder.h"
+#include "oneflow/core/framework/local_tensor_infer_cache.h"
 #include "oneflow/core/framework/op_arg_util.h"
 #include "oneflow/core/framework/scope_util.h"
 #include "oneflow/core/framework/session_util.h"
@@ -56,28 +58,48 @@ Maybe<EagerMirroredTensorImpl*> TensorImpl4Tensor(const std::shared_ptr<Tensor>&
   return tensor->mut_eager_mirrored_tensor_impl();
 }
 
-class MutMirroredTensorMeta : public TensorMeta {
- public:
-  MutMirroredTensorMeta() : TensorMeta(std::make_shared<const Shape>(), kInvalidDataType) {}
-  MutMirroredTensorMeta(const MutMirroredTensorMeta&) = default;
-  MutMirroredTensorMeta(MutMirroredTensorMeta&&) = default;
-  ~MutMirroredTensorMeta() override = default;
-};
-
-std::vector<TensorMeta*>* ThreadLocalDefaultOutputMutTensorMetas(int64_t size) {
-  static thread_local std::vector<MutMirroredTensorMeta> struct_vec;
-  static thread_local std::vector<TensorMeta*> ptr_vec;
-  struct_vec.resize(size);
-  ptr_vec.resize(size);
-  if (size == 1) {
-    ptr_vec.at(0) = &struct_vec.at(0);  // unfold loop
-  } else if (size == 2) {
-    ptr_vec.at(0) = &struct_vec.at(0);  // unfold loop
-    ptr_vec.at(1) = &struct_vec.at(1);  // unfold loop
-  } else {
-    for (int i = 0; i < size; ++i) { ptr_vec.at(i) = &struct_vec.at(i); }
+// Interprets an op call the same way as the recorded one, skipping device and shape inference.
+Maybe<void> ReplayEagerTraceOpCall(const EagerTraceOpCall& call, const TensorTuple& inputs,
+                                   TensorTuple* outputs, const OpExprInterpContext& ctx,
+                                   EagerTrace* trace) {
+  std::shared_ptr<EagerBlobObjectList> input_eager_blob_objects =
+      std::make_shared<EagerBlobObjectList>(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    input_eager_blob_objects->at(i) = JUST(inputs.at(i)->eager_blob_object());
   }
-  return &ptr_vec;
+  std::shared_ptr<EagerBlobObjectList> output_eager_blob_objects =
+      std::make_shared<EagerBlobObjectList>(outputs->size());
+  for (int i = 0; i < outputs->size(); i++) {
+    const auto& output_meta = call.output_metas.at(i);
+    if (!outputs->at(i)) {
+      const auto& tensor_impl = std::make_shared<EagerMirroredTensorImpl>();
+      outputs->at(i) = std::make_shared<MirroredTensor>(tensor_impl);
+      auto* tensor_meta = tensor_impl->mut_tensor_meta();
+      // TensorMeta::mut_shape may modify the shape, so the recorded one is not shared.
+      tensor_meta->set_shape(std::make_shared<const Shape>(*output_meta.shape));
+      tensor_meta->set_dtype(output_meta.dtype);
+      *tensor_meta->mut_device() = output_meta.device;
+      tensor_meta->set_stride(std::make_shared<Stride>(*output_meta.stride));
+      const auto& dep_object = JUST(GetLocalDepObjectFromDevicePool(call.op_device));
+      JUST(tensor_impl->InitEagerBlobObject(dep_object));
+    } else {
+      *JUST(JUST(TensorImpl4Tensor(outputs->at(i)))->mut_device()) = output_meta.device;
+    }
+    output_eager_blob_objects->at(i) = JUST(outputs->at(i)->eager_blob_object());
+  }
+
+  const auto& kernel = call.kernel;
+  for (int64_t index : kernel->output_tuple_indexes4mut2_obns()) {
+    output_eager_blob_objects->at(index)->set_is_shape_synced(false);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(*kernel->mut_main_thread_mutex());
+    kernel->set_need_check_mem_case(call.need_check_mem_case);
+    JUST(trace->mut_builder()->LocalCallOpKernel(kernel, input_eager_blob_objects,
+                                                 output_eager_blob_objects, ctx, call.op_device));
+  }
+  return trace->TryFlush();
 }
 
 }  // namespace
@@ -86,6 +108,18 @@ Maybe<void> NaiveInterpret(const UserOpExpr& user_op_expr, const TensorTuple& in
                            const Symbol<Device>& default_device, TensorTuple* outputs,
                            const OpExprInterpContext& ctx) {
   const auto& attrs = ctx.attrs;
+  EagerTrace* trace = CurrentEagerTrace();
+  std::vector<bool> is_output_inplace;
+  std::vector<EagerTraceTensorMeta> inplace_output_metas;
+  if (unlikely(trace != nullptr)) {
+    const auto* recorded_call =
+        JUST(trace->Match(user_op_expr, inputs, *outputs, default_device, attrs));
+    if (recorded_call != nullptr) {
+      return ReplayEagerTraceOpCall(*recorded_call, inputs, outputs, ctx, trace);
+    }
+    for (const auto& output : *outputs) { is_output_inplace.push_back(static_cast<bool>(output)); }
+    JUST(MakeEagerTraceTensorMetas(*outputs, &inplace_output_metas));
+  }
   std::shared_ptr<EagerBlobObjectList> input_eager_blob_objects =
       std::make_shared<EagerBlobObjectList>(inputs.size());
   for (int i = 0; i < inputs.size(); i++) {
@@ -97,72 +131,74 @@ Maybe<void> NaiveInterpret(const UserOpExpr& user_op_expr, const TensorTuple& in
   }
   std::shared_ptr<EagerBlobObjectList> output_eager_blob_objects =
       std::make_shared<EagerBlobObjectList>(outputs->size());
-  auto* output_tensor_metas = ThreadLocalDefaultOutputMutTensorMetas(outputs->size());
   for (int i = 0; i < outputs->size(); i++) {
     if (!outputs->at(i)) {
       const auto& tensor_impl = std::make_shared<EagerMirroredTensorImpl>();
       outputs->at(i) = std::make_shared<MirroredTensor>(tensor_impl);
-      output_tensor_metas->at(i) = tensor_impl->mut_tensor_meta();
     } else {
       bool has_eager_blob_object = JUST(outputs->at(i)->has_eager_blob_object());
       CHECK_OR_RETURN(has_eager_blob_object);
       output_eager_blob_objects->at(i) = JUST(outputs->at(i)->eager_blob_object());
     }
   }
-  Symbol<Device> op_device;
-  bool need_check_mem_case = true;
-
-  // Infer devices
-  if (!user_op_expr.has_device_infer_fn()) {
-    op_device = default_device;
-    for (int i = 0; i < outputs->size(); i++) {
-      auto* tensor_impl = JUST(TensorImpl4Tensor(outputs->at(i)));
-      *JUST(tensor_impl->mut_device()) = default_device;
-    }
-  } else {
-    need_check_mem_case = false;
-    op_device = JUST(user_op_expr.InferDevices(attrs, inputs, outputs));
-  }
 
-  // Infer shapes and dtypes
-  const auto& device_tag = JUST(op_device->of_type());
-  JUST(user_op_expr.InferPhysicalShapeAndDType(
-      attrs, device_tag,
-      [&](int32_t i) -> const TensorMeta* {
-        return CHECK_JUST(TensorImpl4Tensor(inputs.at(i)))->mut_tensor_meta();
-      },
-      [&](int32_t i) -> TensorMeta* {
-        // using thread_local TensorMeta pointer if inplace.
-        // using tensor_impl TensorMeta pointer if not inplace.
-        return output_tensor_metas->at(i);
-      }));
+  // Infer devices, shapes and dtypes
+  static thread_local LocalTensorMetaInferArgs infer_args;
+  JUST(infer_args.Init(attrs, default_device, inputs));
+  const auto& infer_result =
+      JUST(user_op_expr.mut_local_tensor_infer_cache()->GetOrInfer(infer_args, inputs));
+  const Symbol<Device> op_device = infer_result->op_device();
+  const bool need_check_mem_case = !user_op_expr.has_device_infer_fn();
 
   for (int i = 0; i < output_eager_blob_objects->size(); i++) {
     auto* tensor_impl = JUST(TensorImpl4Tensor(outputs->at(i)));
+    const auto& output_meta = infer_result->output_tensor_metas().at(i);
+    *JUST(tensor_impl->mut_device()) = output_meta.device();
     if (!output_eager_blob_objects->at(i)) {
-      tensor_impl->mut_tensor_meta()->set_stride(std::make_shared<Stride>(*tensor_impl->shape()));
+      auto* tensor_meta = tensor_impl->mut_tensor_meta();
+      // TensorMeta::mut_shape may modify the shape, so the cached one is not shared.
+      tensor_meta->set_shape(std::make_shared<const Shape>(output_meta.shape()));
+      tensor_meta->set_dtype(output_meta.dtype());
+      tensor_meta->set_is_dynamic(output_meta.is_dynamic());
+      tensor_meta->set_stride(output_meta.stride_ptr());
       const auto& dep_object = JUST(GetLocalDepObjectFromDevicePool(op_device));
       JUST(tensor_impl->InitEagerBlobObject(dep_object));
       output_eager_blob_objects->at(i) = JUST(tensor_impl->eager_blob_object());
     } else {
       // output i is inplaced.
-      // check thread_local TensorMeta and tensor_impl TensorMeta.
-      CHECK_OR_RETURN(tensor_impl->tensor_meta()->shape() == output_tensor_metas->at(i)->shape());
-      CHECK_OR_RETURN(tensor_impl->tensor_meta()->dtype() == output_tensor_metas->at(i)->dtype());
+      CHECK_OR_RETURN(tensor_impl->tensor_meta()->shape() == output_meta.shape());
+      CHECK_OR_RETURN(tensor_impl->tensor_meta()->dtype() == output_meta.dtype());
     }
   }
 
   const auto& kernel = JUST(user_op_expr.MutKernel4Device(op_device));
-  kernel->set_need_check_mem_case(need_check_mem_case);
-
   for (int64_t index : kernel->output_tuple_indexes4mut2_obns()) {
     output_eager_blob_objects->at(index)->set_is_shape_synced(false);
   }
 
-  JUST(PhysicalRun([&](InstructionsBuilder* builder) -> Maybe<void> {
-    return builder->LocalCallOpKernel(kernel, input_eager_blob_objects, output_eager_blob_objects,
-                                      ctx, op_device);
-  }));
+  {
+    std::unique_lock<std::mutex> lock(*kernel->mut_main_thread_mutex());
+    kernel->set_need_check_mem_case(need_check_mem_case);
+    JUST(PhysicalRun([&](InstructionsBuilder* builder) -> Maybe<void> {
+      return builder->LocalCallOpKernel(kernel, input_eager_blob_objects,
+                                        output_eager_blob_objects, ctx, op_device);
+    }));
+  }
+
+  if (unlikely(trace != nullptr)) {
+    EagerTraceOpCall call;
+    call.op_expr = &user_op_expr;
+    call.default_device = default_device;
+    JUST(MakeEagerTraceTensorMetas(inputs, &call.input_metas));
+    call.attrs = attrs;
+    call.is_output_inplace = std::move(is_output_inplace);
+    call.inplace_output_metas = std::move(inplace_output_metas);
+    call.kernel = kernel;
+    call.op_device = op_device;
+    call.need_check_mem_case = need_check_mem_case;
+    JUST(MakeEagerTraceTensorMetas(*outputs, &call.output_metas));
+    trace->Record(std::move(call));
+  }
   return Maybe<void>::Ok();
 }
 
@@ -115,16 +115,14 @@ Maybe<Tensor> Reshape(const std::shared_ptr<Tensor>& input, const Shape& shape)
 
   if (autograd::GradMode::is_enabled() && input->requires_grad()) {
     Shape input_shape(input->shape()->dim_vec());
-    auto backward_fn =
-        std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
-            [=](const TensorTuple& out_grads, TensorTuple* in_grads,
-                bool create_graph) -> Maybe<void> {
-              autograd::AutoGradMode mode(create_graph);
-              CHECK_EQ_OR_RETURN(out_grads.size(), 1);
-              in_grads->resize(1);
-              in_grads->at(0) = JUST(functional::Reshape(out_grads.at(0), input_shape));
-              return Maybe<void>::Ok();
-            });
+    auto backward_fn = std::make_shared<const BackwardFunction::Function>(
+        [=](const TensorTuple& out_grads, TensorTuple* in_grads, bool create_graph) -> Maybe<void> {
+          autograd::AutoGradMode mode(create_graph);
+          CHECK_EQ_OR_RETURN(out_grads.size(), 1);
+          in_grads->resize(1);
+          in_grads->at(0) = JUST(functional::Reshape(out_grads.at(0), input_shape));
+          return Maybe<void>::Ok();
+        });
     TensorTuple outputs{output};
     JUST(GetThreadLocalAutogradEngine()->AddBackwardFuncPtr("view::reshape_backward", backward_fn,
                                                             {input}, &outputs));
@@ -19,7 +19,7 @@ limitations under the License.
 namespace oneflow {
 namespace one {
 
-TensorTuple::TensorTuple(std::vector<std::shared_ptr<Tensor>>::size_type size) { resize(size); }
+TensorTuple::TensorTuple(size_type size) { resize(size); }
 
 TensorTuple::TensorTuple(std::initializer_list<std::shared_ptr<Tensor>> init_list) {
   for (const auto& tensor : init_list) { emplace_back(tensor); }
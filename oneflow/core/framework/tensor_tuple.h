@@ -18,20 +18,21 @@ limitations under the License.
 #define ONEFLOW_CORE_FRAMEWORK_TENSOR_TUPLE_H_
 
 #include <memory>
-#include <vector>
+#include "oneflow/core/common/small_vector.h"
 
 namespace oneflow {
 namespace one {
 
 class Tensor;
 
-class TensorTuple final : public std::vector<std::shared_ptr<Tensor>>,
+// Most ops take at most 4 inputs, so the tensors are stored inline up to that size.
+class TensorTuple final : public small_vector<std::shared_ptr<Tensor>, 4>,
                           public std::enable_shared_from_this<TensorTuple> {
  public:
   // TensorTuple(const TensorTuple&) = delete;
   // TensorTuple(TensorTuple&) = delete;
   TensorTuple() = default;
-  TensorTuple(std::vector<std::shared_ptr<Tensor>>::size_type size);
+  TensorTuple(size_type size);
   TensorTuple(std::initializer_list<std::shared_ptr<Tensor>> init_list);
   ~TensorTuple() = default;
 };
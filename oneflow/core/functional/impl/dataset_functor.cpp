@@ -93,7 +93,8 @@ class ReadOneRecFunctor {
   Maybe<Tensor> operator()(const std::vector<std::string>& files, const int32_t batch_size,
                            const bool random_shuffle, const std::string& shuffle_mode,
                            const int32_t shuffle_buffer_size, const bool shuffle_after_epoch,
-                           const bool verify_example,
+                           const bool verify_example, const int32_t num_load_workers,
+                           const int32_t prefetch_buffer_size,
                            const Optional<Symbol<ParallelDesc>>& placement,
                            const Optional<std::vector<Symbol<cfg::SbpParallel>>>& sbp) const {
     MutableAttrMap attrs;
@@ -104,6 +105,8 @@ class ReadOneRecFunctor {
     JUST(attrs.SetAttr<int32_t>("shuffle_buffer_size", shuffle_buffer_size));
     JUST(attrs.SetAttr<bool>("shuffle_after_epoch", shuffle_after_epoch));
     JUST(attrs.SetAttr<bool>("verify_example", verify_example));
+    JUST(attrs.SetAttr<int32_t>("num_load_workers", num_load_workers));
+    JUST(attrs.SetAttr<int32_t>("prefetch_buffer_size", prefetch_buffer_size));
 
     if (placement.has_value()) {
       JUST(CheckDeviceIdsIsValid(JUST(placement)));
@@ -37,7 +37,7 @@ void BoxingIdentityTaskNode::ConsumeAllRegsts() {
 void BoxingIdentityTaskNode::BuildExecGphAndRegst() {
   ExecNode* node = mut_exec_gph().NewNode();
   OperatorConf op_conf;
-  op_conf.set_name("System-Boxing-Identity-" + NewUniqueId());
+  op_conf.set_name("System-Boxing-Identity-" + std::to_string(task_id()));
   op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(this->device_type())));
   *op_conf.mutable_boxing_identity_conf()->mutable_lbi() = lbi();
   std::shared_ptr<Operator> sole_op = CHECK_JUST(ConstructOp(op_conf));
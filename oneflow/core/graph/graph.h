@@ -38,6 +38,9 @@ class Graph {
   Maybe<void> TopoForEachNodeWithErrorCaptured(
       std::function<Maybe<void>(NodeType*)> NodeHandler) const;
   void ReverseTopoForEachNode(std::function<void(NodeType*)> NodeHandler) const;
+  // Visits the nodes level by level, every node is one level after its deepest in node. There are
+  // no edges between the nodes of a level, so LevelHandler may process them in parallel.
+  void TopoForEachLevel(std::function<void(const std::vector<NodeType*>&)> LevelHandler) const;
   void ForEachEdge(std::function<void(EdgeType*)> EdgeHandler) const;
 
   void SortedTopoForEachNode(std::function<bool(const EdgeType* lhs, const EdgeType* rhs)> LessThan,
@@ -240,6 +243,36 @@ void Graph<NodeType, EdgeType>::ReverseTopoForEachNode(
                   NodeHandler);
 }
 
+template<typename NodeType, typename EdgeType>
+void Graph<NodeType, EdgeType>::TopoForEachLevel(
+    std::function<void(const std::vector<NodeType*>&)> LevelHandler) const {
+  HashMap<NodeType*, int64_t> node2pending_in_cnt;
+  std::vector<NodeType*> level;
+  for (const auto& node : nodes_) {
+    int64_t in_cnt = 0;
+    node->ForEachNodeOnInEdge([&](NodeType*) { ++in_cnt; });
+    if (in_cnt == 0) {
+      level.push_back(node.get());
+    } else {
+      node2pending_in_cnt[node.get()] = in_cnt;
+    }
+  }
+  size_t visited_cnt = 0;
+  std::vector<NodeType*> next_level;
+  while (!level.empty()) {
+    LevelHandler(level);
+    visited_cnt += level.size();
+    for (NodeType* node : level) {
+      node->ForEachNodeOnOutEdge([&](NodeType* out) {
+        if (--node2pending_in_cnt.at(out) == 0) { next_level.push_back(out); }
+      });
+    }
+    level.swap(next_level);
+    next_level.clear();
+  }
+  CHECK_EQ(visited_cnt, nodes_.size()) << "graph has a cycle";
+}
+
 template<typename NodeType, typename EdgeType>
 void Graph<NodeType, EdgeType>::ForEachEdge(std::function<void(EdgeType*)> EdgeHandler) const {
   for (auto& x : edges_) {
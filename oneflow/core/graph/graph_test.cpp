@@ -0,0 +1,125 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <random>
+#include "gtest/gtest.h"
+#include "oneflow/core/graph/graph.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+class TestEdge;
+
+class TestNode final : public Node<TestNode, TestEdge> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestNode);
+  TestNode() = default;
+  ~TestNode() override = default;
+};
+
+class TestEdge final : public Edge<TestNode, TestEdge> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestEdge);
+  TestEdge() = default;
+  ~TestEdge() override = default;
+};
+
+class TestGraph final : public Graph<TestNode, TestEdge> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestGraph);
+  TestGraph() = default;
+  ~TestGraph() override = default;
+};
+
+// Node i only gets edges from nodes before it, so the graph is acyclic.
+void InitRandomDag(TestGraph* graph, int64_t node_num, double edge_prob, int64_t seed) {
+  std::mt19937 gen(seed);
+  std::bernoulli_distribution has_edge(edge_prob);
+  std::vector<TestNode*> nodes;
+  FOR_RANGE(int64_t, i, 0, node_num) {
+    nodes.push_back(graph->NewNode());
+    FOR_RANGE(int64_t, j, 0, i) {
+      if (has_edge(gen)) { Connect(nodes.at(j), graph->NewEdge(), nodes.at(i)); }
+    }
+  }
+}
+
+void CheckLevels(const TestGraph& graph) {
+  HashMap<TestNode*, int64_t> node2level;
+  int64_t level_id = 0;
+  graph.TopoForEachLevel([&](const std::vector<TestNode*>& level) {
+    ASSERT_FALSE(level.empty());
+    for (TestNode* node : level) { ASSERT_TRUE(node2level.emplace(node, level_id).second); }
+    ++level_id;
+  });
+  ASSERT_EQ(node2level.size(), graph.node_num());
+  graph.ForEachNode([&](TestNode* node) {
+    // a node is exactly one level after its deepest in node, so no edge stays inside a level
+    int64_t expected_level = 0;
+    node->ForEachNodeOnInEdge([&](TestNode* in) {
+      ASSERT_LT(node2level.at(in), node2level.at(node));
+      expected_level = std::max(expected_level, node2level.at(in) + 1);
+    });
+    ASSERT_EQ(node2level.at(node), expected_level);
+  });
+}
+
+}  // namespace
+
+TEST(Graph, topo_for_each_level_empty) {
+  TestGraph graph;
+  int64_t level_num = 0;
+  graph.TopoForEachLevel([&](const std::vector<TestNode*>&) { ++level_num; });
+  ASSERT_EQ(level_num, 0);
+}
+
+TEST(Graph, topo_for_each_level_chain_and_diamond) {
+  TestGraph graph;
+  // a -> b -> d, a -> c -> d, a -> d, and an isolated e
+  TestNode* a = graph.NewNode();
+  TestNode* b = graph.NewNode();
+  TestNode* c = graph.NewNode();
+  TestNode* d = graph.NewNode();
+  TestNode* e = graph.NewNode();
+  Connect(a, graph.NewEdge(), b);
+  Connect(a, graph.NewEdge(), c);
+  Connect(b, graph.NewEdge(), d);
+  Connect(c, graph.NewEdge(), d);
+  Connect(a, graph.NewEdge(), d);
+  std::vector<HashSet<TestNode*>> levels;
+  graph.TopoForEachLevel([&](const std::vector<TestNode*>& level) {
+    levels.emplace_back(level.begin(), level.end());
+  });
+  ASSERT_EQ(levels.size(), 3);
+  ASSERT_EQ(levels.at(0), (HashSet<TestNode*>{a, e}));
+  ASSERT_EQ(levels.at(1), (HashSet<TestNode*>{b, c}));
+  ASSERT_EQ(levels.at(2), (HashSet<TestNode*>{d}));
+  CheckLevels(graph);
+}
+
+TEST(Graph, topo_for_each_level_random_dag) {
+  FOR_RANGE(int64_t, seed, 0, 20) {
+    for (double edge_prob : {0.0, 0.02, 0.1, 0.5, 1.0}) {
+      TestGraph graph;
+      InitRandomDag(&graph, 200, edge_prob, seed);
+      CheckLevels(graph);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -18,13 +18,13 @@ limitations under the License.
 namespace oneflow {
 
 int64_t NewNodeId() {
-  static int64_t node_id = 0;
-  return node_id++;
+  static std::atomic<int64_t> node_id(0);
+  return node_id.fetch_add(1, std::memory_order_relaxed);
 }
 
 int64_t NewEdgeId() {
-  static int64_t edge_id = 0;
-  return edge_id++;
+  static std::atomic<int64_t> edge_id(0);
+  return edge_id.fetch_add(1, std::memory_order_relaxed);
 }
 
 }  // namespace oneflow
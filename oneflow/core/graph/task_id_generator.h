@@ -29,6 +29,8 @@ class TaskIdGenerator final {
   ~TaskIdGenerator() = default;
 
   TaskId Generate(const StreamId& stream_id);
+  void SaveTaskIndex(HashMap<int64_t, task_index_t>* task_index_state) const;
+  void RestoreTaskIndex(const HashMap<int64_t, task_index_t>& task_index_state);
 
  private:
   HashMap<StreamId, task_index_t> stream_id2task_index_counter_;
@@ -39,6 +41,21 @@ inline TaskId TaskIdGenerator::Generate(const StreamId& stream_id) {
   return TaskId{stream_id, task_index};
 }
 
+inline void TaskIdGenerator::SaveTaskIndex(
+    HashMap<int64_t, task_index_t>* task_index_state) const {
+  for (const auto& pair : stream_id2task_index_counter_) {
+    (*task_index_state)[EncodeStreamIdToInt64(pair.first)] = pair.second;
+  }
+}
+
+inline void TaskIdGenerator::RestoreTaskIndex(
+    const HashMap<int64_t, task_index_t>& task_index_state) {
+  stream_id2task_index_counter_.clear();
+  for (const auto& pair : task_index_state) {
+    stream_id2task_index_counter_[DecodeStreamIdFromInt64(pair.first)] = pair.second;
+  }
+}
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_GRAPH_TASK_ID_GENERATOR_H_
@@ -0,0 +1,310 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/collective_boxing/cpu_executor_backend.h"
+#include "oneflow/core/job/collective_boxing/request_store.h"
+#include "oneflow/core/graph/boxing/collective_boxing_util.h"
+#include "oneflow/core/ccl/ccl.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_consistent_id.h"
+
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace {
+
+ccl::ReduceType GetCclReduceType(ReduceMethod reduce_method) {
+  if (reduce_method == kReduceMethodSum) {
+    return ccl::ReduceType::kSum;
+  } else {
+    UNIMPLEMENTED();
+    return ccl::ReduceType::kInvalidReduceFunctorType;
+  }
+}
+
+Symbol<ParallelDesc> GetCpuParallelDesc(const DeviceSet& device_set) {
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  for (const DeviceDesc& device_desc : device_set.device()) {
+    CHECK_EQ(device_desc.device_type(), DeviceType::kCPU);
+    parallel_conf.add_device_name(std::to_string(device_desc.machine_id()) + ":"
+                                  + std::to_string(device_desc.device_id()));
+  }
+  return SymbolOf(ParallelDesc(parallel_conf));
+}
+
+Maybe<void> LaunchFusedAllReduce(
+    const std::vector<const RequestEntry*>& request_entries,
+    const std::vector<std::shared_ptr<const RuntimeRequestInfo>>& runtime_request_infos,
+    Symbol<ParallelDesc> parallel_desc, std::vector<char>* fusion_buffer) {
+  const OpDesc& first_op_desc = request_entries.front()->desc().op_desc();
+  const DataType data_type = first_op_desc.data_type();
+  std::vector<int64_t> offset_vec;
+  offset_vec.reserve(request_entries.size());
+  int64_t offset = 0;
+  for (const RequestEntry* request_entry : request_entries) {
+    offset_vec.emplace_back(offset);
+    offset += request_entry->size_in_bytes();
+  }
+  if (fusion_buffer->size() < static_cast<size_t>(offset)) { fusion_buffer->resize(offset); }
+  for (int64_t i = 0; i < request_entries.size(); ++i) {
+    std::memcpy(fusion_buffer->data() + offset_vec.at(i), runtime_request_infos.at(i)->send_buff,
+                request_entries.at(i)->size_in_bytes());
+  }
+  JUST(ccl::AllReduce<DeviceType::kCPU>(
+      fusion_buffer->data(), fusion_buffer->data(), offset / GetSizeOfDataType(data_type),
+      data_type, GetCclReduceType(first_op_desc.reduce_method()), parallel_desc, nullptr));
+  for (int64_t i = 0; i < request_entries.size(); ++i) {
+    std::memcpy(runtime_request_infos.at(i)->recv_buff, fusion_buffer->data() + offset_vec.at(i),
+                request_entries.at(i)->size_in_bytes());
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> LaunchOp(const RequestEntry* request_entry,
+                     const std::shared_ptr<const RuntimeRequestInfo>& runtime_request_info,
+                     Symbol<ParallelDesc> parallel_desc) {
+  const auto& op_desc = request_entry->desc().op_desc();
+  const OpType op_type = op_desc.op_type();
+  const void* send_buff = runtime_request_info->send_buff;
+  void* recv_buff = runtime_request_info->recv_buff;
+  const int64_t elem_cnt = request_entry->elem_cnt();
+  const DataType data_type = op_desc.data_type();
+  const int64_t num_ranks = parallel_desc->parallel_num();
+  if (op_type == OpType::kOpTypeAllReduce) {
+    JUST(ccl::AllReduce<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type,
+                                          GetCclReduceType(op_desc.reduce_method()),
+                                          parallel_desc, nullptr));
+  } else if (op_type == OpType::kOpTypeAllGather) {
+    CHECK_EQ_OR_RETURN(elem_cnt % num_ranks, 0);
+    JUST(ccl::AllGather<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt / num_ranks, data_type,
+                                          parallel_desc, nullptr));
+  } else if (op_type == OpType::kOpTypeReduceScatter) {
+    CHECK_EQ_OR_RETURN(elem_cnt % num_ranks, 0);
+    JUST(ccl::ReduceScatter<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt / num_ranks,
+                                              data_type, GetCclReduceType(op_desc.reduce_method()),
+                                              parallel_desc, nullptr));
+  } else if (op_type == OpType::kOpTypeReduce) {
+    const int64_t root = request_entry->desc().device_set().device(op_desc.root()).machine_id();
+    JUST(ccl::Reduce<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type,
+                                       GetCclReduceType(op_desc.reduce_method()), root,
+                                       parallel_desc, nullptr));
+  } else if (op_type == OpType::kOpTypeBroadcast) {
+    const int64_t root = request_entry->desc().device_set().device(op_desc.root()).machine_id();
+    JUST(ccl::Broadcast<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type, root,
+                                          parallel_desc, nullptr));
+  } else {
+    UNIMPLEMENTED_THEN_RETURN();
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+struct CpuExecutorBackend::Impl {
+  Impl(const CollectiveBoxingConf& conf, std::shared_ptr<RequestStore> request_store)
+      : conf(conf), request_store(std::move(request_store)) {
+    CHECK_GE(conf.cpu_fusion_threshold_mb(), 0);
+    CHECK_GT(conf.cpu_fusion_max_ops(), 0);
+    fusion_threshold = conf.cpu_fusion_threshold_mb() * 1024 * 1024;
+    worker = std::thread(&Impl::PollWork, this);
+  }
+  ~Impl() {
+    work_chan.Close();
+    worker.join();
+  }
+
+  // The cpu collectives block until all ranks take part, so they run on a dedicated thread in the
+  // order the coordinator executes the groups, which is the same on every rank.
+  void PollWork() {
+    CHECK_JUST(InitThisThreadConsistentId(kThreadConsistentIdCollectiveBoxing,
+                                          "CpuCollectiveBoxingExecutor"));
+    while (true) {
+      std::function<void()> work;
+      ChannelStatus status = work_chan.Receive(&work);
+      if (status == kChannelStatusErrorClosed) { break; }
+      CHECK_EQ(status, kChannelStatusSuccess);
+      work();
+    }
+  }
+
+  void InitParallelDesc(int64_t job_id) {
+    request_store->ForEachMutRequestEntryInJob(
+        job_id, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const auto& request = request_entry->desc();
+          if (request.op_desc().backend() != Backend::kBackendCPU) { return; }
+          if (!request_entry->HasRankOnThisNode()) { return; }
+          CHECK_EQ(request_entry->LocalRankCount(), 1)
+              << "cpu collective boxing requires one rank per process";
+          const DeviceSet& device_set = request.device_set();
+          if (device_set2parallel_desc.count(device_set) > 0) { return; }
+          device_set2parallel_desc.emplace(device_set, GetCpuParallelDesc(device_set));
+        });
+  }
+
+  bool CanRequestEntryFuse(const RequestEntry* lhs, const RequestEntry* rhs) const {
+    if (lhs->device_set_symbol() != rhs->device_set_symbol()) { return false; }
+    const OpDesc& lhs_op_desc = lhs->desc().op_desc();
+    const OpDesc& rhs_op_desc = rhs->desc().op_desc();
+    return lhs_op_desc.op_type() == OpType::kOpTypeAllReduce
+           && rhs_op_desc.op_type() == OpType::kOpTypeAllReduce
+           && lhs_op_desc.reduce_method() == rhs_op_desc.reduce_method()
+           && lhs_op_desc.data_type() == rhs_op_desc.data_type();
+  }
+
+  void GroupRequests(const std::vector<RequestId>& request_ids,
+                     const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+    std::vector<RequestId> group;
+    int64_t group_size = 0;
+    const int64_t fusion_max_ops = conf.cpu_fusion_max_ops();
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        request_ids, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const int64_t size = request_entry->size_in_bytes();
+          if (group.empty()
+              || !CanRequestEntryFuse(request_store->MutRequestEntry(group.back()), request_entry)
+              || group_size + size > fusion_threshold || group.size() >= fusion_max_ops) {
+            if (!group.empty()) {
+              void* token = CreateGroupToken(group);
+              Handler(std::move(group), token);
+              group.clear();
+              group_size = 0;
+            }
+          }
+          group.emplace_back(request_id);
+          group_size += size;
+        });
+    if (!group.empty()) {
+      void* token = CreateGroupToken(group);
+      Handler(std::move(group), token);
+    }
+  }
+
+  struct GroupToken {
+    GroupToken(const std::vector<RequestId>& group, Symbol<ParallelDesc> parallel_desc)
+        : request_ids(group), parallel_desc(parallel_desc) {}
+    std::vector<RequestId> request_ids;
+    Symbol<ParallelDesc> parallel_desc;
+  };
+
+  void* CreateGroupToken(const std::vector<RequestId>& group) {
+    CHECK_GT(group.size(), 0);
+    const DeviceSet& first_device_set =
+        request_store->MutRequestEntry(group.front())->desc().device_set();
+    auto it = device_set2parallel_desc.find(first_device_set);
+    CHECK(it != device_set2parallel_desc.end());
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        group, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const DeviceSet& device_set = request_entry->desc().device_set();
+          CHECK(first_device_set == device_set);
+        });
+    return new GroupToken(group, it->second);
+  }
+
+  void DestroyGroupToken(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    delete token;
+  }
+
+  void ExecuteGroup(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    const std::vector<RequestId>& request_ids = token->request_ids;
+    if (request_ids.empty()) { return; }
+    // Take the runtime requests here so that the next iteration can be scheduled while the worker
+    // is still busy with this one.
+    std::vector<const RequestEntry*> request_entries;
+    std::vector<std::shared_ptr<const RuntimeRequestInfo>> runtime_request_infos;
+    request_entries.reserve(request_ids.size());
+    runtime_request_infos.reserve(request_ids.size());
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        request_ids, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          request_entries.emplace_back(request_entry);
+          runtime_request_infos.emplace_back(std::move(request_entry->ResetRuntimeRequest().at(0)));
+        });
+    CHECK_EQ(work_chan.Send([this, request_entries, runtime_request_infos,
+                             parallel_desc = token->parallel_desc]() {
+      const Maybe<void> status = Launch(request_entries, runtime_request_infos, parallel_desc);
+      for (const auto& runtime_request_info : runtime_request_infos) {
+        runtime_request_info->callback(status);
+      }
+    }),
+             kChannelStatusSuccess);
+  }
+
+  Maybe<void> Launch(
+      const std::vector<const RequestEntry*>& request_entries,
+      const std::vector<std::shared_ptr<const RuntimeRequestInfo>>& runtime_request_infos,
+      Symbol<ParallelDesc> parallel_desc) {
+    if (request_entries.size() > 1) {
+      // GroupRequests only puts all reduce requests of the same data type together
+      return LaunchFusedAllReduce(request_entries, runtime_request_infos, parallel_desc,
+                                  &fusion_buffer);
+    }
+    return LaunchOp(request_entries.front(), runtime_request_infos.front(), parallel_desc);
+  }
+
+  CollectiveBoxingConf conf;
+  int64_t fusion_threshold;
+  std::shared_ptr<RequestStore> request_store;
+  HashMap<DeviceSet, Symbol<ParallelDesc>> device_set2parallel_desc;
+  // only touched by the worker thread
+  std::vector<char> fusion_buffer;
+  Channel<std::function<void()>> work_chan;
+  std::thread worker;
+};
+
+CpuExecutorBackend::CpuExecutorBackend() = default;
+
+CpuExecutorBackend::~CpuExecutorBackend() = default;
+
+void CpuExecutorBackend::Init(std::shared_ptr<RequestStore> request_store) {
+  impl_ = std::make_unique<Impl>(Global<ResourceDesc, ForSession>::Get()->collective_boxing_conf(),
+                                 request_store);
+}
+
+void CpuExecutorBackend::InitJob(int64_t job_id) { impl_->InitParallelDesc(job_id); }
+
+void CpuExecutorBackend::DeinitJob(int64_t job_id) {}
+
+void CpuExecutorBackend::GroupRequests(
+    const std::vector<RequestId>& request_ids,
+    const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+  impl_->GroupRequests(request_ids, Handler);
+}
+
+void* CpuExecutorBackend::CreateGroupToken(const std::vector<RequestId>& group) {
+  return impl_->CreateGroupToken(group);
+}
+
+void CpuExecutorBackend::DestroyGroupToken(void* group_token) {
+  return impl_->DestroyGroupToken(group_token);
+}
+
+void CpuExecutorBackend::ExecuteGroup(void* group_token) { impl_->ExecuteGroup(group_token); }
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
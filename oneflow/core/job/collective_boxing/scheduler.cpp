@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/graph/boxing/collective_boxing_util.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/collective_boxing/nccl_executor_backend.h"
+#include "oneflow/core/job/collective_boxing/cpu_executor_backend.h"
 #include "oneflow/core/job/plan.pb.h"
 #include "oneflow/core/job/resource_desc.h"
 
@@ -118,6 +119,9 @@ class ExecutorImpl : public Executor {
 void ExecutorImpl::Init(std::shared_ptr<RequestStore> request_store) {
   request_store_ = request_store;
   backends_.resize(Backend_ARRAYSIZE);
+  std::unique_ptr<ExecutorBackend> cpu_backend = std::make_unique<CpuExecutorBackend>();
+  cpu_backend->Init(request_store_);
+  backends_.at(Backend::kBackendCPU) = std::move(cpu_backend);
 #ifdef WITH_CUDA
   std::unique_ptr<ExecutorBackend> nccl_backend = std::make_unique<NcclExecutorBackend>();
   nccl_backend->Init(request_store_);
@@ -126,15 +130,15 @@ void ExecutorImpl::Init(std::shared_ptr<RequestStore> request_store) {
 }
 
 void ExecutorImpl::InitJob(int64_t job_id) {
-#ifdef WITH_CUDA
-  backends_.at(Backend::kBackendNCCL)->InitJob(job_id);
-#endif
+  for (auto& backend : backends_) {
+    if (backend) { backend->InitJob(job_id); }
+  }
 }
 
 void ExecutorImpl::DeinitJob(int64_t job_id) {
-#ifdef WITH_CUDA
-  backends_.at(Backend::kBackendNCCL)->DeinitJob(job_id);
-#endif
+  for (auto& backend : backends_) {
+    if (backend) { backend->DeinitJob(job_id); }
+  }
 }
 
 GroupToken* ExecutorImpl::CreateGroupToken(const std::vector<RequestId>& group,
@@ -143,7 +147,7 @@ GroupToken* ExecutorImpl::CreateGroupToken(const std::vector<RequestId>& group,
 }
 
 void ExecutorImpl::DestroyGroupToken(GroupToken* group_token) {
-  backends_.at(Backend::kBackendNCCL)->DestroyGroupToken(group_token->backend_group_token());
+  backends_.at(group_token->backend())->DestroyGroupToken(group_token->backend_group_token());
   delete group_token;
 }
 
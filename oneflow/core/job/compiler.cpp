@@ -17,11 +17,11 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/intra_job_mem_sharing_util.h"
 #include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/plan_cache.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
 #include "oneflow/core/thread/thread_pool.h"
-#include "oneflow/core/common/blocking_counter.h"
 
 namespace oneflow {
 
@@ -45,10 +45,64 @@ void CreateOpAttributeRef(Plan* plan, int64_t job_id, TaskProto* task_proto) {
   kernel_conf->set_allocated_op_attribute(nullptr);
 }
 
+namespace {
+
+int64_t GetCompileThreadNum() {
+  const int64_t thread_num = ParseIntegerFromEnv("ONEFLOW_LAZY_COMPILE_THREAD_NUM",
+                                                 std::thread::hardware_concurrency());
+  return std::max<int64_t>(thread_num, 1);
+}
+
+// Runs Handler on the task nodes level by level, the nodes of a level run in parallel. A node only
+// writes its own produced regsts and reads the regsts of its producers, which are all done.
+void ParallelTopoForEachTaskNode(TaskGraph* task_gph, ThreadPool* thread_pool,
+                                 void (TaskNode::*Handler)()) {
+  task_gph->TopoForEachLevel([&](const std::vector<TaskNode*>& level) {
+    thread_pool->ParallelFor(level.size(), 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) { (level.at(i)->*Handler)(); }
+    });
+  });
+}
+
+class CompilePhaseTimer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CompilePhaseTimer);
+  CompilePhaseTimer() : phase_start_(GetCurTime()) {}
+  ~CompilePhaseTimer() = default;
+
+  void EndPhase(const std::string& phase) {
+    const double now = GetCurTime();
+    phase2seconds_.emplace_back(phase, (now - phase_start_) / 1000000000.0);
+    phase_start_ = now;
+  }
+
+  std::string ToString() const {
+    std::ostringstream ss;
+    for (const auto& pair : phase2seconds_) {
+      ss << " " << pair.first << " " << pair.second << "s,";
+    }
+    return ss.str();
+  }
+
+ private:
+  double phase_start_;
+  std::vector<std::pair<std::string, double>> phase2seconds_;
+};
+
+}  // namespace
+
 void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   // Step1: ensure job is completed.
   if (need_job_complete) { CHECK_JUST(JobCompleter().Complete(job)); }
 
+  // NOTE: the cached plan is keyed on the completed job, so all job passes still run on a hit.
+  PlanCache* plan_cache = plan->task_size() == 0 ? PlanCache::Get() : nullptr;
+  PlanCacheKey plan_cache_key;
+  if (plan_cache != nullptr) {
+    plan_cache->GenKey(*job, GlobalJobDesc().job_id(), &plan_cache_key);
+    if (CHECK_JUST(plan_cache->TryLoad(plan_cache_key, plan))) { return; }
+  }
+
   // Step2: new Global<OpGraph> and set log configs.
   Global<OpGraph>::New(*job);
   const JobDesc& job_desc = GlobalJobDesc();
@@ -61,44 +115,51 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
 
   // Step3: build task_gph.
   // TODO(levi): we can rewrite this part of code in visitor pattern.
+  CompilePhaseTimer timer;
+  ThreadPool thread_pool(GetCompileThreadNum());
   auto task_gph = std::make_unique<TaskGraph>();
+  timer.EndPhase("build task graph");
   using std::placeholders::_1;
+  // NOTE: producing and consuming regsts allocate regst desc ids and mutate the regsts of
+  // neighbours, so they stay serial.
   task_gph->ForEachNode(std::bind(&TaskNode::ProduceAllRegstsAndBindEdges, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::ConsumeAllRegsts, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::PinConsumedRegst, _1));
-  task_gph->TopoForEachNode(&TaskNode::Build);
+  timer.EndPhase("bind regsts");
+  ParallelTopoForEachTaskNode(task_gph.get(), &thread_pool, &TaskNode::Build);
+  timer.EndPhase("build task nodes");
   task_gph->RemoveEmptyRegsts();
   task_gph->MergeChainAndAddOrderingCtrlEdgeInSameChain();
   auto IsReachable = Global<OpGraph>::Get()->MakePredicatorIsOpNameDataOrCtrlReachable();
   if (job_desc.enable_inplace()) { task_gph->EnableInplaceMemSharing(IsReachable); }
-  task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  timer.EndPhase("merge chains and inplace");
+  ParallelTopoForEachTaskNode(task_gph.get(), &thread_pool, &TaskNode::InferTimeShapeIfMeaningful);
   task_gph->ForEachEdge([&](TaskEdge* task_edge) { task_edge->CheckRegstLbiValid(); });
+  timer.EndPhase("infer time shapes");
 
   // Step4: put infomation from task_gph into plan.
-  const int64_t node_num = task_gph->node_num();
-  const int64_t cpu_num = std::thread::hardware_concurrency();
-  const int64_t thread_pool_size = std::min(node_num, cpu_num);
-  BlockingCounter counter(node_num);
-  std::mutex mtx;
-  ThreadPool thread_pool(thread_pool_size);
+  // Every task node is serialized into its own slot and the slots are appended in node order,
+  // so the plan does not depend on the thread count.
+  std::vector<TaskNode*> meaningful_task_nodes;
+  meaningful_task_nodes.reserve(task_gph->node_num());
   task_gph->ForEachNode([&](TaskNode* task_node) {
-    thread_pool.AddWork([task_node, plan, &job_desc, &counter, &mtx]() {
-      if (!task_node->IsMeaningLess()) {
-        TaskProto task_proto;
-        task_node->ToProto(&task_proto);
-        {
-          std::unique_lock<std::mutex> guard(mtx);
-          if (task_node->GetTaskType() == kNormalForward || task_node->GetTaskType() == kRepeat
-              || task_node->GetTaskType() == kAcc) {
-            CreateOpAttributeRef(plan, job_desc.job_id(), &task_proto);
-          }
-          plan->mutable_task()->Add(std::move(task_proto));
-        }  // guard(mtx)
-      }
-      counter.Decrease();
-    } /* thread_pool.AddWork */);
-  } /* task_gph->ForEachNode */);
-  counter.WaitUntilCntEqualZero();
+    if (!task_node->IsMeaningLess()) { meaningful_task_nodes.push_back(task_node); }
+  });
+  std::vector<TaskProto> task_protos(meaningful_task_nodes.size());
+  thread_pool.ParallelFor(meaningful_task_nodes.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      meaningful_task_nodes.at(i)->ToProto(&task_protos.at(i));
+    }
+  });
+  plan->mutable_task()->Reserve(plan->task_size() + task_protos.size());
+  for (size_t i = 0; i < task_protos.size(); ++i) {
+    const TaskType task_type = meaningful_task_nodes.at(i)->GetTaskType();
+    if (task_type == kNormalForward || task_type == kRepeat || task_type == kAcc) {
+      CreateOpAttributeRef(plan, job_desc.job_id(), &task_protos.at(i));
+    }
+    plan->mutable_task()->Add(std::move(task_protos.at(i)));
+  }
+  timer.EndPhase("serialize tasks");
   // NOTE(levi): release task_gph here to decrise memory peak.
   task_gph.reset();
 
@@ -109,6 +170,15 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(plan, IsReachable);
   PlanUtil::SetUniqueMemBlockId4UnreusedMemRegst(plan);
   Global<OpGraph>::Delete();
+  timer.EndPhase("plan memory");
+  LOG(INFO) << "job_id: " << job_desc.job_id() << " , compile phases:" << timer.ToString();
+
+  if (plan_cache != nullptr) {
+    const auto& save_status = TRY(plan_cache->Save(plan_cache_key, *plan));
+    if (!save_status.IsOk()) {
+      LOG(WARNING) << "plan cache: failed to save plan, " << save_status.error()->msg();
+    }
+  }
 }
 
 }  // namespace oneflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/snapshot.h"
 #include "oneflow/core/device/cuda_util.h"
 #include "oneflow/core/vm/virtual_machine_scope.h"
 #include "oneflow/core/job/job_build_and_infer_ctx_mgr.h"
@@ -222,6 +223,7 @@ EnvGlobalObjectsScope::~EnvGlobalObjectsScope() {
     VLOG(2) << "Multi client session has not closed , env close it at env scope destruction.";
     CHECK_JUST(session_ctx->TryClose());
   }
+  WaitForPendingSnapshots();
   Global<KernelObserver>::Delete();
   if (!Global<ResourceDesc, ForSession>::Get()->enable_dry_run()) {
 #ifdef __linux__
@@ -28,4 +28,28 @@ IDMgr::IDMgr() {
   chunk_id_count_ = 0;
 }
 
+void IDMgr::SaveIdState(IdState* id_state) const {
+  id_state->set_regst_desc_id_count(regst_desc_id_count_);
+  id_state->set_mem_block_id_count(mem_block_id_count_);
+  id_state->set_chunk_id_count(chunk_id_count_);
+  HashMap<int64_t, TaskId::task_index_t> task_index_state;
+  task_id_gen_.SaveTaskIndex(&task_index_state);
+  *id_state->mutable_stream_id2task_index_counter() = HashMap2PbMap(task_index_state);
+  id_state->set_unique_id_count(MutUniqueIdCounter()->load());
+}
+
+void IDMgr::RestoreIdState(const IdState& id_state) {
+  regst_desc_id_count_ = id_state.regst_desc_id_count();
+  mem_block_id_count_ = id_state.mem_block_id_count();
+  chunk_id_count_ = id_state.chunk_id_count();
+  task_id_gen_.RestoreTaskIndex(PbMap2HashMap(id_state.stream_id2task_index_counter()));
+  // the ids handed out so far are in use whatever the restored state is, so the unique id
+  // counter only moves forward
+  std::atomic<int64_t>* unique_id_counter = MutUniqueIdCounter();
+  int64_t unique_id_count = unique_id_counter->load();
+  while (unique_id_count < id_state.unique_id_count()
+         && !unique_id_counter->compare_exchange_weak(unique_id_count,
+                                                      id_state.unique_id_count())) {}
+}
+
 }  // namespace oneflow
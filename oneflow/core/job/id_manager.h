@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_state.pb.h"
 #include "oneflow/core/graph/task_id_generator.h"
 
 namespace oneflow {
@@ -35,6 +36,11 @@ class IDMgr final {
 
   TaskIdGenerator* GetTaskIdGenerator() { return &task_id_gen_; }
 
+  // Snapshot of all id counters, a compiled plan is only valid together with the counters that
+  // were current when it was compiled.
+  void SaveIdState(IdState* id_state) const;
+  void RestoreIdState(const IdState& id_state);
+
  private:
   friend class Global<IDMgr>;
   IDMgr();
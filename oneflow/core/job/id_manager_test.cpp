@@ -72,4 +72,42 @@ TEST(IDMgr, compile_regst_desc_id) {
   Delete();
 }
 
+TEST(IDMgr, save_and_restore_id_state) {
+  New();
+  IDMgr* id_mgr = Global<IDMgr>::Get();
+  const StreamId stream_id(0, DeviceType::kCPU, 0, 0);
+  ASSERT_EQ(id_mgr->NewRegstDescId(), 0);
+  ASSERT_EQ(id_mgr->NewMemBlockId(), 0);
+  ASSERT_EQ(id_mgr->GetTaskIdGenerator()->Generate(stream_id).task_index(), 0);
+  IdState id_state;
+  id_mgr->SaveIdState(&id_state);
+  ASSERT_EQ(id_mgr->NewRegstDescId(), 1);
+  ASSERT_EQ(id_mgr->NewMemBlockId(), 1);
+  ASSERT_EQ(id_mgr->NewChunkId(), 0);
+  ASSERT_EQ(id_mgr->GetTaskIdGenerator()->Generate(stream_id).task_index(), 1);
+  id_mgr->RestoreIdState(id_state);
+  ASSERT_EQ(id_mgr->NewRegstDescId(), 1);
+  ASSERT_EQ(id_mgr->NewMemBlockId(), 1);
+  ASSERT_EQ(id_mgr->NewChunkId(), 0);
+  ASSERT_EQ(id_mgr->GetTaskIdGenerator()->Generate(stream_id).task_index(), 1);
+  Delete();
+}
+
+TEST(IDMgr, restore_only_advances_unique_id) {
+  New();
+  IDMgr* id_mgr = Global<IDMgr>::Get();
+  IdState id_state;
+  id_mgr->SaveIdState(&id_state);
+  const int64_t unique_id = std::stoll(NewUniqueId());
+  ASSERT_GE(unique_id, id_state.unique_id_count());
+  // a state saved before the last id does not hand it out again
+  id_mgr->RestoreIdState(id_state);
+  ASSERT_EQ(std::stoll(NewUniqueId()), unique_id + 1);
+  // a state saved later, e.g. by the process that compiled a cached plan, skips its ids
+  id_state.set_unique_id_count(unique_id + 100);
+  id_mgr->RestoreIdState(id_state);
+  ASSERT_EQ(std::stoll(NewUniqueId()), unique_id + 100);
+  Delete();
+}
+
 }  // namespace oneflow
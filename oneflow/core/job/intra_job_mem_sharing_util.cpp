@@ -22,6 +22,10 @@ limitations under the License.
 #include "oneflow/core/thread/thread_pool.h"
 #include "oneflow/core/graph/task_node.h"
 #include "oneflow/core/job/plan_util.h"
+#include <chrono>
+#include <limits>
+#include <numeric>
+#include <random>
 
 namespace oneflow {
 
@@ -29,6 +33,7 @@ enum MemAllocAlgoType {
   kMemSizeFirstAlgo = 0,
   kMutualExclusionFirstAlgo = 1,
   kTimeLineAlgo = 2,
+  kStripPackingAlgo = 3,
 };
 
 }  // namespace oneflow
@@ -48,10 +53,7 @@ namespace oneflow {
 
 namespace {
 
-struct MemBlockResultInfo {
-  size_t mem_block_size;
-  HashMap<RegstDescProto*, int64_t> regst_desc2offset;
-};
+using detail::MemBlockResultInfo;
 
 int64_t GenDeviceUniqueId(int64_t machine_id, int64_t device_id) {
   return (machine_id << 32) | device_id;
@@ -693,6 +695,173 @@ void MemReusedAlgorithm_TimeLineAlgo(
   result->mem_block_size = bfc_allocator.buffer_size();
 }
 
+}  // namespace
+
+namespace detail {
+
+int64_t MemLowerBound4TimeLine(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                               const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline) {
+  CHECK_EQ(alloc_regsts_timeline.size(), free_regsts_timeline.size());
+  int64_t live_size = 0;
+  int64_t max_live_size = 0;
+  for (int64_t i = 0; i < alloc_regsts_timeline.size(); ++i) {
+    for (RegstDescProto* alloc_regst : alloc_regsts_timeline.at(i)) {
+      live_size += RtRegstDesc(*alloc_regst).TotalMainByteSize4AllRegst();
+    }
+    max_live_size = std::max(max_live_size, live_size);
+    for (RegstDescProto* free_regst : free_regsts_timeline.at(i)) {
+      live_size -= RtRegstDesc(*free_regst).TotalMainByteSize4AllRegst();
+    }
+  }
+  CHECK_EQ(live_size, 0);
+  return max_live_size;
+}
+
+int64_t StripPackingPlaceByOrder(const std::vector<int32_t>& order,
+                                 const std::vector<int64_t>& sizes,
+                                 const std::vector<std::vector<int32_t>>& mutual_exclusions,
+                                 std::vector<int64_t>* offsets, int32_t* peak_index) {
+  offsets->assign(sizes.size(), -1);
+  int64_t peak = 0;
+  *peak_index = -1;
+  std::vector<std::pair<int64_t, int64_t>> occupied;
+  for (int32_t index : order) {
+    occupied.clear();
+    for (int32_t mutual : mutual_exclusions.at(index)) {
+      const int64_t mutual_offset = offsets->at(mutual);
+      if (mutual_offset >= 0) {
+        occupied.emplace_back(mutual_offset, mutual_offset + sizes[mutual]);
+      }
+    }
+    std::sort(occupied.begin(), occupied.end());
+    const int64_t size = sizes.at(index);
+    int64_t offset = -1;
+    int64_t best_gap = std::numeric_limits<int64_t>::max();
+    int64_t cursor = 0;
+    for (const auto& pair : occupied) {
+      const int64_t gap = pair.first - cursor;
+      if (gap >= size && gap > 0 && gap < best_gap) {
+        best_gap = gap;
+        offset = cursor;
+      }
+      cursor = std::max(cursor, pair.second);
+    }
+    if (offset == -1) { offset = cursor; }
+    offsets->at(index) = offset;
+    if (offset + size > peak || *peak_index == -1) {
+      peak = offset + size;
+      *peak_index = index;
+    }
+  }
+  return peak;
+}
+
+void MemReusedAlgorithm_StripPackingAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
+    const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusion_regsts,
+    int64_t max_iterations, int64_t time_budget_ms, MemBlockResultInfo* result) {
+  std::vector<RegstDescProto*> regsts;
+  regsts.reserve(regst2mutual_exclusion_regsts.size());
+  for (const auto& pair : regst2mutual_exclusion_regsts) { regsts.emplace_back(pair.first); }
+  // HashMap order is not stable, index regsts by id so that the result is reproducible
+  std::sort(regsts.begin(), regsts.end(), [](RegstDescProto* lhs, RegstDescProto* rhs) {
+    return lhs->regst_desc_id() < rhs->regst_desc_id();
+  });
+  const int32_t num_regsts = regsts.size();
+  HashMap<RegstDescProto*, int32_t> regst2index;
+  std::vector<int64_t> sizes(num_regsts);
+  for (int32_t i = 0; i < num_regsts; ++i) {
+    CHECK(regst2index.emplace(regsts[i], i).second);
+    sizes[i] = RtRegstDesc(*regsts[i]).TotalMainByteSize4AllRegst();
+  }
+  std::vector<int64_t> lifetimes(num_regsts, 0);
+  {
+    std::vector<int64_t> alloc_index(num_regsts, 0);
+    for (int64_t i = 0; i < alloc_regsts_timeline.size(); ++i) {
+      for (RegstDescProto* regst : alloc_regsts_timeline.at(i)) {
+        alloc_index[regst2index.at(regst)] = i;
+      }
+      for (RegstDescProto* regst : free_regsts_timeline.at(i)) {
+        const int32_t index = regst2index.at(regst);
+        lifetimes[index] = i - alloc_index[index] + 1;
+      }
+    }
+  }
+  std::vector<std::vector<int32_t>> mutual_exclusions(num_regsts);
+  for (int32_t i = 0; i < num_regsts; ++i) {
+    for (RegstDescProto* mutual : regst2mutual_exclusion_regsts.at(regsts[i])) {
+      mutual_exclusions[i].emplace_back(regst2index.at(mutual));
+    }
+  }
+  const int64_t lower_bound = MemLowerBound4TimeLine(alloc_regsts_timeline, free_regsts_timeline);
+
+  std::vector<int32_t> best_order;
+  std::vector<int64_t> best_offsets;
+  int64_t best_peak = std::numeric_limits<int64_t>::max();
+  int32_t best_peak_index = -1;
+  std::vector<int32_t> order;
+  std::vector<int64_t> offsets;
+  int32_t peak_index = -1;
+  const auto TryOrder = [&]() -> bool {
+    const int64_t peak =
+        StripPackingPlaceByOrder(order, sizes, mutual_exclusions, &offsets, &peak_index);
+    if (peak > best_peak) { return false; }
+    best_peak = peak;
+    best_peak_index = peak_index;
+    best_order = order;
+    best_offsets.swap(offsets);
+    return true;
+  };
+  // decreasing size, then decreasing area (size x lifetime)
+  order.resize(num_regsts);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int32_t lhs, int32_t rhs) {
+    return sizes[lhs] != sizes[rhs] ? sizes[lhs] > sizes[rhs] : lifetimes[lhs] > lifetimes[rhs];
+  });
+  TryOrder();
+  std::stable_sort(order.begin(), order.end(), [&](int32_t lhs, int32_t rhs) {
+    return sizes[lhs] * lifetimes[lhs] > sizes[rhs] * lifetimes[rhs];
+  });
+  TryOrder();
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto ElapsedMs = [&]() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()
+                                                                 - start)
+        .count();
+  };
+  std::mt19937 gen(num_regsts);
+  for (int64_t iter = 0; iter < max_iterations && num_regsts > 1 && best_peak > lower_bound;
+       ++iter) {
+    if (time_budget_ms > 0 && ElapsedMs() >= time_budget_ms) { break; }
+    order = best_order;
+    const int32_t peak_pos =
+        std::find(order.begin(), order.end(), best_peak_index) - order.begin();
+    if (peak_pos > 0 && gen() % 2 == 0) {
+      const int32_t new_pos = gen() % peak_pos;
+      std::rotate(order.begin() + new_pos, order.begin() + peak_pos,
+                  order.begin() + peak_pos + 1);
+    } else {
+      // draw in a fixed order, so the search is the same whatever the compiler evaluates first
+      const int32_t lhs = gen() % num_regsts;
+      const int32_t rhs = gen() % num_regsts;
+      std::swap(order[lhs], order[rhs]);
+    }
+    TryOrder();
+  }
+
+  HashMap<RegstDescProto*, int64_t>* regst_desc2offset = &(result->regst_desc2offset);
+  for (int32_t i = 0; i < num_regsts; ++i) {
+    CHECK(regst_desc2offset->emplace(regsts[i], best_offsets[i]).second);
+  }
+  result->mem_block_size = std::max<int64_t>(best_peak, 1);
+}
+
+}  // namespace detail
+
+namespace {
+
 void SelectAlgorithmGenMemBlockOffset4Regsts(
     MemAllocAlgoType algo_id, const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
     const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
@@ -710,12 +879,31 @@ void SelectAlgorithmGenMemBlockOffset4Regsts(
     case kTimeLineAlgo:
       MemReusedAlgorithm_TimeLineAlgo(alloc_regsts_timeline, free_regsts_timeline, result);
       break;
+    case kStripPackingAlgo: {
+      const MemoryAllocationAlgorithmConf& conf =
+          GlobalJobDesc().job_conf().memory_allocation_algorithm_conf();
+      detail::MemReusedAlgorithm_StripPackingAlgo(
+          alloc_regsts_timeline, free_regsts_timeline, regst2mutual_exclusion_regsts,
+          conf.strip_packing_max_iterations(), conf.strip_packing_time_budget_ms(), result);
+      break;
+    }
     default: UNIMPLEMENTED();
   }
   CHECK_GT(result->mem_block_size, 0);
   CHECK(!result->regst_desc2offset.empty());
 }
 
+std::string MemAllocAlgoName(MemAllocAlgoType algo_id) {
+  switch (algo_id) {
+    case kMemSizeFirstAlgo: return "MemSizeFirst";
+    case kMutualExclusionFirstAlgo: return "MutualExclusionFirst";
+    case kTimeLineAlgo: return "TimeLine";
+    case kStripPackingAlgo: return "StripPacking";
+    default: UNIMPLEMENTED();
+  }
+  return "";
+}
+
 int64_t CountMemAllocAlgoNum() {
   const MemoryAllocationAlgorithmConf& mem_alloc_algo_conf =
       GlobalJobDesc().job_conf().memory_allocation_algorithm_conf();
@@ -723,6 +911,7 @@ int64_t CountMemAllocAlgoNum() {
   if (mem_alloc_algo_conf.use_mem_size_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_mutual_exclusion_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_time_line_algo()) { ++ret; }
+  if (mem_alloc_algo_conf.use_strip_packing_algo()) { ++ret; }
   CHECK_GE(ret, 0);
   return ret;
 }
@@ -740,6 +929,9 @@ void InitAlgo2Result(HashMap<MemAllocAlgoType, MemBlockResultInfo>* algo2result)
   if (mem_alloc_algo_conf.use_time_line_algo()) {
     CHECK(algo2result->emplace(kTimeLineAlgo, MemBlockResultInfo()).second);
   }
+  if (mem_alloc_algo_conf.use_strip_packing_algo()) {
+    CHECK(algo2result->emplace(kStripPackingAlgo, MemBlockResultInfo()).second);
+  }
 }
 
 }  // namespace
@@ -803,12 +995,22 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(
   // step 3: choose best one for each mem chain and set offset for inplace consumer regst
   for (const auto& pair : mem_chain2algo2result) {
     const MemBlockResultInfo* best_result = nullptr;
+    MemAllocAlgoType best_algo = kMemSizeFirstAlgo;
+    std::string algo_sizes;
     for (const auto& algo_result_pair : pair.second) {
       if (!best_result || algo_result_pair.second.mem_block_size < best_result->mem_block_size) {
         best_result = &algo_result_pair.second;
+        best_algo = algo_result_pair.first;
       }
+      algo_sizes += " " + MemAllocAlgoName(algo_result_pair.first) + ":"
+                    + std::to_string(algo_result_pair.second.mem_block_size);
     }
     CHECK(best_result != nullptr);
+    const int64_t lower_bound = detail::MemLowerBound4TimeLine(
+        mem_chain2task2alloc_regsts.at(pair.first), mem_chain2task2free_regsts.at(pair.first));
+    LOG(INFO) << "mem chain " << pair.first << " uses " << MemAllocAlgoName(best_algo) << ": "
+              << best_result->mem_block_size << " bytes, lower bound (max live bytes) "
+              << lower_bound << " bytes. Candidates:" << algo_sizes;
     int64_t mem_block_id = Global<IDMgr>::Get()->NewMemBlockId();
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
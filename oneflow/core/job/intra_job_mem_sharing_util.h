@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_JOB_IN_JOB_MEM_SHARING_UTIL_H_
 #define ONEFLOW_CORE_JOB_IN_JOB_MEM_SHARING_UTIL_H_
 
+#include "oneflow/core/common/util.h"
 #include "oneflow/core/job/plan.pb.h"
 #include <functional>
 #include <string>
@@ -28,6 +29,38 @@ struct IntraJobMemSharingUtil {
                       IsOpNameDataOrCtrlReachable);
 };
 
+namespace detail {
+
+struct MemBlockResultInfo {
+  size_t mem_block_size;
+  HashMap<RegstDescProto*, int64_t> regst_desc2offset;
+};
+
+// The max bytes alive at the same time, which no placement can go below.
+int64_t MemLowerBound4TimeLine(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                               const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline);
+
+// Places regsts one by one in the given order. Each regst goes into the smallest gap, among the
+// regsts already placed that are alive at the same time, that can hold it (best fit), or on top
+// of them if there is none. Returns the peak and the index of a regst reaching it.
+int64_t StripPackingPlaceByOrder(const std::vector<int32_t>& order,
+                                 const std::vector<int64_t>& sizes,
+                                 const std::vector<std::vector<int32_t>>& mutual_exclusions,
+                                 std::vector<int64_t>* offsets, int32_t* peak_index);
+
+// Treats the regsts as rectangles (lifetime x size) and packs them into a strip of minimal height.
+// Starts from best-fit-decreasing placements and then tries max_iterations perturbations of the
+// placement order (moving the regst that sets the peak earlier, or swapping two regsts), keeping
+// any order that does not raise the peak. Stops early once the max live bytes bound is reached,
+// or after time_budget_ms if it is positive, which makes the result depend on the machine.
+void MemReusedAlgorithm_StripPackingAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
+    const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusion_regsts,
+    int64_t max_iterations, int64_t time_budget_ms, MemBlockResultInfo* result);
+
+}  // namespace detail
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_JOB_IN_JOB_MEM_SHARING_UTIL_H_
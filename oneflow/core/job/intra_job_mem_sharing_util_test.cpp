@@ -0,0 +1,183 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <numeric>
+#include <random>
+#include "gtest/gtest.h"
+#include "oneflow/core/job/intra_job_mem_sharing_util.h"
+#include "oneflow/core/register/runtime_register_desc.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+// Regsts of random sizes and lifetimes on a timeline of tasks, two of them mutually exclusive
+// iff their lifetimes intersect, like GenRegstAllocFreeTimeLineAndRegstMutualExclusions makes.
+struct RegstTimeline {
+  std::vector<std::unique_ptr<RegstDescProto>> regsts;
+  std::vector<std::pair<int64_t, int64_t>> lifetimes;
+  std::vector<HashSet<RegstDescProto*>> alloc_regsts_timeline;
+  std::vector<HashSet<RegstDescProto*>> free_regsts_timeline;
+  HashMap<RegstDescProto*, std::vector<RegstDescProto*>> regst2mutual_exclusion_regsts;
+};
+
+std::unique_ptr<RegstDescProto> NewRegstDesc(int64_t regst_desc_id, int64_t byte_size) {
+  std::unique_ptr<RegstDescProto> regst(new RegstDescProto());
+  regst->set_regst_desc_id(regst_desc_id);
+  regst->set_producer_task_id(0);
+  regst->set_min_register_num(1);
+  regst->set_max_register_num(1);
+  regst->set_register_num(1);
+  regst->mutable_mem_case()->mutable_host_mem();
+  DataRegstDesc* data_regst_desc = regst->mutable_regst_desc_type()->mutable_data_regst_desc();
+  LbiBlobDescPair* pair = data_regst_desc->add_lbi2blob_desc();
+  pair->mutable_lbi()->set_op_name("op" + std::to_string(regst_desc_id));
+  pair->mutable_lbi()->set_blob_name("out");
+  pair->mutable_blob_desc()->mutable_shape()->add_dim(byte_size);
+  pair->mutable_blob_desc()->set_data_type(DataType::kChar);
+  pair->mutable_blob_desc()->set_is_dynamic(false);
+  data_regst_desc->mutable_time_shape()->add_dim(1);
+  regst->set_enable_reuse_mem(true);
+  regst->set_mem_block_id(-1);
+  regst->set_mem_block_offset(-1);
+  return regst;
+}
+
+RegstTimeline NewRegstTimeline(int64_t regst_num, int64_t task_num, uint32_t seed) {
+  std::mt19937 gen(seed);
+  RegstTimeline timeline;
+  timeline.alloc_regsts_timeline.resize(task_num);
+  timeline.free_regsts_timeline.resize(task_num);
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    timeline.regsts.emplace_back(NewRegstDesc(i, 1 + gen() % (64 * 1024)));
+    const int64_t alloc_index = gen() % task_num;
+    const int64_t free_index = alloc_index + gen() % std::min<int64_t>(task_num - alloc_index, 8);
+    timeline.lifetimes.emplace_back(alloc_index, free_index);
+    timeline.alloc_regsts_timeline.at(alloc_index).insert(timeline.regsts.back().get());
+    timeline.free_regsts_timeline.at(free_index).insert(timeline.regsts.back().get());
+  }
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    auto* mutual_exclusions = &timeline.regst2mutual_exclusion_regsts[timeline.regsts.at(i).get()];
+    FOR_RANGE(int64_t, j, 0, regst_num) {
+      if (i == j) { continue; }
+      if (timeline.lifetimes.at(i).first <= timeline.lifetimes.at(j).second
+          && timeline.lifetimes.at(j).first <= timeline.lifetimes.at(i).second) {
+        mutual_exclusions->emplace_back(timeline.regsts.at(j).get());
+      }
+    }
+  }
+  return timeline;
+}
+
+int64_t Size4Regst(const RegstDescProto* regst) {
+  return RtRegstDesc(*regst).TotalMainByteSize4AllRegst();
+}
+
+// Checks that regsts alive at the same time do not overlap and returns the peak.
+int64_t CheckNoOverlap(const RegstTimeline& timeline,
+                       const HashMap<RegstDescProto*, int64_t>& regst2offset) {
+  int64_t peak = 0;
+  for (const auto& pair : timeline.regst2mutual_exclusion_regsts) {
+    const int64_t offset = regst2offset.at(pair.first);
+    const int64_t size = Size4Regst(pair.first);
+    EXPECT_GE(offset, 0);
+    peak = std::max(peak, offset + size);
+    for (RegstDescProto* mutual : pair.second) {
+      const int64_t mutual_offset = regst2offset.at(mutual);
+      EXPECT_TRUE(offset + size <= mutual_offset || mutual_offset + Size4Regst(mutual) <= offset)
+          << "regst " << pair.first->regst_desc_id() << " overlaps regst "
+          << mutual->regst_desc_id();
+    }
+  }
+  return peak;
+}
+
+}  // namespace
+
+TEST(IntraJobMemSharingUtil, strip_packing_place_by_order) {
+  const RegstTimeline timeline = NewRegstTimeline(200, 50, 1);
+  const int64_t regst_num = timeline.regsts.size();
+  HashMap<RegstDescProto*, int32_t> regst2index;
+  std::vector<int64_t> sizes;
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    regst2index.emplace(timeline.regsts.at(i).get(), i);
+    sizes.emplace_back(Size4Regst(timeline.regsts.at(i).get()));
+  }
+  std::vector<std::vector<int32_t>> mutual_exclusions(regst_num);
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    for (RegstDescProto* mutual :
+         timeline.regst2mutual_exclusion_regsts.at(timeline.regsts.at(i).get())) {
+      mutual_exclusions.at(i).emplace_back(regst2index.at(mutual));
+    }
+  }
+  const int64_t lower_bound = detail::MemLowerBound4TimeLine(timeline.alloc_regsts_timeline,
+                                                             timeline.free_regsts_timeline);
+  std::vector<int32_t> order(regst_num);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 gen(2);
+  FOR_RANGE(int, round, 0, 10) {
+    std::shuffle(order.begin(), order.end(), gen);
+    std::vector<int64_t> offsets;
+    int32_t peak_index = -1;
+    const int64_t peak = detail::StripPackingPlaceByOrder(order, sizes, mutual_exclusions,
+                                                          &offsets, &peak_index);
+    HashMap<RegstDescProto*, int64_t> regst2offset;
+    FOR_RANGE(int64_t, i, 0, regst_num) {
+      regst2offset.emplace(timeline.regsts.at(i).get(), offsets.at(i));
+    }
+    ASSERT_EQ(CheckNoOverlap(timeline, regst2offset), peak);
+    ASSERT_EQ(offsets.at(peak_index) + sizes.at(peak_index), peak);
+    ASSERT_GE(peak, lower_bound);
+  }
+}
+
+TEST(IntraJobMemSharingUtil, strip_packing_algo) {
+  FOR_RANGE(uint32_t, seed, 0, 5) {
+    const RegstTimeline timeline = NewRegstTimeline(300, 60, seed);
+    const int64_t lower_bound = detail::MemLowerBound4TimeLine(timeline.alloc_regsts_timeline,
+                                                               timeline.free_regsts_timeline);
+    const auto RunStripPacking =
+        [&](int64_t max_iterations,
+            const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusions) {
+          detail::MemBlockResultInfo result;
+          result.mem_block_size = 0;
+          detail::MemReusedAlgorithm_StripPackingAlgo(timeline.alloc_regsts_timeline,
+                                                      timeline.free_regsts_timeline,
+                                                      regst2mutual_exclusions, max_iterations, 0,
+                                                      &result);
+          EXPECT_EQ(result.regst_desc2offset.size(), timeline.regsts.size());
+          EXPECT_EQ(CheckNoOverlap(timeline, result.regst_desc2offset), result.mem_block_size);
+          EXPECT_GE(result.mem_block_size, lower_bound);
+          return result;
+        };
+    const auto& mutual_exclusions = timeline.regst2mutual_exclusion_regsts;
+    const detail::MemBlockResultInfo initial = RunStripPacking(0, mutual_exclusions);
+    const detail::MemBlockResultInfo searched = RunStripPacking(1000, mutual_exclusions);
+    ASSERT_LE(searched.mem_block_size, initial.mem_block_size);
+    // without a wall time cap the plan only depends on the regsts, not on the order the hash map
+    // holds them in
+    HashMap<RegstDescProto*, std::vector<RegstDescProto*>> reversed_mutual_exclusions;
+    for (auto it = timeline.regsts.rbegin(); it != timeline.regsts.rend(); ++it) {
+      reversed_mutual_exclusions.emplace(it->get(), mutual_exclusions.at(it->get()));
+    }
+    const detail::MemBlockResultInfo again = RunStripPacking(1000, reversed_mutual_exclusions);
+    ASSERT_EQ(again.mem_block_size, searched.mem_block_size);
+    ASSERT_EQ(again.regst_desc2offset, searched.regst_desc2offset);
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,149 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_cache.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/version.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+// Map fields are serialized in key order, so equal keys have equal bytes. Partial serialization
+// because the plan is cached before its memory block and collective boxing fields are filled.
+std::string SerializeDeterministically(const PbMessage& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&bytes);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    CHECK(message.SerializePartialToCodedStream(&coded_stream));
+  }
+  return bytes;
+}
+
+// FNV-1a, stable across builds unlike std::hash.
+uint64_t Fnv1aHash(const std::string& bytes) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : bytes) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool TryParseEntry(const std::string& path, PlanCacheEntry* entry) {
+  std::ifstream in_stream(path, std::ifstream::in | std::ifstream::binary);
+  if (!in_stream.is_open()) { return false; }
+  google::protobuf::io::IstreamInputStream istream_input(&in_stream);
+  google::protobuf::io::CodedInputStream coded_stream(&istream_input);
+  // Plans of large models easily exceed the default limit of 64MB.
+  coded_stream.SetTotalBytesLimit(INT_MAX);
+  return entry->ParsePartialFromCodedStream(&coded_stream);
+}
+
+}  // namespace
+
+PlanCache* PlanCache::Get() {
+  static PlanCache* plan_cache = []() -> PlanCache* {
+    const std::string cache_dir = GetStringFromEnv("ONEFLOW_PLAN_CACHE_DIR", "");
+    if (cache_dir.empty()) { return nullptr; }
+    if (std::string(GetOneFlowGitVersion()) == "N/A") {
+      LOG(WARNING) << "plan cache is disabled: ONEFLOW_PLAN_CACHE_DIR is set but this build of "
+                      "OneFlow has no git version to invalidate cached plans with";
+      return nullptr;
+    }
+    LocalFS()->RecursivelyCreateDirIfNotExist(cache_dir);
+    return new PlanCache(cache_dir);
+  }();
+  return plan_cache;
+}
+
+void PlanCache::GenKey(const Job& job, int64_t job_id, PlanCacheKey* key) const {
+  key->set_oneflow_version(GetOneFlowGitVersion());
+  key->set_job_id(job_id);
+  *key->mutable_job() = job;
+  *key->mutable_resource() = Global<ResourceDesc, ForSession>::Get()->resource();
+  key->set_world_size(GlobalProcessCtx::WorldSize());
+  Global<IDMgr>::Get()->SaveIdState(key->mutable_id_state());
+  // op names are part of the job already, and eager ops advance the counter as well
+  key->mutable_id_state()->clear_unique_id_count();
+}
+
+std::string PlanCache::EntryPath(const std::string& serialized_key) const {
+  std::ostringstream file_name;
+  file_name << "plan_" << std::hex << std::setw(16) << std::setfill('0')
+            << Fnv1aHash(serialized_key) << ".pb";
+  return JoinPath(cache_dir_, file_name.str());
+}
+
+Maybe<bool> PlanCache::TryLoad(const PlanCacheKey& key, Plan* plan) const {
+  const std::string serialized_key = SerializeDeterministically(key);
+  const std::string path = EntryPath(serialized_key);
+  if (!LocalFS()->FileExists(path)) {
+    LOG(INFO) << "plan cache miss: no entry " << path << " for job " << key.job_id();
+    return false;
+  }
+  PlanCacheEntry entry;
+  if (!TryParseEntry(path, &entry)) {
+    LOG(WARNING) << "plan cache miss: entry " << path << " is corrupted and will be rewritten";
+    return false;
+  }
+  if (SerializeDeterministically(entry.key()) != serialized_key) {
+    // Hash collision or an entry written for another job, resource or version.
+    LOG(INFO) << "plan cache miss: entry " << path << " was compiled from a different key";
+    return false;
+  }
+  plan->Swap(entry.mutable_plan());
+  Global<IDMgr>::Get()->RestoreIdState(entry.id_state());
+  LOG(INFO) << "plan cache hit: loaded plan of job " << key.job_id() << " from " << path;
+  return true;
+}
+
+Maybe<void> PlanCache::Save(const PlanCacheKey& key, const Plan& plan) const {
+  PlanCacheEntry entry;
+  *entry.mutable_key() = key;
+  *entry.mutable_plan() = plan;
+  Global<IDMgr>::Get()->SaveIdState(entry.mutable_id_state());
+  const std::string path = EntryPath(SerializeDeterministically(key));
+  // Write to a private file first, so concurrent readers never see a partial entry.
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream out_stream(tmp_path, std::ofstream::out | std::ofstream::binary
+                                           | std::ofstream::trunc);
+    CHECK_OR_RETURN(out_stream.is_open()) << "failed to open " << tmp_path;
+    CHECK_OR_RETURN(entry.SerializePartialToOstream(&out_stream)) << "failed to write " << tmp_path;
+  }
+  CHECK_EQ_OR_RETURN(std::rename(tmp_path.c_str(), path.c_str()), 0)
+      << "failed to rename " << tmp_path << " to " << path;
+  LOG(INFO) << "plan cache: saved plan of job " << key.job_id() << " to " << path;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
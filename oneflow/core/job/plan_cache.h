@@ -0,0 +1,53 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+#define ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/job/plan_cache.pb.h"
+
+namespace oneflow {
+
+// On-disk cache of the plans built by Compiler::Compile, enabled by setting
+// ONEFLOW_PLAN_CACHE_DIR. An entry is looked up by a hash of its PlanCacheKey and is only used
+// when the stored key is byte-wise equal to the current one, so a different completed job,
+// job id, resource config, world size, OneFlow version or id counters is a miss.
+class PlanCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PlanCache);
+  explicit PlanCache(const std::string& cache_dir) : cache_dir_(cache_dir) {}
+  ~PlanCache() = default;
+
+  // The cache in ONEFLOW_PLAN_CACHE_DIR, or nullptr when the cache is disabled.
+  static PlanCache* Get();
+
+  // Fills the key of a completed job, the id counters are read from Global<IDMgr>.
+  void GenKey(const Job& job, int64_t job_id, PlanCacheKey* key) const;
+  // On a hit, copies the cached plan into `plan` and advances Global<IDMgr> to the counters it
+  // had after the cached plan was compiled.
+  Maybe<bool> TryLoad(const PlanCacheKey& key, Plan* plan) const;
+  Maybe<void> Save(const PlanCacheKey& key, const Plan& plan) const;
+
+ private:
+  std::string EntryPath(const std::string& serialized_key) const;
+
+  std::string cache_dir_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_PLAN_CACHE_H_
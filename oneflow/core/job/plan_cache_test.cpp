@@ -0,0 +1,112 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+EnvProto GetEnvProto() {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  ret.set_ctrl_port(9527);
+  return ret;
+}
+
+Resource GetResource() {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(0);
+  ret.set_cpu_device_num(1);
+  return ret;
+}
+
+void New() {
+  Global<EnvDesc>::New(GetEnvProto());
+  Global<ProcessCtx>::New();
+  Global<ProcessCtx>::Get()->mutable_ctrl_addr()->Add();
+  Global<ProcessCtx>::Get()->set_rank(0);
+  Global<ProcessCtx>::Get()->set_node_size(1);
+  Global<ResourceDesc, ForSession>::New(GetResource(), GlobalProcessCtx::NumOfProcessPerNode());
+  Global<IDMgr>::New();
+}
+
+void Delete() {
+  Global<IDMgr>::Delete();
+  Global<ProcessCtx>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+Job GetJob(const std::string& job_name) {
+  Job job;
+  job.mutable_job_conf()->set_job_name(job_name);
+  return job;
+}
+
+}  // namespace
+
+TEST(PlanCache, save_and_load) {
+  New();
+  const std::string cache_dir = "./plan_cache_test_" + std::to_string(getpid());
+  LocalFS()->RecursivelyCreateDirIfNotExist(cache_dir);
+  PlanCache plan_cache(cache_dir);
+  IDMgr* id_mgr = Global<IDMgr>::Get();
+
+  PlanCacheKey key;
+  plan_cache.GenKey(GetJob("job"), 0, &key);
+  Plan plan;
+  ASSERT_FALSE(CHECK_JUST(plan_cache.TryLoad(key, &plan)));
+  // Compiling allocates ids, the plan is saved with the counters after compiling.
+  plan.add_task()->set_task_id(id_mgr->NewRegstDescId());
+  ASSERT_EQ(id_mgr->NewMemBlockId(), 0);
+  CHECK_JUST(plan_cache.Save(key, plan));
+
+  // Same key in a fresh IDMgr, as after a restart.
+  Global<IDMgr>::Delete();
+  Global<IDMgr>::New();
+  PlanCacheKey same_key;
+  plan_cache.GenKey(GetJob("job"), 0, &same_key);
+  Plan cached_plan;
+  ASSERT_TRUE(CHECK_JUST(plan_cache.TryLoad(same_key, &cached_plan)));
+  ASSERT_EQ(cached_plan.task_size(), 1);
+  ASSERT_EQ(cached_plan.task(0).task_id(), 0);
+  id_mgr = Global<IDMgr>::Get();
+  ASSERT_EQ(id_mgr->NewRegstDescId(), 1);
+  ASSERT_EQ(id_mgr->NewMemBlockId(), 1);
+
+  // Any difference of the job, the job id or the id counters is a miss.
+  PlanCacheKey other_key;
+  plan_cache.GenKey(GetJob("other_job"), 0, &other_key);
+  ASSERT_FALSE(CHECK_JUST(plan_cache.TryLoad(other_key, &cached_plan)));
+  plan_cache.GenKey(GetJob("job"), 1, &other_key);
+  ASSERT_FALSE(CHECK_JUST(plan_cache.TryLoad(other_key, &cached_plan)));
+  plan_cache.GenKey(GetJob("job"), 0, &other_key);
+  ASSERT_FALSE(CHECK_JUST(plan_cache.TryLoad(other_key, &cached_plan)));
+
+  LocalFS()->RecursivelyDeleteDir(cache_dir);
+  Delete();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/auto_parallel_cost.h"
+#include "oneflow/core/graph/boxing/sub_task_graph_builder_util.h"
+
+namespace oneflow {
+
+namespace auto_parallel {
+
+// Placements that differ are assumed not to share devices, so every piece crosses the wire.
+double BoxingBytes(const cfg::SbpParallel& src, const ParallelDesc& src_desc,
+                   const cfg::SbpParallel& dst, const ParallelDesc& dst_desc, double bytes) {
+  const int64_t src_num = src_desc.parallel_num();
+  const int64_t dst_num = dst_desc.parallel_num();
+  const bool same_placement = src_desc == dst_desc;
+  // OneToOneSubTskGphBuilder: device i copies its own piece
+  if ((src_num == 1 && dst_num == 1) || (src_num == dst_num && src == dst)) {
+    if (same_placement) { return 0; }
+    return src.has_split_parallel() ? bytes / src_num : bytes;
+  }
+  const bool is_src_whole = src_num == 1 || src.has_broadcast_parallel();
+  if (dst.has_partial_sum_parallel()) {
+    // B21SubTskGphBuilder or NaiveB2PSubTskGphBuilder: one device takes the nearest copy, the
+    // others fill zeros. Nothing else produces a partial sum.
+    if (!is_src_whole) { return kUnsupportedBoxingCost; }
+    return same_placement ? 0 : bytes;
+  }
+  if (!same_placement) {
+    // B21SubTskGphBuilder, NaiveB2BSubTskGphBuilder or SliceBoxingSubTskGphBuilder: each device
+    // gathers its piece, and the piece of a partial sum from every producer
+    const double piece = dst.has_split_parallel() ? bytes / dst_num : bytes;
+    return src.has_partial_sum_parallel() ? piece * src_num : piece;
+  }
+  // Same devices: the collective CollectiveBoxingSubTskGphBuilder emits for the pair
+  const double n = src_num;
+  // B -> S is a local slice
+  if (SubTskGphBuilderUtil::IsBoxingB2S(src, dst)) { return 0; }
+  // all-gather
+  if (SubTskGphBuilderUtil::IsBoxingS2B(src, dst)) { return bytes * (n - 1) / n; }
+  // all-to-all
+  if (SubTskGphBuilderUtil::IsBoxingS2S(src, dst)) { return bytes * (n - 1) / (n * n); }
+  // all-reduce
+  if (SubTskGphBuilderUtil::IsBoxingP2B(src, dst)) { return 2 * bytes * (n - 1) / n; }
+  // reduce-scatter
+  CHECK(SubTskGphBuilderUtil::IsBoxingP2S(src, dst));
+  return bytes * (n - 1) / n;
+}
+
+}  // namespace auto_parallel
+
+}  // namespace oneflow
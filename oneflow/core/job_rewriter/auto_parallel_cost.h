@@ -0,0 +1,42 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_COST_H_
+#define ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_COST_H_
+
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/job/sbp_parallel.cfg.h"
+
+namespace oneflow {
+
+namespace auto_parallel {
+
+// Cost of a boxing no 1-D sub task graph builder accepts (e.g. producing a partial-sum consumer
+// from a split). Large enough to never be chosen, small enough to keep sums finite.
+constexpr double kUnsupportedBoxingCost = 1e30;
+
+// Bytes each device receives when boxing turns `bytes` logical bytes from `src` on `src_desc`
+// into `dst` on `dst_desc`, or kUnsupportedBoxingCost. The sub task graph builders can only be
+// run on a task graph, which does not exist yet while the job is rewritten, so this mirrors the
+// builder that Make1DSubTskGphBuilder picks for the pair; auto_parallel_cost_test.cpp checks the
+// unsupported pairs against the builders themselves.
+double BoxingBytes(const cfg::SbpParallel& src, const ParallelDesc& src_desc,
+                   const cfg::SbpParallel& dst, const ParallelDesc& dst_desc, double bytes);
+
+}  // namespace auto_parallel
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_COST_H_
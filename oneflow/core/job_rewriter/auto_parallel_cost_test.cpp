@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/core/control/ctrl_bootstrap.pb.h"
+#include "oneflow/core/graph/boxing/b21_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/chain_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/naive_b2b_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/naive_b2p_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/one_to_one_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/slice_boxing_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/sub_task_graph_builder_util.h"
+#include "oneflow/core/job_rewriter/auto_parallel_cost.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+struct GlobalProcessCtxScope final {
+  GlobalProcessCtxScope(int64_t node_size, int64_t world_size) {
+    Global<ProcessCtx>::New();
+    auto* ctx = Global<ProcessCtx>::Get();
+    for (int i = 0; i < world_size; ++i) { ctx->mutable_ctrl_addr()->Add(); }
+    ctx->set_rank(0);
+    ctx->set_node_size(node_size);
+  }
+  ~GlobalProcessCtxScope() { Global<ProcessCtx>::Delete(); }
+};
+
+ParallelDesc CpuParallelDesc(const std::string& device_name) {
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  parallel_conf.add_device_name(device_name);
+  return ParallelDesc(parallel_conf);
+}
+
+cfg::SbpParallel Split(int64_t axis) {
+  cfg::SbpParallel sbp;
+  sbp.mutable_split_parallel()->set_axis(axis);
+  return sbp;
+}
+
+cfg::SbpParallel Broadcast() {
+  cfg::SbpParallel sbp;
+  sbp.mutable_broadcast_parallel();
+  return sbp;
+}
+
+cfg::SbpParallel PartialSum() {
+  cfg::SbpParallel sbp;
+  sbp.mutable_partial_sum_parallel();
+  return sbp;
+}
+
+// The builders of Make1DSubTskGphBuilder for cpu placements. CollectiveBoxingSubTskGphBuilder
+// only takes pairs SliceBoxingSubTskGphBuilder takes too, and
+// FallbackToCpuSliceBoxingSubTskGphBuilder reruns the latter on cpu. Every builder decides
+// whether it takes a pair before it touches the task graph, so rejected pairs need none.
+bool IsRejectedByBuilders(const cfg::SbpParallel& src, const ParallelDesc& src_desc,
+                          const cfg::SbpParallel& dst, const ParallelDesc& dst_desc,
+                          const BlobDesc& blob_desc) {
+  std::vector<std::shared_ptr<SubTskGphBuilder>> builders;
+  builders.emplace_back(new OneToOneSubTskGphBuilder());
+  builders.emplace_back(new B21SubTskGphBuilder());
+  builders.emplace_back(new SliceBoxingSubTskGphBuilder());
+  builders.emplace_back(new NaiveB2BSubTskGphBuilder());
+  builders.emplace_back(new NaiveB2PSubTskGphBuilder());
+  ChainSubTskGphBuilder builder(builders);
+  std::vector<TaskNode*> sorted_out_tasks;
+  std::vector<std::vector<TaskNode*>> sorted_ctrl_tasks;
+  const auto status =
+      TRY(builder.Build(nullptr, {}, &sorted_out_tasks, &sorted_ctrl_tasks, src_desc, dst_desc,
+                        LogicalBlobId(), blob_desc, src, dst, Shape({1})));
+  return !status.IsOk() && SubTskGphBuilderUtil::IsErrorBoxingNotSupported(*status.error());
+}
+
+}  // namespace
+
+TEST(AutoParallelCost, boxing_bytes) {
+  GlobalProcessCtxScope scope(1, 8);
+  const BlobDesc blob_desc(Shape({16, 16}), DataType::kFloat);
+  const double b = blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+  const double kUnsupported = auto_parallel::kUnsupportedBoxingCost;
+  const ParallelDesc four = CpuParallelDesc("0:0-3");
+  const ParallelDesc other_four = CpuParallelDesc("0:4-7");
+  const ParallelDesc two = CpuParallelDesc("0:0-1");
+  const ParallelDesc one = CpuParallelDesc("0:0");
+  const ParallelDesc other_one = CpuParallelDesc("0:1");
+  struct Case {
+    cfg::SbpParallel src;
+    const ParallelDesc* src_desc;
+    cfg::SbpParallel dst;
+    const ParallelDesc* dst_desc;
+    double bytes;
+  };
+  const std::vector<Case> cases{
+      // same devices, one-to-one
+      {Split(0), &four, Split(0), &four, 0},
+      {Broadcast(), &four, Broadcast(), &four, 0},
+      {PartialSum(), &four, PartialSum(), &four, 0},
+      {Broadcast(), &one, Broadcast(), &one, 0},
+      // same devices, collectives
+      {Broadcast(), &four, Split(0), &four, 0},
+      {Split(0), &four, Broadcast(), &four, b * 3 / 4},
+      {Split(0), &four, Split(1), &four, b * 3 / 16},
+      {PartialSum(), &four, Broadcast(), &four, b * 3 / 2},
+      {PartialSum(), &four, Split(0), &four, b * 3 / 4},
+      {Broadcast(), &four, PartialSum(), &four, 0},
+      {Split(0), &four, PartialSum(), &four, kUnsupported},
+      // other devices, one-to-one
+      {Split(0), &four, Split(0), &other_four, b / 4},
+      {Broadcast(), &four, Broadcast(), &other_four, b},
+      {PartialSum(), &four, PartialSum(), &other_four, b},
+      {Broadcast(), &one, Broadcast(), &other_one, b},
+      // other devices, slice boxing and naive copies
+      {Split(0), &four, Split(1), &other_four, b / 4},
+      {Split(0), &four, Broadcast(), &other_four, b},
+      {PartialSum(), &four, Broadcast(), &other_four, 4 * b},
+      {PartialSum(), &four, Split(1), &other_four, b},
+      {Broadcast(), &four, PartialSum(), &other_four, b},
+      {Split(0), &four, PartialSum(), &other_four, kUnsupported},
+      {Split(0), &four, Split(0), &two, b / 2},
+      {Broadcast(), &four, Split(1), &two, b / 2},
+      {PartialSum(), &four, Broadcast(), &two, 4 * b},
+      {PartialSum(), &four, PartialSum(), &two, kUnsupported},
+      {Split(0), &four, Broadcast(), &one, b},
+      {Broadcast(), &four, Broadcast(), &one, b},
+      {PartialSum(), &four, Broadcast(), &one, 4 * b},
+      {Split(0), &four, PartialSum(), &one, kUnsupported},
+      {Broadcast(), &one, PartialSum(), &four, b},
+      {Broadcast(), &one, Split(0), &four, b / 4},
+  };
+  FOR_RANGE(int64_t, i, 0, cases.size()) {
+    const Case& c = cases.at(i);
+    ASSERT_DOUBLE_EQ(auto_parallel::BoxingBytes(c.src, *c.src_desc, c.dst, *c.dst_desc, b), c.bytes)
+        << "case " << i;
+    if (c.bytes >= kUnsupported) {
+      ASSERT_TRUE(IsRejectedByBuilders(c.src, *c.src_desc, c.dst, *c.dst_desc, blob_desc))
+          << "case " << i;
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
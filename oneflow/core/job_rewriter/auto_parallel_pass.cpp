@@ -0,0 +1,418 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/user_op_registry_manager.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/sbp_parallel.h"
+#include "oneflow/core/job_rewriter/auto_parallel_cost.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+using auto_parallel::kUnsupportedBoxingCost;
+
+constexpr int32_t kMaxSearchRounds = 16;
+
+// Nodes are indexed in topological order. A node with a single candidate is fixed; links are
+// producer-output to consumer-input pairs, so an OpEdge carrying several blobs yields several
+// links.
+struct SbpSearchGraph {
+  std::vector<int32_t> num_candidates;
+  std::vector<std::pair<int64_t, int64_t>> links;
+  std::function<double(int64_t node, int32_t k)> ComputeCost;
+  std::function<double(int64_t link, int32_t src_k, int32_t dst_k)> LinkCost;
+};
+
+double TotalCost(const SbpSearchGraph& graph, const std::vector<int32_t>& choice) {
+  double cost = 0;
+  FOR_RANGE(int64_t, i, 0, graph.num_candidates.size()) { cost += graph.ComputeCost(i, choice[i]); }
+  FOR_RANGE(int64_t, l, 0, graph.links.size()) {
+    cost += graph.LinkCost(l, choice[graph.links[l].first], choice[graph.links[l].second]);
+  }
+  return cost;
+}
+
+// Maximal chains of searchable nodes in which each node is the only searchable consumer of its
+// predecessor and the predecessor is its only searchable producer. Every searchable node belongs
+// to exactly one chain; chains are returned in topological order of their heads.
+std::vector<std::vector<int64_t>> GenSearchChains(const SbpSearchGraph& graph) {
+  const int64_t num_nodes = graph.num_candidates.size();
+  const auto IsSearchable = [&](int64_t i) { return graph.num_candidates[i] > 1; };
+  constexpr int64_t kNone = -1;
+  constexpr int64_t kMany = -2;
+  std::vector<int64_t> succ(num_nodes, kNone);
+  std::vector<int64_t> pred(num_nodes, kNone);
+  const auto Update = [&](int64_t* slot, int64_t node) {
+    if (*slot == kNone) {
+      *slot = node;
+    } else if (*slot != node) {
+      *slot = kMany;
+    }
+  };
+  for (const auto& link : graph.links) {
+    if (!IsSearchable(link.first) || !IsSearchable(link.second)) { continue; }
+    Update(&succ[link.first], link.second);
+    Update(&pred[link.second], link.first);
+  }
+  const auto IsChained = [&](int64_t src, int64_t dst) {
+    return src >= 0 && dst >= 0 && succ[src] == dst && pred[dst] == src;
+  };
+  std::vector<std::vector<int64_t>> chains;
+  FOR_RANGE(int64_t, i, 0, num_nodes) {
+    if (!IsSearchable(i) || IsChained(pred[i], i)) { continue; }
+    chains.emplace_back();
+    for (int64_t cur = i; cur != kNone; cur = IsChained(cur, succ[cur]) ? succ[cur] : kNone) {
+      chains.back().push_back(cur);
+    }
+  }
+  return chains;
+}
+
+// Exactly minimizes the total cost over the signatures of one chain while every other node keeps
+// its current choice (Viterbi over the chain). Returns true if the chain changed.
+bool SolveChain(const SbpSearchGraph& graph, const std::vector<std::vector<int64_t>>& in_links,
+                const std::vector<std::vector<int64_t>>& out_links,
+                const std::vector<int64_t>& chain, std::vector<int32_t>* choice) {
+  const int64_t len = chain.size();
+  const auto IsChainLink = [&](int64_t pos, int64_t link) {
+    return pos + 1 < len && graph.links[link].second == chain[pos + 1];
+  };
+  // unary[pos][k]: compute cost plus links to nodes outside the chain
+  std::vector<std::vector<double>> unary(len);
+  FOR_RANGE(int64_t, pos, 0, len) {
+    const int64_t node = chain[pos];
+    unary[pos].resize(graph.num_candidates[node]);
+    FOR_RANGE(int32_t, k, 0, graph.num_candidates[node]) {
+      double cost = graph.ComputeCost(node, k);
+      for (int64_t l : in_links[node]) {
+        if (pos > 0 && graph.links[l].first == chain[pos - 1]) { continue; }
+        cost += graph.LinkCost(l, choice->at(graph.links[l].first), k);
+      }
+      for (int64_t l : out_links[node]) {
+        if (IsChainLink(pos, l)) { continue; }
+        cost += graph.LinkCost(l, k, choice->at(graph.links[l].second));
+      }
+      unary[pos][k] = cost;
+    }
+  }
+  const auto PairCost = [&](int64_t pos, int32_t src_k, int32_t dst_k) {
+    double cost = 0;
+    for (int64_t l : out_links[chain[pos]]) {
+      if (IsChainLink(pos, l)) { cost += graph.LinkCost(l, src_k, dst_k); }
+    }
+    return cost;
+  };
+  std::vector<std::vector<double>> dp(len);
+  std::vector<std::vector<int32_t>> back(len);
+  dp[0] = unary[0];
+  FOR_RANGE(int64_t, pos, 1, len) {
+    const int32_t num_k = unary[pos].size();
+    dp[pos].resize(num_k);
+    back[pos].resize(num_k);
+    FOR_RANGE(int32_t, k, 0, num_k) {
+      double best = std::numeric_limits<double>::infinity();
+      int32_t best_prev = 0;
+      FOR_RANGE(int32_t, prev_k, 0, dp[pos - 1].size()) {
+        const double cost = dp[pos - 1][prev_k] + PairCost(pos - 1, prev_k, k);
+        if (cost < best) {
+          best = cost;
+          best_prev = prev_k;
+        }
+      }
+      dp[pos][k] = best + unary[pos][k];
+      back[pos][k] = best_prev;
+    }
+  }
+  const auto best_it = std::min_element(dp[len - 1].cbegin(), dp[len - 1].cend());
+  double current = 0;
+  FOR_RANGE(int64_t, pos, 0, len) {
+    current += unary[pos][choice->at(chain[pos])];
+    if (pos + 1 < len) {
+      current += PairCost(pos, choice->at(chain[pos]), choice->at(chain[pos + 1]));
+    }
+  }
+  // only move on a strict improvement so that the search terminates
+  if (!(*best_it < current - 1e-6 * std::abs(current))) { return false; }
+  int32_t k = std::distance(dp[len - 1].cbegin(), best_it);
+  for (int64_t pos = len - 1; pos >= 0; --pos) {
+    (*choice)[chain[pos]] = k;
+    if (pos > 0) { k = back[pos][k]; }
+  }
+  return true;
+}
+
+// Block coordinate descent with chains as blocks. Each step is an exact minimization over one
+// chain, so the total cost never increases. Returns the number of rounds run.
+int32_t SearchSbp(const SbpSearchGraph& graph, int32_t max_rounds, std::vector<int32_t>* choice) {
+  const int64_t num_nodes = graph.num_candidates.size();
+  std::vector<std::vector<int64_t>> in_links(num_nodes);
+  std::vector<std::vector<int64_t>> out_links(num_nodes);
+  FOR_RANGE(int64_t, l, 0, graph.links.size()) {
+    out_links[graph.links[l].first].push_back(l);
+    in_links[graph.links[l].second].push_back(l);
+  }
+  const std::vector<std::vector<int64_t>> chains = GenSearchChains(graph);
+  int32_t round = 0;
+  while (round < max_rounds) {
+    ++round;
+    bool changed = false;
+    for (const auto& chain : chains) {
+      changed = SolveChain(graph, in_links, out_links, chain, choice) || changed;
+    }
+    if (!changed) { break; }
+  }
+  return round;
+}
+
+double LogicalBytes(const BlobDesc& blob_desc) {
+  return static_cast<double>(blob_desc.shape().elem_cnt())
+         * GetSizeOfDataType(blob_desc.data_type());
+}
+
+std::string SbpSignatureToString(const Operator& op, const cfg::SbpSignature& sbp_signature) {
+  std::string ret;
+  const auto& bn2sbp = sbp_signature.bn_in_op2sbp_parallel();
+  for (const auto& bn : op.input_output_bns()) {
+    const auto it = bn2sbp.find(bn);
+    if (it == bn2sbp.end()) { continue; }
+    if (!ret.empty()) { ret += " "; }
+    ret += bn + ":" + SbpParallelToString(it->second);
+  }
+  return ret;
+}
+
+class AutoParallelPass final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoParallelPass);
+  AutoParallelPass() = default;
+  ~AutoParallelPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const { return ctx.job_desc().enable_auto_parallel(); }
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, ctx->job_desc(), &job_builder);
+  }
+
+  Maybe<void> Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                    JobBuilder* job_builder) const;
+};
+
+// Ops whose signature the search may change: 1-D user ops with inputs, no signature constraint
+// from the user or an earlier pass, and no custom inference function that could ignore one.
+bool IsSearchableOp(const OpNode* node, const JobParallelViewConf& view_conf) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (!op_conf.has_user_conf()) { return false; }
+  if (node->in_edges().empty()) { return false; }
+  if (node->parallel_desc().hierarchy()->NumAxes() != 1) { return false; }
+  if (node->parallel_desc().parallel_num() <= 1) { return false; }
+  if (view_conf.op_name2nd_sbp_signature_conf().count(op_conf.name()) > 0) { return false; }
+  const auto& op_name2is_mirrored = view_conf.op_name2is_mirrored_parallel_view();
+  const auto mirrored_it = op_name2is_mirrored.find(op_conf.name());
+  if (mirrored_it != op_name2is_mirrored.end() && mirrored_it->second) { return false; }
+  const auto* registry =
+      user_op::UserOpRegistryMgr::Get().GetOpRegistryResult(op_conf.user_conf().op_type_name());
+  if (registry == nullptr) { return false; }
+  return !registry->sbp_signature_infer_fn && !registry->nd_sbp_infer_fn;
+}
+
+Maybe<std::vector<cfg::SbpSignature>> GetValidSbpSignatures(const OpNode* node) {
+  const Operator& op = node->op();
+  const auto LogicalBlobDesc4Bn = [&](const std::string& bn) -> Maybe<const BlobDesc&> {
+    return Maybe<const BlobDesc&>(node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)));
+  };
+  cfg::SbpSignatureList sbp_sig_list;
+  JUST(op.GetSbpSignaturesIf(LogicalBlobDesc4Bn, node->parallel_desc(), &sbp_sig_list));
+  const int64_t parallel_num = node->parallel_desc().parallel_num();
+  std::vector<cfg::SbpSignature> valid;
+  for (const auto& sbp_signature : sbp_sig_list.sbp_signature()) {
+    bool is_valid = true;
+    for (const auto& bn : op.input_output_bns()) {
+      const auto it = sbp_signature.bn_in_op2sbp_parallel().find(bn);
+      if (it == sbp_signature.bn_in_op2sbp_parallel().end()) {
+        is_valid = false;
+        break;
+      }
+      if (!it->second.has_split_parallel()) { continue; }
+      const Shape& shape = JUST(LogicalBlobDesc4Bn(bn)).shape();
+      const int64_t axis = it->second.split_parallel().axis();
+      if (axis < 0 || axis >= shape.NumAxes() || shape.At(axis) < parallel_num) {
+        is_valid = false;
+        break;
+      }
+    }
+    if (is_valid) { valid.push_back(sbp_signature); }
+  }
+  return valid;
+}
+
+Maybe<void> AutoParallelPass::Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                                    JobBuilder* job_builder) const {
+  const JobParallelViewConf& view_conf = job_builder->job().job_parallel_view_conf();
+  std::vector<const OpNode*> nodes;
+  HashMap<const OpNode*, int64_t> node2index;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    node2index.emplace(node, nodes.size());
+    nodes.push_back(node);
+  });
+  // candidates[i] is empty for nodes that take no part in the cost model (Nd hierarchies)
+  std::vector<std::vector<cfg::SbpSignature>> candidates(nodes.size());
+  std::vector<int32_t> greedy(nodes.size(), 0);
+  int64_t num_searchable = 0;
+  FOR_RANGE(int64_t, i, 0, nodes.size()) {
+    const OpNode* node = nodes[i];
+    if (node->parallel_desc().hierarchy()->NumAxes() != 1) { continue; }
+    const cfg::SbpSignature& current = node->sbp_signature();
+    if (IsSearchableOp(node, view_conf)) {
+      const auto valid = TRY(GetValidSbpSignatures(node));
+      if (valid.IsOk()) { candidates[i] = *CHECK_JUST(valid); }
+    }
+    const auto it = std::find(candidates[i].cbegin(), candidates[i].cend(), current);
+    if (it == candidates[i].cend()) {
+      candidates[i].push_back(current);
+      greedy[i] = candidates[i].size() - 1;
+    } else {
+      greedy[i] = std::distance(candidates[i].cbegin(), it);
+    }
+    if (candidates[i].size() > 1) { ++num_searchable; }
+  }
+  if (num_searchable == 0) { return Maybe<void>::Ok(); }
+
+  struct LinkInfo {
+    std::string obn;
+    std::string ibn;
+    double bytes;
+    // The consumer must see the producer's blob itself, so no boxing may be inserted.
+    bool keep_src_sbp;
+  };
+  // A mutable input is written by its consumer, e.g. the model of an update op, and boxing would
+  // hand it a copy. An input whose producer sbp was copied into its consumer's constraint may
+  // have boxing disabled; the job does not tell it apart from a user sbp hint, so keep both.
+  const auto KeepSrcSbp = [&](int64_t src, const std::string& obn, int64_t dst,
+                              const std::string& ibn) -> bool {
+    const Operator& dst_op = nodes[dst]->op();
+    if (dst_op.InputBlobModifier4Ibn(ibn).is_mutable()) { return true; }
+    if (view_conf.op_name2nd_sbp_signature_conf().count(dst_op.op_name()) == 0) { return false; }
+    return nodes[src]->sbp_signature().bn_in_op2sbp_parallel().at(obn)
+           == nodes[dst]->sbp_signature().bn_in_op2sbp_parallel().at(ibn);
+  };
+  SbpSearchGraph graph;
+  std::vector<LinkInfo> link_infos;
+  FOR_RANGE(int64_t, i, 0, nodes.size()) {
+    graph.num_candidates.push_back(std::max<int32_t>(candidates[i].size(), 1));
+    if (candidates[i].empty()) { continue; }
+    for (const OpEdge* edge : nodes[i]->in_edges()) {
+      const int64_t src = node2index.at(edge->src_node());
+      if (candidates[src].empty()) { continue; }
+      for (const LogicalBlobId& lbi : edge->lbis()) {
+        const double bytes = LogicalBytes(nodes[src]->LogicalBlobDesc4Lbi(lbi));
+        const std::string& obn = edge->lbi2obn().at(lbi);
+        for (const std::string& ibn : edge->lbi2ibns().at(lbi)) {
+          graph.links.emplace_back(src, i);
+          link_infos.push_back(LinkInfo{obn, ibn, bytes, KeepSrcSbp(src, obn, i, ibn)});
+        }
+      }
+    }
+  }
+  // Compute is modelled as the bytes each device touches, so redundant (broadcast) work costs
+  // parallel_num times more than split work. Communication is weighted against it by the ratio
+  // of local memory bandwidth to interconnect bandwidth.
+  const double comm_cost_ratio = ParseIntegerFromEnv("ONEFLOW_AUTO_PARALLEL_COMM_COST_RATIO", 16);
+  const auto SbpParallel4Bn = [&](int64_t node, int32_t k, const std::string& bn) {
+    return candidates[node].at(k).bn_in_op2sbp_parallel().at(bn);
+  };
+  graph.ComputeCost = [&](int64_t node, int32_t k) -> double {
+    if (candidates[node].empty()) { return 0; }
+    const OpNode* op_node = nodes[node];
+    const double n = op_node->parallel_desc().parallel_num();
+    double cost = 0;
+    for (const auto& bn : op_node->op().input_output_bns()) {
+      const auto& sbp_map = candidates[node].at(k).bn_in_op2sbp_parallel();
+      const auto it = sbp_map.find(bn);
+      if (it == sbp_map.end()) { continue; }
+      const double bytes = LogicalBytes(op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(bn)));
+      cost += it->second.has_split_parallel() ? bytes / n : bytes;
+    }
+    return cost;
+  };
+  graph.LinkCost = [&](int64_t link, int32_t src_k, int32_t dst_k) -> double {
+    const int64_t src = graph.links[link].first;
+    const int64_t dst = graph.links[link].second;
+    const LinkInfo& info = link_infos[link];
+    if (info.keep_src_sbp) {
+      const bool same =
+          nodes[src]->parallel_desc() == nodes[dst]->parallel_desc()
+          && SbpParallel4Bn(src, src_k, info.obn) == SbpParallel4Bn(dst, dst_k, info.ibn);
+      return same ? 0 : kUnsupportedBoxingCost;
+    }
+    const double bytes = auto_parallel::BoxingBytes(
+        SbpParallel4Bn(src, src_k, info.obn), nodes[src]->parallel_desc(),
+        SbpParallel4Bn(dst, dst_k, info.ibn), nodes[dst]->parallel_desc(), info.bytes);
+    return bytes >= kUnsupportedBoxingCost ? bytes : bytes * comm_cost_ratio;
+  };
+
+  std::vector<int32_t> choice = greedy;
+  const double greedy_cost = TotalCost(graph, greedy);
+  const int32_t rounds = SearchSbp(graph, kMaxSearchRounds, &choice);
+  const double searched_cost = TotalCost(graph, choice);
+  std::vector<int64_t> changed;
+  FOR_RANGE(int64_t, i, 0, nodes.size()) {
+    if (choice[i] != greedy[i]) { changed.push_back(i); }
+  }
+  const bool dry_run = job_desc.auto_parallel_dry_run();
+  LOG(INFO) << "AutoParallelPass job " << job_desc.job_name() << ": " << num_searchable
+            << " searchable ops, " << graph.links.size() << " links, " << rounds
+            << " rounds, predicted cost " << greedy_cost << " -> " << searched_cost << ", "
+            << changed.size() << " ops changed" << (dry_run ? " (dry run, not applied)" : "");
+  if (dry_run) {
+    const std::string sep = "\t";
+    auto log_stream =
+        TeePersistentLogStream::Create("auto_parallel_" + std::to_string(job_desc.job_id()));
+    (*log_stream) << "predicted_cost" << sep << "greedy" << sep << std::to_string(greedy_cost)
+                  << sep << "searched" << sep << std::to_string(searched_cost) << "\n";
+    (*log_stream) << "op_name" << sep << "op_type" << sep << "greedy" << sep << "searched"
+                  << sep << "greedy_compute_cost" << sep << "searched_compute_cost"
+                  << "\n";
+    for (int64_t i : changed) {
+      const Operator& op = nodes[i]->op();
+      (*log_stream) << op.op_name() << sep << op.op_conf().user_conf().op_type_name() << sep
+                    << SbpSignatureToString(op, candidates[i].at(greedy[i])) << sep
+                    << SbpSignatureToString(op, candidates[i].at(choice[i])) << sep
+                    << std::to_string(graph.ComputeCost(i, greedy[i])) << sep
+                    << std::to_string(graph.ComputeCost(i, choice[i])) << "\n";
+    }
+    return Maybe<void>::Ok();
+  }
+  if (changed.empty()) { return Maybe<void>::Ok(); }
+  // Pin every searchable op, not only the changed ones: greedy inference of an unchanged op could
+  // otherwise drift once its producers change.
+  FOR_RANGE(int64_t, i, 0, nodes.size()) {
+    if (graph.num_candidates[i] <= 1) { continue; }
+    job_builder->AddSbpSignature4OpName(nodes[i]->op().op_name(), candidates[i].at(choice[i]));
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("AutoParallelPass", AutoParallelPass);
+
+}  // namespace oneflow
@@ -409,6 +409,8 @@ class ModelSaveV2Kernel final : public Kernel {
                                                            variable_part_id2slice_views.size());
       writer.Write(key, in_accessor.host_blob());
       if (!is_broadcast) {
+        // the other ranks read this part once the counter is full
+        writer.Flush();
         const std::string rpc_key =
             snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*(counters_.at(i)));
         int32_t counter = Global<CtrlClient>::Get()->IncreaseCount(rpc_key);
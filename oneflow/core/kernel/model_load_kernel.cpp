@@ -56,7 +56,7 @@ class ModelLoadKernel final : public Kernel {
       const std::string key =
           GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
       if (reader.HasKey(key)) {
-        reader.Read(key, out_i);
+        reader.ReadAsync(key, out_i);
       } else {
         std::cerr << "WARNING! CANNOT find variable path in : " << JoinPath(path, key)
                   << ". It will be initialized. \n";
@@ -68,6 +68,7 @@ class ModelLoadKernel final : public Kernel {
                                                          random_seed_gen(), out_i);
       }
     }
+    reader.Wait();
   }
 };
 
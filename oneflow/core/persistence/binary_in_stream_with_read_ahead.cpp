@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/binary_in_stream_with_read_ahead.h"
+#include <cstring>
+
+namespace oneflow {
+
+BinaryInStreamWithReadAhead::BinaryInStreamWithReadAhead(fs::FileSystem* fs,
+                                                         const std::string& file_path,
+                                                         int32_t depth, size_t block_size)
+    : fs_(fs),
+      file_path_(file_path),
+      cur_file_pos_(0),
+      read_ahead_pos_(0),
+      depth_(depth),
+      block_size_(block_size) {
+  CHECK_GT(depth_, 0);
+  CHECK_GT(block_size_, 0);
+  file_size_ = fs->GetFileSize(file_path);
+}
+
+BinaryInStreamWithReadAhead::~BinaryInStreamWithReadAhead() { Drain(); }
+
+int32_t BinaryInStreamWithReadAhead::Read(char* s, size_t n) {
+  if (IsEof()) return -1;
+  CHECK_LE(cur_file_pos_ + n, file_size_);
+  while (n > 0) {
+    while (!blocks_.empty() && blocks_.front().offset + blocks_.front().size <= cur_file_pos_) {
+      PopFrontBlock();
+    }
+    if (blocks_.empty() || blocks_.front().offset > cur_file_pos_) { Restart(); }
+    Block* block = &blocks_.front();
+    if (!block->done) {
+      file_->Wait(block->read_id);
+      block->done = true;
+    }
+    const size_t block_pos = cur_file_pos_ - block->offset;
+    const size_t copy_size = std::min(n, block->size - block_pos);
+    std::memcpy(s, block->data.data() + block_pos, copy_size);
+    s += copy_size;
+    n -= copy_size;
+    cur_file_pos_ += copy_size;
+    if (block_pos + copy_size == block->size) {
+      PopFrontBlock();
+      ReadAhead();
+    }
+  }
+  if (IsEof()) {
+    Drain();
+    file_.reset();
+    free_buffers_.clear();
+  }
+  return 0;
+}
+
+void BinaryInStreamWithReadAhead::Restart() {
+  Drain();
+  if (!file_) { fs_->NewAsyncRandomAccessFile(file_path_, &file_); }
+  read_ahead_pos_ = cur_file_pos_;
+  ReadAhead();
+}
+
+void BinaryInStreamWithReadAhead::ReadAhead() {
+  while (blocks_.size() < static_cast<size_t>(depth_) && read_ahead_pos_ < file_size_) {
+    Block block;
+    if (!free_buffers_.empty()) {
+      block.data = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+    block.offset = read_ahead_pos_;
+    block.size = std::min<uint64_t>(block_size_, file_size_ - read_ahead_pos_);
+    block.data.resize(block_size_);
+    block.read_id = file_->ReadAsync(block.offset, block.size, block.data.data());
+    block.done = false;
+    read_ahead_pos_ += block.size;
+    blocks_.emplace_back(std::move(block));
+  }
+}
+
+void BinaryInStreamWithReadAhead::PopFrontBlock() {
+  Block* block = &blocks_.front();
+  if (!block->done) { file_->Wait(block->read_id); }
+  free_buffers_.emplace_back(std::move(block->data));
+  blocks_.pop_front();
+}
+
+void BinaryInStreamWithReadAhead::Drain() {
+  while (!blocks_.empty()) { PopFrontBlock(); }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,72 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_BINARY_IN_STREAM_WITH_READ_AHEAD_H_
+#define ONEFLOW_CORE_PERSISTENCE_BINARY_IN_STREAM_WITH_READ_AHEAD_H_
+
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/binary_in_stream.h"
+
+namespace oneflow {
+
+// Keeps up to depth reads of block_size bytes in flight ahead of the read position, so the
+// consumer only waits on the disk when it is faster than the disk. Moving the read position
+// anywhere but forward drops the reads in flight.
+class BinaryInStreamWithReadAhead final : public BinaryInStream {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BinaryInStreamWithReadAhead);
+  BinaryInStreamWithReadAhead() = delete;
+  ~BinaryInStreamWithReadAhead() override;
+
+  BinaryInStreamWithReadAhead(fs::FileSystem* fs, const std::string& file_path, int32_t depth,
+                              size_t block_size);
+  int32_t Read(char* s, size_t n) override;
+
+  uint64_t file_size() const override { return file_size_; }
+  uint64_t cur_file_pos() const override { return cur_file_pos_; }
+  void set_cur_file_pos(uint64_t val) override { cur_file_pos_ = val; }
+  bool IsEof() const override { return cur_file_pos_ == file_size_; }
+
+ private:
+  struct Block {
+    std::vector<char> data;
+    uint64_t offset;
+    size_t size;
+    int64_t read_id;
+    bool done;
+  };
+
+  void Restart();
+  void ReadAhead();
+  void PopFrontBlock();
+  void Drain();
+
+  fs::FileSystem* fs_;
+  std::string file_path_;
+  // opened on the first read and closed at eof, a scanner holds a stream per part file
+  std::unique_ptr<fs::AsyncRandomAccessFile> file_;
+  uint64_t file_size_;
+  uint64_t cur_file_pos_;
+  uint64_t read_ahead_pos_;
+  int32_t depth_;
+  size_t block_size_;
+  // blocks in flight, in file order and without gaps
+  std::deque<Block> blocks_;
+  std::vector<std::vector<char>> free_buffers_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_BINARY_IN_STREAM_WITH_READ_AHEAD_H_
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/binary_in_stream_with_read_ahead.h"
+#include "oneflow/core/persistence/binary_in_stream_without_local_copy.h"
+
+namespace oneflow {
+
+namespace {
+
+void TestReadAhead(bool use_io_uring) {
+  setenv("ONEFLOW_POSIX_FILE_SYSTEM_USE_IO_URING", use_io_uring ? "1" : "0", 1);
+  fs::FileSystem* file_system = LocalFS();
+  std::string file_name = JoinPath(GetCwd(), "tmp_read_ahead_test_file");
+  std::mt19937 gen(0);
+  std::string content(1000003, '\0');
+  for (char& c : content) { c = static_cast<char>(gen()); }
+  {
+    std::unique_ptr<fs::WritableFile> writable_file;
+    file_system->NewWritableFile(file_name, &writable_file);
+    writable_file->Append(content.data(), content.size());
+    writable_file->Close();
+  }
+  for (int32_t depth : {1, 2, 8}) {
+    for (size_t block_size : {4096, 65537, 4 * 1024 * 1024}) {
+      BinaryInStreamWithReadAhead stream(file_system, file_name, depth, block_size);
+      ASSERT_EQ(stream.file_size(), content.size());
+      std::string read;
+      std::vector<char> buffer(100000);
+      // sequential reads of random sizes
+      while (!stream.IsEof()) {
+        size_t n = std::min<size_t>(gen() % buffer.size(), stream.file_size() - read.size());
+        ASSERT_EQ(stream.Read(buffer.data(), n), 0);
+        read.append(buffer.data(), n);
+        ASSERT_EQ(stream.cur_file_pos(), read.size());
+      }
+      ASSERT_EQ(read, content);
+      ASSERT_EQ(stream.Read(buffer.data(), 1), -1);
+      // jumps backward and forward
+      for (int i = 0; i < 20; ++i) {
+        const uint64_t pos = gen() % content.size();
+        const size_t n = std::min<size_t>(gen() % buffer.size(), content.size() - pos);
+        stream.set_cur_file_pos(pos);
+        ASSERT_EQ(stream.Read(buffer.data(), n), 0);
+        ASSERT_EQ(std::string(buffer.data(), n), content.substr(pos, n));
+      }
+    }
+  }
+  file_system->DelFile(file_name);
+}
+
+}  // namespace
+
+TEST(BinaryInStreamWithReadAhead, io_uring) { TestReadAhead(true); }
+
+TEST(BinaryInStreamWithReadAhead, threads) { TestReadAhead(false); }
+
+TEST(BinaryInStreamWithReadAhead, benchmark) {
+  fs::FileSystem* file_system = LocalFS();
+  std::string file_name = JoinPath(GetCwd(), "tmp_read_ahead_benchmark_file");
+  std::string content(64 * 1024 * 1024, 'x');
+  {
+    std::unique_ptr<fs::WritableFile> writable_file;
+    file_system->NewWritableFile(file_name, &writable_file);
+    writable_file->Append(content.data(), content.size());
+    writable_file->Close();
+  }
+  // the consumer works on every 32KB chunk for about as long as it takes to read it
+  constexpr size_t kChunkSize = 32 * 1024;
+  auto Consume = [&](BinaryInStream* stream) {
+    std::vector<char> buffer(kChunkSize);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t sum = 0;
+    while (!stream->IsEof()) {
+      const size_t n = std::min<size_t>(kChunkSize, stream->file_size() - stream->cur_file_pos());
+      stream->Read(buffer.data(), n);
+      for (int pass = 0; pass < 4; ++pass) {
+        for (size_t i = 0; i < n; ++i) { sum += buffer[i] * (pass + 1); }
+      }
+    }
+    CHECK_GT(sum, 0);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  BinaryInStreamWithoutLocalCopy sync_stream(file_system, file_name);
+  const double sync_ms = Consume(&sync_stream);
+  BinaryInStreamWithReadAhead read_ahead_stream(file_system, file_name, 4, 1024 * 1024);
+  const double read_ahead_ms = Consume(&read_ahead_stream);
+  LOG(INFO) << "64MB consumed in " << sync_ms << " ms with synchronous reads, " << read_ahead_ms
+            << " ms with read ahead";
+  file_system->DelFile(file_name);
+}
+
+}  // namespace oneflow
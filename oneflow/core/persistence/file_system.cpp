@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/persistence/file_system.h"
 #include <errno.h>
+#include "oneflow/core/common/channel.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/job/job_set.pb.h"
@@ -26,6 +27,85 @@ namespace oneflow {
 
 namespace fs {
 
+namespace {
+
+// Background threads running the blocking reads of ThreadedAsyncRandomAccessFile, shared by all
+// the files. Never deleted, files may still be waited on during static destruction.
+class AsyncReadThreads final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncReadThreads);
+  ~AsyncReadThreads() = delete;
+
+  static AsyncReadThreads* Get() {
+    static AsyncReadThreads* threads =
+        new AsyncReadThreads(ParseIntegerFromEnv("ONEFLOW_ASYNC_READ_THREAD_NUM", 4));
+    return threads;
+  }
+
+  void AddWork(std::function<void()>&& work) { CHECK_EQ(channel_.Send(std::move(work)), 0); }
+
+ private:
+  explicit AsyncReadThreads(int64_t thread_num) {
+    CHECK_GT(thread_num, 0);
+    for (int64_t i = 0; i < thread_num; ++i) {
+      std::thread([this]() {
+        std::function<void()> work;
+        while (channel_.Receive(&work) == kChannelStatusSuccess) { work(); }
+      }).detach();
+    }
+  }
+
+  Channel<std::function<void()>> channel_;
+};
+
+class ThreadedAsyncRandomAccessFile final : public AsyncRandomAccessFile {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ThreadedAsyncRandomAccessFile);
+  explicit ThreadedAsyncRandomAccessFile(std::unique_ptr<RandomAccessFile>&& file)
+      : file_(std::move(file)), next_read_id_(0) {}
+  ~ThreadedAsyncRandomAccessFile() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return in_flight_read_ids_.empty(); });
+  }
+
+  int64_t ReadAsync(uint64_t offset, size_t n, char* result) override {
+    const int64_t read_id = next_read_id_++;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      in_flight_read_ids_.insert(read_id);
+    }
+    AsyncReadThreads::Get()->AddWork([this, read_id, offset, n, result]() {
+      file_->Read(offset, n, result);
+      // notify under the lock, the file may be deleted as soon as the lock is released
+      std::unique_lock<std::mutex> lock(mutex_);
+      in_flight_read_ids_.erase(read_id);
+      cond_.notify_all();
+    });
+    return read_id;
+  }
+
+  void Wait(int64_t read_id) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() { return in_flight_read_ids_.count(read_id) == 0; });
+  }
+
+ private:
+  std::unique_ptr<RandomAccessFile> file_;
+  int64_t next_read_id_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  HashSet<int64_t> in_flight_read_ids_;
+};
+
+}  // namespace
+
+void FileSystem::NewAsyncRandomAccessFile(const std::string& fname,
+                                          std::unique_ptr<AsyncRandomAccessFile>* result) {
+  std::unique_ptr<RandomAccessFile> file;
+  NewRandomAccessFile(fname, &file);
+  result->reset(new ThreadedAsyncRandomAccessFile(std::move(file)));
+}
+
 std::string FileSystem::SplitRecursiveDir(const std::string& dirname,
                                           std::vector<std::string>& sub_dirs) {
   std::string remaining_dir = dirname;
@@ -44,6 +124,13 @@ std::string FileSystem::SplitRecursiveDir(const std::string& dirname,
   return remaining_dir;
 }
 
+void FileSystem::NewPositionalWritableFile(const std::string& fname, uint64_t size,
+                                           std::unique_ptr<PositionalWritableFile>* result) {
+  result->reset();
+}
+
+void FileSystem::SyncFile(const std::string& fname) {}
+
 void FileSystem::CreateDirIfNotExist(const std::string& dirname) {
   if (IsDirectory(dirname)) { return; }
   CreateDir(dirname);
@@ -162,6 +249,7 @@ void CreateFileSystemFromEnv(std::unique_ptr<fs::FileSystem>& fs, const std::str
   } else {
     LOG(FATAL) << "invalid value " << fs_type << " of env " << fs_type_env;
   }
+  fs->set_read_ahead_depth(ParseIntegerFromEnv(env_prefix + "_READ_AHEAD_DEPTH", 0));
 }
 
 fs::FileSystem* DataFS() {
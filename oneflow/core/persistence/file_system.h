@@ -72,6 +72,45 @@ class WritableFile {
  private:
 };
 
+// A file abstraction for reads that are started now and waited on later.
+//
+// The returned file will only be accessed by one thread at a time.
+class AsyncRandomAccessFile {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncRandomAccessFile);
+  AsyncRandomAccessFile() = default;
+  virtual ~AsyncRandomAccessFile() = default;
+
+  // Starts reading `n` bytes from the file starting at `offset` into `result`,
+  // which has to stay valid until the read is waited on.
+  // Returns the id to wait on.
+  virtual int64_t ReadAsync(uint64_t offset, size_t n, char* result) = 0;
+
+  // Blocks until the read with the given id is done.
+  // Every read has to be waited on exactly once, before the file is deleted.
+  virtual void Wait(int64_t read_id) = 0;
+
+ private:
+};
+
+// A file abstraction for writing the parts of a file of known size in any order.
+//
+// Write may be called by multiple threads at once, for disjoint ranges.
+class PositionalWritableFile {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PositionalWritableFile);
+  PositionalWritableFile() = default;
+  virtual ~PositionalWritableFile() = default;
+
+  // Writes `n` bytes of `data` to the file starting at `offset`.
+  virtual void Write(uint64_t offset, const char* data, size_t n) = 0;
+
+  // Close the file.
+  virtual void Close() = 0;
+
+ private:
+};
+
 class FileSystem {
  public:
   virtual ~FileSystem() = default;
@@ -89,6 +128,13 @@ class FileSystem {
   virtual void NewRandomAccessFile(const std::string& fname,
                                    std::unique_ptr<RandomAccessFile>* result) = 0;
 
+  // Creates a random access read-only file for asynchronous reads.
+  //
+  // The default implementation runs the blocking reads of NewRandomAccessFile
+  // on a few background threads.
+  virtual void NewAsyncRandomAccessFile(const std::string& fname,
+                                        std::unique_ptr<AsyncRandomAccessFile>* result);
+
   // Creates an object that writes to a new file with the specified
   // name.
   //
@@ -102,6 +148,20 @@ class FileSystem {
   // and the object should be deleted when is not used.
   virtual void NewWritableFile(const std::string& fname, std::unique_ptr<WritableFile>* result) = 0;
 
+  // Creates an object that writes a new file of `size` bytes at any offset,
+  // deleting any existing file with the same name.
+  //
+  // The default implementation stores NULL in *result, meaning that the
+  // file system only supports sequential writing.
+  virtual void NewPositionalWritableFile(const std::string& fname, uint64_t size,
+                                         std::unique_ptr<PositionalWritableFile>* result);
+
+  // Makes the contents of a closed file durable, so that they survive a
+  // crash of the OS or the machine.
+  //
+  // The default implementation does nothing.
+  virtual void SyncFile(const std::string& fname);
+
   // Creates an object that either appends to an existing file, or
   // writes to a new file (if the file does not exist to begin with).
   //
@@ -161,11 +221,18 @@ class FileSystem {
   // Returns whether the given path is a directory or not.
   virtual bool IsDirectory(const std::string& fname) = 0;
 
+  // Number of reads PersistentInStream keeps in flight ahead of its consumer,
+  // 0 means reading synchronously.
+  int32_t read_ahead_depth() const { return read_ahead_depth_; }
+  void set_read_ahead_depth(int32_t val) { read_ahead_depth_ = val; }
+
  protected:
-  FileSystem() = default;
+  FileSystem() : read_ahead_depth_(0) {}
 
  private:
   std::string SplitRecursiveDir(const std::string& dirname, std::vector<std::string>& sub_dirs);
+
+  int32_t read_ahead_depth_;
 };
 
 }  // namespace fs
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/binary_in_stream_with_local_copy.h"
 #include "oneflow/core/persistence/binary_in_stream_without_local_copy.h"
+#include "oneflow/core/persistence/binary_in_stream_with_read_ahead.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include <cstring>
 #include "oneflow/core/common/constant.h"
@@ -25,6 +26,9 @@ namespace oneflow {
 namespace {
 
 constexpr size_t kDefaultBufferSize = 32 * 1024;  // 32KB
+constexpr int64_t kDefaultReadAheadBlockSize = 1024 * 1024;  // 1MB
+// io_uring rings of AsyncRandomAccessFile have 64 entries
+constexpr int32_t kMaxReadAheadDepth = 64;
 
 size_t GetBufferSize() {
   const char* buf_size_str = std::getenv("ONEFLOW_PERSISTENT_IN_STREAM_BUFFER_SIZE_BYTES");
@@ -53,9 +57,15 @@ PersistentInStream::PersistentInStream(int64_t session_id, fs::FileSystem* fs,
                                        bool cyclic, bool with_local_copy) {
   if (with_local_copy) { CHECK_EQ(offset, 0); }
   std::vector<std::shared_ptr<BinaryInStream>> streams;
+  const int32_t read_ahead_depth = std::min(fs->read_ahead_depth(), kMaxReadAheadDepth);
   for (auto& file_path : file_paths) {
     if (with_local_copy) {
       streams.emplace_back(new BinaryInStreamWithLocalCopy(fs, file_path));
+    } else if (read_ahead_depth > 0) {
+      static const int64_t block_size = ParseIntegerFromEnv(
+          "ONEFLOW_PERSISTENT_IN_STREAM_READ_AHEAD_BLOCK_SIZE_BYTES", kDefaultReadAheadBlockSize);
+      streams.emplace_back(
+          new BinaryInStreamWithReadAhead(fs, file_path, read_ahead_depth, block_size));
     } else {
       streams.emplace_back(new BinaryInStreamWithoutLocalCopy(fs, file_path));
     }
@@ -28,6 +28,14 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define OF_WITH_IO_URING
+#endif
+#endif
+
 namespace oneflow {
 
 namespace fs {
@@ -90,6 +98,201 @@ class PosixWritableFile : public WritableFile {
   }
 };
 
+class PosixPositionalWritableFile final : public PositionalWritableFile {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PosixPositionalWritableFile);
+  PosixPositionalWritableFile(const std::string& fname, int fd) : fname_(fname), fd_(fd) {}
+  ~PosixPositionalWritableFile() override {
+    if (fd_ >= 0) { close(fd_); }
+  }
+
+  void Write(uint64_t offset, const char* data, size_t n) override {
+    while (n > 0) {
+      const ssize_t w = pwrite(fd_, data, n, static_cast<off_t>(offset));
+      if (w < 0 && errno == EINTR) { continue; }
+      PCHECK(w > 0) << "Fail to write to file " << fname_ << ", errno is " << errno;
+      data += w;
+      offset += w;
+      n -= w;
+    }
+  }
+
+  void Close() override {
+    PCHECK(close(fd_) == 0) << "Fail to close file " << fname_ << ", errno is " << errno;
+    fd_ = -1;
+  }
+
+ private:
+  std::string fname_;
+  int fd_;
+};
+
+#ifdef OF_WITH_IO_URING
+
+// Talks to io_uring with raw syscalls, so there is no dependency on liburing.
+// The ring is only used by the thread owning the file, so nothing is locked.
+class IoUringRandomAccessFile final : public AsyncRandomAccessFile {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IoUringRandomAccessFile);
+  ~IoUringRandomAccessFile() override {
+    while (!in_flight_reads_.empty()) { Reap(true); }
+    munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != sq_ptr_) { munmap(cq_ptr_, cq_ring_size_); }
+    munmap(sq_ptr_, sq_ring_size_);
+    close(ring_fd_);
+    close(fd_);
+  }
+
+  // Returns nullptr when io_uring is not available, e.g. kernels before 5.1 or seccomp
+  static IoUringRandomAccessFile* New(const std::string& fname, int fd) {
+    static std::atomic<bool> unavailable(false);
+    if (unavailable.load(std::memory_order_relaxed)) { return nullptr; }
+    io_uring_params params{};
+    const int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, kRingSize, &params));
+    if (ring_fd < 0) {
+      LOG(INFO) << "io_uring is not available, errno is " << errno
+                << ", reading asynchronously on threads";
+      unavailable.store(true, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return new IoUringRandomAccessFile(fname, fd, ring_fd, params);
+  }
+
+  int64_t ReadAsync(uint64_t offset, size_t n, char* result) override {
+    CHECK_LT(in_flight_reads_.size(), kRingSize);
+    const int64_t read_id = next_read_id_++;
+    if (n == 0) { return read_id; }
+    Read* read = &in_flight_reads_[read_id];
+    read->offset = offset;
+    read->iov.iov_base = result;
+    read->iov.iov_len = n;
+    Submit(read_id, read);
+    return read_id;
+  }
+
+  void Wait(int64_t read_id) override {
+    while (in_flight_reads_.find(read_id) != in_flight_reads_.end()) { Reap(true); }
+  }
+
+ private:
+  static constexpr unsigned kRingSize = 64;
+
+  struct Read {
+    uint64_t offset;
+    iovec iov;
+  };
+
+  IoUringRandomAccessFile(const std::string& fname, int fd, int ring_fd,
+                          const io_uring_params& params)
+      : fname_(fname), fd_(fd), ring_fd_(ring_fd), next_read_id_(0) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) { sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_); }
+    sq_ptr_ = Mmap(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ptr_ = single_mmap ? sq_ptr_ : Mmap(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(Mmap(sqes_size_, IORING_OFF_SQES));
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  void* Mmap(size_t size, off_t offset) {
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                     offset);
+    PCHECK(ptr != MAP_FAILED) << "Fail to map io_uring, errno is " << errno;
+    return ptr;
+  }
+
+  int Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    while (true) {
+      const int ret = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+      if (ret >= 0 || errno != EINTR) { return ret; }
+    }
+  }
+
+  void Submit(int64_t read_id, Read* read) {
+    // there are never more in-flight reads than sq entries, so the sq is never full
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&read->iov);
+    sqe->len = 1;
+    sqe->off = read->offset;
+    sqe->user_data = static_cast<uint64_t>(read_id);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    PCHECK(Enter(1, 0, 0) == 1) << "Fail to submit read of file " << fname_ << ", errno is "
+                                << errno;
+  }
+
+  void Reap(bool wait) {
+    unsigned head = *cq_head_;
+    if (wait && head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      PCHECK(Enter(0, 1, IORING_ENTER_GETEVENTS) >= 0)
+          << "Fail to wait for read of file " << fname_ << ", errno is " << errno;
+    }
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      const int64_t read_id = static_cast<int64_t>(cqe.user_data);
+      auto it = in_flight_reads_.find(read_id);
+      CHECK(it != in_flight_reads_.end());
+      Read* read = &it->second;
+      if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+        Submit(read_id, read);
+      } else if (cqe.res <= 0) {
+        if (cqe.res == 0) { LOG(FATAL) << "Read EOF of file " << fname_; }
+        LOG(FATAL) << "Fail to read file " << fname_ << ", errno is " << -cqe.res;
+      } else if (static_cast<size_t>(cqe.res) < read->iov.iov_len) {
+        // short read, read the rest
+        read->offset += cqe.res;
+        read->iov.iov_base = static_cast<char*>(read->iov.iov_base) + cqe.res;
+        read->iov.iov_len -= cqe.res;
+        Submit(read_id, read);
+      } else {
+        in_flight_reads_.erase(it);
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  std::string fname_;
+  int fd_;
+  int ring_fd_;
+  void* sq_ptr_;
+  size_t sq_ring_size_;
+  void* cq_ptr_;
+  size_t cq_ring_size_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+  int64_t next_read_id_;
+  // node based, so the iovecs the kernel reads from do not move
+  HashMap<int64_t, Read> in_flight_reads_;
+};
+
+constexpr unsigned IoUringRandomAccessFile::kRingSize;
+
+#endif  // OF_WITH_IO_URING
+
 void PosixFileSystem::NewRandomAccessFile(const std::string& fname,
                                           std::unique_ptr<RandomAccessFile>* result) {
   std::string translated_fname = TranslateName(fname);
@@ -117,6 +320,42 @@ void PosixFileSystem::NewAppendableFile(const std::string& fname,
   CHECK_NOTNULL(result->get());
 }
 
+void PosixFileSystem::NewPositionalWritableFile(const std::string& fname, uint64_t size,
+                                                std::unique_ptr<PositionalWritableFile>* result) {
+  std::string translated_fname = TranslateName(fname);
+  int fd = open(translated_fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  PCHECK(fd >= 0) << "Fail to open file " << fname << ", errno is " << errno;
+  PCHECK(ftruncate(fd, static_cast<off_t>(size)) == 0)
+      << "Fail to resize file " << fname << ", errno is " << errno;
+  result->reset(new PosixPositionalWritableFile(translated_fname, fd));
+}
+
+void PosixFileSystem::SyncFile(const std::string& fname) {
+  std::string translated_fname = TranslateName(fname);
+  int fd = open(translated_fname.c_str(), O_RDONLY);
+  PCHECK(fd >= 0) << "Fail to open file " << fname << ", errno is " << errno;
+  PCHECK(fsync(fd) == 0) << "Fail to sync file " << fname << ", errno is " << errno;
+  close(fd);
+}
+
+void PosixFileSystem::NewAsyncRandomAccessFile(const std::string& fname,
+                                               std::unique_ptr<AsyncRandomAccessFile>* result) {
+#ifdef OF_WITH_IO_URING
+  if (ParseBooleanFromEnv("ONEFLOW_POSIX_FILE_SYSTEM_USE_IO_URING", true)) {
+    std::string translated_fname = TranslateName(fname);
+    int fd = open(translated_fname.c_str(), O_RDONLY);
+    PCHECK(fd >= 0) << "Fail to open file " << fname << ", errno is " << errno;
+    IoUringRandomAccessFile* file = IoUringRandomAccessFile::New(fname, fd);
+    if (file != nullptr) {
+      result->reset(file);
+      return;
+    }
+    close(fd);
+  }
+#endif  // OF_WITH_IO_URING
+  FileSystem::NewAsyncRandomAccessFile(fname, result);
+}
+
 bool PosixFileSystem::FileExists(const std::string& fname) {
   if (access(TranslateName(fname).c_str(), F_OK) == 0) { return true; }
   return false;
@@ -33,10 +33,18 @@ class PosixFileSystem final : public FileSystem {
   void NewRandomAccessFile(const std::string& fname,
                            std::unique_ptr<RandomAccessFile>* result) override;
 
+  void NewAsyncRandomAccessFile(const std::string& fname,
+                                std::unique_ptr<AsyncRandomAccessFile>* result) override;
+
   void NewWritableFile(const std::string& fname, std::unique_ptr<WritableFile>* result) override;
 
   void NewAppendableFile(const std::string& fname, std::unique_ptr<WritableFile>* result) override;
 
+  void NewPositionalWritableFile(const std::string& fname, uint64_t size,
+                                 std::unique_ptr<PositionalWritableFile>* result) override;
+
+  void SyncFile(const std::string& fname) override;
+
   bool FileExists(const std::string& fname) override;
 
   std::vector<std::string> ListDir(const std::string& dir) override;
@@ -15,24 +15,194 @@ limitations under the License.
 */
 #include "oneflow/core/persistence/snapshot.h"
 #include "oneflow/core/common/str_util.h"
-#include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
 #include "oneflow/core/register/tensor_slice_copier.h"
 #include "oneflow/core/ep/cpu/cpu_stream.h"
 #include "oneflow/core/ep/include/device_manager_registry.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
+// Counts the reads or writes of a SnapshotReader or SnapshotWriter that are not done yet.
+// Outlives the reader or writer when io is still in flight.
+class PendingSnapshotIo final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PendingSnapshotIo);
+  PendingSnapshotIo() : pending_cnt_(0), staging_bytes_(0) {}
+  ~PendingSnapshotIo() = default;
+
+  void Add() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_cnt_ += 1;
+  }
+
+  void Done() {
+    std::vector<std::function<void()>> idle_callbacks;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      CHECK_GT(pending_cnt_, 0);
+      pending_cnt_ -= 1;
+      if (pending_cnt_ > 0) { return; }
+      idle_callbacks.swap(idle_callbacks_);
+      cond_.notify_all();
+    }
+    for (const auto& callback : idle_callbacks) { callback(); }
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return pending_cnt_ == 0; });
+  }
+
+  // Calls `callback` on the thread finishing the last pending io, or right away if there is none
+  void OnIdle(const std::function<void()>& callback) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (pending_cnt_ > 0) {
+        idle_callbacks_.emplace_back(callback);
+        return;
+      }
+    }
+    callback();
+  }
+
+  // Blocks while taking `size` more bytes would exceed `max_staging_bytes`, unless nothing is
+  // staged at all.
+  void AcquireStagingBytes(int64_t size, int64_t max_staging_bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() {
+      return staging_bytes_ == 0 || staging_bytes_ + size <= max_staging_bytes;
+    });
+    staging_bytes_ += size;
+  }
+
+  void ReleaseStagingBytes(int64_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    staging_bytes_ -= size;
+    cond_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int64_t pending_cnt_;
+  int64_t staging_bytes_;
+  std::vector<std::function<void()>> idle_callbacks_;
+};
+
 namespace {
 
+constexpr int64_t kDefaultChunkSize = 64 * 1024 * 1024;  // 64MB
+
 std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+int64_t GetChunkSize() {
+  static const int64_t chunk_size =
+      std::max<int64_t>(ParseIntegerFromEnv("ONEFLOW_SNAPSHOT_IO_CHUNK_SIZE_BYTES",
+                                            kDefaultChunkSize),
+                        1);
+  return chunk_size;
+}
+
+// The first call has to come after the first SnapshotFS() call, so that the pool, whose
+// destructor finishes the remaining works, is destroyed before the file system.
+ThreadPool* SnapshotIoThreadPool() {
+  static ThreadPool pool(ParseIntegerFromEnv("ONEFLOW_SNAPSHOT_IO_THREAD_NUM", 8));
+  return &pool;
+}
+
+std::mutex pending_snapshots_mutex;
+std::vector<std::shared_future<void>> pending_snapshots;
+
+void AddPendingSnapshot(const std::shared_future<void>& future) {
+  std::unique_lock<std::mutex> lock(pending_snapshots_mutex);
+  pending_snapshots.erase(
+      std::remove_if(pending_snapshots.begin(), pending_snapshots.end(),
+                     [](const std::shared_future<void>& f) {
+                       return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                     }),
+      pending_snapshots.end());
+  pending_snapshots.emplace_back(future);
+}
+
+// Reads [offset, offset + size) of the file in chunks, calls `then` after the last chunk.
+void ReadFileAsync(const std::string& path, int64_t offset, int64_t size, char* dst,
+                   const std::shared_ptr<PendingSnapshotIo>& pending,
+                   const std::function<void()>& then) {
+  pending->Add();
+  if (size == 0) {
+    if (then) { then(); }
+    pending->Done();
+    return;
+  }
+  std::unique_ptr<fs::RandomAccessFile> unique_file;
+  SnapshotFS()->NewRandomAccessFile(path, &unique_file);
+  std::shared_ptr<fs::RandomAccessFile> file(unique_file.release());
+  const int64_t chunk_size = GetChunkSize();
+  const int64_t chunk_num = RoundUp(size, chunk_size) / chunk_size;
+  auto remaining_chunk_cnt = std::make_shared<std::atomic<int64_t>>(chunk_num);
+  FOR_RANGE(int64_t, i, 0, chunk_num) {
+    const int64_t chunk_offset = i * chunk_size;
+    const int64_t n = std::min(chunk_size, size - chunk_offset);
+    SnapshotIoThreadPool()->AddWork([=]() {
+      file->Read(offset + chunk_offset, n, dst + chunk_offset);
+      if (remaining_chunk_cnt->fetch_sub(1) == 1) {
+        if (then) { then(); }
+        pending->Done();
+      }
+    });
+  }
+}
+
+void ReadSliceAsync(const std::string& path, const Shape& logical_blob_shape,
+                    DataType data_type, const TensorSliceView& slice, char* dst,
+                    const std::shared_ptr<PendingSnapshotIo>& pending) {
+  const TensorSliceView logical_blob_slice(logical_blob_shape);
+  CHECK(logical_blob_slice.Contains(slice));
+  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
+  CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
+      << "unexpected model snapshot size, path: " << path;
+  const int64_t row_size = logical_blob_shape.Count(1) * GetSizeOfDataType(data_type);
+  const int64_t offset = slice.At(0).begin() * row_size;
+  const int64_t size = slice.At(0).size() * row_size;
+  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
+    ReadFileAsync(path, offset, size, dst, pending, nullptr);
+  } else {
+    // only the rows the slice lies in are read
+    std::vector<Range> row_ranges = logical_blob_slice.range_vec();
+    row_ranges.at(0) = slice.At(0);
+    const TensorSliceView rows_slice(row_ranges);
+    auto buffer = std::make_shared<std::vector<char>>(size);
+    ReadFileAsync(path, offset, size, buffer->data(), pending,
+                  [buffer, rows_slice, slice, data_type, dst]() {
+                    TensorSliceCopier copier(slice, rows_slice, data_type, DeviceType::kCPU);
+                    auto device = Global<ep::DeviceManagerRegistry>::Get()->GetDevice(
+                        DeviceType::kCPU, 0);
+                    CHECK(device);
+                    auto* stream = device->CreateStream();
+                    copier.Copy(stream, dst, buffer->data());
+                    device->DestroyStream(stream);
+                  });
+  }
+}
+
 }  // namespace
 
+void WaitForPendingSnapshots() {
+  std::vector<std::shared_future<void>> futures;
+  {
+    std::unique_lock<std::mutex> lock(pending_snapshots_mutex);
+    futures.swap(pending_snapshots);
+  }
+  for (const auto& future : futures) { future.wait(); }
+}
+
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
-    : root_path_(snapshot_root_path) {}
+    : root_path_(snapshot_root_path), pending_reads_(new PendingSnapshotIo()) {}
+
+SnapshotReader::~SnapshotReader() { Wait(); }
 
 bool SnapshotReader::HasKey(const std::string& key) const {
   const std::string path = GenDataFilePath(root_path_, key);
@@ -47,28 +217,10 @@ void SnapshotReader::Read(const std::string& key, Blob* blob) const {
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
                           DataType data_type, const TensorSliceView& slice, char* dst) const {
-  const TensorSliceView logical_blob_slice(logical_blob_shape);
-  CHECK(logical_blob_slice.Contains(slice));
-  const std::string path = GenDataFilePath(root_path_, key);
-  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
-  CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
-      << "unexpected model snapshot size, path: " << path;
-  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
-    PersistentInStream in_stream(
-        SnapshotFS(), path,
-        slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
-    in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
-  } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type, DeviceType::kCPU);
-    auto device = Global<ep::DeviceManagerRegistry>::Get()->GetDevice(DeviceType::kCPU, 0);
-    CHECK(device);
-    auto* stream = device->CreateStream();
-    copier.Copy(stream, dst, buffer.data());
-    device->DestroyStream(stream);
-  }
+  auto pending = std::make_shared<PendingSnapshotIo>();
+  ReadSliceAsync(GenDataFilePath(root_path_, key), logical_blob_shape, data_type, slice, dst,
+                 pending);
+  pending->Wait();
 }
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
@@ -77,10 +229,26 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
   Read(key, logical_blob_shape, blob->data_type(), slice, blob->mut_dptr<char>());
 }
 
-void SnapshotReader::Close() {}
+void SnapshotReader::ReadAsync(const std::string& key, const Shape& logical_blob_shape,
+                               DataType data_type, const TensorSliceView& slice, char* dst) {
+  ReadSliceAsync(GenDataFilePath(root_path_, key), logical_blob_shape, data_type, slice, dst,
+                 pending_reads_);
+}
+
+void SnapshotReader::ReadAsync(const std::string& key, Blob* blob) {
+  Shape shape;
+  blob->shape().ToShape(&shape);
+  ReadAsync(key, shape, blob->data_type(), TensorSliceView(shape), blob->mut_dptr<char>());
+}
+
+void SnapshotReader::Wait() { pending_reads_->Wait(); }
+
+void SnapshotReader::Close() { Wait(); }
 
 SnapshotWriter::SnapshotWriter(const std::string& snapshot_root_path)
-    : root_path_(snapshot_root_path) {
+    : root_path_(snapshot_root_path),
+      async_(ParseBooleanFromEnv("ONEFLOW_SNAPSHOT_WRITER_ASYNC", false)),
+      pending_writes_(new PendingSnapshotIo()) {
   OfCallOnce("SnapshotWriteCheckRootPath-" + snapshot_root_path, [&]() {
     if (SnapshotFS()->FileExists(snapshot_root_path)) {
       CHECK(SnapshotFS()->IsDirectory(snapshot_root_path))
@@ -93,21 +261,115 @@ SnapshotWriter::SnapshotWriter(const std::string& snapshot_root_path)
   });
 }
 
+SnapshotWriter::~SnapshotWriter() {
+  // keys written without Close, like the parts of ModelSaveV2, are still waited for at exit
+  auto done = std::make_shared<std::promise<void>>();
+  AddPendingSnapshot(done->get_future().share());
+  pending_writes_->OnIdle([done]() { done->set_value(); });
+}
+
 void SnapshotWriter::Write(const std::string& key, const char* data, size_t size) {
   const std::string path = GenDataFilePath(root_path_, key);
   const std::string dir_path = Dirname(path);
   SnapshotFS()->CreateDirIfNotExist(dir_path);
   CHECK(!SnapshotFS()->FileExists(path));
-  PersistentOutStream out_stream(SnapshotFS(), path);
-  out_stream.Write(data, size);
+  written_paths_.emplace_back(path);
+  std::shared_ptr<const char> buffer;
+  if (async_) {
+    static const int64_t max_staging_bytes =
+        ParseIntegerFromEnv("ONEFLOW_SNAPSHOT_WRITER_MAX_STAGING_BYTES", GetMaxVal<int64_t>());
+    pending_writes_->AcquireStagingBytes(size, max_staging_bytes);
+    char* staging = new char[size];
+    std::memcpy(staging, data, size);
+    auto pending = pending_writes_;
+    buffer.reset(staging, [pending, size](const char* ptr) {
+      delete[] ptr;
+      pending->ReleaseStagingBytes(size);
+    });
+  } else {
+    buffer.reset(data, [](const char*) {});
+  }
+  auto pending = pending_writes_;
+  const int64_t chunk_size = GetChunkSize();
+  if (size >= 2 * static_cast<size_t>(chunk_size)) {
+    std::unique_ptr<fs::PositionalWritableFile> unique_file;
+    SnapshotFS()->NewPositionalWritableFile(path, size, &unique_file);
+    if (unique_file) {
+      std::shared_ptr<fs::PositionalWritableFile> file(unique_file.release());
+      const int64_t chunk_num = RoundUp(size, chunk_size) / chunk_size;
+      auto remaining_chunk_cnt = std::make_shared<std::atomic<int64_t>>(chunk_num);
+      pending->Add();
+      FOR_RANGE(int64_t, i, 0, chunk_num) {
+        const int64_t offset = i * chunk_size;
+        const int64_t n = std::min<int64_t>(chunk_size, size - offset);
+        SnapshotIoThreadPool()->AddWork([=]() {
+          file->Write(offset, buffer.get() + offset, n);
+          if (remaining_chunk_cnt->fetch_sub(1) == 1) {
+            file->Close();
+            pending->Done();
+          }
+        });
+      }
+      if (!async_) { Flush(); }
+      return;
+    }
+  }
+  if (async_) {
+    pending->Add();
+    SnapshotIoThreadPool()->AddWork([path, buffer, size, pending]() {
+      {
+        PersistentOutStream out_stream(SnapshotFS(), path);
+        out_stream.Write(buffer.get(), size);
+      }
+      pending->Done();
+    });
+  } else {
+    PersistentOutStream out_stream(SnapshotFS(), path);
+    out_stream.Write(data, size);
+  }
 }
 
 void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
   Write(key, blob->dptr<char>(), blob->ByteSizeOfBlobBody());
 }
 
-void SnapshotWriter::Close() {
-  PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
+void SnapshotWriter::Flush() { pending_writes_->Wait(); }
+
+std::shared_future<void> SnapshotWriter::Close() {
+  auto done = std::make_shared<std::promise<void>>();
+  std::shared_future<void> future = done->get_future().share();
+  const std::string done_path = JoinPath(root_path_, "snapshot_done");
+  const auto MarkDone = [done, done_path]() {
+    { PersistentOutStream out_stream(SnapshotFS(), done_path); }
+    done->set_value();
+  };
+  if (ParseBooleanFromEnv("ONEFLOW_SNAPSHOT_WRITER_FSYNC", false)) {
+    std::vector<std::string> paths;
+    paths.swap(written_paths_);
+    pending_writes_->OnIdle([paths, MarkDone]() {
+      // sync the files all at once, the disk gets to order the flushes of all of them
+      if (paths.empty()) {
+        MarkDone();
+        return;
+      }
+      auto remaining_cnt = std::make_shared<std::atomic<int64_t>>(paths.size());
+      for (const std::string& path : paths) {
+        SnapshotIoThreadPool()->AddWork([path, remaining_cnt, MarkDone]() {
+          SnapshotFS()->SyncFile(path);
+          if (remaining_cnt->fetch_sub(1) == 1) { MarkDone(); }
+        });
+      }
+    });
+  } else {
+    written_paths_.clear();
+    pending_writes_->OnIdle(MarkDone);
+  }
+  if (async_) {
+    AddPendingSnapshot(future);
+  } else {
+    future.wait();
+  }
+  return future;
 }
 
 }  // namespace oneflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
 #define ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
 
+#include <future>
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/register/tensor_slice_view.h"
@@ -23,41 +24,69 @@ limitations under the License.
 namespace oneflow {
 
 class Blob;
+class PendingSnapshotIo;
 
+// Large variables are read in chunks by the snapshot io threads in parallel.
 class SnapshotReader final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SnapshotReader);
   SnapshotReader() = delete;
   explicit SnapshotReader(const std::string& snapshot_root_path);
-  ~SnapshotReader() = default;
+  ~SnapshotReader();
 
   void Read(const std::string& key, const Shape& logical_blob_shape, DataType data_type,
             const TensorSliceView& slice, char* dst) const;
   void Read(const std::string& key, const Shape& logical_blob_shape, const TensorSliceView& slice,
             Blob* blob) const;
   void Read(const std::string& key, Blob* blob) const;
+  // Like Read, but returns once the read is started. dst has to stay valid until Wait returns,
+  // so that the reads of many variables overlap each other.
+  void ReadAsync(const std::string& key, const Shape& logical_blob_shape, DataType data_type,
+                 const TensorSliceView& slice, char* dst);
+  void ReadAsync(const std::string& key, Blob* blob);
+  // Blocks until all the reads started by ReadAsync are done.
+  void Wait();
   bool HasKey(const std::string& key) const;
   void Close();
 
  private:
   const std::string root_path_;
+  std::shared_ptr<PendingSnapshotIo> pending_reads_;
 };
 
+// Large variables are written in chunks by the snapshot io threads in parallel.
+//
+// With ONEFLOW_SNAPSHOT_WRITER_ASYNC, Write copies the data to a staging buffer and returns
+// before the file is written, so the caller is free to modify the data right away.
+// With ONEFLOW_SNAPSHOT_WRITER_FSYNC, Close syncs all the files of the snapshot in one go
+// before marking the snapshot done.
 class SnapshotWriter final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SnapshotWriter);
   SnapshotWriter() = delete;
   explicit SnapshotWriter(const std::string& snapshot_root_path);
-  ~SnapshotWriter() = default;
+  ~SnapshotWriter();
 
   void Write(const std::string& key, const char* data, size_t size);
   void Write(const std::string& key, const Blob* blob);
-  void Close();
+  // Blocks until the files of all the keys written so far are complete.
+  void Flush();
+  // Marks the snapshot done once all the keys are written. Only blocks if the writer is not
+  // async, the returned future becomes ready when the snapshot is done either way.
+  // The writer may be destroyed before that.
+  std::shared_future<void> Close();
 
  private:
   const std::string root_path_;
+  const bool async_;
+  std::vector<std::string> written_paths_;
+  std::shared_ptr<PendingSnapshotIo> pending_writes_;
 };
 
+// Blocks until all the snapshots closed so far, and the writes of all the async writers
+// destroyed so far, are done.
+void WaitForPendingSnapshots();
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
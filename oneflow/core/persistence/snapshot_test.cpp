@@ -0,0 +1,168 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+// Small enough that the larger tensors take many chunks. The chunk size is read once per
+// process, so every test here sets the same value.
+constexpr int64_t kChunkSize = 4096;
+
+void SetUpSnapshotEnv() {
+  setenv("ONEFLOW_SNAPSHOT_IO_CHUNK_SIZE_BYTES", std::to_string(kChunkSize).c_str(), 1);
+}
+
+std::string NewSnapshotRoot(const std::string& name) {
+  std::string root = JoinPath(GetCwd(), name);
+  if (SnapshotFS()->IsDirectory(root)) { SnapshotFS()->RecursivelyDeleteDir(root); }
+  return root;
+}
+
+std::vector<char> SnapshotData(size_t size, int seed) {
+  std::vector<char> data(size);
+  FOR_RANGE(size_t, i, 0, size) { data.at(i) = static_cast<char>((i * 131 + seed * 7) % 251); }
+  return data;
+}
+
+// a single chunk, two chunks written positionally, and many chunks with a partial last one,
+// the last size has rows of 4 bytes
+const std::vector<size_t> kSnapshotSizes = {1, kChunkSize - 1, 2 * kChunkSize,
+                                            33 * kChunkSize + 100};
+
+void CheckSnapshot(const std::string& root) {
+  ASSERT_TRUE(SnapshotFS()->FileExists(JoinPath(root, "snapshot_done")));
+  SnapshotReader reader(root);
+  FOR_RANGE(size_t, i, 0, kSnapshotSizes.size()) {
+    const std::string key = "var" + std::to_string(i) + "/out";
+    ASSERT_TRUE(reader.HasKey(key));
+    const std::vector<char> expected = SnapshotData(kSnapshotSizes.at(i), i);
+    const Shape shape({static_cast<int64_t>(expected.size())});
+    std::vector<char> actual(expected.size());
+    reader.Read(key, shape, DataType::kChar, TensorSliceView(shape), actual.data());
+    ASSERT_EQ(actual, expected) << key;
+    std::vector<char> async_actual(expected.size());
+    reader.ReadAsync(key, shape, DataType::kChar, TensorSliceView(shape), async_actual.data());
+    reader.Wait();
+    ASSERT_EQ(async_actual, expected) << key;
+  }
+  // rows from the middle of the file, as the parts of a split variable are read
+  const int64_t row_size = 4;
+  const size_t last = kSnapshotSizes.size() - 1;
+  const std::vector<char> last_data = SnapshotData(kSnapshotSizes.at(last), last);
+  const Shape shape({static_cast<int64_t>(last_data.size()) / row_size, row_size});
+  const TensorSliceView slice({Range(600, 30000), Range(0, row_size)});
+  std::vector<char> actual(slice.shape().elem_cnt());
+  reader.Read("var" + std::to_string(last) + "/out", shape, DataType::kChar, slice,
+              actual.data());
+  ASSERT_TRUE(std::equal(actual.begin(), actual.end(), last_data.begin() + 600 * row_size));
+  reader.Close();
+}
+
+}  // namespace
+
+TEST(Snapshot, write_and_read) {
+  SetUpSnapshotEnv();
+  const std::string root = NewSnapshotRoot("tmp_snapshot_test_sync");
+  {
+    SnapshotWriter writer(root);
+    FOR_RANGE(size_t, i, 0, kSnapshotSizes.size()) {
+      const std::vector<char> data = SnapshotData(kSnapshotSizes.at(i), i);
+      writer.Write("var" + std::to_string(i) + "/out", data.data(), data.size());
+    }
+    // not async, the snapshot is done once Close returns
+    std::shared_future<void> done = writer.Close();
+    ASSERT_EQ(done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  }
+  CheckSnapshot(root);
+  SnapshotFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(Snapshot, async_write_and_read) {
+  SetUpSnapshotEnv();
+  setenv("ONEFLOW_SNAPSHOT_WRITER_ASYNC", "1", 1);
+  const std::string root = NewSnapshotRoot("tmp_snapshot_test_async");
+  const std::string unclosed_root = NewSnapshotRoot("tmp_snapshot_test_async_unclosed");
+  {
+    SnapshotWriter writer(root);
+    SnapshotWriter unclosed_writer(unclosed_root);
+    FOR_RANGE(size_t, i, 0, kSnapshotSizes.size()) {
+      std::vector<char> data = SnapshotData(kSnapshotSizes.at(i), i);
+      writer.Write("var" + std::to_string(i) + "/out", data.data(), data.size());
+      unclosed_writer.Write("var" + std::to_string(i) + "/out", data.data(), data.size());
+      // Write staged a copy, the data is free to change right away
+      std::fill(data.begin(), data.end(), 0);
+    }
+    writer.Close();
+    // the writes of a writer destroyed without Close are waited for as well
+  }
+  unsetenv("ONEFLOW_SNAPSHOT_WRITER_ASYNC");
+  WaitForPendingSnapshots();
+  CheckSnapshot(root);
+  {
+    SnapshotReader reader(unclosed_root);
+    FOR_RANGE(size_t, i, 0, kSnapshotSizes.size()) {
+      const std::vector<char> expected = SnapshotData(kSnapshotSizes.at(i), i);
+      const Shape shape({static_cast<int64_t>(expected.size())});
+      std::vector<char> actual(expected.size());
+      reader.Read("var" + std::to_string(i) + "/out", shape, DataType::kChar,
+                  TensorSliceView(shape), actual.data());
+      ASSERT_EQ(actual, expected);
+    }
+  }
+  SnapshotFS()->RecursivelyDeleteDir(root);
+  SnapshotFS()->RecursivelyDeleteDir(unclosed_root);
+}
+
+#ifdef OF_PLATFORM_POSIX
+TEST(Snapshot, posix_positional_writable_file) {
+  fs::PosixFileSystem file_system;
+  const std::string filename = JoinPath(GetCwd(), "tmp_positional_writable_file_test");
+  const std::vector<char> data = SnapshotData(10 * kChunkSize + 17, 0);
+  std::unique_ptr<fs::PositionalWritableFile> file;
+  file_system.NewPositionalWritableFile(filename, data.size(), &file);
+  ASSERT_TRUE(file);
+  // disjoint chunks, from several threads, last chunk first
+  std::vector<std::thread> threads;
+  for (int64_t offset = RoundUp(data.size(), kChunkSize) - kChunkSize; offset >= 0;
+       offset -= kChunkSize) {
+    threads.emplace_back([&, offset]() {
+      file->Write(offset, data.data() + offset,
+                  std::min<int64_t>(kChunkSize, data.size() - offset));
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  file->Close();
+  ASSERT_EQ(file_system.GetFileSize(filename), data.size());
+  std::unique_ptr<fs::RandomAccessFile> read_file;
+  file_system.NewRandomAccessFile(filename, &read_file);
+  std::vector<char> actual(data.size());
+  read_file->Read(0, actual.size(), actual.data());
+  ASSERT_EQ(actual, data);
+  file_system.DelFile(filename);
+}
+#endif  // OF_PLATFORM_POSIX
+
+}  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/lazy/actor/actor_message_bus.h"
 #include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/mpsc_channel.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/job/task.pb.h"
 #include "oneflow/core/lazy/actor/actor.h"
@@ -35,7 +36,7 @@ class Thread {
 
   void AddTask(const TaskProto&);
 
-  Channel<ActorMsg>* GetMsgChannelPtr() { return &msg_channel_; }
+  MpscChannel<ActorMsg>* GetMsgChannelPtr() { return &msg_channel_; }
 
   inline void EnqueueActorMsg(const ActorMsg& msg) {
     if (UseLocalMsgQueue()) {
@@ -68,7 +69,7 @@ class Thread {
   std::mutex id2task_mtx_;
 
   std::thread actor_thread_;
-  Channel<ActorMsg> msg_channel_;
+  MpscChannel<ActorMsg> msg_channel_;
   HashMap<int64_t, std::pair<std::unique_ptr<ActorContext>, std::unique_ptr<ActorBase>>>
       id2actor_ptr_;
   HashMap<int64_t, int64_t> id2job_id_;
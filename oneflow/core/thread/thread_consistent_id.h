@@ -24,6 +24,8 @@ namespace oneflow {
 const static int kThreadConsistentIdMain = 0;
 const static int kThreadConsistentIdHook = 1;
 const static int kThreadConsistentIdScheduler = 2;
+// The vm allocates ids for its transport streams upward from kThreadConsistentIdScheduler + 1.
+const static int kThreadConsistentIdCollectiveBoxing = 7;
 
 size_t GetThreadConsistentIdCount();
 
@@ -54,20 +54,15 @@ void MultiThreadLoop(size_t num, const DoEachT& DoEach) {
     SingleThreadLoop(num, DoEach);
     return;
   }
-  size_t thread_num = Global<ThreadPool>::Get()->thread_num();
-  thread_num = std::min(num, thread_num);
-  BalancedSplitter bs(num, thread_num);
-  BlockingCounter bc(thread_num);
-  FOR_RANGE(size_t, range_id, 0, thread_num) {
-    Global<ThreadPool>::Get()->AddWork([&bc, &bs, range_id, DoEach] {
-      size_t start = bs.At(range_id).begin();
-      size_t end = bs.At(range_id).end();
-      FOR_RANGE(size_t, i, start, end) { DoEach(i); }
-      bc.Decrease();
-    });
-  }
-  // buzy loop wait.
-  bc.WaitUntilCntEqualZero();
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  // Several chunks per thread, so that workers finishing early can take over the rest of a
+  // skewed loop instead of waiting for the slowest range.
+  constexpr size_t kChunkNumPerThread = 4;
+  const size_t grain = std::max<size_t>(
+      num / (std::max<size_t>(thread_pool->thread_num(), 1) * kChunkNumPerThread), 1);
+  thread_pool->ParallelFor(num, grain, [&DoEach](size_t begin, size_t end) {
+    FOR_RANGE(size_t, i, begin, end) { DoEach(i); }
+  });
 }
 
 }  // namespace oneflow
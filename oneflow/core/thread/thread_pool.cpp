@@ -14,31 +14,166 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kWorkerDequeCapacity = 4096;
+
+thread_local const ThreadPool* tls_current_pool = nullptr;
+thread_local int32_t tls_current_worker_id = -1;
+
+}  // namespace
+
+struct ThreadPool::Worker final {
+  explicit Worker(uint32_t seed) : deque(kWorkerDequeCapacity), rand_state(seed) {}
+
+  // xorshift32, only touched by the owner thread
+  uint32_t NextRandom() {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+  }
+
+  WorkStealingDeque<std::function<void()>> deque;
+  uint32_t rand_state;
+};
+
 ThreadPool::ThreadPool(int32_t thread_num)
-    : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    : threads_(thread_num),
+      pending_work_cnt_(0),
+      parked_thread_cnt_(0),
+      is_closed_(false),
+      spin_cnt_(ParseIntegerFromEnv("ONEFLOW_THREAD_POOL_SPIN_COUNT", 1024)) {
+  FOR_RANGE(int32_t, i, 0, thread_num) {
+    workers_.emplace_back(new Worker(static_cast<uint32_t>(i) * 2654435761U + 1));
+  }
   FOR_RANGE(int32_t, i, 0, thread_num) {
-    Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
-      std::function<void()> work;
-      while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
-    });
+    threads_[i] = std::thread([this, i]() { WorkerLoop(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
-    work_chans_.at(i).Close();
-    threads_.at(i).join();
+  {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    is_closed_ = true;
   }
+  park_cond_.notify_all();
+  FOR_RANGE(int32_t, i, 0, threads_.size()) { threads_.at(i).join(); }
 }
 
 void ThreadPool::AddWork(const std::function<void()>& work) {
-  const size_t cur_chan_idx =
-      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
-  work_chans_.at(cur_chan_idx).Send(work);
+  auto* item = new std::function<void()>(work);
+  // count the work before publishing it, so that pending_work_cnt_ never underflows
+  pending_work_cnt_.fetch_add(1);
+  bool pushed = false;
+  if (tls_current_pool == this) { pushed = workers_.at(tls_current_worker_id)->deque.Push(item); }
+  if (!pushed) {
+    std::unique_lock<std::mutex> lock(injection_mutex_);
+    injection_queue_.push(item);
+  }
+  NotifyOneIfParked();
+}
+
+void ThreadPool::NotifyOneIfParked() {
+  if (parked_thread_cnt_.load() == 0) { return; }
+  // taking the lock makes sure the parked worker is already waiting on park_cond_
+  { std::unique_lock<std::mutex> lock(park_mutex_); }
+  park_cond_.notify_one();
+}
+
+std::function<void()>* ThreadPool::TryPopInjectionQueue() {
+  std::unique_lock<std::mutex> lock(injection_mutex_);
+  if (injection_queue_.empty()) { return nullptr; }
+  std::function<void()>* work = injection_queue_.front();
+  injection_queue_.pop();
+  return work;
+}
+
+std::function<void()>* ThreadPool::TryTakeWork(int32_t worker_id) {
+  Worker* worker = workers_.at(worker_id).get();
+  std::function<void()>* work = worker->deque.Pop();
+  if (work != nullptr) { return work; }
+  work = TryPopInjectionQueue();
+  if (work != nullptr) { return work; }
+  const int32_t worker_num = workers_.size();
+  const int32_t offset = worker->NextRandom() % worker_num;
+  FOR_RANGE(int32_t, i, 0, worker_num) {
+    const int32_t victim_id = (offset + i) % worker_num;
+    if (victim_id == worker_id) { continue; }
+    work = workers_.at(victim_id)->deque.Steal();
+    if (work != nullptr) { return work; }
+  }
+  return nullptr;
+}
+
+void ThreadPool::WorkerLoop(int32_t worker_id) {
+  tls_current_pool = this;
+  tls_current_worker_id = worker_id;
+  while (true) {
+    std::function<void()>* work = TryTakeWork(worker_id);
+    for (int64_t i = 0; work == nullptr && i < spin_cnt_; ++i) {
+      if (pending_work_cnt_.load(std::memory_order_relaxed) > 0) {
+        work = TryTakeWork(worker_id);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    if (work == nullptr) {
+      std::unique_lock<std::mutex> lock(park_mutex_);
+      parked_thread_cnt_.fetch_add(1);
+      park_cond_.wait(lock, [this]() { return pending_work_cnt_.load() > 0 || is_closed_; });
+      parked_thread_cnt_.fetch_sub(1);
+      if (is_closed_ && pending_work_cnt_.load() == 0) { break; }
+      continue;
+    }
+    pending_work_cnt_.fetch_sub(1);
+    (*work)();
+    delete work;
+  }
+  tls_current_pool = nullptr;
+  tls_current_worker_id = -1;
+}
+
+void ThreadPool::ParallelFor(size_t num, size_t grain,
+                             const std::function<void(size_t begin, size_t end)>& DoRange) {
+  if (num == 0) { return; }
+  grain = std::max<size_t>(grain, 1);
+  const size_t chunk_num = (num + grain - 1) / grain;
+  if (chunk_num == 1 || threads_.empty()) {
+    DoRange(0, num);
+    return;
+  }
+  struct ParallelForCtx {
+    ParallelForCtx() : next_chunk_id(0), done_chunk_cnt(0), bc(1) {}
+    std::atomic<size_t> next_chunk_id;
+    std::atomic<size_t> done_chunk_cnt;
+    BlockingCounter bc;
+  };
+  auto ctx = std::make_shared<ParallelForCtx>();
+  // Helpers that get scheduled after all chunks are claimed return without touching DoRange,
+  // so it is safe to capture it by pointer.
+  const auto* DoRangePtr = &DoRange;
+  const auto RunChunks = [ctx, DoRangePtr, num, grain, chunk_num]() {
+    size_t done_cnt = 0;
+    while (true) {
+      const size_t chunk_id = ctx->next_chunk_id.fetch_add(1, std::memory_order_relaxed);
+      if (chunk_id >= chunk_num) { break; }
+      const size_t begin = chunk_id * grain;
+      (*DoRangePtr)(begin, std::min(begin + grain, num));
+      ++done_cnt;
+    }
+    if (done_cnt > 0 && ctx->done_chunk_cnt.fetch_add(done_cnt) + done_cnt == chunk_num) {
+      ctx->bc.Decrease();
+    }
+  };
+  const size_t helper_num = std::min(chunk_num - 1, threads_.size());
+  FOR_RANGE(size_t, i, 0, helper_num) { AddWork(RunChunks); }
+  RunChunks();
+  ctx->bc.WaitUntilCntEqualZero();
 }
 
 }  // namespace oneflow
@@ -17,10 +17,16 @@ limitations under the License.
 #define ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 
 #include "oneflow/core/common/util.h"
-#include "oneflow/core/common/channel.h"
+#include "oneflow/core/thread/work_stealing_deque.h"
 
 namespace oneflow {
 
+// Work-stealing thread pool.
+//
+// Work added from a pool worker goes to that worker's own lock-free deque, work added from
+// other threads goes to a shared injection queue. An idle worker pops its own deque first,
+// then the injection queue, then steals from random victims. Workers spin for a while before
+// parking on a condition variable, so bursts of short works do not pay for futex wakeups.
 class ThreadPool final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
@@ -31,11 +37,31 @@ class ThreadPool final {
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
 
+  // Calls DoRange on disjoint sub-ranges of [0, num) that cover the whole range, each of them
+  // at least `grain` elements long except the last one. The calling thread takes part in the
+  // loop and returns after all sub-ranges are done.
+  void ParallelFor(size_t num, size_t grain,
+                   const std::function<void(size_t begin, size_t end)>& DoRange);
+
  private:
-  std::vector<Channel<std::function<void()>>> work_chans_;
+  struct Worker;
+  void WorkerLoop(int32_t worker_id);
+  std::function<void()>* TryTakeWork(int32_t worker_id);
+  std::function<void()>* TryPopInjectionQueue();
+  void NotifyOneIfParked();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
   std::vector<std::thread> threads_;
 
-  std::atomic<size_t> work_cnt_;
+  std::mutex injection_mutex_;
+  std::queue<std::function<void()>*> injection_queue_;
+
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
+  std::atomic<int64_t> pending_work_cnt_;
+  std::atomic<int32_t> parked_thread_cnt_;
+  bool is_closed_;
+  const int64_t spin_cnt_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,166 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+// The dispatch policy ThreadPool used before work stealing, kept as the benchmark baseline.
+class RoundRobinChannelThreadPool final {
+ public:
+  explicit RoundRobinChannelThreadPool(int32_t thread_num)
+      : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    FOR_RANGE(int32_t, i, 0, thread_num) {
+      Channel<std::function<void()>>* chan = &(work_chans_.at(i));
+      threads_[i] = std::thread([chan]() {
+        std::function<void()> work;
+        while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
+      });
+    }
+  }
+  ~RoundRobinChannelThreadPool() {
+    FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
+      work_chans_.at(i).Close();
+      threads_.at(i).join();
+    }
+  }
+
+  void AddWork(const std::function<void()>& work) {
+    const size_t cur_chan_idx =
+        work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
+    work_chans_.at(cur_chan_idx).Send(work);
+  }
+
+ private:
+  std::vector<Channel<std::function<void()>>> work_chans_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> work_cnt_;
+};
+
+void BusyWaitFor(std::chrono::microseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {}
+}
+
+// Every `slow_period`-th work is 100x slower than the others. Returns the latency from AddWork
+// to the end of each work, in microseconds, sorted.
+template<typename PoolT>
+std::vector<int64_t> RunSkewedWorkload(PoolT* pool, int64_t work_num, int64_t slow_period) {
+  std::vector<int64_t> latencies(work_num);
+  BlockingCounter bc(work_num);
+  FOR_RANGE(int64_t, i, 0, work_num) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto duration = std::chrono::microseconds(i % slow_period == 0 ? 10000 : 100);
+    pool->AddWork([&latencies, &bc, start, duration, i]() {
+      BusyWaitFor(duration);
+      latencies.at(i) = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+std::string LatencySummary(const std::vector<int64_t>& sorted_latencies) {
+  const auto Percentile = [&](double p) {
+    return sorted_latencies.at(static_cast<size_t>(p * (sorted_latencies.size() - 1)));
+  };
+  return "p50: " + std::to_string(Percentile(0.5)) + "us, p99: " + std::to_string(Percentile(0.99))
+         + "us, max: " + std::to_string(sorted_latencies.back()) + "us";
+}
+
+}  // namespace
+
+TEST(ThreadPool, add_work) {
+  std::atomic<int64_t> cnt(0);
+  {
+    ThreadPool pool(4);
+    FOR_RANGE(int, i, 0, 1000) {
+      pool.AddWork([&cnt]() { ++cnt; });
+    }
+    // the destructor runs all pending works
+  }
+  ASSERT_EQ(cnt, 1000);
+}
+
+TEST(ThreadPool, add_work_from_worker) {
+  std::atomic<int64_t> cnt(0);
+  {
+    ThreadPool pool(4);
+    FOR_RANGE(int, i, 0, 10) {
+      pool.AddWork([&pool, &cnt]() {
+        FOR_RANGE(int, j, 0, 10000) {
+          pool.AddWork([&cnt]() { ++cnt; });
+        }
+      });
+    }
+  }
+  ASSERT_EQ(cnt, 100000);
+}
+
+TEST(ThreadPool, parallel_for) {
+  ThreadPool pool(4);
+  for (size_t grain : {1, 7, 1000, 100000}) {
+    std::vector<std::atomic<int32_t>> visits(10007);
+    for (auto& visit : visits) { visit = 0; }
+    pool.ParallelFor(visits.size(), grain, [&](size_t begin, size_t end) {
+      ASSERT_LT(begin, end);
+      ASSERT_LE(end - begin, grain);
+      FOR_RANGE(size_t, i, begin, end) { ++visits.at(i); }
+    });
+    for (const auto& visit : visits) { ASSERT_EQ(visit, 1); }
+  }
+}
+
+TEST(ThreadPool, nested_parallel_for) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> cnt(0);
+  pool.ParallelFor(16, 1, [&](size_t begin, size_t end) {
+    pool.ParallelFor(100, 3, [&](size_t begin, size_t end) { cnt += end - begin; });
+  });
+  ASSERT_EQ(cnt, 1600);
+}
+
+TEST(ThreadPool, skewed_workload_latency) {
+  constexpr int32_t kThreadNum = 4;
+  constexpr int64_t kWorkNum = 512;
+  constexpr int64_t kSlowPeriod = 32;
+  std::vector<int64_t> round_robin_latencies;
+  {
+    RoundRobinChannelThreadPool pool(kThreadNum);
+    round_robin_latencies = RunSkewedWorkload(&pool, kWorkNum, kSlowPeriod);
+  }
+  std::vector<int64_t> work_stealing_latencies;
+  {
+    ThreadPool pool(kThreadNum);
+    work_stealing_latencies = RunSkewedWorkload(&pool, kWorkNum, kSlowPeriod);
+  }
+  LOG(INFO) << "round robin channel pool, " << LatencySummary(round_robin_latencies);
+  LOG(INFO) << "work stealing pool, " << LatencySummary(work_stealing_latencies);
+  ASSERT_EQ(round_robin_latencies.size(), kWorkNum);
+  ASSERT_EQ(work_stealing_latencies.size(), kWorkNum);
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
+#define ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Bounded Chase-Lev deque.
+// Push/Pop may only be called by the owner thread, Steal may be called by any thread.
+// The buffer never grows, so Push returns false when the deque is full and the caller is
+// expected to fall back to some other queue.
+template<typename T>
+class WorkStealingDeque final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(WorkStealingDeque);
+  explicit WorkStealingDeque(size_t capacity)
+      : top_(0), bottom_(0), buffer_(capacity), mask_(capacity - 1) {
+    CHECK_GT(capacity, 0);
+    CHECK_EQ(capacity & (capacity - 1), 0) << "capacity must be a power of 2";
+  }
+  ~WorkStealingDeque() = default;
+
+  bool Push(T* item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_) { return false; }
+    buffer_[b & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  T* Pop() {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    T* item = nullptr;
+    if (t <= b) {
+      item = buffer_[b & mask_].load(std::memory_order_relaxed);
+      if (t == b) {
+        // last item, race against thieves
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+          item = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  T* Steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) { return nullptr; }
+    T* item = buffer_[t & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  bool Empty() const {
+    return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> top_;
+  // keeps the thieves' CAS on top_ away from the cache line of bottom_
+  char padding_[64];
+  std::atomic<int64_t> bottom_;
+  std::vector<std::atomic<T*>> buffer_;
+  const int64_t mask_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
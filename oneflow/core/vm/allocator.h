@@ -27,6 +27,8 @@ class Allocator {
 
   virtual void Allocate(char** mem_ptr, std::size_t size) = 0;
   virtual void Deallocate(char* mem_ptr, std::size_t size) = 0;
+  // Returns memory cached by this allocator to its backend, e.g. under memory pressure.
+  virtual void ReleaseCachedMemory() {}
 
  protected:
   Allocator() = default;
@@ -15,18 +15,49 @@ limitations under the License.
 */
 #include <cstdlib>
 #include "oneflow/core/vm/cpu_allocator.h"
+#include "oneflow/core/vm/thread_safe_allocator.h"
 #include "oneflow/core/common/util.h"
 
 namespace oneflow {
 namespace vm {
 
+CpuAllocator::CpuAllocator(size_t max_cached_bytes) : Allocator(), caching_allocator_(nullptr) {
+  if (max_cached_bytes > 0) {
+    caching_allocator_ =
+        new CpuCachingAllocator(std::unique_ptr<Allocator>(new CpuAllocator()), max_cached_bytes);
+    thread_safe_caching_allocator_.reset(
+        new ThreadSafeAllocator(std::unique_ptr<Allocator>(caching_allocator_)));
+  }
+}
+
 void CpuAllocator::Allocate(char** mem_ptr, std::size_t size) {
-  *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  if (thread_safe_caching_allocator_) {
+    thread_safe_caching_allocator_->Allocate(mem_ptr, size);
+  } else {
+    *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  }
+}
+
+void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (thread_safe_caching_allocator_) {
+    thread_safe_caching_allocator_->Deallocate(mem_ptr, size);
+  } else {
+    std::free(mem_ptr);
+  }
 }
 
-void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) { std::free(mem_ptr); }
+void CpuAllocator::ReleaseCachedMemory() {
+  if (thread_safe_caching_allocator_) { thread_safe_caching_allocator_->ReleaseCachedMemory(); }
+}
+
+CpuCachingAllocatorStats CpuAllocator::stats() const {
+  if (caching_allocator_ == nullptr) { return CpuCachingAllocatorStats(); }
+  return caching_allocator_->stats();
+}
 
-COMMAND(Global<CpuAllocator>::SetAllocated(new CpuAllocator()));
+// Caching is opt-in: ONEFLOW_VM_CPU_ALLOCATOR_MAX_CACHED_MB sets the cap, 0 disables it.
+COMMAND(Global<CpuAllocator>::SetAllocated(new CpuAllocator(
+    ParseIntegerFromEnv("ONEFLOW_VM_CPU_ALLOCATOR_MAX_CACHED_MB", 0) * 1024 * 1024)));
 
 }  // namespace vm
 }  // namespace oneflow
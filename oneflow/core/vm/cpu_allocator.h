@@ -17,18 +17,30 @@ limitations under the License.
 #define ONEFLOW_CORE_VM_CPU_ALLOCATOR_H_
 
 #include <cstdint>
+#include <memory>
 #include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/vm/cpu_caching_allocator.h"
 
 namespace oneflow {
 namespace vm {
 
+// Thread safe host allocator. Freed blocks are kept in a CpuCachingAllocator of at most
+// max_cached_bytes, max_cached_bytes = 0 makes every call go straight to aligned_alloc/free.
 class CpuAllocator final : public Allocator {
  public:
-  explicit CpuAllocator() = default;
+  explicit CpuAllocator(size_t max_cached_bytes = 0);
   ~CpuAllocator() override = default;
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+  void ReleaseCachedMemory() override;
+
+  CpuCachingAllocatorStats stats() const;
+
+ private:
+  // owned by thread_safe_caching_allocator_, nullptr if caching is disabled
+  CpuCachingAllocator* caching_allocator_;
+  std::unique_ptr<Allocator> thread_safe_caching_allocator_;
 };
 
 }  // namespace vm
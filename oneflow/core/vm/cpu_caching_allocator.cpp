@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+constexpr size_t CpuCachingAllocator::kSmallSizeLimit;
+
+CpuCachingAllocator::CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator,
+                                         size_t max_cached_bytes)
+    : Allocator(),
+      backend_allocator_(std::move(backend_allocator)),
+      max_cached_bytes_(max_cached_bytes),
+      hits_(0),
+      misses_(0),
+      cached_bytes_(0),
+      in_use_bytes_(0) {}
+
+CpuCachingAllocator::~CpuCachingAllocator() { ReleaseCachedMemory(); }
+
+size_t CpuCachingAllocator::SizeClass4Size(size_t size) {
+  if (size <= kSmallSizeLimit) { return RoundUp(std::max<size_t>(size, 1), kHostAlignSize); }
+  // size is in (2^log2, 2^(log2 + 1)], split that range into 4 classes
+  const int log2 = 63 - __builtin_clzll(size - 1);
+  const size_t step = static_cast<size_t>(1) << (log2 - 2);
+  return RoundUp(size, step);
+}
+
+void CpuCachingAllocator::Allocate(char** mem_ptr, std::size_t size) {
+  const size_t size_class = SizeClass4Size(size);
+  auto it = size_class2free_blocks_.find(size_class);
+  if (it != size_class2free_blocks_.end() && !it->second.empty()) {
+    *mem_ptr = it->second.back();
+    it->second.pop_back();
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    cached_bytes_.fetch_sub(size_class, std::memory_order_relaxed);
+    in_use_bytes_.fetch_add(size_class, std::memory_order_relaxed);
+    return;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  backend_allocator_->Allocate(mem_ptr, size_class);
+  if (*mem_ptr == nullptr) {
+    // the cached blocks of other size classes may be what the system is missing
+    ReleaseCachedMemory();
+    backend_allocator_->Allocate(mem_ptr, size_class);
+  }
+  CHECK_NOTNULL(*mem_ptr);
+  in_use_bytes_.fetch_add(size_class, std::memory_order_relaxed);
+}
+
+void CpuCachingAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+  const size_t size_class = SizeClass4Size(size);
+  in_use_bytes_.fetch_sub(size_class, std::memory_order_relaxed);
+  if (cached_bytes_.load(std::memory_order_relaxed) + size_class > max_cached_bytes_) {
+    backend_allocator_->Deallocate(mem_ptr, size_class);
+    return;
+  }
+  size_class2free_blocks_[size_class].push_back(mem_ptr);
+  cached_bytes_.fetch_add(size_class, std::memory_order_relaxed);
+}
+
+void CpuCachingAllocator::ReleaseCachedMemory() {
+  for (auto& pair : size_class2free_blocks_) {
+    for (char* mem_ptr : pair.second) { backend_allocator_->Deallocate(mem_ptr, pair.first); }
+    cached_bytes_.fetch_sub(pair.first * pair.second.size(), std::memory_order_relaxed);
+  }
+  size_class2free_blocks_.clear();
+  backend_allocator_->ReleaseCachedMemory();
+}
+
+CpuCachingAllocatorStats CpuCachingAllocator::stats() const {
+  CpuCachingAllocatorStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+  stats.in_use_bytes = in_use_bytes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+#define ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace vm {
+
+struct CpuCachingAllocatorStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  // bytes held in the free lists
+  int64_t cached_bytes = 0;
+  // bytes handed out and not yet deallocated, rounded up to size classes
+  int64_t in_use_bytes = 0;
+};
+
+// Caches freed host blocks in per size-class free lists and hands them out again instead of
+// going back to the backend allocator.
+//
+// Sizes up to kSmallSizeLimit are rounded up to kHostAlignSize, larger sizes are rounded up to one
+// of four classes per power of two, so a block wastes at most 25% of its size. A freed block is
+// returned to the backend instead of being cached once cached bytes would exceed max_cached_bytes.
+//
+// Not thread safe, wrap it with ThreadSafeAllocator when shared between threads. stats() may be
+// read from any thread.
+class CpuCachingAllocator final : public Allocator {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCachingAllocator);
+  CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator, size_t max_cached_bytes);
+  ~CpuCachingAllocator() override;
+
+  void Allocate(char** mem_ptr, std::size_t size) override;
+  void Deallocate(char* mem_ptr, std::size_t size) override;
+  void ReleaseCachedMemory() override;
+
+  CpuCachingAllocatorStats stats() const;
+
+  static size_t SizeClass4Size(size_t size);
+
+ private:
+  static constexpr size_t kSmallSizeLimit = 1024;
+
+  std::unique_ptr<Allocator> backend_allocator_;
+  const size_t max_cached_bytes_;
+  HashMap<size_t, std::vector<char*>> size_class2free_blocks_;
+
+  std::atomic<int64_t> hits_;
+  std::atomic<int64_t> misses_;
+  std::atomic<int64_t> cached_bytes_;
+  std::atomic<int64_t> in_use_bytes_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
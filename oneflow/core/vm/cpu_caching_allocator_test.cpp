@@ -0,0 +1,173 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include <thread>
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+namespace test {
+
+namespace {
+
+class CountingAllocator final : public Allocator {
+ public:
+  CountingAllocator(int64_t* allocate_cnt, int64_t* deallocate_cnt)
+      : allocate_cnt_(allocate_cnt), deallocate_cnt_(deallocate_cnt) {}
+  ~CountingAllocator() override = default;
+
+  void Allocate(char** mem_ptr, std::size_t size) override {
+    ++*allocate_cnt_;
+    backend_.Allocate(mem_ptr, size);
+  }
+  void Deallocate(char* mem_ptr, std::size_t size) override {
+    ++*deallocate_cnt_;
+    backend_.Deallocate(mem_ptr, size);
+  }
+
+ private:
+  CpuAllocator backend_;
+  int64_t* allocate_cnt_;
+  int64_t* deallocate_cnt_;
+};
+
+double MeasureAllocatorNs(Allocator* allocator, int iter_num) {
+  const std::vector<size_t> sizes{64, 256, 4096, 65536, 1 << 20, 4 << 20};
+  std::vector<char*> ptrs(sizes.size());
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int, i, 0, iter_num) {
+    FOR_RANGE(size_t, j, 0, sizes.size()) {
+      allocator->Allocate(&ptrs[j], sizes[j]);
+      ptrs[j][0] = 1;
+    }
+    FOR_RANGE(size_t, j, 0, sizes.size()) { allocator->Deallocate(ptrs[j], sizes[j]); }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count()
+         / (iter_num * sizes.size());
+}
+
+}  // namespace
+
+TEST(CpuCachingAllocator, size_class) {
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(0), kHostAlignSize);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(1), kHostAlignSize);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(65), 2 * kHostAlignSize);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(1024), 1024);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(1025), 1280);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(2048), 2048);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size(2049), 2560);
+  ASSERT_EQ(CpuCachingAllocator::SizeClass4Size((1 << 20) + 1), (1 << 20) + (1 << 18));
+  for (size_t size = 1; size < (1 << 16); size += 37) {
+    const size_t size_class = CpuCachingAllocator::SizeClass4Size(size);
+    ASSERT_GE(size_class, size);
+    ASSERT_EQ(size_class % kHostAlignSize, 0);
+    if (size > 1024) { ASSERT_LE(size_class, size + size / 4); }
+  }
+}
+
+TEST(CpuCachingAllocator, reuse) {
+  int64_t allocate_cnt = 0;
+  int64_t deallocate_cnt = 0;
+  CpuCachingAllocator allocator(
+      std::unique_ptr<Allocator>(new CountingAllocator(&allocate_cnt, &deallocate_cnt)), 1 << 20);
+  char* ptr0 = nullptr;
+  allocator.Allocate(&ptr0, 1000);
+  ASSERT_NE(ptr0, nullptr);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr0) % kHostAlignSize, 0);
+  allocator.Deallocate(ptr0, 1000);
+  char* ptr1 = nullptr;
+  // same size class as 1000
+  allocator.Allocate(&ptr1, 990);
+  ASSERT_EQ(ptr0, ptr1);
+  ASSERT_EQ(allocate_cnt, 1);
+  ASSERT_EQ(deallocate_cnt, 0);
+  CpuCachingAllocatorStats stats = allocator.stats();
+  ASSERT_EQ(stats.hits, 1);
+  ASSERT_EQ(stats.misses, 1);
+  ASSERT_EQ(stats.cached_bytes, 0);
+  ASSERT_EQ(stats.in_use_bytes, 1024);
+  allocator.Deallocate(ptr1, 990);
+  ASSERT_EQ(allocator.stats().cached_bytes, 1024);
+  ASSERT_EQ(allocator.stats().in_use_bytes, 0);
+  allocator.ReleaseCachedMemory();
+  ASSERT_EQ(deallocate_cnt, 1);
+  ASSERT_EQ(allocator.stats().cached_bytes, 0);
+}
+
+TEST(CpuCachingAllocator, max_cached_bytes) {
+  int64_t allocate_cnt = 0;
+  int64_t deallocate_cnt = 0;
+  {
+    CpuCachingAllocator allocator(
+        std::unique_ptr<Allocator>(new CountingAllocator(&allocate_cnt, &deallocate_cnt)), 4096);
+    std::vector<char*> ptrs(3);
+    for (char*& ptr : ptrs) { allocator.Allocate(&ptr, 2048); }
+    for (char* ptr : ptrs) { allocator.Deallocate(ptr, 2048); }
+    ASSERT_EQ(allocator.stats().cached_bytes, 4096);
+    ASSERT_EQ(deallocate_cnt, 1);
+    allocator.Allocate(&ptrs[0], 1 << 20);
+    allocator.Deallocate(ptrs[0], 1 << 20);
+    ASSERT_EQ(deallocate_cnt, 2);
+  }
+  ASSERT_EQ(allocate_cnt, 4);
+  ASSERT_EQ(deallocate_cnt, 4);
+}
+
+TEST(CpuCachingAllocator, multi_thread) {
+  CpuAllocator allocator(64 << 20);
+  std::vector<std::thread> threads;
+  FOR_RANGE(int, i, 0, 4) {
+    threads.emplace_back([&allocator, i]() {
+      std::vector<std::pair<char*, size_t>> blocks;
+      FOR_RANGE(int, j, 0, 1000) {
+        const size_t size = 64 + ((i * 1000 + j) * 97) % 100000;
+        char* ptr = nullptr;
+        allocator.Allocate(&ptr, size);
+        ASSERT_NE(ptr, nullptr);
+        ptr[0] = static_cast<char>(j);
+        ptr[size - 1] = static_cast<char>(j);
+        blocks.emplace_back(ptr, size);
+        if (blocks.size() > 16) {
+          allocator.Deallocate(blocks.front().first, blocks.front().second);
+          blocks.erase(blocks.begin());
+        }
+      }
+      for (const auto& block : blocks) { allocator.Deallocate(block.first, block.second); }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+  const CpuCachingAllocatorStats stats = allocator.stats();
+  ASSERT_EQ(stats.in_use_bytes, 0);
+  ASSERT_EQ(stats.hits + stats.misses, 4000);
+  allocator.ReleaseCachedMemory();
+  ASSERT_EQ(allocator.stats().cached_bytes, 0);
+}
+
+TEST(CpuCachingAllocator, benchmark) {
+  constexpr int kIterNum = 2000;
+  CpuAllocator raw_allocator;
+  CpuAllocator caching_allocator(64 << 20);
+  LOG(INFO) << "aligned_alloc: " << MeasureAllocatorNs(&raw_allocator, kIterNum)
+            << " ns per allocation";
+  LOG(INFO) << "CpuCachingAllocator: " << MeasureAllocatorNs(&caching_allocator, kIterNum)
+            << " ns per allocation";
+}
+
+}  // namespace test
+}  // namespace vm
+}  // namespace oneflow
@@ -33,6 +33,8 @@ class ThreadCtx final : public intrusive::Base {
   using StreamList = intrusive::List<INTRUSIVE_FIELD(Stream, thread_ctx_stream_hook_)>;
   using PendingInstructionChannel =
       intrusive::Channel<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)>;
+  using PendingInstructionList =
+      intrusive::List<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)>;
 
   // Getters
   bool has_stream_rt_desc() const { return stream_rt_desc_ != nullptr; }
@@ -44,6 +46,9 @@ class ThreadCtx final : public intrusive::Base {
   void clear_stream_rt_desc() { stream_rt_desc_ = nullptr; }
   StreamList* mut_stream_list() { return &stream_list_; }
   PendingInstructionChannel* mut_pending_instruction_list() { return &pending_instruction_list_; }
+  PendingInstructionList* mut_dispatching_instruction_list() {
+    return &dispatching_instruction_list_;
+  }
 
   // methods
   void __Init__(const StreamRtDesc& stream_rt_desc) {
@@ -64,6 +69,7 @@ class ThreadCtx final : public intrusive::Base {
         stream_rt_desc_(),
         stream_list_(),
         pending_instruction_list_(),
+        dispatching_instruction_list_(),
         thread_ctx_hook_() {}
   intrusive::Ref intrusive_ref_;
   // fields
@@ -71,6 +77,9 @@ class ThreadCtx final : public intrusive::Base {
   // lists
   StreamList stream_list_;
   PendingInstructionChannel pending_instruction_list_;
+  // Instructions dispatched by the scheduler but not yet flushed into pending_instruction_list_.
+  // Only accessed by the scheduler thread.
+  PendingInstructionList dispatching_instruction_list_;
 
  public:
   // list hooks
@@ -29,6 +29,11 @@ void ThreadSafeAllocator::Deallocate(char* mem_ptr, std::size_t size) {
   backend_allocator_->Deallocate(mem_ptr, size);
 }
 
+void ThreadSafeAllocator::ReleaseCachedMemory() {
+  std::unique_lock<std::mutex> lock(mutex4backend_allocator_);
+  backend_allocator_->ReleaseCachedMemory();
+}
+
 void SingleThreadOnlyAllocator::Allocate(char** mem_ptr, std::size_t size) {
   CheckUniqueThreadAccess();
   backend_allocator_->Allocate(mem_ptr, size);
@@ -39,6 +44,11 @@ void SingleThreadOnlyAllocator::Deallocate(char* mem_ptr, std::size_t size) {
   backend_allocator_->Deallocate(mem_ptr, size);
 }
 
+void SingleThreadOnlyAllocator::ReleaseCachedMemory() {
+  CheckUniqueThreadAccess();
+  backend_allocator_->ReleaseCachedMemory();
+}
+
 void SingleThreadOnlyAllocator::CheckUniqueThreadAccess() {
   std::unique_lock<std::mutex> lock(mutex4accessed_thread_id_);
   CHECK(accessed_thread_id_ == std::this_thread::get_id());
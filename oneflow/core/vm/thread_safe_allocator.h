@@ -33,6 +33,7 @@ class ThreadSafeAllocator final : public Allocator {
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+  void ReleaseCachedMemory() override;
 
  private:
   std::unique_ptr<Allocator> backend_allocator_;
@@ -49,6 +50,7 @@ class SingleThreadOnlyAllocator final : public Allocator {
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+  void ReleaseCachedMemory() override;
 
  private:
   void CheckUniqueThreadAccess();
@@ -319,6 +319,9 @@ void VirtualMachineEngine::TryConnectInstruction(Instruction* src_instruction,
                                                  Instruction* dst_instruction) {
   if (unlikely(src_instruction == dst_instruction)) { return; }
   if (likely(EdgeDispatchable(src_instruction, dst_instruction))) { return; }
+  // Consecutive dependences of an instruction usually come from the same producer.
+  auto* last_in_edge = dst_instruction->mut_in_edges()->Last();
+  if (last_in_edge != nullptr && &last_in_edge->src_instruction() == src_instruction) { return; }
   auto edge = instruction_edge_pool_.make_shared(src_instruction, dst_instruction);
   src_instruction->mut_out_edges()->PushBack(edge.Mutable());
   dst_instruction->mut_in_edges()->PushBack(edge.Mutable());
@@ -329,13 +332,26 @@ void VirtualMachineEngine::ConnectInstructionsByWrite(RwMutexedObjectAccess* dst
   auto* mirrored_object = dst_access->mut_mirrored_object();
   auto* dst_instruction = dst_access->mut_instruction();
   auto* access_list = mirrored_object->mut_rw_mutexed_object()->mut_access_list();
-  if (likely(access_list->Begin() == dst_access)) { return; }
+  auto* first_access = access_list->Begin();
+  if (likely(first_access == dst_access)) { return; }
+  // The access list holds the last writer (if any) followed by the readers since then. Every
+  // reader already runs after the writer, so the writer edge is only needed without readers.
+  Instruction* writer_instruction =
+      first_access->is_mut_operand() ? first_access->mut_instruction() : nullptr;
+  bool ordered_after_writer = false;
   INTRUSIVE_FOR_EACH_PTR(src_access, access_list) {
     if (unlikely(src_access == dst_access)) { break; }
-    TryConnectInstruction(src_access->mut_instruction(), dst_instruction);
+    if (src_access != first_access || writer_instruction == nullptr) {
+      auto* src_instruction = src_access->mut_instruction();
+      TryConnectInstruction(src_instruction, dst_instruction);
+      ordered_after_writer = ordered_after_writer || src_instruction != dst_instruction;
+    }
     CHECK_EQ(src_access->mut_rw_mutexed_object(), mirrored_object->mut_rw_mutexed_object());
     access_list->Erase(src_access);
   }
+  if (writer_instruction != nullptr && !ordered_after_writer) {
+    TryConnectInstruction(writer_instruction, dst_instruction);
+  }
 }
 
 void VirtualMachineEngine::ConnectInstructionsByRead(RwMutexedObjectAccess* dst_access) {
@@ -484,9 +500,20 @@ void VirtualMachineEngine::DispatchAndPrescheduleInstructions() {
       }
     }
   }
+  FlushDispatchingInstructions();
   OF_PROFILER_RANGE_POP();
 }
 
+// Hands the instructions dispatched in one round over to worker threads, taking each channel lock
+// and notifying each worker only once.
+void VirtualMachineEngine::FlushDispatchingInstructions() {
+  for (auto* thread_ctx : dispatching_thread_ctxs_) {
+    thread_ctx->mut_pending_instruction_list()->MoveFrom(
+        thread_ctx->mut_dispatching_instruction_list());
+  }
+  dispatching_thread_ctxs_.clear();
+}
+
 void VirtualMachineEngine::DispatchInstruction(Instruction* instruction) {
   OF_PROFILER_RANGE_PUSH(
       "D:"
@@ -499,7 +526,10 @@ void VirtualMachineEngine::DispatchInstruction(Instruction* instruction) {
   if (OnSchedulerThread(stream_type)) {
     stream_type.Run(this, instruction);
   } else {
-    stream->mut_thread_ctx()->mut_pending_instruction_list()->PushBack(instruction);
+    auto* thread_ctx = stream->mut_thread_ctx();
+    auto* dispatching_instruction_list = thread_ctx->mut_dispatching_instruction_list();
+    if (dispatching_instruction_list->empty()) { dispatching_thread_ctxs_.push_back(thread_ctx); }
+    dispatching_instruction_list->PushBack(instruction);
   }
   OF_PROFILER_RANGE_POP();
 }
@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_VM_VIRTUAL_MACHINE_ENGINE_H_
 
 #include <mutex>
+#include <vector>
 #include "oneflow/core/common/maybe.h"
 #include "oneflow/core/vm/interpret_type.h"
 #include "oneflow/core/vm/instruction.h"
@@ -172,6 +173,7 @@ class VirtualMachineEngine final : public intrusive::Base {
                                               Instruction* instrution);
   void ConsumeMirroredObjects(Id2LogicalObject* id2logical_object, Instruction* instruction);
   void DispatchInstruction(Instruction* instruction);
+  void FlushDispatchingInstructions();
   void TryDeleteLogicalObjects();
 
   bool EdgeDispatchable(const Instruction* src, const Instruction* dst) const;
@@ -213,6 +215,8 @@ class VirtualMachineEngine final : public intrusive::Base {
   std::map<std::string, RtInstrTypeId> instr_type_name2rt_instr_type_id_;
   RwMutexedObjectAccess::object_pool_type access_pool_;
   InstructionEdge::object_pool_type instruction_edge_pool_;
+  // Thread contexts whose dispatching_instruction_list is not empty.
+  std::vector<ThreadCtx*> dispatching_thread_ctxs_;
 };
 
 }  // namespace vm
@@ -13,7 +13,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <chrono>
 #include <iostream>
+#include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/vm/virtual_machine_engine.h"
 #include "oneflow/core/vm/control_stream_type.h"
 #include "oneflow/core/vm/vm_desc.h"
@@ -22,6 +24,9 @@ limitations under the License.
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/test_util.h"
 #include "oneflow/core/vm/stream_desc.h"
+#include "oneflow/core/vm/host_stream_type.h"
+#include "oneflow/core/vm/id_util.h"
+#include "oneflow/core/vm/phy_instr_operand.h"
 #include "oneflow/core/common/util.h"
 
 namespace oneflow {
@@ -39,6 +44,90 @@ TEST(VirtualMachineEngine, __Init__) {
   ASSERT_EQ(vm->stream_type_id2stream_rt_desc().size(), 2);
 }
 
+struct GlobalProcessCtxScope {
+  GlobalProcessCtxScope() {
+    auto* ctx = Global<ProcessCtx>::New();
+    ctx->mutable_ctrl_addr()->Add();
+    ctx->set_rank(0);
+    ctx->set_node_size(1);
+  }
+  ~GlobalProcessCtxScope() { Global<ProcessCtx>::Delete(); }
+};
+
+// Does nothing on HostStreamType, so that only the scheduling overhead gets measured.
+class NopInstructionType final : public InstructionType {
+ public:
+  NopInstructionType() = default;
+  ~NopInstructionType() override = default;
+
+  using stream_type = HostStreamType;
+
+  void Infer(Instruction* instruction) const override {}
+  void Compute(Instruction* instruction) const override {}
+};
+COMMAND(RegisterInstructionType<NopInstructionType>("Nop"));
+
+// Reads one object and writes another, like a LocalCallOpKernel instruction does with the
+// mirrored objects of its input and output tensors.
+class NopPhyInstrOperand final : public PhyInstrOperand {
+ public:
+  NopPhyInstrOperand(MirroredObject* input, MirroredObject* output)
+      : input_dependences_({input}), output_dependences_({output}) {}
+  ~NopPhyInstrOperand() override = default;
+
+  const DependenceVector& input_dependences() const override { return input_dependences_; }
+  const DependenceVector& output_dependences() const override { return output_dependences_; }
+
+ private:
+  DependenceVector input_dependences_;
+  DependenceVector output_dependences_;
+};
+
+TEST(VirtualMachineEngine, instruction_chain_throughput) {
+  constexpr int64_t kInstructionNum = 1000000;
+  constexpr int64_t kBatchSize = 1024;
+  constexpr int64_t kObjectNum = 8;
+  GlobalProcessCtxScope scope;
+  auto vm_desc = intrusive::make_shared<VmDesc>(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop"});
+  auto vm = intrusive::make_shared<VirtualMachineEngine>(vm_desc.Get());
+  std::vector<intrusive::shared_ptr<LogicalObject>> logical_objects;
+  std::vector<intrusive::shared_ptr<MirroredObject>> mirrored_objects;
+  for (int64_t i = 0; i < kObjectNum; ++i) {
+    auto logical_object = intrusive::make_shared<LogicalObject>(
+        IdUtil::NewPhysicalValueObjectId(GlobalProcessCtx::Rank()));
+    auto mirrored_object = intrusive::make_shared<MirroredObject>(logical_object.Mutable(), 0);
+    logical_objects.push_back(logical_object);
+    mirrored_objects.push_back(mirrored_object);
+  }
+  const auto& RunUntilEmpty = [&]() {
+    while (!vm->Empty()) {
+      vm->Schedule();
+      INTRUSIVE_FOR_EACH_PTR(thread_ctx, vm->mut_thread_ctx_list()) {
+        thread_ctx->TryReceiveAndRun();
+      }
+    }
+  };
+  const auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < kInstructionNum; i += kBatchSize) {
+    InstructionMsgList list;
+    for (int64_t j = i; j < std::min(i + kBatchSize, kInstructionNum); ++j) {
+      auto* input = mirrored_objects.at(j % kObjectNum).Mutable();
+      auto* output = mirrored_objects.at((j + 1) % kObjectNum).Mutable();
+      list.EmplaceBack(intrusive::make_shared<InstructionMsg>(
+          vm.Mutable(), "Nop", std::shared_ptr<const ParallelDesc>(),
+          std::make_shared<NopPhyInstrOperand>(input, output)));
+    }
+    CHECK_JUST(vm->Receive(&list));
+    RunUntilEmpty();
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ASSERT_TRUE(vm->Empty());
+  LOG(INFO) << kInstructionNum << " chained nop instructions: " << kInstructionNum / seconds
+            << " instructions/s";
+}
+
 }  // namespace
 
 }  // namespace test
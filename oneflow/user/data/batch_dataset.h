@@ -42,6 +42,8 @@ class BatchDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  void Materialize(LoadTargetPtrList* samples) override { loader_->Materialize(samples); }
+
  private:
   int32_t batch_size_;
   std::unique_ptr<Dataset<LoadTarget>> loader_;
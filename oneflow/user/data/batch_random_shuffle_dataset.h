@@ -54,6 +54,8 @@ class BatchRandomShuffleDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  void Materialize(LoadTargetPtrList* samples) override { loader_->Materialize(samples); }
+
  private:
   std::unique_ptr<Dataset<LoadTarget>> loader_;
   std::vector<LoadTargetPtrList> batch_buffer_;
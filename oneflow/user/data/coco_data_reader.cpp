@@ -60,7 +60,7 @@ COCODataReader::COCODataReader(user_op::KernelInitContext* ctx) : DataReader<COC
   }
 
   parser_.reset(new COCOParser(meta));
-  StartLoadThread();
+  StartLoadThreads(ctx);
 }
 
 COCOMeta::COCOMeta(int64_t session_id, const std::string& annotation_file,
@@ -28,15 +28,21 @@ COCODataset::LoadTargetShdPtrVec COCODataset::At(int64_t index) const {
   sample->id = meta_->GetImageId(index);
   sample->height = meta_->GetImageHeight(index);
   sample->width = meta_->GetImageWidth(index);
-  const std::string& image_file_path = meta_->GetImageFilePath(index);
-  PersistentInStream in_stream(session_id_, DataFS(), image_file_path);
-  int64_t file_size = DataFS()->GetFileSize(image_file_path);
-  sample->data.Resize(Shape({file_size}), DataType::kChar);
-  CHECK_EQ(in_stream.ReadFully(sample->data.mut_data<char>(), sample->data.nbytes()), 0);
   ret.emplace_back(std::move(sample));
   return ret;
 }
 
+void COCODataset::Materialize(LoadTargetShdPtrVec* samples) {
+  for (auto& sample : *samples) {
+    if (sample->data.data() != nullptr) { continue; }
+    const std::string& image_file_path = meta_->GetImageFilePath(sample->index);
+    PersistentInStream in_stream(session_id_, DataFS(), image_file_path);
+    int64_t file_size = DataFS()->GetFileSize(image_file_path);
+    sample->data.Resize(Shape({file_size}), DataType::kChar);
+    CHECK_EQ(in_stream.ReadFully(sample->data.mut_data<char>(), sample->data.nbytes()), 0);
+  }
+}
+
 size_t COCODataset::Size() const { return meta_->Size(); }
 
 }  // namespace data
@@ -41,8 +41,10 @@ class COCODataset final : public RandomAccessDataset<COCOImage> {
       : meta_(meta), session_id_(ctx->Attr<int64_t>("session_id")) {}
   ~COCODataset() = default;
 
+  // At() only fills the annotations, the image file is read by Materialize()
   LoadTargetShdPtrVec At(int64_t index) const override;
   size_t Size() const override;
+  void Materialize(LoadTargetShdPtrVec* samples) override;
 
  private:
   std::shared_ptr<const COCOMeta> meta_;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_USER_DATA_DATA_READER_H_
 #define ONEFLOW_USER_DATA_DATA_READER_H_
 
+#include <chrono>
 #include "oneflow/core/common/buffer.h"
 #include "oneflow/core/framework/op_kernel.h"
 #include "oneflow/user/data/dataset.h"
@@ -26,63 +27,162 @@ namespace data {
 
 static const int32_t kDataReaderBatchBufferSize = 4;
 
+struct DataReaderStats {
+  int64_t batch_cnt = 0;
+  // time load workers spent in Dataset::Next and Dataset::Materialize
+  int64_t load_ns = 0;
+  // time load workers were blocked on a full prefetch buffer
+  int64_t buffer_full_ns = 0;
+  // time Read was blocked on an empty prefetch buffer
+  int64_t buffer_empty_ns = 0;
+};
+
+// Loads batches on num_workers threads. Workers take turns calling loader_->Next() in batch
+// order, run loader_->Materialize() concurrently, and push to their own buffer. Read pulls the
+// buffers round robin, so batches come out in the same order for any number of workers.
 template<typename LoadTarget>
 class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+      : is_closed_(false),
+        num_workers_(0),
+        next_batch_id_(0),
+        fetch_batch_id_(0),
+        batch_cnt_(0),
+        load_ns_(0),
+        buffer_full_ns_(0),
+        buffer_empty_ns_(0) {}
   virtual ~DataReader() {
     Close();
-    if (load_thrd_.joinable()) { load_thrd_.join(); }
+    for (auto& load_thrd : load_thrds_) {
+      if (load_thrd.joinable()) { load_thrd.join(); }
+    }
+    const DataReaderStats stats = this->stats();
+    VLOG(1) << "DataReader loaded " << stats.batch_cnt << " batches, load " << stats.load_ns
+            << " ns, blocked on full buffer " << stats.buffer_full_ns
+            << " ns, blocked on empty buffer " << stats.buffer_empty_ns << " ns";
   }
 
   void Read(user_op::KernelComputeContext* ctx) {
-    CHECK(load_thrd_.joinable()) << "You should call StartLoadThread before read data";
+    CHECK(!load_thrds_.empty()) << "You should call StartLoadThread before read data";
     auto batch_data = FetchBatchData();
     parser_->Parse(batch_data, ctx);
   }
 
   void Close() {
-    is_closed_.store(true);
-    bool buffer_drained = false;
-    while (!buffer_drained) {
-      std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
-      auto status = batch_buffer_.TryReceive(&abandoned_batch_data);
-      CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
-      buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+    {
+      std::unique_lock<std::mutex> lock(loader_mutex_);
+      is_closed_.store(true);
+    }
+    loader_cond_.notify_all();
+    for (auto& batch_buffer : batch_buffers_) {
+      bool buffer_drained = false;
+      while (!buffer_drained) {
+        std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
+        auto status = batch_buffer->TryReceive(&abandoned_batch_data);
+        CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
+        buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+      }
+      batch_buffer->Close();
     }
-    batch_buffer_.Close();
+  }
+
+  DataReaderStats stats() const {
+    DataReaderStats stats;
+    stats.batch_cnt = batch_cnt_.load(std::memory_order_relaxed);
+    stats.load_ns = load_ns_.load(std::memory_order_relaxed);
+    stats.buffer_full_ns = buffer_full_ns_.load(std::memory_order_relaxed);
+    stats.buffer_empty_ns = buffer_empty_ns_.load(std::memory_order_relaxed);
+    return stats;
   }
 
  protected:
-  void StartLoadThread() {
-    if (load_thrd_.joinable()) { return; }
-    load_thrd_ = std::thread([this] {
-      while (!is_closed_.load() && LoadBatch()) {}
-    });
+  void StartLoadThread() { StartLoadThreads(1, kDataReaderBatchBufferSize); }
+
+  // prefetch_buffer_size is the number of batches buffered across all workers
+  void StartLoadThreads(int32_t num_workers, int32_t prefetch_buffer_size) {
+    if (!load_thrds_.empty()) { return; }
+    CHECK_GT(num_workers, 0);
+    CHECK_GT(prefetch_buffer_size, 0);
+    num_workers_ = num_workers;
+    const size_t buffer_size_per_worker = RoundUp(prefetch_buffer_size, num_workers) / num_workers;
+    for (int32_t i = 0; i < num_workers; ++i) {
+      batch_buffers_.emplace_back(
+          new Buffer<std::shared_ptr<LoadTargetPtrList>>(buffer_size_per_worker));
+    }
+    for (int32_t i = 0; i < num_workers; ++i) {
+      load_thrds_.emplace_back([this, i] { LoadWorker(i); });
+    }
+  }
+
+  // Uses the num_load_workers and prefetch_buffer_size attrs of the reader op
+  void StartLoadThreads(user_op::KernelInitContext* ctx) {
+    StartLoadThreads(ctx->Attr<int32_t>("num_load_workers"),
+                     ctx->Attr<int32_t>("prefetch_buffer_size"));
   }
 
   std::unique_ptr<Dataset<LoadTarget>> loader_;
   std::unique_ptr<Parser<LoadTarget>> parser_;
 
  private:
+  static int64_t NanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                                - start)
+        .count();
+  }
+
   std::shared_ptr<LoadTargetPtrList> FetchBatchData() {
     std::shared_ptr<LoadTargetPtrList> batch_data(nullptr);
-    CHECK_EQ(batch_buffer_.Pull(&batch_data), BufferStatus::kBufferStatusSuccess);
+    auto& batch_buffer = batch_buffers_.at(fetch_batch_id_ % num_workers_);
+    fetch_batch_id_ += 1;
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_EQ(batch_buffer->Pull(&batch_data), BufferStatus::kBufferStatusSuccess);
+    buffer_empty_ns_.fetch_add(NanosecondsSince(start), std::memory_order_relaxed);
     return batch_data;
   }
 
-  bool LoadBatch() {
-    std::shared_ptr<LoadTargetPtrList> batch_data =
-        std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
-    return batch_buffer_.Push(batch_data) == BufferStatus::kBufferStatusSuccess;
+  void LoadWorker(int32_t worker_id) {
+    while (true) {
+      std::shared_ptr<LoadTargetPtrList> batch_data = std::make_shared<LoadTargetPtrList>();
+      {
+        std::unique_lock<std::mutex> lock(loader_mutex_);
+        // batch i is loaded by worker i % num_workers_
+        loader_cond_.wait(lock, [this, worker_id]() {
+          return is_closed_.load() || next_batch_id_ % num_workers_ == worker_id;
+        });
+        if (is_closed_.load()) { return; }
+        const auto start = std::chrono::steady_clock::now();
+        *batch_data = loader_->Next();
+        load_ns_.fetch_add(NanosecondsSince(start), std::memory_order_relaxed);
+        next_batch_id_ += 1;
+      }
+      loader_cond_.notify_all();
+      auto start = std::chrono::steady_clock::now();
+      loader_->Materialize(batch_data.get());
+      load_ns_.fetch_add(NanosecondsSince(start), std::memory_order_relaxed);
+      start = std::chrono::steady_clock::now();
+      const auto status = batch_buffers_.at(worker_id)->Push(batch_data);
+      buffer_full_ns_.fetch_add(NanosecondsSince(start), std::memory_order_relaxed);
+      if (status != BufferStatus::kBufferStatusSuccess) { return; }
+      batch_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
   }
 
   std::atomic<bool> is_closed_;
-  Buffer<std::shared_ptr<LoadTargetPtrList>> batch_buffer_;
-  std::thread load_thrd_;
+  int64_t num_workers_;
+  std::mutex loader_mutex_;
+  std::condition_variable loader_cond_;
+  int64_t next_batch_id_;
+  int64_t fetch_batch_id_;
+  std::vector<std::unique_ptr<Buffer<std::shared_ptr<LoadTargetPtrList>>>> batch_buffers_;
+  std::vector<std::thread> load_thrds_;
+
+  std::atomic<int64_t> batch_cnt_;
+  std::atomic<int64_t> load_ns_;
+  std::atomic<int64_t> buffer_full_ns_;
+  std::atomic<int64_t> buffer_empty_ns_;
 };
 
 }  // namespace data
@@ -0,0 +1,157 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <future>
+#include <numeric>
+#include <random>
+#include "oneflow/user/data/data_reader.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr int64_t kNumSamples = 1000;
+constexpr int64_t kBatchSize = 7;
+
+// Returns the samples of every epoch in an order shuffled by seed. Materialize turns the index
+// into its payload after a short sleep, so that workers finish batches out of order.
+class ShuffledIndexDataset final : public Dataset<int64_t> {
+ public:
+  ShuffledIndexDataset(int64_t seed, int64_t max_materialize_us)
+      : gen_(seed), max_materialize_us_(max_materialize_us), cur_(kNumSamples) {
+    indices_.resize(kNumSamples);
+    std::iota(indices_.begin(), indices_.end(), 0);
+  }
+  ~ShuffledIndexDataset() override = default;
+
+  LoadTargetPtrList Next() override {
+    LoadTargetPtrList batch;
+    FOR_RANGE(int64_t, i, 0, kBatchSize) {
+      if (cur_ == kNumSamples) {
+        std::shuffle(indices_.begin(), indices_.end(), gen_);
+        cur_ = 0;
+      }
+      batch.emplace_back(std::make_shared<int64_t>(indices_.at(cur_++)));
+    }
+    return batch;
+  }
+
+  void Materialize(LoadTargetPtrList* samples) override {
+    if (max_materialize_us_ > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(*samples->front() % (max_materialize_us_ + 1)));
+    }
+    for (auto& sample : *samples) { *sample = Payload(*sample); }
+  }
+
+  static int64_t Payload(int64_t index) { return index * 10 + 3; }
+
+ private:
+  std::mt19937 gen_;
+  int64_t max_materialize_us_;
+  std::vector<int64_t> indices_;
+  int64_t cur_;
+};
+
+class RecordingParser final : public Parser<int64_t> {
+ public:
+  explicit RecordingParser(std::vector<int64_t>* samples) : samples_(samples) {}
+  ~RecordingParser() override = default;
+
+  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+             user_op::KernelComputeContext* ctx) override {
+    for (const auto& sample : *batch_data) { samples_->push_back(*sample); }
+  }
+
+ private:
+  std::vector<int64_t>* samples_;
+};
+
+class TestDataReader final : public DataReader<int64_t> {
+ public:
+  TestDataReader(int64_t seed, int32_t num_workers, int32_t prefetch_buffer_size,
+                 int64_t max_materialize_us, std::vector<int64_t>* samples)
+      : DataReader<int64_t>(nullptr) {
+    loader_.reset(new ShuffledIndexDataset(seed, max_materialize_us));
+    parser_.reset(new RecordingParser(samples));
+    StartLoadThreads(num_workers, prefetch_buffer_size);
+  }
+  ~TestDataReader() override = default;
+};
+
+std::vector<int64_t> ReadSamples(int64_t seed, int32_t num_workers, int32_t prefetch_buffer_size,
+                                 int64_t num_batches) {
+  std::vector<int64_t> samples;
+  TestDataReader reader(seed, num_workers, prefetch_buffer_size, 50, &samples);
+  FOR_RANGE(int64_t, i, 0, num_batches) { reader.Read(nullptr); }
+  return samples;
+}
+
+// Destroys the reader on another thread and fails instead of hanging if that does not return.
+void DestroyWithTimeout(std::unique_ptr<TestDataReader>&& reader) {
+  auto destroyed = std::make_shared<std::promise<void>>();
+  std::future<void> future = destroyed->get_future();
+  TestDataReader* raw_reader = reader.release();
+  std::thread([raw_reader, destroyed]() {
+    delete raw_reader;
+    destroyed->set_value();
+  }).detach();
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(30)), std::future_status::ready)
+      << "destroying the data reader hangs";
+}
+
+}  // namespace
+
+TEST(DataReader, deterministic_order_across_worker_nums) {
+  // a bit more than two epochs, so the reshuffle at the epoch end is covered
+  constexpr int64_t kNumBatches = 2 * kNumSamples / kBatchSize + 5;
+  for (int64_t seed : {0, 524287}) {
+    const std::vector<int64_t> expected = ReadSamples(seed, 1, 4, kNumBatches);
+    ASSERT_EQ(expected.size(), kNumBatches * kBatchSize);
+    std::vector<int64_t> first_epoch(expected.begin(), expected.begin() + kNumSamples);
+    std::sort(first_epoch.begin(), first_epoch.end());
+    FOR_RANGE(int64_t, i, 0, kNumSamples) {
+      ASSERT_EQ(first_epoch.at(i), ShuffledIndexDataset::Payload(i));
+    }
+    for (int32_t num_workers : {2, 3, 8}) {
+      for (int32_t prefetch_buffer_size : {1, 4, 16}) {
+        ASSERT_EQ(ReadSamples(seed, num_workers, prefetch_buffer_size, kNumBatches), expected)
+            << "num_workers " << num_workers << ", prefetch_buffer_size "
+            << prefetch_buffer_size;
+      }
+    }
+  }
+  ASSERT_NE(ReadSamples(0, 4, 4, 10), ReadSamples(1, 4, 4, 10));
+}
+
+TEST(DataReader, shutdown_mid_epoch) {
+  for (int32_t num_workers : {1, 2, 8}) {
+    for (int64_t num_read_batches : {0, 1, 13}) {
+      std::vector<int64_t> samples;
+      // slow materialize keeps workers inside it, a small buffer keeps the others blocked on
+      // a full buffer or waiting for their turn
+      std::unique_ptr<TestDataReader> reader(
+          new TestDataReader(0, num_workers, num_workers, 2000, &samples));
+      FOR_RANGE(int64_t, i, 0, num_read_batches) { reader->Read(nullptr); }
+      ASSERT_NO_FATAL_FAILURE(DestroyWithTimeout(std::move(reader)));
+      ASSERT_EQ(samples.size(), num_read_batches * kBatchSize);
+    }
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
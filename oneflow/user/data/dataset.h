@@ -32,7 +32,13 @@ class Dataset {
   Dataset() = default;
   virtual ~Dataset() = default;
 
+  // Next() advances the dataset and is never called concurrently
   virtual LoadTargetPtrList Next() = 0;
+  // Finishes loading samples returned by Next(). A dataset may leave the expensive part of
+  // loading (e.g. reading payloads from storage) to this call, which DataReader runs concurrently
+  // with Next() and with itself for different batches, so it must not touch the state Next()
+  // advances. Datasets wrapping another dataset forward it.
+  virtual void Materialize(LoadTargetPtrList* samples) {}
 };
 
 template<typename LoadTarget>
@@ -77,6 +77,8 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  void Materialize(LoadTargetShdPtrVec* samples) override { base_dataset_->Materialize(samples); }
+
  private:
   void CheckRanOutOfSize() {
     if (pos_ >= index_seq_.size()) {
@@ -0,0 +1,163 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/global_shuffle_dataset.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/user/data/onerec_dataset.h"
+#include "oneflow/user/kernels/example_generated.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// records closer than this are read together, the bytes between them are read and dropped
+constexpr int64_t kMaxCoalesceGap = 64 * 1024;
+constexpr int64_t kMaxCoalescedReadSize = 16 * 1024 * 1024;
+
+bool LocationLess(const RecordLocation& lhs, const RecordLocation& rhs) {
+  return std::make_pair(lhs.part_id, lhs.offset) < std::make_pair(rhs.part_id, rhs.offset);
+}
+
+}  // namespace
+
+GlobalShuffleDataset::GlobalShuffleDataset(fs::FileSystem* fs,
+                                           const std::vector<std::string>& part_paths,
+                                           RecordFormat format, int32_t batch_size, int64_t seed,
+                                           int64_t parallel_id, int64_t parallel_num,
+                                           bool verify_example)
+    : fs_(fs),
+      part_paths_(part_paths),
+      index_(RecordIndex::GetOrCreate(fs, part_paths, format)),
+      verify_example_(verify_example),
+      batch_size_(batch_size),
+      seed_(seed),
+      parallel_id_(parallel_id),
+      parallel_num_(parallel_num),
+      epoch_(-1),
+      cursor_(0) {
+  CHECK_GT(batch_size_, 0);
+  CHECK_LT(parallel_id_, parallel_num_);
+  CHECK_GE(static_cast<int64_t>(index_->size()), parallel_num_) << "fewer records than ranks";
+  CHECK(!verify_example_ || format == RecordFormat::kOneRec)
+      << "only OneRec examples can be verified";
+  NewEpoch();
+}
+
+GlobalShuffleDataset::LoadTargetPtrList GlobalShuffleDataset::Next() {
+  LoadTargetPtrList ret;
+  ret.reserve(batch_size_);
+  std::unique_lock<std::mutex> lock(pending_mutex_);
+  for (int32_t i = 0; i < batch_size_; ++i) {
+    if (cursor_ == permutation_.size()) { NewEpoch(); }
+    LoadTargetPtr sample_ptr(new TensorBuffer());
+    pending_.emplace(sample_ptr.get(), index_->at(permutation_.at(cursor_)));
+    cursor_ += 1;
+    ret.emplace_back(std::move(sample_ptr));
+  }
+  return ret;
+}
+
+void GlobalShuffleDataset::Materialize(LoadTargetPtrList* samples) {
+  std::vector<std::pair<RecordLocation, TensorBuffer*>> records;
+  records.reserve(samples->size());
+  {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    for (const LoadTargetPtr& sample : *samples) {
+      auto it = pending_.find(sample.get());
+      if (it == pending_.end()) { continue; }
+      records.emplace_back(it->second, sample.get());
+      pending_.erase(it);
+    }
+  }
+  std::sort(records.begin(), records.end(),
+            [](const std::pair<RecordLocation, TensorBuffer*>& lhs,
+               const std::pair<RecordLocation, TensorBuffer*>& rhs) {
+              return LocationLess(lhs.first, rhs.first);
+            });
+  ReadRecords(records);
+}
+
+void GlobalShuffleDataset::NewEpoch() {
+  epoch_ += 1;
+  std::vector<int64_t> permutation(index_->size());
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::mt19937_64 gen(seed_ + epoch_);
+  std::shuffle(permutation.begin(), permutation.end(), gen);
+  const Range range = BalancedSplitter(permutation.size(), parallel_num_).At(parallel_id_);
+  permutation_.assign(permutation.begin() + range.begin(), permutation.begin() + range.end());
+  cursor_ = 0;
+}
+
+fs::RandomAccessFile* GlobalShuffleDataset::PartFile4ThisThread(int32_t part_id) {
+  std::vector<std::unique_ptr<fs::RandomAccessFile>>* files = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(files_mutex_);
+    files = &thread_id2files_[std::this_thread::get_id()];
+  }
+  // only this thread touches its files
+  if (files->empty()) { files->resize(part_paths_.size()); }
+  std::unique_ptr<fs::RandomAccessFile>& file = files->at(part_id);
+  if (!file) { fs_->NewRandomAccessFile(part_paths_.at(part_id), &file); }
+  return file.get();
+}
+
+void GlobalShuffleDataset::ReadRecords(
+    const std::vector<std::pair<RecordLocation, TensorBuffer*>>& records) {
+  std::vector<char> buffer;
+  size_t first = 0;
+  while (first < records.size()) {
+    // records[first, last) are read with one request
+    const RecordLocation& first_location = records.at(first).first;
+    int64_t read_end = first_location.offset + index_->Extent(first_location);
+    size_t last = first + 1;
+    while (last < records.size()) {
+      const RecordLocation& location = records.at(last).first;
+      const int64_t end = location.offset + index_->Extent(location);
+      if (location.part_id != first_location.part_id || location.offset - read_end > kMaxCoalesceGap
+          || end - first_location.offset > kMaxCoalescedReadSize) {
+        break;
+      }
+      read_end = std::max(read_end, end);
+      last += 1;
+    }
+    buffer.resize(read_end - first_location.offset);
+    PartFile4ThisThread(first_location.part_id)
+        ->Read(first_location.offset, buffer.size(), buffer.data());
+    for (size_t i = first; i < last; ++i) {
+      const RecordLocation& location = records.at(i).first;
+      TensorBuffer* tensor = records.at(i).second;
+      const char* payload = buffer.data() + (location.offset - first_location.offset);
+      if (index_->format() == RecordFormat::kOneRec) {
+        XXH64_hash_t digest = 0;
+        std::memcpy(&digest, payload + index_->Extent(location) - sizeof(XXH64_hash_t),
+                    sizeof(XXH64_hash_t));
+        CHECK_EQ(ByteSwap(digest), XXH64(payload, location.size, 0));
+        if (verify_example_) {
+          flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(payload),
+                                         static_cast<size_t>(location.size));
+          CHECK(onerec::example::VerifyExampleBuffer(verifier)) << "bad OneRec example";
+        }
+      }
+      if (location.size == 0) { continue; }
+      tensor->Resize(Shape({static_cast<int64_t>(location.size)}), DataType::kChar);
+      std::memcpy(tensor->mut_data<char>(), payload, location.size);
+    }
+    first = last;
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
+#define ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
+
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/user/data/record_index.h"
+
+namespace oneflow {
+namespace data {
+
+// Shuffles the records of all parts instead of a window of them. Every epoch all ranks draw the
+// same permutation of the RecordIndex from seed and epoch, and each rank reads its own slice.
+// Next only assigns records to samples, Materialize reads them sorted by location and merges
+// nearby records into one read. Materialize runs on several load workers, each of them reads
+// through part files opened by itself.
+class GlobalShuffleDataset final : public Dataset<TensorBuffer> {
+ public:
+  using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetPtrList = std::vector<LoadTargetPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(GlobalShuffleDataset);
+  GlobalShuffleDataset(fs::FileSystem* fs, const std::vector<std::string>& part_paths,
+                       RecordFormat format, int32_t batch_size, int64_t seed, int64_t parallel_id,
+                       int64_t parallel_num, bool verify_example);
+  ~GlobalShuffleDataset() = default;
+
+  LoadTargetPtrList Next() override;
+  void Materialize(LoadTargetPtrList* samples) override;
+
+  int64_t epoch() const { return epoch_; }
+
+ private:
+  void NewEpoch();
+  void ReadRecords(const std::vector<std::pair<RecordLocation, TensorBuffer*>>& records);
+  // A RandomAccessFile can not be shared by threads on every file system.
+  fs::RandomAccessFile* PartFile4ThisThread(int32_t part_id);
+
+  fs::FileSystem* fs_;
+  std::vector<std::string> part_paths_;
+  std::shared_ptr<const RecordIndex> index_;
+  // verifies the flatbuffer of every OneRec example on the load workers
+  bool verify_example_;
+  std::mutex files_mutex_;
+  HashMap<std::thread::id, std::vector<std::unique_ptr<fs::RandomAccessFile>>> thread_id2files_;
+  int32_t batch_size_;
+  int64_t seed_;
+  int64_t parallel_id_;
+  int64_t parallel_num_;
+
+  int64_t epoch_;
+  // indices into index_ this rank reads in the current epoch
+  std::vector<int64_t> permutation_;
+  size_t cursor_;
+
+  // records assigned by Next and not read by Materialize yet
+  std::mutex pending_mutex_;
+  HashMap<const TensorBuffer*, RecordLocation> pending_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
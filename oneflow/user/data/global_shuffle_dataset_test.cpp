@@ -0,0 +1,208 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/user/data/global_shuffle_dataset.h"
+#include "oneflow/user/data/onerec_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr int kNumParts = 3;
+constexpr int kNumRecordsPerPart = 200;
+
+void WriteRecord(RecordFormat format, const std::string& record, std::ofstream* stream) {
+  if (format == RecordFormat::kOFRecord) {
+    const int64_t size = record.size();
+    stream->write(reinterpret_cast<const char*>(&size), sizeof(size));
+    stream->write(record.data(), record.size());
+  } else {
+    OneRecFrameHeaderView header_view{};
+    header_view.header.magic = kMagicNumber;
+    header_view.header.reserved = kReservedNumber;
+    header_view.header.payload_size = record.size();
+    header_view.header.digest = ByteSwap(XXH64(header_view.raw, kHeaderSizeWithoutDigest, 0));
+    stream->write(header_view.raw, kHeaderSize);
+    stream->write(record.data(), record.size());
+    const std::string padding(RoundUp(record.size(), kPayloadAlignmentSize) - record.size(), '\0');
+    stream->write(padding.data(), padding.size());
+    const XXH64_hash_t digest = ByteSwap(XXH64(record.data(), record.size(), 0));
+    stream->write(reinterpret_cast<const char*>(&digest), sizeof(digest));
+  }
+}
+
+// Records are "<part>-<index>" followed by a variable length of filler.
+std::vector<std::string> WriteParts(RecordFormat format, const std::string& prefix) {
+  std::mt19937 gen(0);
+  std::vector<std::string> paths;
+  for (int part = 0; part < kNumParts; ++part) {
+    paths.emplace_back(prefix + std::to_string(part));
+    std::ofstream stream(paths.back(), std::ios::binary | std::ios::trunc);
+    for (int i = 0; i < kNumRecordsPerPart; ++i) {
+      std::string record = std::to_string(part) + "-" + std::to_string(i) + ":";
+      record.append(gen() % 300, 'x');
+      WriteRecord(format, record, &stream);
+    }
+  }
+  return paths;
+}
+
+std::string SampleToString(const TensorBuffer& sample) {
+  return std::string(sample.data<char>(), sample.elem_cnt());
+}
+
+// Reads one epoch of every rank, in the order each rank returns the records.
+std::vector<std::vector<std::string>> ReadEpoch(RecordFormat format,
+                                                const std::vector<std::string>& paths,
+                                                int64_t parallel_num, int64_t seed) {
+  // samples are taken one by one to stop right at the epoch end, and materialized in groups so
+  // that nearby records get merged
+  constexpr size_t kGroupSize = 8;
+  std::vector<std::vector<std::string>> rank_records(parallel_num);
+  for (int64_t rank = 0; rank < parallel_num; ++rank) {
+    GlobalShuffleDataset dataset(LocalFS(), paths, format, 1, seed, rank, parallel_num, false);
+    std::vector<std::shared_ptr<TensorBuffer>> group;
+    while (true) {
+      auto sample = dataset.Next();
+      const bool epoch_end = dataset.epoch() > 0;
+      if (!epoch_end) { group.emplace_back(sample.front()); }
+      if (epoch_end || group.size() == kGroupSize) {
+        dataset.Materialize(&group);
+        for (const auto& record : group) {
+          rank_records.at(rank).emplace_back(SampleToString(*record));
+        }
+        group.clear();
+      }
+      if (epoch_end) { break; }
+    }
+  }
+  return rank_records;
+}
+
+void TestGlobalShuffle(RecordFormat format) {
+  Global<ThreadPool>::New(4);
+  const std::vector<std::string> paths =
+      WriteParts(format, JoinPath(GetCwd(), "tmp_global_shuffle_dataset_test_part-"));
+  for (int64_t parallel_num : {1, 3, 7}) {
+    const auto rank_records = ReadEpoch(format, paths, parallel_num, 1);
+    // every record is read by exactly one rank
+    std::set<std::string> all_records;
+    size_t num_records = 0;
+    for (const auto& records : rank_records) {
+      all_records.insert(records.begin(), records.end());
+      num_records += records.size();
+    }
+    ASSERT_EQ(num_records, kNumParts * kNumRecordsPerPart);
+    ASSERT_EQ(all_records.size(), kNumParts * kNumRecordsPerPart);
+    // the order only depends on the seed
+    ASSERT_EQ(ReadEpoch(format, paths, parallel_num, 1), rank_records);
+    ASSERT_NE(ReadEpoch(format, paths, parallel_num, 2), rank_records);
+  }
+  // records of different parts are mixed early on
+  const auto records = ReadEpoch(format, paths, 1, 1).front();
+  std::set<char> first_parts;
+  for (size_t i = 0; i < 16; ++i) { first_parts.insert(records.at(i).front()); }
+  ASSERT_EQ(first_parts.size(), kNumParts);
+  for (const std::string& path : paths) { std::remove(path.c_str()); }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace
+
+TEST(GlobalShuffleDataset, ofrecord) { TestGlobalShuffle(RecordFormat::kOFRecord); }
+
+TEST(GlobalShuffleDataset, onerec) { TestGlobalShuffle(RecordFormat::kOneRec); }
+
+TEST(GlobalShuffleDataset, epochs_differ) {
+  Global<ThreadPool>::New(4);
+  const std::vector<std::string> paths = WriteParts(
+      RecordFormat::kOFRecord, JoinPath(GetCwd(), "tmp_global_shuffle_dataset_epoch_test_part-"));
+  constexpr int32_t kBatchSize = kNumParts * kNumRecordsPerPart;
+  GlobalShuffleDataset dataset(LocalFS(), paths, RecordFormat::kOFRecord, kBatchSize, 1, 0, 1,
+                               false);
+  std::vector<std::string> epochs[2];
+  for (auto& epoch : epochs) {
+    auto batch = dataset.Next();
+    dataset.Materialize(&batch);
+    for (const auto& sample : batch) { epoch.emplace_back(SampleToString(*sample)); }
+  }
+  ASSERT_NE(epochs[0], epochs[1]);
+  std::sort(epochs[0].begin(), epochs[0].end());
+  std::sort(epochs[1].begin(), epochs[1].end());
+  ASSERT_EQ(epochs[0], epochs[1]);
+  for (const std::string& path : paths) { std::remove(path.c_str()); }
+  Global<ThreadPool>::Delete();
+}
+
+TEST(GlobalShuffleDataset, concurrent_materialize) {
+  Global<ThreadPool>::New(4);
+  const std::vector<std::string> paths =
+      WriteParts(RecordFormat::kOneRec,
+                 JoinPath(GetCwd(), "tmp_global_shuffle_dataset_concurrent_test_part-"));
+  constexpr int32_t kBatchSize = 16;
+  constexpr int kNumThreads = 4;
+  GlobalShuffleDataset dataset(LocalFS(), paths, RecordFormat::kOneRec, kBatchSize, 1, 0, 1,
+                               false);
+  const int num_batches = kNumParts * kNumRecordsPerPart / kBatchSize;
+  std::vector<std::vector<std::shared_ptr<TensorBuffer>>> batches;
+  for (int i = 0; i < num_batches; ++i) { batches.emplace_back(dataset.Next()); }
+  // the load workers materialize their batches at the same time, each through its own files
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = t; i < num_batches; i += kNumThreads) { dataset.Materialize(&batches.at(i)); }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  std::set<std::string> records;
+  for (const auto& batch : batches) {
+    for (const auto& sample : batch) { records.insert(SampleToString(*sample)); }
+  }
+  ASSERT_EQ(records.size(), num_batches * kBatchSize);
+  for (const std::string& record : records) { ASSERT_NE(record.find('-'), std::string::npos); }
+  for (const std::string& path : paths) { std::remove(path.c_str()); }
+  Global<ThreadPool>::Delete();
+}
+
+TEST(RecordIndex, shared_until_parts_change) {
+  Global<ThreadPool>::New(4);
+  const std::vector<std::string> paths = WriteParts(
+      RecordFormat::kOFRecord, JoinPath(GetCwd(), "tmp_record_index_cache_test_part-"));
+  const auto index = RecordIndex::GetOrCreate(LocalFS(), paths, RecordFormat::kOFRecord);
+  ASSERT_EQ(index->size(), kNumParts * kNumRecordsPerPart);
+  ASSERT_EQ(RecordIndex::GetOrCreate(LocalFS(), paths, RecordFormat::kOFRecord), index);
+  // a subset of the parts is another index
+  const std::vector<std::string> first_part(paths.begin(), paths.begin() + 1);
+  ASSERT_EQ(RecordIndex::GetOrCreate(LocalFS(), first_part, RecordFormat::kOFRecord)->size(),
+            kNumRecordsPerPart);
+  {
+    std::ofstream stream(paths.back(), std::ios::binary | std::ios::app);
+    WriteRecord(RecordFormat::kOFRecord, "appended", &stream);
+  }
+  const auto grown_index = RecordIndex::GetOrCreate(LocalFS(), paths, RecordFormat::kOFRecord);
+  ASSERT_NE(grown_index, index);
+  ASSERT_EQ(grown_index->size(), kNumParts * kNumRecordsPerPart + 1);
+  for (const std::string& path : paths) { std::remove(path.c_str()); }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace data
+}  // namespace oneflow
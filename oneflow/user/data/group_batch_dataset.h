@@ -77,6 +77,8 @@ class GroupBatchDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  void Materialize(LoadTargetShdPtrVec* samples) override { base_->Materialize(samples); }
+
  private:
   int64_t FindEarliestBatchGroupId() const {
     int64_t group_id = -1;
@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_USER_DATA_OFRECORD_DATA_READER_H_
 
 #include "oneflow/user/data/data_reader.h"
+#include "oneflow/user/data/global_shuffle_dataset.h"
 #include "oneflow/user/data/ofrecord_dataset.h"
 #include "oneflow/user/data/ofrecord_parser.h"
 #include "oneflow/user/data/random_shuffle_dataset.h"
@@ -29,14 +30,30 @@ namespace data {
 class OFRecordDataReader final : public DataReader<TensorBuffer> {
  public:
   OFRecordDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
-    loader_.reset(new OFRecordDataset(ctx));
     parser_.reset(new OFRecordParser());
-    if (ctx->Attr<bool>("random_shuffle")) {
-      loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
-    }
     int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
-    loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
-    StartLoadThread();
+    const bool random_shuffle = ctx->Attr<bool>("random_shuffle");
+    const auto mode = ctx->Attr<std::string>("shuffle_mode");
+    if (random_shuffle && mode == "global") {
+      int32_t parallel_id = 0;
+      int32_t parallel_num = 0;
+      GetOFRecordParallelIdAndNum(ctx, &parallel_id, &parallel_num);
+      // all ranks have to draw the same permutation
+      int64_t seed = ctx->Attr<int64_t>("seed");
+      if (seed == -1) { seed = kOneflowDatasetSeed; }
+      loader_.reset(new GlobalShuffleDataset(DataFS(), GetOFRecordDataFilePaths(ctx),
+                                             RecordFormat::kOFRecord, batch_size, seed,
+                                             parallel_id, parallel_num,
+                                             /*verify_example=*/false));
+    } else {
+      loader_.reset(new OFRecordDataset(ctx));
+      if (random_shuffle) {
+        CHECK_EQ(mode, "instance") << "unsupported shuffle_mode " << mode;
+        loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
+      }
+      loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+    }
+    StartLoadThreads(ctx);
   }
   ~OFRecordDataReader() = default;
 
@@ -21,14 +21,55 @@ limitations under the License.
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/rpc/include/global_process_ctx.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/user/data/dataset.h"
+#include "oneflow/user/data/ofrecord_mapped_file.h"
 
 namespace oneflow {
 namespace data {
 
+inline std::vector<std::string> GetOFRecordDataFilePaths(user_op::KernelInitContext* ctx) {
+  const int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
+  const std::string data_dir = ctx->Attr<std::string>("data_dir");
+  const std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
+  const int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
+  std::vector<std::string> data_file_paths;
+  for (int i = 0; i < data_part_num; ++i) {
+    std::string num = std::to_string(i);
+    int32_t zero_count = std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
+    data_file_paths.emplace_back(
+        JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
+  }
+  return data_file_paths;
+}
+
+// The rank of this reader and the number of ranks the data parts are split across.
+inline void GetOFRecordParallelIdAndNum(user_op::KernelInitContext* ctx, int32_t* parallel_id,
+                                        int32_t* parallel_num) {
+  bool is_local = false;
+  // NOTE(zwx): OFRecordDataset is used by OFRecordDataReader and
+  // OFRecordImageClassificationDataReader both, the latter has no attr nd_sbp,
+  // so it couldn't work in DDP for now. The If condition here could be removed when
+  // OFRecordImageClassificationDataReader had supported DDP (add attr nd_sbp)
+  // or been deprecated.
+  if (ctx->op_type_name() == "OFRecordReader") {
+    auto nd_sbp_str_vec = ctx->Attr<std::vector<std::string>>("nd_sbp");
+    // NOTE(zwx): OFRecordDataset is not consistent since attr nd_sbp is empty,
+    // we assume that it works in DDP
+    if (nd_sbp_str_vec.empty() && CHECK_JUST(IsMultiClient())) { is_local = true; }
+  }
+  if (is_local) {
+    *parallel_id = GlobalProcessCtx::Rank();
+    *parallel_num = GlobalProcessCtx::WorldSize();
+  } else {
+    *parallel_id = ctx->parallel_ctx().parallel_id();
+    *parallel_num = ctx->parallel_ctx().parallel_num();
+  }
+}
+
 class OFRecordDataset final : public Dataset<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
@@ -39,44 +80,24 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     shuffle_after_epoch_ = ctx->Attr<bool>("shuffle_after_epoch");
 
     // in stream
-    data_part_num_ = ctx->Attr<int32_t>("data_part_num");
-    std::string data_dir = ctx->Attr<std::string>("data_dir");
-    std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
-    int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
-
-    for (int i = 0; i < data_part_num_; ++i) {
-      std::string num = std::to_string(i);
-      int32_t zero_count =
-          std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
-      data_file_paths_.emplace_back(
-          JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
-    }
-
-    bool is_local = false;
-    // NOTE(zwx): OFRecordDataset is used by OFRecordDataReader and
-    // OFRecordImageClassificationDataReader both, the latter has no attr nd_sbp,
-    // so it couldn't work in DDP for now. The If condition here could be removed when
-    // OFRecordImageClassificationDataReader had supported DDP (add attr nd_sbp)
-    // or been deprecated.
-    if (ctx->op_type_name() == "OFRecordReader") {
-      auto nd_sbp_str_vec = ctx->Attr<std::vector<std::string>>("nd_sbp");
-      // NOTE(zwx): OFRecordDataset is not consistent since attr nd_sbp is empty,
-      // we assume that it works in DDP
-      if (nd_sbp_str_vec.empty() && CHECK_JUST(IsMultiClient())) { is_local = true; }
-    }
-    if (is_local) {
-      parallel_id_ = GlobalProcessCtx::Rank();
-      parallel_num_ = GlobalProcessCtx::WorldSize();
-    } else {
-      parallel_id_ = ctx->parallel_ctx().parallel_id();
-      parallel_num_ = ctx->parallel_ctx().parallel_num();
-    }
+    data_file_paths_ = GetOFRecordDataFilePaths(ctx);
+    data_part_num_ = data_file_paths_.size();
+    GetOFRecordParallelIdAndNum(ctx, &parallel_id_, &parallel_num_);
     CHECK_LE(parallel_num_, data_part_num_);
     BalancedSplitter bs(data_part_num_, parallel_num_);
     range_ = bs.At(parallel_id_);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(
-        new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, false));
+    use_mmap_ = ParseBooleanFromEnv("ONEFLOW_OFRECORD_READER_USE_MMAP", false) && IsLocalDataFS();
+    persist_mmap_index_ = false;
+    mapped_file_idx_ = 0;
+    mapped_record_idx_ = 0;
+    if (use_mmap_) {
+      persist_mmap_index_ = ParseBooleanFromEnv("ONEFLOW_OFRECORD_READER_PERSIST_INDEX", false);
+      MapLocalFiles();
+    } else {
+      std::vector<std::string> local_file_paths = GetLocalFilePaths();
+      in_stream_.reset(
+          new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, false));
+    }
   }
   ~OFRecordDataset() = default;
 
@@ -89,7 +110,16 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   }
 
  private:
+  static bool IsLocalDataFS() {
+#ifdef OF_PLATFORM_POSIX
+    return dynamic_cast<fs::PosixFileSystem*>(DataFS()) != nullptr;
+#else
+    return false;
+#endif
+  }
+
   void ReadSample(TensorBuffer& tensor) {
+    if (use_mmap_) { return ReadMappedSample(tensor); }
     int64_t OFRecord_size = -1;
     char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
     if (in_stream_->ReadFully(size_ptr, sizeof(int64_t)) != 0) {
@@ -101,13 +131,64 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
   }
 
+  // Points tensor into the mapping instead of copying the record, the view keeps the mapping
+  // alive until the record is parsed.
+  void ReadMappedSample(TensorBuffer& tensor) {
+    while (mapped_file_idx_ < mapped_files_.size()
+           && mapped_record_idx_ == mapped_files_.at(mapped_file_idx_)->num_records()) {
+      mapped_file_idx_ += 1;
+      mapped_record_idx_ = 0;
+    }
+    if (mapped_file_idx_ == mapped_files_.size()) {
+      if (shuffle_after_epoch_) {
+        ShuffleAfterEpoch();
+      } else {
+        mapped_file_idx_ = 0;
+        mapped_record_idx_ = 0;
+      }
+      CHECK(std::any_of(mapped_files_.begin(), mapped_files_.end(),
+                        [](const std::shared_ptr<OFRecordMappedFile>& file) {
+                          return file->num_records() > 0;
+                        }))
+          << "no OFRecord in data parts of this rank";
+      return ReadMappedSample(tensor);
+    }
+    const std::shared_ptr<OFRecordMappedFile>& file = mapped_files_.at(mapped_file_idx_);
+    file->WillNeed(mapped_record_idx_);
+    tensor.ResetView(file->Data(mapped_record_idx_),
+                     Shape({static_cast<int64_t>(file->Size(mapped_record_idx_))}),
+                     DataType::kChar, file);
+    mapped_record_idx_ += 1;
+  }
+
+  // Maps the parts of this rank in order, reusing the mappings of the previous epoch.
+  void MapLocalFiles() {
+    HashMap<std::string, std::shared_ptr<OFRecordMappedFile>> path2mapped_file;
+    for (auto& file : mapped_files_) { path2mapped_file.emplace(file->filename(), file); }
+    mapped_files_.clear();
+    for (const std::string& path : GetLocalFilePaths()) {
+      auto it = path2mapped_file.find(path);
+      if (it != path2mapped_file.end()) {
+        mapped_files_.emplace_back(it->second);
+      } else {
+        mapped_files_.emplace_back(std::make_shared<OFRecordMappedFile>(path, persist_mmap_index_));
+      }
+    }
+    mapped_file_idx_ = 0;
+    mapped_record_idx_ = 0;
+  }
+
   void ShuffleAfterEpoch() {
     CHECK(shuffle_after_epoch_);
     current_epoch_++;  // move to next epoch
     std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
     std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, false));
+    if (use_mmap_) {
+      MapLocalFiles();
+    } else {
+      std::vector<std::string> local_file_paths = GetLocalFilePaths();
+      in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, false));
+    }
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -127,6 +208,12 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   Range range_;
   std::vector<std::string> data_file_paths_;
   std::unique_ptr<PersistentInStream> in_stream_;
+
+  bool use_mmap_;
+  bool persist_mmap_index_;
+  std::vector<std::shared_ptr<OFRecordMappedFile>> mapped_files_;
+  size_t mapped_file_idx_;
+  size_t mapped_record_idx_;
 };
 
 }  // namespace data
@@ -96,6 +96,7 @@ void LoadWorker(BaseDataset* record_dataset,
   bool shutdown = false;
   while (!shutdown) {
     BaseLoadTargetPtrList records = record_dataset->Next();
+    record_dataset->Materialize(&records);
     for (const auto& record : records) {
       auto& current_in_buffer = decode_in_buffers->at(thread_idx);
       thread_idx = (thread_idx + 1) % decode_in_buffers->size();
@@ -0,0 +1,176 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/ofrecord_mapped_file.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr char kIndexMagicCode[] = "OFRIDX\x00\x00";
+constexpr size_t kIndexMagicCodeLen = sizeof(kIndexMagicCode) - 1;
+constexpr uint64_t kIndexVersion = 1;
+// bytes asked to be read ahead of the cursor by madvise(MADV_WILLNEED)
+constexpr size_t kReadAheadSize = 32 * 1024 * 1024;
+
+struct IndexHeader {
+  char magic_code[kIndexMagicCodeLen];
+  uint64_t version;
+  uint64_t file_size;
+  int64_t file_mtime_ns;
+  uint64_t num_records;
+};
+
+}  // namespace
+
+OFRecordMappedFile::OFRecordMappedFile(const std::string& filename, bool persist_index)
+    : filename_(filename),
+      mapped_(nullptr),
+      size_(0),
+      mtime_ns_(0),
+      advised_begin_(0),
+      advised_end_(0) {
+#ifdef __linux__
+  int fd = open(filename.c_str(), O_RDONLY);
+  CHECK(fd != -1) << "open " << filename << " failed: " << strerror(errno);
+  struct stat s;
+  CHECK(fstat(fd, &s) != -1) << "stat " << filename << " failed: " << strerror(errno);
+  size_ = s.st_size;
+  mtime_ns_ = static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000 + s.st_mtim.tv_nsec;
+  if (size_ > 0) {
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    CHECK(mapped != MAP_FAILED) << "mmap " << filename << " failed: " << strerror(errno);
+    mapped_ = static_cast<const char*>(mapped);
+    // records are consumed front to back, let the kernel read ahead aggressively
+    madvise(mapped, size_, MADV_SEQUENTIAL);
+  }
+  close(fd);
+#else
+  UNIMPLEMENTED() << "OFRecordMappedFile is only supported on linux";
+#endif
+  const std::string index_filename = IndexFilePath(filename);
+  if (!LoadIndex(index_filename)) {
+    BuildIndex();
+    if (persist_index) { SaveIndex(index_filename); }
+  }
+}
+
+OFRecordMappedFile::~OFRecordMappedFile() {
+#ifdef __linux__
+  if (mapped_ != nullptr) {
+    CHECK(munmap(const_cast<char*>(mapped_), size_) == 0) << "munmap failed";
+  }
+#endif
+}
+
+std::string OFRecordMappedFile::IndexFilePath(const std::string& filename) {
+  return filename + ".index";
+}
+
+void OFRecordMappedFile::WillNeed(size_t i) {
+#ifdef __linux__
+  const size_t offset = offsets_.at(i);
+  // the next epoch starts over below the advised window, which has to follow it there
+  if (offset >= advised_begin_
+      && (offset + kReadAheadSize / 2 < advised_end_ || advised_end_ >= size_)) {
+    return;
+  }
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t begin = offset / page_size * page_size;
+  const size_t end = std::min(offset + kReadAheadSize, size_);
+  madvise(const_cast<char*>(mapped_) + begin, end - begin, MADV_WILLNEED);
+  advised_begin_ = begin;
+  advised_end_ = end;
+#endif
+}
+
+bool OFRecordMappedFile::LoadIndex(const std::string& index_filename) {
+  std::ifstream stream(index_filename, std::ios::binary);
+  if (!stream.is_open()) { return false; }
+  IndexHeader header{};
+  stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!stream.good() || std::memcmp(header.magic_code, kIndexMagicCode, kIndexMagicCodeLen) != 0
+      || header.version != kIndexVersion || header.file_size != size_
+      || header.file_mtime_ns != mtime_ns_) {
+    LOG(WARNING) << "Ignoring stale OFRecord index file " << index_filename;
+    return false;
+  }
+  std::vector<size_t> offsets(header.num_records);
+  stream.read(reinterpret_cast<char*>(offsets.data()), sizeof(size_t) * offsets.size());
+  if (!stream.good()) {
+    LOG(WARNING) << "Ignoring truncated OFRecord index file " << index_filename;
+    return false;
+  }
+  offsets_ = std::move(offsets);
+  return true;
+}
+
+void OFRecordMappedFile::BuildIndex() {
+  offsets_.clear();
+  size_t offset = 0;
+  while (offset < size_) {
+    CHECK_LE(offset + sizeof(int64_t), size_) << "truncated OFRecord file " << filename_;
+    int64_t record_size = -1;
+    std::memcpy(&record_size, mapped_ + offset, sizeof(int64_t));
+    CHECK_GT(record_size, 0) << "bad OFRecord size at offset " << offset << " of " << filename_;
+    CHECK_LE(offset + sizeof(int64_t) + record_size, size_)
+        << "truncated OFRecord file " << filename_;
+    offsets_.emplace_back(offset);
+    offset += sizeof(int64_t) + record_size;
+  }
+}
+
+void OFRecordMappedFile::SaveIndex(const std::string& index_filename) const {
+  IndexHeader header{};
+  std::memcpy(header.magic_code, kIndexMagicCode, kIndexMagicCodeLen);
+  header.version = kIndexVersion;
+  header.file_size = size_;
+  header.file_mtime_ns = mtime_ns_;
+  header.num_records = offsets_.size();
+  // several ranks may index the same part, write aside and rename so readers never see a
+  // partial file
+  const std::string tmp_filename = index_filename + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      LOG(WARNING) << "Can not write OFRecord index file " << index_filename;
+      return;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(offsets_.data()), sizeof(size_t) * offsets_.size());
+    if (!stream.good()) {
+      LOG(WARNING) << "Can not write OFRecord index file " << index_filename;
+      std::remove(tmp_filename.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_filename.c_str(), index_filename.c_str()) != 0) {
+    LOG(WARNING) << "Can not write OFRecord index file " << index_filename;
+    std::remove(tmp_filename.c_str());
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
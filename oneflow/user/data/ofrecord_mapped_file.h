@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_MAPPED_FILE_H_
+#define ONEFLOW_USER_DATA_OFRECORD_MAPPED_FILE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace data {
+
+// A read only mapping of a local OFRecord part file plus the offsets of its records.
+// Record i is the Size(i) bytes at Data(i), which point straight into the page cache.
+class OFRecordMappedFile final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordMappedFile);
+  // Loads the offsets from the sidecar index file IndexFilePath(filename) when it matches the
+  // part file, otherwise scans the part file, and writes the sidecar if persist_index is set.
+  OFRecordMappedFile(const std::string& filename, bool persist_index);
+  ~OFRecordMappedFile();
+
+  static std::string IndexFilePath(const std::string& filename);
+
+  const std::string& filename() const { return filename_; }
+  size_t num_records() const { return offsets_.size(); }
+  const char* Data(size_t i) const { return mapped_ + offsets_.at(i) + sizeof(int64_t); }
+  size_t Size(size_t i) const {
+    const size_t end = i + 1 < offsets_.size() ? offsets_.at(i + 1) : size_;
+    return end - offsets_.at(i) - sizeof(int64_t);
+  }
+  // Hints the kernel to read ahead of the record about to be read.
+  void WillNeed(size_t i);
+  // The bytes the last read ahead hint covers.
+  size_t advised_begin() const { return advised_begin_; }
+  size_t advised_end() const { return advised_end_; }
+
+ private:
+  bool LoadIndex(const std::string& index_filename);
+  void BuildIndex();
+  void SaveIndex(const std::string& index_filename) const;
+
+  std::string filename_;
+  const char* mapped_;
+  size_t size_;
+  int64_t mtime_ns_;
+  std::vector<size_t> offsets_;
+  size_t advised_begin_;
+  size_t advised_end_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_MAPPED_FILE_H_
@@ -0,0 +1,132 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/user/data/ofrecord_mapped_file.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+std::vector<std::string> WriteOFRecordFile(const std::string& filename, size_t num_records) {
+  std::mt19937 gen(0);
+  std::vector<std::string> records;
+  std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+  for (size_t i = 0; i < num_records; ++i) {
+    std::string record(1 + gen() % 4096, '\0');
+    for (char& c : record) { c = static_cast<char>(gen()); }
+    const int64_t size = record.size();
+    stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    stream.write(record.data(), record.size());
+    records.emplace_back(std::move(record));
+  }
+  return records;
+}
+
+void CheckRecords(const OFRecordMappedFile& file, const std::vector<std::string>& records) {
+  ASSERT_EQ(file.num_records(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(std::string(file.Data(i), file.Size(i)), records.at(i));
+  }
+}
+
+}  // namespace
+
+TEST(OFRecordMappedFile, index) {
+  std::string filename = JoinPath(GetCwd(), "tmp_ofrecord_mapped_file_test");
+  const std::string index_filename = OFRecordMappedFile::IndexFilePath(filename);
+  std::remove(index_filename.c_str());
+  const std::vector<std::string> records = WriteOFRecordFile(filename, 1000);
+  {
+    OFRecordMappedFile file(filename, false);
+    CheckRecords(file, records);
+    ASSERT_FALSE(std::ifstream(index_filename).is_open());
+  }
+  {
+    OFRecordMappedFile file(filename, true);
+    CheckRecords(file, records);
+    ASSERT_TRUE(std::ifstream(index_filename).is_open());
+  }
+  {
+    // loaded from the sidecar index
+    OFRecordMappedFile file(filename, true);
+    CheckRecords(file, records);
+  }
+  {
+    // the sidecar no longer matches the part file
+    const std::vector<std::string> new_records = WriteOFRecordFile(filename, 10);
+    OFRecordMappedFile file(filename, false);
+    CheckRecords(file, new_records);
+  }
+  std::remove(index_filename.c_str());
+  std::remove(filename.c_str());
+}
+
+TEST(OFRecordMappedFile, empty_file) {
+  std::string filename = JoinPath(GetCwd(), "tmp_ofrecord_mapped_file_empty_test");
+  WriteOFRecordFile(filename, 0);
+  OFRecordMappedFile file(filename, false);
+  ASSERT_EQ(file.num_records(), 0);
+  std::remove(filename.c_str());
+}
+
+TEST(OFRecordMappedFile, will_need_wraps_around) {
+  std::string filename = JoinPath(GetCwd(), "tmp_ofrecord_mapped_file_will_need_test");
+  const std::vector<std::string> records = WriteOFRecordFile(filename, 1000);
+  {
+    OFRecordMappedFile file(filename, false);
+    file.WillNeed(900);
+    const size_t advised_begin = file.advised_begin();
+    ASSERT_GT(advised_begin, 0);
+    ASSERT_GT(file.advised_end(), advised_begin);
+    file.WillNeed(950);
+    ASSERT_EQ(file.advised_begin(), advised_begin);
+    // the next epoch starts over from the first record
+    file.WillNeed(0);
+    ASSERT_EQ(file.advised_begin(), 0);
+    ASSERT_GE(file.advised_end(), file.Size(0));
+    file.WillNeed(1);
+    ASSERT_EQ(file.advised_begin(), 0);
+    CheckRecords(file, records);
+  }
+  std::remove(filename.c_str());
+}
+
+TEST(OFRecordMappedFile, tensor_buffer_view) {
+  std::string filename = JoinPath(GetCwd(), "tmp_ofrecord_mapped_file_view_test");
+  const std::vector<std::string> records = WriteOFRecordFile(filename, 10);
+  TensorBuffer buffer;
+  {
+    auto file = std::make_shared<OFRecordMappedFile>(filename, false);
+    buffer.ResetView(file->Data(3), Shape({static_cast<int64_t>(file->Size(3))}), DataType::kChar,
+                     file);
+  }
+  // the view keeps the mapping alive
+  ASSERT_TRUE(buffer.is_view());
+  ASSERT_EQ(buffer.capacity(), 0);
+  ASSERT_EQ(std::string(buffer.data<char>(), buffer.elem_cnt()), records.at(3));
+  // resizing a view gives it a buffer of its own
+  buffer.Resize(Shape({16}), DataType::kChar);
+  ASSERT_FALSE(buffer.is_view());
+  buffer.mut_data<char>()[0] = 'a';
+  std::remove(filename.c_str());
+}
+
+}  // namespace data
+}  // namespace oneflow
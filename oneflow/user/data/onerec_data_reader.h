@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CUSTOMIZED_DATA_ONEREC_DATA_READER_H_
 
 #include "oneflow/user/data/data_reader.h"
+#include "oneflow/user/data/global_shuffle_dataset.h"
 #include "oneflow/user/data/onerec_dataset.h"
 #include "oneflow/user/data/onerec_parser.h"
 #include "oneflow/user/data/random_shuffle_dataset.h"
@@ -32,9 +33,12 @@ class OneRecDataReader final : public DataReader<TensorBuffer> {
   OneRecDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
     const int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
     const auto random_shuffle = ctx->Attr<bool>("random_shuffle");
-    parser_.reset(new OneRecParser());
+    const auto mode = ctx->Attr<std::string>("shuffle_mode");
+    const bool verify_example = ctx->Attr<bool>("verify_example");
+    // the global shuffle dataset verifies the examples on the load workers
+    const bool global_shuffle = random_shuffle && mode == "global";
+    parser_.reset(new OneRecParser(verify_example && !global_shuffle));
     if (random_shuffle) {
-      const auto mode = ctx->Attr<std::string>("shuffle_mode");
       if (mode == "batch") {
         loader_.reset(new OneRecDataset(ctx, batch_size));
         loader_.reset(new BatchRandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
@@ -42,13 +46,21 @@ class OneRecDataReader final : public DataReader<TensorBuffer> {
         loader_.reset(new OneRecDataset(ctx, 1));
         loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
         loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+      } else if (mode == "global") {
+        // all ranks have to draw the same permutation
+        int64_t seed = ctx->Attr<int64_t>("seed");
+        if (seed == -1) { seed = kOneflowDatasetSeed; }
+        loader_.reset(new GlobalShuffleDataset(
+            DataFS(), ctx->Attr<std::vector<std::string>>("files"), RecordFormat::kOneRec,
+            batch_size, seed, ctx->parallel_ctx().parallel_id(), ctx->parallel_ctx().parallel_num(),
+            verify_example));
       } else {
         UNIMPLEMENTED();
       }
     } else {
       loader_.reset(new OneRecDataset(ctx, batch_size));
     }
-    StartLoadThread();
+    StartLoadThreads(ctx);
   }
   ~OneRecDataReader() = default;
 
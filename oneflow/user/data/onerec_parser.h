@@ -29,16 +29,15 @@ class OneRecParser final : public Parser<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
-  OneRecParser() = default;
+  explicit OneRecParser(bool verify_example) : verify_example_(verify_example) {}
   ~OneRecParser() = default;
 
   void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
              user_op::KernelComputeContext* ctx) override {
     user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
-    const bool verify_example = ctx->Attr<bool>("verify_example");
     FOR_RANGE(int32_t, i, 0, batch_data->size()) {
       TensorBuffer* tensor = batch_data->at(i).get();
-      if (verify_example) {
+      if (verify_example_) {
         flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(tensor->data()),
                                        static_cast<size_t>(tensor->elem_cnt()));
         CHECK(onerec::example::VerifyExampleBuffer(verifier));
@@ -47,6 +46,9 @@ class OneRecParser final : public Parser<TensorBuffer> {
       out->Swap(tensor);
     }
   }
+
+ private:
+  bool verify_example_;
 };
 
 }  // namespace data
@@ -60,6 +60,8 @@ class RandomShuffleDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  void Materialize(LoadTargetPtrList* samples) override { loader_->Materialize(samples); }
+
  private:
   std::unique_ptr<Dataset<LoadTarget>> loader_;
   std::vector<LoadTargetPtr> sample_buffer_;
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/record_index.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/data/onerec_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// headers are read in chunks, so parts of small records are scanned sequentially instead of
+// with one read per record
+constexpr int64_t kIndexChunkSize = 1 << 20;
+
+int64_t HeaderSize(RecordFormat format) {
+  return format == RecordFormat::kOFRecord ? sizeof(int64_t) : kHeaderSize;
+}
+
+int64_t ParsePayloadSize(RecordFormat format, const char* header, const std::string& path) {
+  if (format == RecordFormat::kOFRecord) {
+    int64_t payload_size = -1;
+    std::memcpy(&payload_size, header, sizeof(int64_t));
+    CHECK_GT(payload_size, 0) << "bad OFRecord size in " << path;
+    return payload_size;
+  } else if (format == RecordFormat::kOneRec) {
+    OneRecFrameHeaderView header_view{};
+    std::memcpy(header_view.raw, header, kHeaderSize);
+    CHECK_EQ(header_view.header.magic, kMagicNumber) << "bad OneRec frame in " << path;
+    CHECK_EQ(header_view.header.reserved, kReservedNumber);
+    CHECK_GE(header_view.header.payload_size, 0);
+    CHECK_EQ(ByteSwap(header_view.header.digest),
+             XXH64(header_view.raw, kHeaderSizeWithoutDigest, 0));
+    return header_view.header.payload_size;
+  } else {
+    UNIMPLEMENTED();
+    return 0;
+  }
+}
+
+}  // namespace
+
+RecordIndex::RecordIndex(fs::FileSystem* fs, const std::vector<std::string>& part_paths,
+                         RecordFormat format)
+    : format_(format) {
+  CHECK_LE(part_paths.size(), std::numeric_limits<int32_t>::max());
+  std::vector<std::vector<RecordLocation>> part_locations(part_paths.size());
+  MultiThreadLoop(part_paths.size(), [&](size_t i) {
+    part_locations.at(i) = IndexPart(fs, part_paths.at(i), static_cast<int32_t>(i));
+  });
+  size_t num_records = 0;
+  for (const auto& locations : part_locations) { num_records += locations.size(); }
+  locations_.reserve(num_records);
+  for (const auto& locations : part_locations) {
+    locations_.insert(locations_.end(), locations.begin(), locations.end());
+  }
+}
+
+std::shared_ptr<const RecordIndex> RecordIndex::GetOrCreate(
+    fs::FileSystem* fs, const std::vector<std::string>& part_paths, RecordFormat format) {
+  static std::mutex mutex;
+  static HashMap<std::string, std::shared_ptr<const RecordIndex>> key2index;
+  std::string key = std::to_string(reinterpret_cast<uintptr_t>(fs)) + "/"
+                    + std::to_string(static_cast<int>(format));
+  for (const std::string& path : part_paths) {
+    key += "/" + path + ":" + std::to_string(fs->GetFileSize(path));
+  }
+  // indexing a part reads all of it, so readers of the same parts wait for the first one
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<const RecordIndex>& index = key2index[key];
+  if (!index) {
+    index.reset(new RecordIndex(fs, part_paths, format));
+    LOG(INFO) << "Indexed " << index->size() << " records in " << part_paths.size() << " parts";
+  }
+  return index;
+}
+
+int64_t RecordIndex::Extent(const RecordLocation& location) const {
+  if (format_ == RecordFormat::kOneRec) {
+    return RoundUp(location.size, kPayloadAlignmentSize) + kDigestFieldSize;
+  } else {
+    return location.size;
+  }
+}
+
+std::vector<RecordLocation> RecordIndex::IndexPart(fs::FileSystem* fs, const std::string& path,
+                                                   int32_t part_id) const {
+  std::unique_ptr<fs::RandomAccessFile> file;
+  fs->NewRandomAccessFile(path, &file);
+  const int64_t file_size = fs->GetFileSize(path);
+  const int64_t header_size = HeaderSize(format_);
+  std::vector<char> chunk;
+  int64_t chunk_offset = 0;
+  std::vector<RecordLocation> locations;
+  int64_t offset = 0;
+  while (offset < file_size) {
+    CHECK_LE(offset + header_size, file_size) << "truncated record file " << path;
+    if (offset + header_size > chunk_offset + static_cast<int64_t>(chunk.size())) {
+      chunk_offset = offset;
+      chunk.resize(std::min(kIndexChunkSize, file_size - offset));
+      file->Read(chunk_offset, chunk.size(), chunk.data());
+    }
+    const int64_t payload_size =
+        ParsePayloadSize(format_, chunk.data() + (offset - chunk_offset), path);
+    CHECK_LE(payload_size, std::numeric_limits<int32_t>::max());
+    RecordLocation location{};
+    location.offset = offset + header_size;
+    location.part_id = part_id;
+    location.size = static_cast<int32_t>(payload_size);
+    offset = location.offset + Extent(location);
+    CHECK_LE(offset, file_size) << "truncated record file " << path;
+    locations.emplace_back(location);
+  }
+  return locations;
+}
+
+}  // namespace data
+}  // namespace oneflow
@@ -0,0 +1,71 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_RECORD_INDEX_H_
+#define ONEFLOW_USER_DATA_RECORD_INDEX_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace data {
+
+enum class RecordFormat {
+  kOFRecord,
+  kOneRec,
+};
+
+// Where the payload of a record lives.
+struct RecordLocation {
+  int64_t offset;
+  int32_t part_id;
+  int32_t size;
+};
+
+// The location of every record in a list of OFRecord or OneRec part files.
+class RecordIndex final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RecordIndex);
+  // Reads the record headers of all parts, the parts are indexed in parallel.
+  RecordIndex(fs::FileSystem* fs, const std::vector<std::string>& part_paths, RecordFormat format);
+  ~RecordIndex() = default;
+
+  // Returns the index of the parts shared by all the readers of this process, e.g. the readers
+  // of a train and an eval graph, or a reader created again. An index is built again when the
+  // size of a part changed.
+  static std::shared_ptr<const RecordIndex> GetOrCreate(fs::FileSystem* fs,
+                                                        const std::vector<std::string>& part_paths,
+                                                        RecordFormat format);
+
+  RecordFormat format() const { return format_; }
+  size_t size() const { return locations_.size(); }
+  const RecordLocation& at(size_t i) const { return locations_.at(i); }
+
+  // Bytes from the payload offset a read of the record has to cover, OneRec frames end with the
+  // padding and the digest of the payload.
+  int64_t Extent(const RecordLocation& location) const;
+
+ private:
+  std::vector<RecordLocation> IndexPart(fs::FileSystem* fs, const std::string& path,
+                                        int32_t part_id) const;
+
+  RecordFormat format_;
+  std::vector<RecordLocation> locations_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_RECORD_INDEX_H_
@@ -14,9 +14,211 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
 
 namespace oneflow {
 
+namespace {
+
+template<typename T>
+struct LayerNormComputeType {
+  using type = T;
+};
+
+template<>
+struct LayerNormComputeType<float16> {
+  using type = float;
+};
+
+// Rows are reduced with this many independent accumulators, which the compiler keeps in the lanes
+// of one SIMD register. The lanes are merged once per row.
+constexpr int64_t kNumLanes = 8;
+
+// Roughly the elements a parallel task should process.
+constexpr int64_t kParallelGrainElemCnt = 32768;
+
+// layer_norm_param_grad reduces over rows in at most this many blocks of rows, every block
+// accumulates its own partial sums and the partial sums are added in block order, so the result
+// does not depend on the number of threads.
+constexpr int64_t kMaxParamGradNumBlocks = 64;
+
+int64_t ParallelGrainRows(int64_t cols) {
+  return std::max<int64_t>(kParallelGrainElemCnt / std::max<int64_t>(cols, 1), 1);
+}
+
+// One-pass Welford mean and biased variance of a row.
+template<typename T, typename ComputeType>
+void WelfordRow(const T* x, int64_t cols, ComputeType* mean, ComputeType* variance) {
+  ComputeType lane_mean[kNumLanes] = {};
+  ComputeType lane_m2[kNumLanes] = {};
+  const int64_t lane_cols = cols / kNumLanes * kNumLanes;
+  int64_t lane_count = 0;
+  for (int64_t j = 0; j < lane_cols; j += kNumLanes) {
+    lane_count += 1;
+    const ComputeType inv_count = static_cast<ComputeType>(1) / static_cast<ComputeType>(lane_count);
+    for (int64_t k = 0; k < kNumLanes; ++k) {
+      const ComputeType val = static_cast<ComputeType>(x[j + k]);
+      const ComputeType delta = val - lane_mean[k];
+      lane_mean[k] += delta * inv_count;
+      lane_m2[k] += delta * (val - lane_mean[k]);
+    }
+  }
+  ComputeType row_mean = 0;
+  ComputeType row_m2 = 0;
+  int64_t row_count = 0;
+  if (lane_count > 0) {
+    // Chan's formula for merging the statistics of two disjoint sets.
+    for (int64_t k = 0; k < kNumLanes; ++k) {
+      const int64_t count = row_count + lane_count;
+      const ComputeType delta = lane_mean[k] - row_mean;
+      const ComputeType lane_ratio =
+          static_cast<ComputeType>(lane_count) / static_cast<ComputeType>(count);
+      row_mean += delta * lane_ratio;
+      row_m2 += lane_m2[k] + delta * delta * static_cast<ComputeType>(row_count) * lane_ratio;
+      row_count = count;
+    }
+  }
+  for (int64_t j = lane_cols; j < cols; ++j) {
+    row_count += 1;
+    const ComputeType val = static_cast<ComputeType>(x[j]);
+    const ComputeType delta = val - row_mean;
+    row_mean += delta / static_cast<ComputeType>(row_count);
+    row_m2 += delta * (val - row_mean);
+  }
+  *mean = row_mean;
+  *variance = row_m2 / static_cast<ComputeType>(cols);
+}
+
+template<typename T, typename ComputeType, bool do_scale, bool do_center>
+void LayerNormForwardRows(int64_t begin, int64_t end, int64_t cols, ComputeType epsilon,
+                          const T* x, const T* gamma, const T* beta, T* normalized, T* y,
+                          ComputeType* mean, ComputeType* inv_variance) {
+  for (int64_t i = begin; i < end; ++i) {
+    const T* row_x = x + i * cols;
+    ComputeType row_mean = 0;
+    ComputeType row_variance = 0;
+    WelfordRow<T, ComputeType>(row_x, cols, &row_mean, &row_variance);
+    const ComputeType row_inv_variance =
+        static_cast<ComputeType>(1) / std::sqrt(row_variance + epsilon);
+    mean[i] = row_mean;
+    inv_variance[i] = row_inv_variance;
+    T* row_normalized = normalized + i * cols;
+    T* row_y = y + i * cols;
+    for (int64_t j = 0; j < cols; ++j) {
+      const ComputeType normalized_j =
+          (static_cast<ComputeType>(row_x[j]) - row_mean) * row_inv_variance;
+      if (do_scale) { row_normalized[j] = static_cast<T>(normalized_j); }
+      ComputeType y_j = normalized_j;
+      if (do_scale) { y_j *= static_cast<ComputeType>(gamma[j]); }
+      if (do_center) { y_j += static_cast<ComputeType>(beta[j]); }
+      row_y[j] = static_cast<T>(y_j);
+    }
+  }
+}
+
+template<typename T, typename ComputeType, bool do_add>
+void LayerNormBackwardRows(int64_t begin, int64_t end, int64_t cols, const T* x, const T* dy,
+                           const ComputeType* mean, const ComputeType* inv_variance,
+                           const T* add_to_output, T* dx) {
+  const ComputeType inv_cols = static_cast<ComputeType>(1) / static_cast<ComputeType>(cols);
+  for (int64_t i = begin; i < end; ++i) {
+    const T* row_x = x + i * cols;
+    const T* row_dy = dy + i * cols;
+    const ComputeType row_mean = mean[i];
+    const ComputeType row_inv_variance = inv_variance[i];
+    ComputeType lane_sum_dy[kNumLanes] = {};
+    ComputeType lane_sum_dy_normalized[kNumLanes] = {};
+    const int64_t lane_cols = cols / kNumLanes * kNumLanes;
+    for (int64_t j = 0; j < lane_cols; j += kNumLanes) {
+      for (int64_t k = 0; k < kNumLanes; ++k) {
+        const ComputeType dy_k = static_cast<ComputeType>(row_dy[j + k]);
+        const ComputeType normalized_k =
+            (static_cast<ComputeType>(row_x[j + k]) - row_mean) * row_inv_variance;
+        lane_sum_dy[k] += dy_k;
+        lane_sum_dy_normalized[k] += dy_k * normalized_k;
+      }
+    }
+    ComputeType sum_dy = 0;
+    ComputeType sum_dy_normalized = 0;
+    for (int64_t k = 0; k < kNumLanes; ++k) {
+      sum_dy += lane_sum_dy[k];
+      sum_dy_normalized += lane_sum_dy_normalized[k];
+    }
+    for (int64_t j = lane_cols; j < cols; ++j) {
+      const ComputeType dy_j = static_cast<ComputeType>(row_dy[j]);
+      sum_dy += dy_j;
+      sum_dy_normalized +=
+          dy_j * (static_cast<ComputeType>(row_x[j]) - row_mean) * row_inv_variance;
+    }
+    const ComputeType mean_dy = sum_dy * inv_cols;
+    const ComputeType mean_dy_normalized = sum_dy_normalized * inv_cols;
+    T* row_dx = dx + i * cols;
+    const T* row_add_to_output = do_add ? add_to_output + i * cols : nullptr;
+    for (int64_t j = 0; j < cols; ++j) {
+      const ComputeType normalized_j =
+          (static_cast<ComputeType>(row_x[j]) - row_mean) * row_inv_variance;
+      ComputeType dx_j = (static_cast<ComputeType>(row_dy[j]) - mean_dy
+                          - normalized_j * mean_dy_normalized)
+                         * row_inv_variance;
+      if (do_add) { dx_j += static_cast<ComputeType>(row_add_to_output[j]); }
+      row_dx[j] = static_cast<T>(dx_j);
+    }
+  }
+}
+
+int64_t GetParamGradNumBlocks(int64_t rows, int64_t cols) {
+  const int64_t num_blocks = rows * cols / kParallelGrainElemCnt;
+  return std::max<int64_t>(std::min(std::min(num_blocks, rows), kMaxParamGradNumBlocks), 1);
+}
+
+// Accumulates sum(dy) and sum(dy * normalized) of rows [begin, end) into the partial sums of one
+// block, and writes normalized_diff = dy * gamma of those rows in the same pass.
+template<typename T, typename ComputeType>
+void LayerNormParamGradRows(int64_t begin, int64_t end, int64_t cols, const T* dy,
+                            const T* normalized, const T* gamma, ComputeType* partial_beta_diff,
+                            ComputeType* partial_gamma_diff, T* normalized_diff) {
+  if (partial_beta_diff != nullptr) { std::fill_n(partial_beta_diff, cols, 0); }
+  if (partial_gamma_diff != nullptr) { std::fill_n(partial_gamma_diff, cols, 0); }
+  for (int64_t i = begin; i < end; ++i) {
+    const T* row_dy = dy + i * cols;
+    if (partial_beta_diff != nullptr) {
+      for (int64_t j = 0; j < cols; ++j) {
+        partial_beta_diff[j] += static_cast<ComputeType>(row_dy[j]);
+      }
+    }
+    if (partial_gamma_diff != nullptr) {
+      const T* row_normalized = normalized + i * cols;
+      for (int64_t j = 0; j < cols; ++j) {
+        partial_gamma_diff[j] +=
+            static_cast<ComputeType>(row_dy[j]) * static_cast<ComputeType>(row_normalized[j]);
+      }
+    }
+    if (normalized_diff != nullptr) {
+      T* row_normalized_diff = normalized_diff + i * cols;
+      if (gamma != nullptr) {
+        for (int64_t j = 0; j < cols; ++j) {
+          row_normalized_diff[j] = static_cast<T>(static_cast<ComputeType>(row_dy[j])
+                                                  * static_cast<ComputeType>(gamma[j]));
+        }
+      } else {
+        std::copy(row_dy, row_dy + cols, row_normalized_diff);
+      }
+    }
+  }
+}
+
+template<typename T, typename ComputeType>
+void SumPartials(int64_t begin_col, int64_t end_col, int64_t cols, int64_t num_blocks,
+                 const ComputeType* partials, T* sum) {
+  for (int64_t j = begin_col; j < end_col; ++j) {
+    ComputeType sum_j = 0;
+    for (int64_t b = 0; b < num_blocks; ++b) { sum_j += partials[b * cols + j]; }
+    sum[j] = static_cast<T>(sum_j);
+  }
+}
+
+}  // namespace
+
 template<typename T>
 class LayerNormCpuKernel final : public user_op::OpKernel {
  public:
@@ -24,8 +226,56 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
   ~LayerNormCpuKernel() = default;
 
  private:
+  using ComputeType = typename LayerNormComputeType<T>::type;
+
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* normalized =
+        ctx->has_input("gamma", 0) ? ctx->Tensor4ArgNameAndIndex("normalized", 0) : y;
+    const ComputeType epsilon = static_cast<ComputeType>(ctx->Attr<double>("epsilon"));
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    const T* gamma_ptr = nullptr;
+    const T* beta_ptr = nullptr;
+    if (ctx->has_input("gamma", 0)) {
+      const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+      gamma_ptr = gamma->dptr<T>();
+      CHECK_EQ(gamma->shape().elem_cnt(), norm_size);
+    }
+    if (ctx->has_input("beta", 0)) {
+      const user_op::Tensor* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+      beta_ptr = beta->dptr<T>();
+      CHECK_EQ(beta->shape().elem_cnt(), norm_size);
+    }
+    void (*forward_rows)(int64_t, int64_t, int64_t, ComputeType, const T*, const T*, const T*, T*,
+                         T*, ComputeType*, ComputeType*) = nullptr;
+    if (gamma_ptr != nullptr && beta_ptr != nullptr) {
+      forward_rows = LayerNormForwardRows<T, ComputeType, true, true>;
+    } else if (gamma_ptr != nullptr) {
+      forward_rows = LayerNormForwardRows<T, ComputeType, true, false>;
+    } else if (beta_ptr != nullptr) {
+      forward_rows = LayerNormForwardRows<T, ComputeType, false, true>;
+    } else {
+      forward_rows = LayerNormForwardRows<T, ComputeType, false, false>;
+    }
+    const T* x_ptr = x->dptr<T>();
+    T* normalized_ptr = normalized->mut_dptr<T>();
+    T* y_ptr = y->mut_dptr<T>();
+    ComputeType* mean_ptr = mean->mut_dptr<ComputeType>();
+    ComputeType* inv_variance_ptr = inv_variance->mut_dptr<ComputeType>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, num_instances,
+        [&](int64_t begin, int64_t end) {
+          forward_rows(begin, end, norm_size, epsilon, x_ptr, gamma_ptr, beta_ptr, normalized_ptr,
+                       y_ptr, mean_ptr, inv_variance_ptr);
+        },
+        ParallelGrainRows(norm_size));
+  };
 };
 
 #define REGISTER_LAYER_NORM_CPU_KERNEL(dtype)                         \
@@ -36,6 +286,7 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
 
 REGISTER_LAYER_NORM_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_CPU_KERNEL(double)
+REGISTER_LAYER_NORM_CPU_KERNEL(float16)
 
 template<typename T>
 class LayerNormGradCpuKernel final : public user_op::OpKernel {
@@ -44,18 +295,60 @@ class LayerNormGradCpuKernel final : public user_op::OpKernel {
   ~LayerNormGradCpuKernel() = default;
 
  private:
+  using ComputeType = typename LayerNormComputeType<T>::type;
+
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    const T* add_to_output_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), dx->data_type());
+      CHECK_EQ(add_to_output->shape(), dx->shape());
+      add_to_output_ptr = add_to_output->dptr<T>();
+    }
+    const auto backward_rows = add_to_output_ptr != nullptr
+                                   ? &LayerNormBackwardRows<T, ComputeType, true>
+                                   : &LayerNormBackwardRows<T, ComputeType, false>;
+    const T* x_ptr = x->dptr<T>();
+    const T* dy_ptr = dy->dptr<T>();
+    const ComputeType* mean_ptr = mean->dptr<ComputeType>();
+    const ComputeType* inv_variance_ptr = inv_variance->dptr<ComputeType>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, num_instances,
+        [&](int64_t begin, int64_t end) {
+          backward_rows(begin, end, norm_size, x_ptr, dy_ptr, mean_ptr, inv_variance_ptr,
+                        add_to_output_ptr, dx_ptr);
+        },
+        ParallelGrainRows(norm_size));
+  };
 };
 
-#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                    \
-  REGISTER_USER_KERNEL("layer_norm_grad")                             \
-      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                   \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                                         \
+  REGISTER_USER_KERNEL("layer_norm_grad")                                                  \
+      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                      \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))    \
+      .SetInplaceProposalFn(                                                               \
+          [](const user_op::InferContext& ctx,                                             \
+             const user_op::AddInplaceArgPair& AddInplaceArgPairFn) -> Maybe<void> {       \
+            if (ctx.has_input("_add_to_output", 0)) {                                      \
+              OF_RETURN_IF_ERROR(AddInplaceArgPairFn("dx", 0, "_add_to_output", 0, true)); \
+            }                                                                              \
+            return Maybe<void>::Ok();                                                      \
+          });
 
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(double)
+REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(float16)
 
 template<typename T>
 class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
@@ -64,17 +357,104 @@ class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
   ~LayerNormParamGradCpuKernel() = default;
 
  private:
+  using ComputeType = typename LayerNormComputeType<T>::type;
+
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    user_op::Tensor* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    user_op::Tensor* normalized_diff = ctx->Tensor4ArgNameAndIndex("normalized_diff", 0);
+    const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const int64_t begin_params_axis = ctx->Attr<int64_t>("begin_params_axis");
+    const int64_t m = dy->shape().Count(begin_params_axis);
+    if (m == 0) { return; }
+    CHECK_EQ(dy->shape().elem_cnt() % m, 0);
+    const int64_t n = dy->shape().elem_cnt() / m;
+    const T* dy_ptr = dy->dptr<T>();
+    const T* normalized_ptr = nullptr;
+    const T* gamma_ptr = nullptr;
+    ComputeType* partial_beta_diff = nullptr;
+    ComputeType* partial_gamma_diff = nullptr;
+    T* normalized_diff_ptr = nullptr;
+    const int64_t num_blocks = GetParamGradNumBlocks(n, m);
+    if (beta_diff != nullptr || gamma_diff != nullptr) {
+      user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+      ComputeType* partials = tmp_buffer->mut_dptr<ComputeType>();
+      if (beta_diff != nullptr) {
+        CHECK_EQ(beta_diff->shape().elem_cnt(), m);
+        partial_beta_diff = partials;
+        partials += num_blocks * m;
+      }
+      if (gamma_diff != nullptr) {
+        CHECK_EQ(gamma_diff->shape().elem_cnt(), m);
+        normalized_ptr = ctx->Tensor4ArgNameAndIndex("normalized", 0)->dptr<T>();
+        partial_gamma_diff = partials;
+      }
+    }
+    if (normalized_diff != nullptr) {
+      normalized_diff_ptr = normalized_diff->mut_dptr<T>();
+      if (gamma != nullptr) {
+        CHECK_EQ(gamma->shape().elem_cnt(), m);
+        gamma_ptr = gamma->dptr<T>();
+      }
+    }
+    ep::CpuStream* cpu_stream = ctx->stream()->As<ep::CpuStream>();
+    cpu_stream->ParallelFor(
+        0, num_blocks,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t b = begin; b < end; ++b) {
+            LayerNormParamGradRows<T, ComputeType>(
+                b * n / num_blocks, (b + 1) * n / num_blocks, m, dy_ptr, normalized_ptr,
+                gamma_ptr, partial_beta_diff == nullptr ? nullptr : partial_beta_diff + b * m,
+                partial_gamma_diff == nullptr ? nullptr : partial_gamma_diff + b * m,
+                normalized_diff_ptr);
+          }
+        },
+        1);
+    const int64_t grain_cols = ParallelGrainRows(num_blocks);
+    if (beta_diff != nullptr) {
+      T* beta_diff_ptr = beta_diff->mut_dptr<T>();
+      cpu_stream->ParallelFor(
+          0, m,
+          [&](int64_t begin, int64_t end) {
+            SumPartials<T, ComputeType>(begin, end, m, num_blocks, partial_beta_diff,
+                                        beta_diff_ptr);
+          },
+          grain_cols);
+    }
+    if (gamma_diff != nullptr) {
+      T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+      cpu_stream->ParallelFor(
+          0, m,
+          [&](int64_t begin, int64_t end) {
+            SumPartials<T, ComputeType>(begin, end, m, num_blocks, partial_gamma_diff,
+                                        gamma_diff_ptr);
+          },
+          grain_cols);
+    }
+  };
 };
 
-#define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)              \
-  REGISTER_USER_KERNEL("layer_norm_param_grad")                       \
-      .SetCreateFn<LayerNormParamGradCpuKernel<dtype>>()              \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("layer_norm_param_grad")                                                 \
+      .SetCreateFn<LayerNormParamGradCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                           \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))         \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                             \
+        const int64_t num_partials =                                                            \
+            ctx->has_output("beta_diff", 0) + ctx->has_output("gamma_diff", 0);                 \
+        if (num_partials == 0) { return 0; }                                                    \
+        const Shape& dy_shape = ctx->InputTensorDesc("dy", 0).shape();                          \
+        const int64_t m = dy_shape.Count(ctx->Attr<int64_t>("begin_params_axis"));              \
+        if (m == 0) { return 0; }                                                               \
+        const int64_t n = dy_shape.elem_cnt() / m;                                              \
+        return num_partials * GetParamGradNumBlocks(n, m) * m                                   \
+               * sizeof(typename LayerNormComputeType<dtype>::type);                            \
+      });
 
 REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(double)
+REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(float16)
 
 }  // namespace oneflow
@@ -44,7 +44,7 @@ class ConsistentTensorInferResult;
 
 using ArgVec = std::vector<std::pair<std::string, int32_t>>;
 
-using EagerBlobObjectListRawPtr = const std::vector<std::shared_ptr<vm::EagerBlobObject>>*;
+using EagerBlobObjectListRawPtr = const EagerBlobObjectList*;
 using ConsistentTensorInferResultRawPtr = const ConsistentTensorInferResult*;
 
 class EagerBlobObjectTensorView final : public user_op::Tensor {
@@ -410,6 +410,10 @@ class StatefulLocalOpKernel final {
     return op_infer_ctx_for_scheduler_thread_.get();
   }
 
+  // Held while an instruction is built with this kernel, because need_check_mem_case and the
+  // kernel chosen by ChooseOpKernel are shared by all the threads interpreting the op.
+  std::mutex* mut_main_thread_mutex() const { return &main_thread_mutex_; }
+
   void set_need_check_mem_case(bool value) { need_check_mem_case_ = value; }
 
   Maybe<void> ChooseOpKernel(const user_op::OpKernel** user_opkernel, bool* need_temp_storage,
@@ -454,6 +458,7 @@ class StatefulLocalOpKernel final {
   std::shared_ptr<const ArgTuple> input_arg_tuple_;
   std::shared_ptr<const ArgTuple> output_arg_tuple_;
   bool need_check_mem_case_;
+  mutable std::mutex main_thread_mutex_;
   user_op::TensorDescInferFn tensor_desc_infer_fn_;
   user_op::DataTypeInferFn data_type_infer_fn_;
   // NOTE: every device has its own stateful local opkernel instance,
@@ -14,4 +14,5 @@ See the License for the specific language governing permissions and
 limitations under the License.
 """
 from oneflow.framework.config_util import api_enable_fusion as enable_fusion
+from . import cpu
 from . import nccl
@@ -0,0 +1,20 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from oneflow.framework.config_util import (
+    api_cpu_enable_collective_boxing as enable_collective_boxing,
+    api_cpu_fusion_threshold_mb as set_fusion_threshold_mbytes,
+    api_cpu_fusion_max_ops as set_fusion_max_ops_num,
+)
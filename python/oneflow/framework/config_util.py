@@ -551,6 +551,55 @@ def nccl_enable_mixed_fusion(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_enable_mixed_fusion = val
 
 
+def api_cpu_enable_collective_boxing(val: bool) -> None:
+    """Whether or not use collective boxing for cpu placements. Defaults to False, which
+    boxes cpu tensors with the slice boxing task graphs.
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([cpu_enable_collective_boxing, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_enable_collective_boxing(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.collective_boxing_conf.cpu_enable_collective_boxing = val
+
+
+def api_cpu_fusion_threshold_mb(val: int) -> None:
+    """Set up threshold for cpu collective boxing fusion
+
+    Args:
+        val (int): int number, e.g. 10(mb)
+    """
+    return enable_if.unique([cpu_fusion_threshold_mb, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_fusion_threshold_mb(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.cpu_fusion_threshold_mb = val
+
+
+def api_cpu_fusion_max_ops(val: int) -> None:
+    """Maximum number of ops for cpu collective boxing fusion.
+
+    Args:
+        val (int): Maximum number of ops
+    """
+    return enable_if.unique([cpu_fusion_max_ops, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_fusion_max_ops(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.cpu_fusion_max_ops = val
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
@@ -19,7 +19,7 @@ from oneflow.framework.docstr.utils import add_docstr
 add_docstr(
     oneflow.read_onerec,
     r"""
-    read_onerec(files:List[str], batch_size:int, random_shuffle:bool, shuffle_mode:str, shuffle_buffer_size=1024, shuffle_after_epoch=False, verify_example=True, placement=None, sbp=None) -> Tensor 
+    read_onerec(files:List[str], batch_size:int, random_shuffle:bool, shuffle_mode:str, shuffle_buffer_size=1024, shuffle_after_epoch=False, verify_example=True, num_load_workers=1, prefetch_buffer_size=4, placement=None, sbp=None) -> Tensor 
     
     Read OneRec format dataset into a Tensor which then can be decode by decode_onerec API.
 
@@ -27,10 +27,12 @@ add_docstr(
         files: (List[str]): The file list to be read from filesystem       
         batch_size(int): batch size
         random_shuffle(bool): shuffle or not
-        shuffle_mode(str): can be "batch" or "instance"
+        shuffle_mode(str): can be "batch", "instance" or "global", "global" shuffles the records of all files
         shuffle_buffer_size(int): shuffle buffer size, default to 1024
         shuffle_after_epoch(bool): if shuffle after each epoch
         verify_example(bool): if verify example, defaults to True
+        num_load_workers(int): number of threads loading batches, defaults to 1
+        prefetch_buffer_size(int): number of batches loaded ahead, defaults to 4
         placement(Optional[oneflow._oneflow_internal.placement]): The placement attribute allows you to specify which physical device the tensor is stored on.
         sbp(Optional[Union[oneflow._oneflow_internal.sbp.sbp, List[oneflow._oneflow_internal.sbp.sbp]]]): When creating a consistent tensor, specify the SBP of the tensor.
     
@@ -0,0 +1,34 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from contextlib import contextmanager
+
+import oneflow._oneflow_internal
+
+
+@contextmanager
+def eager_trace(name):
+    """Traces the eager local ops called in the block under `name`, so that entering the
+    same trace again replays them without inferring devices and shapes again.
+
+    The trace is always ended, an exception in the block aborts it.
+    """
+    oneflow._oneflow_internal.eager_trace.begin(name)
+    try:
+        yield
+    except BaseException:
+        oneflow._oneflow_internal.eager_trace.abort()
+        raise
+    oneflow._oneflow_internal.eager_trace.end()
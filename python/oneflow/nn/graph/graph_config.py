@@ -88,6 +88,20 @@ class GraphConfig(object):
         """
         self.proto.set_enable_fuse_cast_scale(mode)
 
+    def enable_auto_parallel(self, mode: bool = True, dry_run: bool = False):
+        """If true, search the SBP signatures of unconstrained ops with a cost model of compute and boxing,
+        instead of choosing them greedily op by op. Ops with a user-specified SBP are kept as they are.
+
+        Args:
+            mode (bool, optional): enable the search. Default is True.
+            dry_run (bool, optional): only dump the predicted costs and the signatures the search would
+                change to the log directory, keep the greedy signatures. Default is False.
+        """
+        assert type(mode) is bool
+        assert type(dry_run) is bool
+        self.proto.set_enable_auto_parallel(mode)
+        self.proto.set_auto_parallel_dry_run(dry_run)
+
     def set_gradient_accumulation_steps(self, value):
         """Set num of steps to accumulate gradient.
 
@@ -53,6 +53,9 @@ class OFRecordReader(Module):
         placement: flow.placement = None,
         sbp: Union[flow.sbp.sbp, List[flow.sbp.sbp]] = None,
         name: Optional[str] = None,
+        num_load_workers: int = 1,
+        prefetch_buffer_size: int = 4,
+        shuffle_mode: str = "instance",
     ):
         super().__init__()
 
@@ -66,6 +69,9 @@ class OFRecordReader(Module):
         self.random_shuffle = random_shuffle
         self.shuffle_buffer_size = shuffle_buffer_size
         self.shuffle_after_epoch = shuffle_after_epoch
+        self.num_load_workers = num_load_workers
+        self.prefetch_buffer_size = prefetch_buffer_size
+        self.shuffle_mode = shuffle_mode
 
         self.placement = placement
         if placement is None:
@@ -100,8 +106,11 @@ class OFRecordReader(Module):
                 batch_size=self.batch_size,
                 shuffle_buffer_size=self.shuffle_buffer_size,
                 random_shuffle=self.random_shuffle,
+                shuffle_mode=self.shuffle_mode,
                 shuffle_after_epoch=self.shuffle_after_epoch,
                 seed=self.seed,
+                num_load_workers=self.num_load_workers,
+                prefetch_buffer_size=self.prefetch_buffer_size,
                 sbp=self.sbp,
                 placement=self.placement,
             )
@@ -115,8 +124,11 @@ class OFRecordReader(Module):
                 batch_size=self.batch_size,
                 shuffle_buffer_size=self.shuffle_buffer_size,
                 random_shuffle=self.random_shuffle,
+                shuffle_mode=self.shuffle_mode,
                 shuffle_after_epoch=self.shuffle_after_epoch,
                 seed=self.seed,
+                num_load_workers=self.num_load_workers,
+                prefetch_buffer_size=self.prefetch_buffer_size,
                 device=self.device,
             )
         return res
@@ -801,6 +813,8 @@ class COCOReader(Module):
         device: Union[flow.device, str] = None,
         placement: flow.placement = None,
         sbp: Union[flow.sbp.sbp, List[flow.sbp.sbp]] = None,
+        num_load_workers: int = 1,
+        prefetch_buffer_size: int = 4,
     ):
         super().__init__()
         self.annotation_file = annotation_file
@@ -810,6 +824,8 @@ class COCOReader(Module):
         self.group_by_aspect_ratio = group_by_aspect_ratio
         self.remove_images_without_annotations = remove_images_without_annotations
         self.stride_partition = stride_partition
+        self.num_load_workers = num_load_workers
+        self.prefetch_buffer_size = prefetch_buffer_size
         if random_seed is None:
             random_seed = random.randrange(sys.maxsize)
         self.random_seed = random_seed
@@ -864,6 +880,8 @@ class COCOReader(Module):
                 group_by_ratio=self.group_by_aspect_ratio,
                 remove_images_without_annotations=self.remove_images_without_annotations,
                 stride_partition=self.stride_partition,
+                num_load_workers=self.num_load_workers,
+                prefetch_buffer_size=self.prefetch_buffer_size,
                 device=self.device,
             )
         else:
@@ -879,6 +897,8 @@ class COCOReader(Module):
                 group_by_ratio=self.group_by_aspect_ratio,
                 remove_images_without_annotations=self.remove_images_without_annotations,
                 stride_partition=self.stride_partition,
+                num_load_workers=self.num_load_workers,
+                prefetch_buffer_size=self.prefetch_buffer_size,
                 placement=self.placement,
                 sbp=self.sbp,
             )
@@ -0,0 +1,134 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _sbp_signatures(graph):
+    job = graph._full_graph_proto
+    name2signature = job.job_parallel_view_conf.op_name2nd_sbp_signature_conf
+    return [
+        str(name2signature[op.name]) for op in job.net.op if op.name in name2signature
+    ]
+
+
+def _test_graph_auto_parallel(test_case, device, x_sbp, dry_run):
+    PT = flow.placement(device, {0: [0, 1]})
+    B = flow.sbp.broadcast
+
+    class MLP(flow.nn.Module):
+        def __init__(self):
+            super().__init__()
+            self.linear1 = flow.nn.Linear(64, 256)
+            self.linear2 = flow.nn.Linear(256, 32)
+            flow.nn.init.constant_(self.linear1.weight, 0.023)
+            flow.nn.init.constant_(self.linear2.weight, 0.17)
+            flow.nn.init.constant_(self.linear1.bias, 0.01)
+            flow.nn.init.constant_(self.linear2.bias, 0.01)
+
+        def forward(self, x):
+            out = self.linear1(x)
+            out = flow.relu(out)
+            out = self.linear2(out)
+            return out.sum()
+
+    class MLPGraph(flow.nn.Graph):
+        def __init__(self, m, auto_parallel):
+            super().__init__()
+            self.m = m
+            self.add_optimizer(flow.optim.SGD(self.m.parameters(), lr=0.01))
+            if auto_parallel:
+                self.config.enable_auto_parallel(True, dry_run=dry_run)
+
+        def build(self, x):
+            loss = self.m(x)
+            loss.backward()
+            return loss
+
+    def Params(m):
+        return [p.to_consistent(sbp=B).to_local().numpy() for p in m.parameters()]
+
+    ref_m = MLP().to_consistent(PT, B)
+    auto_m = MLP().to_consistent(PT, B)
+    init_params = Params(auto_m)
+    ref_g = MLPGraph(ref_m, False)
+    auto_g = MLPGraph(auto_m, True)
+    np_x = np.random.uniform(-1, 1, (16, 64)).astype(np.float32)
+    x = flow.tensor(np_x).to_consistent(PT, x_sbp)
+    for i in range(3):
+        ref_loss = ref_g(x).to_consistent(sbp=B).to_local().numpy()
+        auto_loss = auto_g(x).to_consistent(sbp=B).to_local().numpy()
+        test_case.assertTrue(np.allclose(ref_loss, auto_loss, 1e-3, 1e-3))
+    # the update ops must write the variables themselves, not a boxed copy of them
+    for init, ref, auto in zip(init_params, Params(ref_m), Params(auto_m)):
+        test_case.assertFalse(np.allclose(init, auto))
+        test_case.assertTrue(np.allclose(ref, auto, 1e-3, 1e-3))
+    if dry_run:
+        # nothing is applied, so every op keeps the signature the greedy inference chose
+        ref_signatures = _sbp_signatures(ref_g)
+        test_case.assertTrue(len(ref_signatures) > 0)
+        test_case.assertEqual(_sbp_signatures(auto_g), ref_signatures)
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphAutoParallel(oneflow.unittest.TestCase):
+    def test_auto_parallel_split_input_cpu(test_case):
+        _test_graph_auto_parallel(test_case, "cpu", flow.sbp.split(0), False)
+
+    def test_auto_parallel_broadcast_input_cpu(test_case):
+        _test_graph_auto_parallel(test_case, "cpu", flow.sbp.broadcast, False)
+
+    def test_auto_parallel_dry_run_cpu(test_case):
+        # the report goes to the log dir, so the graphs are compiled in child processes
+        # that log to a fresh one
+        with tempfile.TemporaryDirectory() as log_dir:
+            env = dict(os.environ)
+            env["GLOG_log_dir"] = log_dir
+            if "MASTER_PORT" in env:
+                env["MASTER_PORT"] = str(int(env["MASTER_PORT"]) + 1)
+            proc = subprocess.run(
+                [sys.executable, os.path.abspath(__file__), "dry_run"],
+                env=env,
+                timeout=300,
+            )
+            test_case.assertEqual(proc.returncode, 0)
+            reports = glob.glob(os.path.join(log_dir, "*", "auto_parallel_*"))
+            test_case.assertEqual(len(reports), 1, reports)
+            with open(reports[0]) as f:
+                test_case.assertTrue(f.readline().startswith("predicted_cost"))
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_auto_parallel_split_input_gpu(test_case):
+        _test_graph_auto_parallel(test_case, "cuda", flow.sbp.split(0), False)
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_auto_parallel_broadcast_input_gpu(test_case):
+        _test_graph_auto_parallel(test_case, "cuda", flow.sbp.broadcast, False)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 2 and sys.argv[1] == "dry_run":
+        _test_graph_auto_parallel(unittest.TestCase(), "cpu", flow.sbp.split(0), True)
+    else:
+        unittest.main()
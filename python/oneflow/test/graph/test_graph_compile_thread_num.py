@@ -0,0 +1,137 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+import oneflow as flow
+import oneflow.unittest
+
+# Task nodes are built level by level on ONEFLOW_LAZY_COMPILE_THREAD_NUM threads. The
+# plan must not depend on that, so the same train graph is compiled in child processes
+# with 1 and with several threads, and the plans they dump in debug mode are compared.
+# The 1n2d case splits the parameters over 2 ranks, so that boxing task nodes, which
+# name their ops while being built, are part of the plan.
+_THREAD_NUMS = [1, 8]
+
+
+class _BranchyModule(flow.nn.Module):
+    def __init__(self):
+        super().__init__()
+        # parallel branches give the task graph wide levels
+        self.branches = flow.nn.ModuleList([flow.nn.Linear(16, 16) for _ in range(6)])
+        self.head = flow.nn.Linear(16, 4)
+
+    def forward(self, x):
+        y = sum(flow.relu(branch(x)) for branch in self.branches)
+        return self.head(y).sum()
+
+
+class _BoxingModule(flow.nn.Module):
+    def __init__(self, placement):
+        super().__init__()
+        # column then row parallel, the output of row is partial sum
+        self.col = flow.nn.Linear(16, 16).to_global(placement, flow.sbp.split(0))
+        self.row = flow.nn.Linear(16, 16, bias=False).to_global(
+            placement, flow.sbp.split(1)
+        )
+        self.head = flow.nn.Linear(16, 4).to_global(placement, flow.sbp.broadcast)
+
+    def forward(self, x):
+        y = self.row(flow.relu(self.col(x)))
+        y = y.to_global(sbp=flow.sbp.broadcast)
+        return self.head(flow.relu(y)).sum()
+
+
+def _compile(kind):
+    if kind == "boxing":
+        placement = flow.placement("cpu", ranks=[0, 1])
+        model = _BoxingModule(placement)
+        x = flow.ones(8, 16, placement=placement, sbp=flow.sbp.broadcast)
+    else:
+        model = _BranchyModule()
+        x = flow.ones(8, 16)
+    sgd = flow.optim.SGD(model.parameters(), lr=0.01, momentum=0.9)
+
+    class TrainGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.model = model
+            self.add_optimizer(sgd)
+
+        def build(self, x):
+            loss = self.model(x)
+            loss.backward()
+            return loss
+
+    TrainGraph()(x)
+
+
+def _test_plan_does_not_depend_on_thread_num(test_case, kind):
+    # only the master compiles and dumps the plan
+    is_master = flow.env.get_rank() == 0
+    with tempfile.TemporaryDirectory() as log_root:
+        plans = []
+        for idx, thread_num in enumerate(_THREAD_NUMS):
+            log_dir = os.path.join(log_root, str(thread_num))
+            env = dict(os.environ)
+            env["ONEFLOW_LAZY_COMPILE_THREAD_NUM"] = str(thread_num)
+            env["ONEFLOW_DEBUG_MODE"] = "1"
+            env["GLOG_log_dir"] = log_dir
+            env.pop("ONEFLOW_PLAN_CACHE_DIR", None)
+            if "MASTER_PORT" in env:
+                env["MASTER_PORT"] = str(int(env["MASTER_PORT"]) + 1 + idx)
+            proc = subprocess.run(
+                [sys.executable, os.path.abspath(__file__), "compile", kind],
+                env=env,
+                timeout=300,
+            )
+            test_case.assertEqual(proc.returncode, 0, thread_num)
+            if not is_master:
+                continue
+            plan_files = glob.glob(os.path.join(log_dir, "*", "job_*_plan"))
+            test_case.assertEqual(len(plan_files), 1, plan_files)
+            with open(plan_files[0], "rb") as f:
+                plans.append(f.read())
+        if not is_master:
+            return
+        test_case.assertTrue(len(plans[0]) > 0)
+        if kind == "boxing":
+            test_case.assertTrue(b"System-Boxing-" in plans[0])
+        for thread_num, plan in zip(_THREAD_NUMS[1:], plans[1:]):
+            test_case.assertTrue(plan == plans[0], thread_num)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestGraphCompileThreadNum(oneflow.unittest.TestCase):
+    def test_plan_does_not_depend_on_thread_num(test_case):
+        _test_plan_does_not_depend_on_thread_num(test_case, "branchy")
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphCompileThreadNumWithBoxing(oneflow.unittest.TestCase):
+    def test_plan_with_boxing_does_not_depend_on_thread_num(test_case):
+        _test_plan_does_not_depend_on_thread_num(test_case, "boxing")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "compile":
+        _compile(sys.argv[2])
+    else:
+        unittest.main()
@@ -0,0 +1,136 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+# The boxing config is read when the session starts, so every case runs in a child
+# process. The children of the two ranks meet on a port of their own.
+_CASES = {
+    "slice_boxing": dict(collective=False, fusion=False),
+    "collective": dict(collective=True, fusion=False),
+    "collective_fusion": dict(
+        collective=True, fusion=True, threshold_mb=16, max_ops=64
+    ),
+    "collective_small_fusion": dict(
+        collective=True, fusion=True, threshold_mb=1, max_ops=2
+    ),
+}
+
+_P_SHAPES = [(4, 6), (8, 5), (6, 3)]
+_S0_SHAPE = (6, 3)
+
+
+def _local_data(rank, shape, seed):
+    return np.random.RandomState(seed * 10 + rank).rand(*shape).astype(np.float32)
+
+
+def _run_case(case_name, out_file):
+    conf = _CASES[case_name]
+    flow.boxing.cpu.enable_collective_boxing(conf["collective"])
+    flow.boxing.enable_fusion(conf["fusion"])
+    if conf["fusion"]:
+        flow.boxing.cpu.set_fusion_threshold_mbytes(conf["threshold_mb"])
+        flow.boxing.cpu.set_fusion_max_ops_num(conf["max_ops"])
+    rank = flow.env.get_rank()
+    placement = flow.placement("cpu", {0: [0, 1]})
+    p_inputs = [
+        flow.tensor(_local_data(rank, shape, seed)).to_consistent(
+            placement=placement, sbp=flow.sbp.partial_sum
+        )
+        for seed, shape in enumerate(_P_SHAPES)
+    ]
+    s0_input = flow.tensor(
+        _local_data(rank, (_S0_SHAPE[0] // 2, _S0_SHAPE[1]), len(_P_SHAPES))
+    ).to_consistent(placement=placement, sbp=flow.sbp.split(0))
+
+    class BoxingGraph(flow.nn.Graph):
+        def build(self, p0, p1, p2, s0):
+            # several all-reduces in a row, so that the fusion has something to group
+            return (
+                p0.to_consistent(sbp=flow.sbp.broadcast),
+                p1.to_consistent(sbp=flow.sbp.broadcast),
+                p2.to_consistent(sbp=flow.sbp.split(0)),
+                s0.to_consistent(sbp=flow.sbp.broadcast),
+            )
+
+    outputs = BoxingGraph()(*p_inputs, s0_input)
+    np.savez(out_file, *[output.to_local().numpy() for output in outputs])
+
+
+def _expected_outputs(rank):
+    sums = [
+        _local_data(0, shape, seed) + _local_data(1, shape, seed)
+        for seed, shape in enumerate(_P_SHAPES)
+    ]
+    half = _P_SHAPES[2][0] // 2
+    gathered = np.concatenate(
+        [
+            _local_data(r, (_S0_SHAPE[0] // 2, _S0_SHAPE[1]), len(_P_SHAPES))
+            for r in range(2)
+        ]
+    )
+    return [sums[0], sums[1], sums[2][rank * half : (rank + 1) * half], gathered]
+
+
+@unittest.skipIf(
+    sys.platform != "linux", "cpu collective boxing uses linux shared memory"
+)
+@flow.unittest.skip_unless_1n2d()
+class TestGraphCpuCollectiveBoxing(oneflow.unittest.TestCase):
+    def test_cpu_collective_boxing(test_case):
+        rank = flow.env.get_rank()
+        with tempfile.TemporaryDirectory() as out_dir:
+            results = {}
+            for case_idx, case_name in enumerate(sorted(_CASES)):
+                env = dict(os.environ)
+                port = int(os.environ["MASTER_PORT"]) + 1 + case_idx
+                env["MASTER_PORT"] = str(port)
+                out_file = os.path.join(out_dir, case_name + ".npz")
+                proc = subprocess.run(
+                    [sys.executable, os.path.abspath(__file__), case_name, out_file],
+                    env=env,
+                    timeout=300,
+                )
+                test_case.assertEqual(proc.returncode, 0, case_name)
+                with np.load(out_file) as outputs:
+                    results[case_name] = [outputs[k] for k in sorted(outputs.files)]
+            expected = _expected_outputs(rank)
+            for case_name, outputs in results.items():
+                test_case.assertEqual(len(outputs), len(expected))
+                for output, ref, slice_output in zip(
+                    outputs, expected, results["slice_boxing"]
+                ):
+                    test_case.assertTrue(
+                        np.allclose(output, ref, 1e-5, 1e-5), case_name
+                    )
+                    test_case.assertTrue(
+                        np.array_equal(output, slice_output), case_name
+                    )
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] in _CASES:
+        _run_case(sys.argv[1], sys.argv[2])
+    else:
+        unittest.main()
@@ -0,0 +1,63 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import time
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _run_ops(x, op_num):
+    y = x
+    for _ in range(op_num):
+        y = flow.relu(y)
+    return y
+
+
+def _time_per_op(x, op_num, repeat):
+    _run_ops(x, op_num)
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        _run_ops(x, op_num).numpy()
+        best = min(best, time.perf_counter() - start)
+    return best / op_num
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestAutogradRecordingOverhead(flow.unittest.TestCase):
+    def test_recording_overhead(test_case):
+        # Compares the same op chain with and without recording the autograd graph, the difference
+        # is the time spent on building FunctionNodes for each op call.
+        op_num, repeat = 1000, 5
+        x = flow.tensor(np.random.rand(4, 4).astype(np.float32), requires_grad=True)
+        with flow.no_grad():
+            without_recording = _time_per_op(x, op_num, repeat)
+        with_recording = _time_per_op(x, op_num, repeat)
+        # recording must not make an op an order of magnitude slower, the bound is loose
+        # enough for a loaded CI machine
+        test_case.assertLess(with_recording, 10 * without_recording)
+        y = _run_ops(x, op_num)
+        y.sum().backward()
+        test_case.assertTrue(
+            np.allclose(x.grad.numpy(), (x.numpy() > 0).astype(np.float32))
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,92 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import subprocess
+import sys
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+# Small cpu all-reduce, reduce and broadcast take the recursive doubling and binomial
+# tree paths of ccl. Shared memory is turned off so that they are not short-circuited
+# on a single host, and the thresholds are read once per process, so every world runs
+# in child processes of its own. A world of 3 ranks covers the non power of 2 case.
+_MAX_BYTES = 64 * 1024
+# 16000 float32 stays just below the threshold, the odd sizes do not split evenly
+_ELEM_CNTS = [1, 3, 1001, 16000]
+_WORLD_SIZES = [4, 3]
+
+
+def _local_data(rank, elem_cnt, seed):
+    # integers keep the float sums exact whatever order the algorithm adds in
+    rng = np.random.RandomState(seed * 10 + rank)
+    return rng.randint(-100, 100, size=elem_cnt).astype(np.float32)
+
+
+def _check_world(world_size, rank):
+    for seed, elem_cnt in enumerate(_ELEM_CNTS):
+        assert elem_cnt * 4 < _MAX_BYTES
+        inputs = [_local_data(r, elem_cnt, seed) for r in range(world_size)]
+        total = np.sum(inputs, axis=0)
+
+        x = flow.tensor(inputs[rank])
+        y = flow._C.local_all_reduce(x)
+        assert np.array_equal(y.numpy(), total), ("all_reduce", elem_cnt)
+
+        for root in range(world_size):
+            x = flow.tensor(inputs[rank])
+            flow._C.local_reduce(x, dst=root)
+            if rank == root:
+                assert np.array_equal(x.numpy(), total), ("reduce", elem_cnt, root)
+
+            x = flow.tensor(inputs[rank])
+            flow._C.broadcast(x, src_rank=root)
+            assert np.array_equal(x.numpy(), inputs[root]), (
+                "broadcast",
+                elem_cnt,
+                root,
+            )
+
+
+@flow.unittest.skip_unless_1n4d()
+class TestCpuCclSmallCollectives(flow.unittest.TestCase):
+    def test_cpu_ccl_small_collectives(test_case):
+        rank = flow.env.get_rank()
+        for world_idx, world_size in enumerate(_WORLD_SIZES):
+            if rank >= world_size:
+                continue
+            env = dict(os.environ)
+            env["MASTER_PORT"] = str(int(os.environ["MASTER_PORT"]) + 1 + world_idx)
+            env["WORLD_SIZE"] = str(world_size)
+            env["ONEFLOW_CCL_CPU_USE_SHM"] = "0"
+            env["ONEFLOW_CCL_CPU_RECURSIVE_DOUBLING_MAX_BYTES"] = str(_MAX_BYTES)
+            env["ONEFLOW_CCL_CPU_BINOMIAL_TREE_MAX_BYTES"] = str(_MAX_BYTES)
+            proc = subprocess.run(
+                [sys.executable, os.path.abspath(__file__), "world"],
+                env=env,
+                timeout=300,
+            )
+            test_case.assertEqual(proc.returncode, 0, "world of %d" % world_size)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 2 and sys.argv[1] == "world":
+        _check_world(flow.env.get_world_size(), flow.env.get_rank())
+    else:
+        unittest.main()
@@ -0,0 +1,57 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import time
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _time_per_add(x, y, op_num, repeat):
+    best = float("inf")
+    for _ in range(repeat):
+        z = x
+        start = time.perf_counter()
+        for _ in range(op_num):
+            z = flow.add(z, y)
+        z.numpy()
+        best = min(best, time.perf_counter() - start)
+    return best / op_num
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestEagerDispatchOverhead(flow.unittest.TestCase):
+    def test_add_dispatch_overhead(test_case):
+        # A one-element add does almost no computation, so the time per op is dominated by
+        # dispatching: building TensorTuples and blob object lists and looking up attrs.
+        op_num, repeat = 10000, 5
+        x = flow.tensor(np.zeros((1,), dtype=np.float32))
+        y = flow.tensor(np.ones((1,), dtype=np.float32))
+        with flow.no_grad():
+            time_per_op = _time_per_add(x, y, op_num, repeat)
+        # loose enough for a loaded CI machine, it only catches a dispatch path that has
+        # regressed by orders of magnitude
+        test_case.assertLess(time_per_op, 1e-3)
+        z = x
+        for _ in range(op_num):
+            z = flow.add(z, y)
+        test_case.assertTrue(np.allclose(z.numpy(), np.array([op_num], dtype=np.float32)))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,100 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+from test_util import GenArgList
+
+import oneflow
+import oneflow as flow
+import oneflow.unittest
+from oneflow.framework.eager_trace import eager_trace
+
+
+def _step(x, w):
+    y = flow.matmul(x, w)
+    y = flow.relu(y)
+    return (y * 2 + 1).sum(dim=1)
+
+
+def _test_eager_trace_impl(test_case, device, shape):
+    w = flow.tensor(
+        np.random.rand(shape[1], 4), dtype=flow.float32, device=flow.device(device)
+    )
+    for i in range(4):
+        # The last step changes the input shape, which has to be re-recorded.
+        rows = shape[0] if i < 3 else shape[0] + 1
+        x_np = np.random.rand(rows, shape[1])
+        x = flow.tensor(x_np, dtype=flow.float32, device=flow.device(device))
+        expected = _step(x, w).numpy()
+        oneflow._oneflow_internal.eager_trace.begin("step")
+        y = _step(x, w)
+        # Reading a tensor inside a trace must see all the batched instructions.
+        test_case.assertTrue(np.allclose(y.numpy(), expected, 0.0001, 0.0001))
+        z = y + 1
+        oneflow._oneflow_internal.eager_trace.end()
+        test_case.assertEqual(z.shape, flow.Size([rows]))
+        test_case.assertTrue(np.allclose(z.numpy(), expected + 1, 0.0001, 0.0001))
+    oneflow._oneflow_internal.eager_trace.clear()
+
+
+def _test_eager_trace_exception(test_case, device, shape):
+    w = flow.tensor(
+        np.random.rand(shape[1], 4), dtype=flow.float32, device=flow.device(device)
+    )
+    x = flow.tensor(
+        np.random.rand(*shape), dtype=flow.float32, device=flow.device(device)
+    )
+    expected = _step(x, w).numpy()
+    with eager_trace("step"):
+        _step(x, w)
+    # the first pass records the calls, the second one raises in the middle of them
+    with test_case.assertRaises(ValueError):
+        with eager_trace("step"):
+            y = flow.matmul(x, w)
+            raise ValueError("in trace")
+    # the calls made before the exception still run, and the trace is no longer current
+    test_case.assertTrue(
+        np.allclose(y.numpy(), np.matmul(x.numpy(), w.numpy()), 0.0001, 0.0001)
+    )
+    for _ in range(2):
+        with eager_trace("step"):
+            z = _step(x, w)
+        test_case.assertTrue(np.allclose(z.numpy(), expected, 0.0001, 0.0001))
+    oneflow._oneflow_internal.eager_trace.clear()
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestEagerTrace(flow.unittest.TestCase):
+    def test_eager_trace(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device"] = ["cpu", "cuda"]
+        arg_dict["shape"] = [[2, 3], [8, 10]]
+        for arg in GenArgList(arg_dict):
+            _test_eager_trace_impl(test_case, *arg)
+
+    def test_eager_trace_exception(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device"] = ["cpu", "cuda"]
+        arg_dict["shape"] = [[2, 3]]
+        for arg in GenArgList(arg_dict):
+            _test_eager_trace_exception(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -126,6 +126,42 @@ def _test_layernorm_backward(test_case, device):
     )
 
 
+def _np_layernorm(x, gamma, beta, dy, eps):
+    mean = x.mean(axis=-1, keepdims=True)
+    inv_variance = 1.0 / np.sqrt(x.var(axis=-1, keepdims=True) + eps)
+    normalized = (x - mean) * inv_variance
+    y = normalized * gamma + beta
+    dnormalized = dy * gamma
+    dx = inv_variance * (
+        dnormalized
+        - dnormalized.mean(axis=-1, keepdims=True)
+        - normalized * (dnormalized * normalized).mean(axis=-1, keepdims=True)
+    )
+    return y, dx, (dy * normalized).sum(axis=0), dy.sum(axis=0)
+
+
+def _test_layernorm_cpu_hidden_sizes(test_case, hidden_size):
+    # Hidden sizes of common transformer models, the rows are spread across threads.
+    num_rows, eps = 256, 1e-5
+    x_np = np.random.randn(num_rows, hidden_size).astype(np.float32)
+    dy_np = np.random.randn(num_rows, hidden_size).astype(np.float32)
+    m = flow.nn.LayerNorm(hidden_size, eps=eps)
+    gamma_np = np.random.randn(hidden_size).astype(np.float32)
+    beta_np = np.random.randn(hidden_size).astype(np.float32)
+    m.weight = flow.nn.Parameter(flow.tensor(gamma_np))
+    m.bias = flow.nn.Parameter(flow.tensor(beta_np))
+    x = flow.tensor(x_np, requires_grad=True)
+    y = m(x)
+    y.backward(flow.tensor(dy_np))
+    y_ref, dx_ref, dgamma_ref, dbeta_ref = _np_layernorm(
+        x_np.astype(np.float64), gamma_np, beta_np, dy_np.astype(np.float64), eps
+    )
+    test_case.assertTrue(np.allclose(y.numpy(), y_ref, 1e-4, 1e-4))
+    test_case.assertTrue(np.allclose(x.grad.numpy(), dx_ref, 1e-3, 1e-3))
+    test_case.assertTrue(np.allclose(m.weight.grad.numpy(), dgamma_ref, 1e-3, 1e-3))
+    test_case.assertTrue(np.allclose(m.bias.grad.numpy(), dbeta_ref, 1e-3, 1e-3))
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestLayerNorm(flow.unittest.TestCase):
     def test_layernorm(test_case):
@@ -140,6 +176,10 @@ class TestLayerNorm(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             arg[0](test_case, *arg[1:])
 
+    def test_layernorm_cpu_hidden_sizes(test_case):
+        for hidden_size in [768, 1024, 2048, 4096, 8192]:
+            _test_layernorm_cpu_hidden_sizes(test_case, hidden_size)
+
     @autotest(n=20, auto_backward=True, rtol=1e-3, atol=1e-3)
     def test_layernorm_with_random_data_warp(test_case):
         device = random_device()
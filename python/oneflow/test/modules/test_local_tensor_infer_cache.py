@@ -0,0 +1,52 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+
+import numpy as np
+
+import oneflow
+import oneflow as flow
+import oneflow.unittest
+
+infer_cache = oneflow._oneflow_internal.local_tensor_infer_cache
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestLocalTensorInferCache(flow.unittest.TestCase):
+    def test_hit_on_same_metas(test_case):
+        x = flow.tensor(np.random.rand(4, 5), dtype=flow.float32)
+        y = flow.relu(x)
+        infer_cache.reset_counters()
+        for _ in range(3):
+            z = flow.relu(x)
+        test_case.assertEqual(infer_cache.hit_count(), 3)
+        test_case.assertEqual(infer_cache.miss_count(), 0)
+        test_case.assertTrue(np.allclose(z.numpy(), y.numpy()))
+
+    def test_miss_on_new_shape(test_case):
+        x = flow.tensor(np.random.rand(4, 5), dtype=flow.float32)
+        flow.relu(x)
+        x = flow.tensor(np.random.rand(7, 3), dtype=flow.float32)
+        infer_cache.reset_counters()
+        y = flow.relu(x)
+        test_case.assertEqual(infer_cache.miss_count(), 1)
+        test_case.assertEqual(y.shape, flow.Size([7, 3]))
+        test_case.assertTrue(np.allclose(y.numpy(), np.maximum(x.numpy(), 0)))
+
+
+if __name__ == "__main__":
+    unittest.main()
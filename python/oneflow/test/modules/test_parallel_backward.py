@@ -0,0 +1,186 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import subprocess
+import sys
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow import autograd
+
+# The backward thread pool is created from this env at the first backward of a process, so the
+# cases run in a child process instead of changing the env of the process collecting the tests.
+_THREAD_NUM_ENV = "ONEFLOW_AUTOGRAD_BACKWARD_THREAD_NUM"
+
+
+def _multi_head_loss(x, weights):
+    hidden = flow.relu(x)
+    losses = [flow.matmul(hidden, w).sum() for w in weights]
+    return sum(losses)
+
+
+def _test_multi_head_grads(test_case):
+    x_np = np.random.randn(8, 16).astype(np.float32)
+    weights_np = [np.random.randn(16, 4).astype(np.float32) for _ in range(6)]
+    x = flow.tensor(x_np, requires_grad=True)
+    weights = [flow.tensor(w, requires_grad=True) for w in weights_np]
+    _multi_head_loss(x, weights).backward()
+    hidden_np = np.maximum(x_np, 0)
+    hidden_grad_np = sum(np.ones((8, 4), np.float32).dot(w.T) for w in weights_np)
+    test_case.assertTrue(
+        np.allclose(x.grad.numpy(), hidden_grad_np * (x_np > 0), 1e-4, 1e-4)
+    )
+    for w in weights:
+        test_case.assertTrue(
+            np.allclose(w.grad.numpy(), hidden_np.T.dot(np.ones((8, 4))), 1e-4, 1e-4)
+        )
+
+
+def _test_deterministic_accumulation(test_case):
+    x_np = np.random.randn(32, 64).astype(np.float32)
+    weights_np = [np.random.randn(64, 64).astype(np.float32) for _ in range(8)]
+    grads = []
+    for _ in range(3):
+        x = flow.tensor(x_np, requires_grad=True)
+        weights = [flow.tensor(w) for w in weights_np]
+        _multi_head_loss(x, weights).backward()
+        grads.append(x.grad.numpy())
+    for grad in grads[1:]:
+        test_case.assertTrue(np.array_equal(grad, grads[0]))
+
+
+def _test_hook_and_retain_grad(test_case):
+    x = flow.tensor(np.random.randn(4, 4).astype(np.float32), requires_grad=True)
+    x.register_hook(lambda grad: grad * 2)
+    y = x * 3
+    y.retain_grad()
+    (y.sum() + (x * 5).sum()).backward()
+    test_case.assertTrue(np.allclose(y.grad.numpy(), np.ones((4, 4))))
+    test_case.assertTrue(np.allclose(x.grad.numpy(), np.full((4, 4), 16.0)))
+
+
+def _test_custom_function(test_case):
+    class MyReLU(autograd.Function):
+        @staticmethod
+        def forward(ctx, x):
+            ctx.save_for_backward(x)
+            return x.clamp(min=0.0, max=None)
+
+        @staticmethod
+        def backward(ctx, y_grad):
+            (x,) = ctx.saved_tensors
+            x_grad = y_grad.clone()
+            x_grad[x < 0] = 0
+            return x_grad
+
+    x_np = np.random.randn(8, 16).astype(np.float32)
+    weights_np = [np.random.randn(16, 4).astype(np.float32) for _ in range(6)]
+    x = flow.tensor(x_np, requires_grad=True)
+    weights = [flow.tensor(w, requires_grad=True) for w in weights_np]
+    hidden = MyReLU.apply(x)
+    sum(flow.matmul(hidden, w).sum() for w in weights).backward()
+    hidden_grad_np = sum(np.ones((8, 4), np.float32).dot(w.T) for w in weights_np)
+    test_case.assertTrue(
+        np.allclose(x.grad.numpy(), hidden_grad_np * (x_np > 0), 1e-4, 1e-4)
+    )
+    for w in weights:
+        test_case.assertTrue(
+            np.allclose(
+                w.grad.numpy(), np.maximum(x_np, 0).T.dot(np.ones((8, 4))), 1e-4, 1e-4
+            )
+        )
+
+
+def _test_graph_backward(test_case):
+    # the backward ops of a graph are added to the job by the thread building it
+    x_np = np.random.randn(8, 16).astype(np.float32)
+    weights_np = [np.random.randn(16, 4).astype(np.float32) for _ in range(6)]
+
+    class MultiHead(flow.nn.Module):
+        def __init__(self):
+            super().__init__()
+            self.heads = flow.nn.ModuleList()
+            for w in weights_np:
+                head = flow.nn.Linear(16, 4, bias=False)
+                head.weight = flow.nn.Parameter(flow.tensor(w.T.copy()))
+                self.heads.append(head)
+
+        def forward(self, x):
+            return sum(head(flow.relu(x)).sum() for head in self.heads)
+
+    model = MultiHead()
+    sgd = flow.optim.SGD(model.parameters(), lr=1.0)
+
+    class TrainGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.model = model
+            self.add_optimizer(sgd)
+
+        def build(self, x):
+            loss = self.model(x)
+            loss.backward()
+            return loss
+
+    TrainGraph()(flow.tensor(x_np))
+    w_grad_np = np.maximum(x_np, 0).T.dot(np.ones((8, 4), np.float32))
+    for head, w_np in zip(model.heads, weights_np):
+        test_case.assertTrue(
+            np.allclose(head.weight.numpy(), (w_np - w_grad_np).T, 1e-4, 1e-4)
+        )
+
+
+def _run_with_backward_threads(test_case, case_name):
+    env = dict(os.environ)
+    env[_THREAD_NUM_ENV] = "4"
+    # a deadlock shows up as a timeout instead of hanging the test run
+    proc = subprocess.run(
+        [sys.executable, os.path.abspath(__file__), case_name], env=env, timeout=300
+    )
+    test_case.assertEqual(proc.returncode, 0)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestParallelBackward(flow.unittest.TestCase):
+    def test_multi_head_grads(test_case):
+        _run_with_backward_threads(test_case, "_test_multi_head_grads")
+
+    def test_deterministic_accumulation(test_case):
+        _run_with_backward_threads(test_case, "_test_deterministic_accumulation")
+
+    def test_hook_and_retain_grad(test_case):
+        _run_with_backward_threads(test_case, "_test_hook_and_retain_grad")
+
+    def test_custom_function(test_case):
+        _run_with_backward_threads(test_case, "_test_custom_function")
+
+    def test_graph_backward(test_case):
+        _run_with_backward_threads(test_case, "_test_graph_backward")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) > 1 and sys.argv[1].startswith("_test_"):
+
+        class _Checker(unittest.TestCase):
+            def runTest(self):
+                pass
+
+        globals()[sys.argv[1]](_Checker())
+    else:
+        unittest.main()